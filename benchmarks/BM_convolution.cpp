@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "effects/impl/PartitionedConvolver.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+// Stereo convolution by blocks of 256 frames, with responses from a small
+// room to a long hall; the argument is the length of the response in frames
+constexpr int blockSize { 256 };
+
+class Convolution : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const size_t length = static_cast<size_t>(state.range(0));
+        std::minstd_rand prng { 1 };
+        std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+
+        ir = sfz::AudioBuffer<float>(2, length);
+        for (size_t c = 0; c < 2; ++c) {
+            for (float& x : ir.getSpan(c))
+                x = dist(prng);
+        }
+        for (size_t c = 0; c < 2; ++c) {
+            for (float& x : input.getSpan(c))
+                x = dist(prng);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+    }
+
+    sfz::AudioBuffer<float> ir;
+    sfz::AudioBuffer<float> input { 2, blockSize };
+    sfz::AudioBuffer<float> output { 2, blockSize };
+};
+
+// Non-uniform partitions, without latency
+BENCHMARK_DEFINE_F(Convolution, Partitioned)(benchmark::State& state)
+{
+    sfz::fx::PartitionedConvolver convolver;
+    convolver.setImpulseResponse(sfz::AudioSpan<const float>(ir));
+    for (auto _ : state) {
+        convolver.process(sfz::AudioSpan<float>(input), sfz::AudioSpan<float>(output), blockSize);
+        benchmark::DoNotOptimize(output.getSample(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+// Uniform partitions of the block size, with a latency of one block
+BENCHMARK_DEFINE_F(Convolution, Uniform)(benchmark::State& state)
+{
+    sfz::fx::UniformConvolver convolvers[2];
+    for (size_t c = 0; c < 2; ++c)
+        convolvers[c].init(ir.getConstSpan(c), blockSize);
+    for (auto _ : state) {
+        for (size_t c = 0; c < 2; ++c)
+            convolvers[c].processBlock(input.channelReader(c), output.channelWriter(c));
+        benchmark::DoNotOptimize(output.getSample(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+BENCHMARK_REGISTER_F(Convolution, Partitioned)->Arg(4800)->Arg(24000)->Arg(96000)->Arg(288000);
+BENCHMARK_REGISTER_F(Convolution, Uniform)->Arg(4800)->Arg(24000)->Arg(96000)->Arg(288000);
+BENCHMARK_MAIN();
@@ -7,6 +7,7 @@
 #include "SIMDHelpers.h"
 #include "OnePoleFilter.h"
 #include "SfzFilter.h"
+#include "FilterBank.h"
 #include "SfzHelpers.h"
 #include "ScopedFTZ.h"
 #include "SfzHelpers.h"
@@ -141,9 +142,89 @@ BENCHMARK_DEFINE_F(FilterFixture, TwoPoleShelf_Faust)(benchmark::State& state) {
     }
 }
 
+BENCHMARK_DEFINE_F(FilterFixture, TwoPole_Tabulated)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::Filter filter;
+    filter.init(sampleRate);
+    filter.setType(sfz::FilterType::kFilterLpf2p);
+    filter.setQuality(0);
+    for (auto _ : state)
+    {
+        const auto step = static_cast<size_t>(state.range(0));
+        auto cutoffPtr = cutoff.data();
+        auto qIterator = q.begin();
+        auto pkshIterator = pksh.begin();
+        auto inputPtr = input.data();
+        auto outputPtr = output.data();
+        const auto sentinel = cutoff.data() + blockSize;
+        while (cutoffPtr < sentinel)
+        {
+            filter.process(&inputPtr, &outputPtr, *cutoffPtr, *qIterator, *pkshIterator, step);
+            qIterator += step;
+            cutoffPtr += step;
+            pkshIterator += step;
+            inputPtr += step;
+            outputPtr += step;
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterFixture, TwoPoleShelf_Tabulated)(benchmark::State& state) {
+    ScopedFTZ ftz;
+    sfz::Filter filter;
+    filter.init(sampleRate);
+    filter.setType(sfz::FilterType::kFilterLsh);
+    filter.setQuality(0);
+    for (auto _ : state)
+    {
+        const auto step = static_cast<size_t>(state.range(0));
+        auto cutoffPtr = cutoff.data();
+        auto qIterator = q.begin();
+        auto pkshIterator = pksh.begin();
+        auto inputPtr = input.data();
+        auto outputPtr = output.data();
+        const auto sentinel = cutoff.data() + blockSize;
+        while (cutoffPtr < sentinel)
+        {
+            filter.process(&inputPtr, &outputPtr, *cutoffPtr, *qIterator, *pkshIterator, step);
+            qIterator += step;
+            cutoffPtr += step;
+            pkshIterator += step;
+            inputPtr += step;
+            outputPtr += step;
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterFixture, Coefficients_Exact)(benchmark::State& state) {
+    sfz::BiquadCoefficients coefs;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < blockSize; ++i) {
+            sfz::computeBiquad(sfz::FilterType::kFilterLpf2p, sampleRate, cutoff[i], q[i], pksh[i], coefs);
+            benchmark::DoNotOptimize(coefs);
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(FilterFixture, Coefficients_Tabulated)(benchmark::State& state) {
+    sfz::BiquadCoefficients coefs;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < blockSize; ++i) {
+            sfz::computeBiquadTabulated(sfz::FilterType::kFilterLpf2p, sampleRate, cutoff[i], q[i], pksh[i], coefs);
+            benchmark::DoNotOptimize(coefs);
+        }
+    }
+}
+
 BENCHMARK_REGISTER_F(FilterFixture, OnePole_VA)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, OnePole_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, TwoPole_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
 BENCHMARK_REGISTER_F(FilterFixture, TwoPoleShelf_Faust)->RangeMultiplier(2)->Range(1, 1 << 8);
+BENCHMARK_REGISTER_F(FilterFixture, TwoPole_Tabulated)->RangeMultiplier(2)->Range(1, 1 << 8);
+BENCHMARK_REGISTER_F(FilterFixture, TwoPoleShelf_Tabulated)->RangeMultiplier(2)->Range(1, 1 << 8);
+BENCHMARK_REGISTER_F(FilterFixture, Coefficients_Exact);
+BENCHMARK_REGISTER_F(FilterFixture, Coefficients_Tabulated);
 BENCHMARK_MAIN();
 
@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "AudioBuffer.h"
+#include "utility/Timing.h"
+#include <benchmark/benchmark.h>
+#include <ghc/fs_std.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Render whole instruments under MIDI workloads, at several block sizes,
+// polyphonies and sample qualities. The instruments and their samples are
+// generated in a temporary directory, so that no external asset is needed.
+//
+// Each iteration renders the same few seconds of a workload. The counters are
+// the real-time factor (the render time over the rendered duration, lower is
+// better), the per-block render time at the median, the 99th percentile and
+// the maximum, in microseconds, and the loading time of the instrument in
+// milliseconds.
+constexpr float sampleRate { 48000.0f };
+constexpr int renderSeconds { 4 };
+constexpr int64_t renderFrames { static_cast<int64_t>(renderSeconds * sampleRate) };
+constexpr double twoPi { 6.283185307179586 };
+
+namespace {
+
+struct WorkloadEvent {
+    enum class Type { NoteOn, NoteOff, CC, PitchBend };
+    int64_t frame;
+    Type type;
+    int number;
+    int value;
+};
+
+/**
+ * @brief Write 16-bit PCM WAV file, from interleaved frames in [-1, 1]
+ */
+void writeWav(const fs::path& path, const std::vector<float>& frames, int numChannels)
+{
+    auto put16 = [](std::ofstream& f, uint16_t x) { f.put(char(x & 0xff)); f.put(char(x >> 8)); };
+    auto put32 = [&](std::ofstream& f, uint32_t x) { put16(f, uint16_t(x & 0xffff)); put16(f, uint16_t(x >> 16)); };
+
+    const uint32_t dataSize = static_cast<uint32_t>(frames.size() * 2);
+    std::ofstream f(path.string(), std::ios::binary);
+    f.write("RIFF", 4);
+    put32(f, 36 + dataSize);
+    f.write("WAVEfmt ", 8);
+    put32(f, 16);
+    put16(f, 1);
+    put16(f, uint16_t(numChannels));
+    put32(f, uint32_t(sampleRate));
+    put32(f, uint32_t(sampleRate) * numChannels * 2);
+    put16(f, uint16_t(numChannels * 2));
+    put16(f, 16);
+    f.write("data", 4);
+    put32(f, dataSize);
+    for (float x : frames)
+        put16(f, uint16_t(int16_t(std::lround(std::max(-1.0f, std::min(1.0f, x)) * 32767.0f))));
+}
+
+void sortByFrame(std::vector<WorkloadEvent>& events)
+{
+    std::stable_sort(events.begin(), events.end(), [](const WorkloadEvent& a, const WorkloadEvent& b) {
+        return a.frame < b.frame;
+    });
+}
+
+float noteFrequency(int note)
+{
+    return 440.0f * std::pow(2.0f, (note - 69) / 12.0f);
+}
+
+/**
+ * @brief Generate a decaying harmonic tone, as a piano sample
+ */
+std::vector<float> pianoTone(int note, float seconds)
+{
+    const size_t numFrames = static_cast<size_t>(seconds * sampleRate);
+    const double f0 = noteFrequency(note);
+    std::vector<float> frames(numFrames);
+    for (size_t i = 0; i < numFrames; ++i) {
+        const double t = i / sampleRate;
+        double x = 0.0;
+        for (int h = 1; h <= 6 && h * f0 < 0.45 * sampleRate; ++h)
+            x += std::sin(twoPi * h * f0 * t) * std::exp(-t * (1.0 + h)) / h;
+        frames[i] = static_cast<float>(0.4 * x);
+    }
+    return frames;
+}
+
+/**
+ * @brief Generate a filtered noise burst, as a drum hit
+ */
+std::vector<float> drumHit(float seconds, float decay, float tone, unsigned seed)
+{
+    const size_t numFrames = static_cast<size_t>(seconds * sampleRate);
+    std::minstd_rand rng { seed };
+    std::uniform_real_distribution<float> noise { -1.0f, 1.0f };
+    std::vector<float> frames(numFrames);
+    float lowpass = 0.0f;
+    for (size_t i = 0; i < numFrames; ++i) {
+        const double t = i / sampleRate;
+        lowpass += tone * (noise(rng) - lowpass);
+        const double body = std::sin(twoPi * 60.0 * t) * (1.0 - tone);
+        frames[i] = static_cast<float>((lowpass + body) * std::exp(-t * decay) * 0.8);
+    }
+    return frames;
+}
+
+/**
+ * @brief Generate a stereo detuned saw, which loops over its whole length
+ */
+std::vector<float> padTone(int note, float seconds)
+{
+    const double f0 = noteFrequency(note);
+    const size_t period = static_cast<size_t>(std::lround(sampleRate / f0));
+    const size_t numFrames = (static_cast<size_t>(seconds * sampleRate) / period) * period;
+    std::vector<float> frames(2 * numFrames);
+    for (size_t i = 0; i < numFrames; ++i) {
+        const double phase = double(i % period) / period;
+        const double phase2 = std::fmod(phase * 2.0, 1.0);
+        frames[2 * i] = static_cast<float>(0.3 * (2.0 * phase - 1.0));
+        frames[2 * i + 1] = static_cast<float>(0.3 * (2.0 * phase2 - 1.0) * 0.5 + 0.15 * (2.0 * phase - 1.0));
+    }
+    return frames;
+}
+
+/**
+ * @brief Generate the instruments once for the process
+ */
+const fs::path& instrumentDirectory()
+{
+    static const fs::path directory = []() {
+        const fs::path dir = fs::temp_directory_path() / "sfizz_bm_instrument";
+        fs::create_directories(dir / "samples");
+
+        std::string piano = "<control> default_path=samples/\n"
+                            "<global> ampeg_release=0.8 amp_veltrack=80\n";
+        for (int note = 21; note <= 108; note += 3) {
+            const std::string name = "piano_" + std::to_string(note) + ".wav";
+            writeWav(dir / "samples" / name, pianoTone(note, 2.0f), 1);
+            piano += "<region> sample=" + name + " pitch_keycenter=" + std::to_string(note)
+                + " lokey=" + std::to_string(note - 1) + " hikey=" + std::to_string(note + 1) + "\n";
+        }
+        std::ofstream((dir / "piano.sfz").string()) << piano;
+
+        std::string drums = "<control> default_path=samples/\n"
+                            "<global> loop_mode=one_shot amp_veltrack=100\n";
+        const struct { int key; float seconds; float decay; float tone; } kit[] = {
+            { 36, 0.5f, 8.0f, 0.05f }, { 38, 0.4f, 12.0f, 0.5f }, { 42, 0.15f, 30.0f, 0.95f },
+            { 46, 0.6f, 6.0f, 0.9f }, { 45, 0.5f, 9.0f, 0.2f }, { 49, 1.5f, 2.5f, 0.85f },
+        };
+        unsigned seed = 1;
+        for (const auto& drum : kit) {
+            drums += "<group> key=" + std::to_string(drum.key) + " seq_length=4\n";
+            for (int rr = 1; rr <= 4; ++rr) {
+                const std::string name = "drum_" + std::to_string(drum.key) + "_" + std::to_string(rr) + ".wav";
+                writeWav(dir / "samples" / name, drumHit(drum.seconds, drum.decay, drum.tone, seed++), 1);
+                drums += "<region> sample=" + name + " seq_position=" + std::to_string(rr)
+                    + (drum.key == 42 ? " group=1" : drum.key == 46 ? " group=2 off_by=1" : "") + "\n";
+            }
+        }
+        std::ofstream((dir / "drums.sfz").string()) << drums;
+
+        std::string pads = "<control> default_path=samples/\n"
+                           "<global> loop_mode=loop_continuous ampeg_attack=0.3 ampeg_release=1.5\n"
+                           " fil_type=lpf_2p cutoff=800 cutoff_oncc74=4800 resonance=4\n"
+                           " lfo1_freq=0.7 lfo1_cutoff1=600 lfo2_freq=5 lfo2_pitch_oncc1=40\n"
+                           " eq1_freq=2000 eq1_gain=4 eq1_bw=1\n"
+                           " amplitude_oncc11=100 pan_oncc10=100 effect1=40\n";
+        for (int note = 36; note <= 96; note += 6) {
+            const std::string name = "pad_" + std::to_string(note) + ".wav";
+            const auto frames = padTone(note, 1.0f);
+            writeWav(dir / "samples" / name, frames, 2);
+            pads += "<region> sample=" + name + " pitch_keycenter=" + std::to_string(note)
+                + " lokey=" + std::to_string(note - 3) + " hikey=" + std::to_string(note + 2)
+                + " loop_start=0 loop_end=" + std::to_string(frames.size() / 2 - 1) + "\n";
+        }
+        pads += "<effect> bus=fx1 fx1tomain=100 type=fverb reverb_type=large_hall reverb_input=100 reverb_wet=100\n"
+                "<effect> bus=main type=eq eq_freq=200 eq_gain=-3 eq_bw=1\n";
+        std::ofstream((dir / "pads.sfz").string()) << pads;
+
+        return dir;
+    }();
+    return directory;
+}
+
+/**
+ * @brief Broken chords under the sustain pedal, which is released every
+ * second, so the voices pile up to the polyphony
+ */
+std::vector<WorkloadEvent> pianoWorkload()
+{
+    std::vector<WorkloadEvent> events;
+    std::minstd_rand rng { 42 };
+    std::uniform_int_distribution<int> velocity { 40, 120 };
+    const int64_t step = static_cast<int64_t>(0.04f * sampleRate);
+    const int chord[] = { 0, 4, 7, 12, 16, 19, 24 };
+    int root = 36;
+    for (int64_t frame = 0, i = 0; frame < renderFrames; frame += step, ++i) {
+        if (i % 25 == 0) {
+            events.push_back({ frame, WorkloadEvent::Type::CC, 64, 0 });
+            events.push_back({ frame + 64, WorkloadEvent::Type::CC, 64, 127 });
+            root = 28 + static_cast<int>((i / 25) * 5 % 36);
+        }
+        const int note = root + chord[i % 7] + 12 * static_cast<int>((i / 7) % 3);
+        events.push_back({ frame, WorkloadEvent::Type::NoteOn, note, velocity(rng) });
+        events.push_back({ frame + step * 2, WorkloadEvent::Type::NoteOff, note, 0 });
+    }
+    sortByFrame(events);
+    return events;
+}
+
+/**
+ * @brief Snare and tom rolls in 32nd note triplets over hi-hats and kicks
+ */
+std::vector<WorkloadEvent> drumsWorkload()
+{
+    std::vector<WorkloadEvent> events;
+    std::minstd_rand rng { 7 };
+    std::uniform_int_distribution<int> velocity { 30, 127 };
+    const int64_t step = static_cast<int64_t>(sampleRate * 0.5f / 12); // 120 bpm
+    for (int64_t frame = 0, i = 0; frame < renderFrames; frame += step, ++i) {
+        const int roll = (i / 48) % 2 == 0 ? 38 : 45;
+        events.push_back({ frame, WorkloadEvent::Type::NoteOn, roll, velocity(rng) });
+        if (i % 3 == 0)
+            events.push_back({ frame, WorkloadEvent::Type::NoteOn, (i % 24 == 21) ? 46 : 42, velocity(rng) });
+        if (i % 12 == 0)
+            events.push_back({ frame, WorkloadEvent::Type::NoteOn, 36, 120 });
+        if (i % 96 == 0)
+            events.push_back({ frame, WorkloadEvent::Type::NoteOn, 49, 110 });
+    }
+    return events;
+}
+
+/**
+ * @brief Overlapping held chords, with modulation wheel, expression,
+ * brightness and pan sweeps and pitch bends every millisecond
+ */
+std::vector<WorkloadEvent> padsWorkload()
+{
+    std::vector<WorkloadEvent> events;
+    const int64_t chordStep = static_cast<int64_t>(0.5f * sampleRate);
+    const int chord[] = { 0, 3, 7, 10, 14, 19 };
+    for (int64_t frame = 0, i = 0; frame < renderFrames; frame += chordStep, ++i) {
+        const int root = 40 + static_cast<int>(i * 5 % 12);
+        for (int offset : chord) {
+            events.push_back({ frame, WorkloadEvent::Type::NoteOn, root + offset, 90 });
+            events.push_back({ frame + 2 * chordStep, WorkloadEvent::Type::NoteOff, root + offset, 0 });
+        }
+    }
+
+    const int64_t ccStep = static_cast<int64_t>(0.001f * sampleRate);
+    for (int64_t frame = 0; frame < renderFrames; frame += ccStep) {
+        const double t = frame / sampleRate;
+        auto sweep = [t](double rate) { return static_cast<int>(63.5 + 63.5 * std::sin(twoPi * rate * t)); };
+        events.push_back({ frame, WorkloadEvent::Type::CC, 1, sweep(0.3) });
+        events.push_back({ frame, WorkloadEvent::Type::CC, 11, sweep(0.7) });
+        events.push_back({ frame, WorkloadEvent::Type::CC, 74, sweep(1.1) });
+        events.push_back({ frame, WorkloadEvent::Type::CC, 10, sweep(0.2) });
+        events.push_back({ frame, WorkloadEvent::Type::PitchBend, 0, static_cast<int>(2000 * std::sin(twoPi * 0.5 * t)) });
+    }
+
+    sortByFrame(events);
+    return events;
+}
+
+} // namespace
+
+class Instrument : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        blockSize = static_cast<int>(state.range(0));
+        synth.setSamplesPerBlock(blockSize);
+        synth.setSampleRate(sampleRate);
+        synth.setNumVoices(static_cast<int>(state.range(1)));
+        synth.setSampleQuality(sfz::Synth::ProcessMode::ProcessFreewheeling, static_cast<int>(state.range(2)));
+        // The freewheeling mode waits for the background loads, so that the
+        // timings do not depend on the disk
+        synth.enableFreeWheeling();
+        buffer.resize(blockSize);
+        blockDurations.reserve(static_cast<size_t>(renderFrames / blockSize + 1));
+
+        const auto loadStart = sfz::highResNow();
+        synth.loadSfzFile(instrumentDirectory() / sfzFile);
+        loadDuration = (sfz::highResNow() - loadStart).count();
+
+        // Warm up the sample data
+        renderWorkload(nullptr);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        synth.allSoundOff();
+    }
+
+    /**
+     * @brief Play the workload once from the start, storing the render time
+     * of each block if durations is non-null
+     */
+    void renderWorkload(std::vector<double>* durations)
+    {
+        synth.allSoundOff();
+        auto event = events.begin();
+        for (int64_t blockStart = 0; blockStart < renderFrames; blockStart += blockSize) {
+            const auto start = sfz::highResNow();
+            for (; event != events.end() && event->frame < blockStart + blockSize; ++event) {
+                const int delay = static_cast<int>(event->frame - blockStart);
+                switch (event->type) {
+                case WorkloadEvent::Type::NoteOn:
+                    synth.noteOn(delay, event->number, event->value);
+                    break;
+                case WorkloadEvent::Type::NoteOff:
+                    synth.noteOff(delay, event->number, event->value);
+                    break;
+                case WorkloadEvent::Type::CC:
+                    synth.cc(delay, event->number, event->value);
+                    break;
+                case WorkloadEvent::Type::PitchBend:
+                    synth.pitchWheel(delay, event->value);
+                    break;
+                }
+            }
+            synth.renderBlock(buffer);
+            benchmark::DoNotOptimize(buffer.getSample(0, 0));
+            if (durations)
+                durations->push_back((sfz::highResNow() - start).count());
+        }
+    }
+
+    void run(benchmark::State& state)
+    {
+        double totalDuration = 0.0;
+        std::vector<double> allDurations;
+        for (auto _ : state) {
+            blockDurations.clear();
+            renderWorkload(&blockDurations);
+            for (double duration : blockDurations)
+                totalDuration += duration;
+            allDurations.insert(allDurations.end(), blockDurations.begin(), blockDurations.end());
+        }
+
+        std::sort(allDurations.begin(), allDurations.end());
+        auto percentile = [&allDurations](double p) {
+            if (allDurations.empty())
+                return 0.0;
+            const size_t index = static_cast<size_t>(p * (allDurations.size() - 1));
+            return allDurations[index] * 1e6;
+        };
+        const double renderedDuration = static_cast<double>(state.iterations()) * renderSeconds;
+        state.counters["rtf"] = totalDuration / renderedDuration;
+        state.counters["p50_us"] = percentile(0.5);
+        state.counters["p99_us"] = percentile(0.99);
+        state.counters["max_us"] = percentile(1.0);
+        state.counters["load_ms"] = loadDuration * 1e3;
+        state.SetItemsProcessed(state.iterations() * renderFrames);
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    std::string sfzFile;
+    std::vector<WorkloadEvent> events;
+    std::vector<double> blockDurations;
+    double loadDuration { 0.0 };
+    int blockSize { 0 };
+};
+
+class Piano : public Instrument {
+public:
+    Piano() { sfzFile = "piano.sfz"; events = pianoWorkload(); }
+};
+
+class Drums : public Instrument {
+public:
+    Drums() { sfzFile = "drums.sfz"; events = drumsWorkload(); }
+};
+
+class Pads : public Instrument {
+public:
+    Pads() { sfzFile = "pads.sfz"; events = padsWorkload(); }
+};
+
+static void instrumentArguments(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "block", "voices", "quality" });
+    for (int blockSize : { 64, 256, 1024 })
+        for (int numVoices : { 64, 256 })
+            for (int quality : { 1, 2, 10 })
+                b->Args({ blockSize, numVoices, quality });
+    b->Iterations(2)->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_DEFINE_F(Piano, SustainedPedal)(benchmark::State& state) { run(state); }
+BENCHMARK_DEFINE_F(Drums, Rolls)(benchmark::State& state) { run(state); }
+BENCHMARK_DEFINE_F(Pads, ControllerSweeps)(benchmark::State& state) { run(state); }
+BENCHMARK_REGISTER_F(Piano, SustainedPedal)->Apply(instrumentArguments);
+BENCHMARK_REGISTER_F(Drums, Rolls)->Apply(instrumentArguments);
+BENCHMARK_REGISTER_F(Pads, ControllerSweeps)->Apply(instrumentArguments);
+BENCHMARK_MAIN();
@@ -6,7 +6,13 @@
 
 #include "Config.h"
 #include "Interpolators.h"
+#include "SampleFormat.h"
 #include "ScopedFTZ.h"
+#include "SIMDHelpers.h"
+#include "SIMDConfig.h"
+#include "simd/HelpersSSE.h"
+#include "simd/HelpersAVX.h"
+#include "simd/HelpersNEON.h"
 #include "absl/types/span.h"
 #include <benchmark/benchmark.h>
 #include <random>
@@ -15,6 +21,7 @@ class Interpolators : public benchmark::Fixture {
 public:
     Interpolators()
     {
+        sfz::initializeSIMDDispatchers();
         sfz::initializeInterpolators();
     }
 
@@ -26,14 +33,34 @@ public:
 
         const size_t numFramesIn = state.range(0);
         inputBuffer = std::vector<float>(numFramesIn + 2 * sfz::config::excessFileFrames);
+        inputBufferRight = std::vector<float>(numFramesIn + 2 * sfz::config::excessFileFrames);
 
         // any ratio will do, compute time will be proportional
         static constexpr float ratio = 1.234;
 
         const size_t numFramesOut = static_cast<size_t>(std::ceil(numFramesIn * ratio));
         input = absl::MakeSpan(inputBuffer).subspan(sfz::config::excessFileFrames, numFramesIn);
+        inputRight = absl::MakeSpan(inputBufferRight).subspan(sfz::config::excessFileFrames, numFramesIn);
         output = std::vector<float>(numFramesOut);
+        outputRight = std::vector<float>(numFramesOut);
         std::generate(input.begin(), input.end(), [&]() { return dist(gen); });
+        std::generate(inputRight.begin(), inputRight.end(), [&]() { return dist(gen); });
+
+        inputBufferInt16.resize(inputBuffer.size());
+        inputBufferInt16Right.resize(inputBufferRight.size());
+        std::transform(inputBuffer.begin(), inputBuffer.end(), inputBufferInt16.begin(), sfz::storedSample<int16_t>);
+        std::transform(inputBufferRight.begin(), inputBufferRight.end(), inputBufferInt16Right.begin(), sfz::storedSample<int16_t>);
+        inputInt16 = absl::MakeSpan(inputBufferInt16).subspan(sfz::config::excessFileFrames, numFramesIn);
+        inputInt16Right = absl::MakeSpan(inputBufferInt16Right).subspan(sfz::config::excessFileFrames, numFramesIn);
+
+        const float kOutToIn = static_cast<float>(numFramesIn) / numFramesOut;
+        indices = std::vector<int>(numFramesOut);
+        coeffs = std::vector<float>(numFramesOut);
+        for (size_t iOut = 0; iOut < numFramesOut; ++iOut) {
+            float posIn = iOut * kOutToIn;
+            indices[iOut] = static_cast<int>(posIn);
+            coeffs[iOut] = posIn - indices[iOut];
+        }
     }
 
     void TearDown(const ::benchmark::State& /* state */)
@@ -41,8 +68,17 @@ public:
     }
 
     std::vector<float> inputBuffer;
+    std::vector<float> inputBufferRight;
     absl::Span<float> input;
+    absl::Span<float> inputRight;
+    std::vector<int16_t> inputBufferInt16;
+    std::vector<int16_t> inputBufferInt16Right;
+    absl::Span<int16_t> inputInt16;
+    absl::Span<int16_t> inputInt16Right;
     std::vector<float> output;
+    std::vector<float> outputRight;
+    std::vector<int> indices;
+    std::vector<float> coeffs;
 
     enum { excessFrames = 8 };
 };
@@ -84,3 +120,129 @@ ADD_INTERPOLATOR_BENCHMARK(Sinc36)
 ADD_INTERPOLATOR_BENCHMARK(Sinc48)
 ADD_INTERPOLATOR_BENCHMARK(Sinc60)
 ADD_INTERPOLATOR_BENCHMARK(Sinc72)
+
+template <sfz::InterpolatorModel M>
+static void doStereoInterpolation(
+    absl::Span<const float> left, absl::Span<const float> right,
+    absl::Span<float> outputLeft, absl::Span<float> outputRight,
+    absl::Span<const int> indices, absl::Span<const float> coeffs)
+{
+    for (size_t iOut = 0; iOut < indices.size(); ++iOut) {
+        outputLeft[iOut] = sfz::interpolate<M>(&left[indices[iOut]], coeffs[iOut]);
+        outputRight[iOut] = sfz::interpolate<M>(&right[indices[iOut]], coeffs[iOut]);
+    }
+}
+
+template <size_t Points, class Kernel>
+static void doSincBlockInterpolation(Kernel&& kernel,
+    absl::Span<const float> left, absl::Span<const float> right,
+    absl::Span<float> outputLeft, absl::Span<float> outputRight,
+    absl::Span<const int> indices, absl::Span<const float> coeffs)
+{
+    const auto& ws = *sfz::SincInterpolatorTraits<Points>::windowedSinc;
+    kernel(ws.getTablePointer(), ws.getTableSize(), Points,
+        left.data(), right.data(), outputLeft.data(), outputRight.data(),
+        indices.data(), coeffs.data(), nullptr, indices.size());
+}
+
+#define ADD_STEREO_SINC_BENCHMARK(Points, Suffix, Kernel)                                \
+    BENCHMARK_DEFINE_F(Interpolators, Sinc##Points##Stereo##Suffix)                    \
+        (benchmark::State& state)                                                       \
+    {                                                                                   \
+        ScopedFTZ ftz;                                                                  \
+        for (auto _ : state) {                                                          \
+            doSincBlockInterpolation<Points>(Kernel,                                    \
+                input, inputRight, absl::MakeSpan(output), absl::MakeSpan(outputRight), \
+                indices, coeffs);                                                       \
+        }                                                                               \
+    }                                                                                   \
+    BENCHMARK_REGISTER_F(Interpolators, Sinc##Points##Stereo##Suffix)                   \
+        ->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+
+// Stereo: frame by frame and channel by channel
+// StereoBlock: block kernel, with the default dispatch
+// StereoBlock<ISA>: block kernel, for a specific instruction set
+#define ADD_STEREO_SINC_BENCHMARKS(Points)                                              \
+    BENCHMARK_DEFINE_F(Interpolators, Sinc##Points##Stereo)(benchmark::State& state)    \
+    {                                                                                   \
+        ScopedFTZ ftz;                                                                  \
+        for (auto _ : state) {                                                          \
+            doStereoInterpolation<sfz::kInterpolatorSinc##Points>(                      \
+                input, inputRight, absl::MakeSpan(output), absl::MakeSpan(outputRight), \
+                indices, coeffs);                                                       \
+        }                                                                               \
+    }                                                                                   \
+    BENCHMARK_REGISTER_F(Interpolators, Sinc##Points##Stereo)                           \
+        ->RangeMultiplier(4)->Range(1 << 4, 1 << 12);                                   \
+    ADD_STEREO_SINC_BENCHMARK(Points, Block, sfz::sincInterpolate)                      \
+    ADD_STEREO_SINC_BENCHMARK(Points, BlockScalar, sincInterpolateScalar<float>)        \
+    ADD_STEREO_SINC_BENCHMARKS_ISA(Points)
+
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+#define ADD_STEREO_SINC_BENCHMARKS_ISA(Points)                                          \
+    ADD_STEREO_SINC_BENCHMARK(Points, BlockSSE, sincInterpolateSSE)                     \
+    ADD_STEREO_SINC_BENCHMARK(Points, BlockAVX, sincInterpolateAVX)
+#elif SFIZZ_CPU_FAMILY_AARCH64 || SFIZZ_CPU_FAMILY_ARM
+#define ADD_STEREO_SINC_BENCHMARKS_ISA(Points)                                          \
+    ADD_STEREO_SINC_BENCHMARK(Points, BlockNEON, sincInterpolateNEON)
+#else
+#define ADD_STEREO_SINC_BENCHMARKS_ISA(Points)
+#endif
+
+ADD_STEREO_SINC_BENCHMARKS(8)
+ADD_STEREO_SINC_BENCHMARKS(12)
+ADD_STEREO_SINC_BENCHMARKS(16)
+ADD_STEREO_SINC_BENCHMARKS(24)
+ADD_STEREO_SINC_BENCHMARKS(36)
+ADD_STEREO_SINC_BENCHMARKS(48)
+ADD_STEREO_SINC_BENCHMARKS(60)
+ADD_STEREO_SINC_BENCHMARKS(72)
+
+template <sfz::InterpolatorModel M, class T>
+static void doStereoInterpolationOf(
+    absl::Span<const T> left, absl::Span<const T> right,
+    absl::Span<float> outputLeft, absl::Span<float> outputRight,
+    absl::Span<const int> indices, absl::Span<const float> coeffs)
+{
+    for (size_t iOut = 0; iOut < indices.size(); ++iOut) {
+        outputLeft[iOut] = sfz::interpolate<M>(&left[indices[iOut]], coeffs[iOut]);
+        outputRight[iOut] = sfz::interpolate<M>(&right[indices[iOut]], coeffs[iOut]);
+    }
+}
+
+// Stereo<Format>: block interpolation of the samples in memory, as the voices do
+// StereoInt16Frames: frame by frame, converting the windows as they are read
+#define ADD_SAMPLE_FORMAT_SINC_BENCHMARK(Points, Format, Left, Right)                   \
+    BENCHMARK_DEFINE_F(Interpolators, Sinc##Points##Stereo##Format)                    \
+        (benchmark::State& state)                                                       \
+    {                                                                                   \
+        ScopedFTZ ftz;                                                                  \
+        for (auto _ : state) {                                                          \
+            sfz::interpolateSincBlock(sfz::kInterpolatorSinc##Points,                   \
+                Left.data(), Right.data(), output.data(), outputRight.data(),           \
+                indices.data(), coeffs.data(), nullptr,                                 \
+                static_cast<unsigned>(indices.size()));                                 \
+        }                                                                               \
+    }                                                                                   \
+    BENCHMARK_REGISTER_F(Interpolators, Sinc##Points##Stereo##Format)                   \
+        ->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+
+#define ADD_SAMPLE_FORMAT_SINC_BENCHMARKS(Points)                                       \
+    ADD_SAMPLE_FORMAT_SINC_BENCHMARK(Points, Float, input, inputRight)                  \
+    ADD_SAMPLE_FORMAT_SINC_BENCHMARK(Points, Int16, inputInt16, inputInt16Right)        \
+    BENCHMARK_DEFINE_F(Interpolators, Sinc##Points##StereoInt16Frames)                 \
+        (benchmark::State& state)                                                       \
+    {                                                                                   \
+        ScopedFTZ ftz;                                                                  \
+        for (auto _ : state) {                                                          \
+            doStereoInterpolationOf<sfz::kInterpolatorSinc##Points, int16_t>(           \
+                inputInt16, inputInt16Right,                                            \
+                absl::MakeSpan(output), absl::MakeSpan(outputRight), indices, coeffs);  \
+        }                                                                               \
+    }                                                                                   \
+    BENCHMARK_REGISTER_F(Interpolators, Sinc##Points##StereoInt16Frames)                \
+        ->RangeMultiplier(4)->Range(1 << 4, 1 << 12);
+
+ADD_SAMPLE_FORMAT_SINC_BENCHMARKS(8)
+ADD_SAMPLE_FORMAT_SINC_BENCHMARKS(24)
+ADD_SAMPLE_FORMAT_SINC_BENCHMARKS(72)
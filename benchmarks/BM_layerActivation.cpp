@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Layer.h"
+#include "LayerActivationIndex.h"
+#include "MidiState.h"
+#include "absl/memory/memory.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// An articulation library: keyswitched articulations over the whole keyboard,
+// each with 4 velocity layers, and the first articulation selected
+constexpr int numVelocityLayers { 4 };
+
+class LayerActivation : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int numLayers = static_cast<int>(state.range(0));
+        layers.clear();
+        layers.reserve(numLayers);
+        for (int i = 0; i < numLayers; ++i) {
+            auto layer = absl::make_unique<sfz::Layer>(i, "", midiState);
+            sfz::Region& region = layer->getRegion();
+            const int velocityLayer = i % numVelocityLayers;
+            region.usesKeySwitches = true;
+            region.velocityRange.setStart(float(velocityLayer) / numVelocityLayers);
+            region.velocityRange.setEnd(float(velocityLayer + 1) / numVelocityLayers);
+            layer->initializeActivations();
+            layers.push_back(std::move(layer));
+        }
+
+        index.build(layers);
+        for (int i = 0; i < numVelocityLayers && i < numLayers; ++i)
+            layers[i]->setKeySwitched(true);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        index.clear();
+        layers.clear();
+    }
+
+    sfz::MidiState midiState;
+    std::vector<std::unique_ptr<sfz::Layer>> layers;
+    sfz::LayerActivationIndex index;
+    int note { 0 };
+};
+
+// Visit all the layers of the key, as the note on dispatch did before the index
+BENCHMARK_DEFINE_F(LayerActivation, Linear)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const int noteNumber = note++ % 128;
+        const float velocity = float(noteNumber) / 127;
+        int triggered = 0;
+        for (const auto& layer : layers)
+            triggered += layer->registerNoteOn(noteNumber, velocity, 0.5f);
+        benchmark::DoNotOptimize(triggered);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(LayerActivation, Indexed)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const int noteNumber = note++ % 128;
+        const float velocity = float(noteNumber) / 127;
+        int triggered = 0;
+        index.forEachCandidate(noteNumber, velocity, [&](sfz::Layer* layer) {
+            triggered += layer->registerNoteOn(noteNumber, velocity, 0.5f);
+        });
+        benchmark::DoNotOptimize(triggered);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(LayerActivation, Linear)->RangeMultiplier(4)->Range(16, 16384);
+BENCHMARK_REGISTER_F(LayerActivation, Indexed)->RangeMultiplier(4)->Range(16, 16384);
+BENCHMARK_MAIN();
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Synth.h"
+#include "AudioBuffer.h"
+#include <benchmark/benchmark.h>
+
+// Render large blocks, as an offline render does, with a number of filtered
+// and modulated voices; the argument is the render quantum, 0 being the whole
+// block at once.
+constexpr int blockSize { 8192 };
+constexpr int numNotes { 32 };
+
+class RenderQuantum : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSamplesPerBlock(blockSize);
+        synth.setSampleRate(48000.0f);
+        synth.setNumVoices(numNotes);
+        synth.setRenderQuantum(static_cast<int>(state.range(0)));
+        synth.loadSfzString("/quantum.sfz", R"(
+            <region> sample=*saw
+                fil_type=lpf_2p cutoff=2000 resonance=6
+                lfo1_freq=3 lfo1_cutoff=1200
+                ampeg_attack=0.1 ampeg_release=1
+        )");
+        for (int i = 0; i < numNotes; ++i)
+            synth.noteOn(i * blockSize / numNotes, 36 + i, 100);
+    }
+
+    void TearDown(const ::benchmark::State& /* state */)
+    {
+        synth.allSoundOff();
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, blockSize };
+};
+
+BENCHMARK_DEFINE_F(RenderQuantum, Render)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSample(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+BENCHMARK_REGISTER_F(RenderQuantum, Render)->Arg(0)->Arg(64)->Arg(128)->Arg(256)->Arg(1024);
+BENCHMARK_MAIN();
@@ -36,19 +36,26 @@
 #include <jack/midiport.h>
 #include <jack/types.h>
 #include <ostream>
+#include <string>
 #include <signal.h>
 #include <string_view>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <algorithm>
+#include <array>
 #include <vector>
 
 sfz::Sfizz synth;
 
+// One port per channel, in stereo pairs; this covers the range of the `output` opcode
+constexpr unsigned maxOutputPorts = 32;
+
 static jack_port_t* midiInputPort;
-static jack_port_t* outputPort1;
-static jack_port_t* outputPort2;
+static std::array<jack_port_t*, maxOutputPorts> outputPorts {};
+static std::atomic<unsigned> numOutputPorts { 0 };
+static unsigned numRegisteredPorts = 0;
+static bool multiOutput = false;
 static jack_client_t* client;
 static SpinMutex processMutex;
 
@@ -59,13 +66,16 @@ int process(jack_nframes_t numFrames, void* arg)
     auto* buffer = jack_port_get_buffer(midiInputPort, numFrames);
     assert(buffer);
 
-    auto* leftOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort1, numFrames));
-    auto* rightOutput = reinterpret_cast<float*>(jack_port_get_buffer(outputPort2, numFrames));
+    // The synth renders directly into the port buffers
+    const unsigned numPorts = numOutputPorts.load(std::memory_order_acquire);
+    std::array<float*, maxOutputPorts> outputs;
+    for (unsigned i = 0; i < numPorts; ++i)
+        outputs[i] = reinterpret_cast<float*>(jack_port_get_buffer(outputPorts[i], numFrames));
 
     std::unique_lock<SpinMutex> lock { processMutex, std::try_to_lock };
     if (!lock.owns_lock()) {
-        std::fill_n(leftOutput, numFrames, 0.0f);
-        std::fill_n(rightOutput, numFrames, 0.0f);
+        for (unsigned i = 0; i < numPorts; ++i)
+            std::fill_n(outputs[i], numFrames, 0.0f);
         return 0;
     }
 
@@ -110,8 +120,7 @@ int process(jack_nframes_t numFrames, void* arg)
         }
     }
 
-    float* stereoOutput[] = { leftOutput, rightOutput };
-    synth->renderBlock(stereoOutput, numFrames);
+    synth->renderBlock(outputs.data(), numFrames, static_cast<int>(numPorts / 2));
 
     return 0;
 }
@@ -152,14 +161,46 @@ static void done(int sig)
     // exit(0);
 }
 
-bool loadInstrument(const char* fpath)
+/**
+ * @brief Register the output ports up to the given number of stereo pairs.
+ * The ports are never unregistered, to keep their connections.
+ */
+bool registerOutputPorts(unsigned numPairs)
+{
+    const unsigned numPorts = std::min(2 * numPairs, maxOutputPorts);
+    for (; numRegisteredPorts < numPorts; ++numRegisteredPorts) {
+        const std::string name = "output_" + std::to_string(numRegisteredPorts + 1);
+        jack_port_t* port = jack_port_register(client, name.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        if (port == nullptr) {
+            std::cerr << "Could not open output port " << name << '\n';
+            break;
+        }
+        outputPorts[numRegisteredPorts] = port;
+    }
+
+    // Publish whole stereo pairs to the audio thread
+    numOutputPorts.store(numRegisteredPorts & ~1u, std::memory_order_release);
+    return numRegisteredPorts >= numPorts;
+}
+
+bool loadInstrument(const char* fpath, bool staged = false)
 {
     const char* importFormat = nullptr;
-    if (!sfizz_load_or_import_file(synth.handle(), fpath, &importFormat)) {
+    const bool loaded = staged ?
+        sfizz_stage_or_import_file(synth.handle(), fpath, &importFormat) :
+        sfizz_load_or_import_file(synth.handle(), fpath, &importFormat);
+    if (!loaded) {
         std::cout << "Could not load the instrument file: " << fpath << '\n';
         return false;
     }
 
+    // Wait for the audio thread to switch to the staged instrument
+    while (staged && synth.hasStagedState() && !shouldClose)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if (multiOutput)
+        registerOutputPorts(static_cast<unsigned>(synth.getNumOutputs()));
+
     std::cout << "Instrument loaded: " << fpath << '\n';
     std::cout << "===========================" << '\n';
     std::cout << "Total:" << '\n';
@@ -168,6 +209,7 @@ bool loadInstrument(const char* fpath)
     std::cout << "\tRegions: " << synth.getNumRegions() << '\n';
     std::cout << "\tCurves: " << synth.getNumCurves() << '\n';
     std::cout << "\tPreloadedSamples: " << synth.getNumPreloadedSamples() << '\n';
+    std::cout << "\tOutputs: " << synth.getNumOutputs() << '\n';
 #if 0 // not currently in public API
     std::cout << "===========================" << '\n';
     std::cout << "Included files:" << '\n';
@@ -233,8 +275,7 @@ void cliThreadProc()
 
         if (kw == "load_instrument") {
             try {
-                std::lock_guard<SpinMutex> lock { processMutex };
-                loadInstrument(tokens[0].c_str());
+                loadInstrument(tokens[0].c_str(), true);
             } catch (...) {
                 std::cout << "ERROR: Can't load instrument!\n";
             }
@@ -267,12 +308,77 @@ void cliThreadProc()
     }
 }
 
+class LatencyWatcher {
+public:
+    explicit LatencyWatcher(double loadWarning)
+        : loadWarning(loadWarning)
+    {
+    }
+
+    // Report the deadline misses, the high loads and the late streams since
+    // the last check
+    void check(sfz::Sfizz& synth)
+    {
+        const sfz::Sfizz::LatencyStats stats = synth.getLatencyStats();
+        histogram.resize(stats.numBins);
+        lastHistogram.resize(stats.numBins);
+        synth.getLatencyHistogram(histogram.data(), stats.numBins);
+
+        if (stats.numDeadlineMisses > lastMisses) {
+            const uint64_t numNew = stats.numDeadlineMisses - lastMisses;
+            misses.resize(std::min<uint64_t>(numNew, 16));
+            const int numRead = synth.getDeadlineMisses(misses.data(), static_cast<int>(misses.size()));
+            std::cout << "WARNING: " << numNew << " deadline miss(es), xruns are likely\n";
+            for (int i = numRead - 1; i >= 0; --i) {
+                const sfz::Sfizz::DeadlineMiss& miss = misses[i];
+                std::cout << "- Block " << miss.block << ": " << miss.duration * 1e3
+                          << " ms for " << miss.budget * 1e3 << " ms, "
+                          << miss.numVoices << " voices, " << miss.numEvents << " events\n";
+            }
+        }
+
+        if (loadWarning > 0.0) {
+            uint64_t numHighLoads = 0;
+            for (int i = 0; i < stats.numBins; ++i) {
+                if (i * stats.binWidth >= loadWarning && i * stats.binWidth < 1.0)
+                    numHighLoads += histogram[i] - std::min(histogram[i], lastHistogram[i]);
+            }
+            if (numHighLoads > 0)
+                std::cout << "WARNING: " << numHighLoads << " block(s) above "
+                          << loadWarning * 100 << "% load, close to an xrun\n";
+        }
+
+        if (stats.numStreamUnderruns > lastUnderruns)
+            std::cout << "WARNING: " << stats.numStreamUnderruns - lastUnderruns
+                      << " stream underrun(s), the disk could not keep up\n";
+
+        lastMisses = stats.numDeadlineMisses;
+        lastUnderruns = stats.numStreamUnderruns;
+        std::swap(histogram, lastHistogram);
+    }
+
+private:
+    double loadWarning { 0.0 };
+    uint64_t lastMisses { 0 };
+    uint64_t lastUnderruns { 0 };
+    std::vector<uint64_t> histogram;
+    std::vector<uint64_t> lastHistogram;
+    std::vector<sfz::Sfizz::DeadlineMiss> misses;
+};
+
 ABSL_FLAG(std::string, client_name, "sfizz", "Jack client name");
 ABSL_FLAG(std::string, oversampling, "1x", "Internal oversampling factor (value values are x1, x2, x4, x8)");
 ABSL_FLAG(uint32_t, preload_size, 8192, "Preloaded size");
 ABSL_FLAG(uint32_t, num_voices, 32, "Num of voices");
+ABSL_FLAG(bool, stream, false, "Stream the samples from disk instead of loading them in memory");
+ABSL_FLAG(bool, compressed, false, "Keep the samples in memory as stored on disk and decode them while playing");
+ABSL_FLAG(std::string, sample_format, "float", "Format of the preloaded samples in memory (valid values are float, int16, int24)");
+ABSL_FLAG(bool, share_samples, false, "Share the preloaded samples with the other instances of the process");
+ABSL_FLAG(std::string, preload_cache, "", "Directory of the persistent preload cache");
 ABSL_FLAG(bool, jack_autoconnect, false, "Autoconnect audio output");
+ABSL_FLAG(bool, multi_output, false, "Expose each stereo output of the instrument as a pair of ports");
 ABSL_FLAG(bool, state, false, "Output the synth state in the jack loop");
+ABSL_FLAG(double, load_warning, 0.8, "Warn about the blocks above this ratio of render time to block duration (0 to disable)");
 
 int main(int argc, char** argv)
 {
@@ -283,16 +389,30 @@ int main(int argc, char** argv)
     const std::string oversampling = absl::GetFlag(FLAGS_oversampling);
     const uint32_t preload_size = absl::GetFlag(FLAGS_preload_size);
     const uint32_t num_voices = absl::GetFlag(FLAGS_num_voices);
+    const bool stream = absl::GetFlag(FLAGS_stream);
+    const bool compressed = absl::GetFlag(FLAGS_compressed);
+    const std::string sampleFormat = absl::GetFlag(FLAGS_sample_format);
+    const bool shareSamples = absl::GetFlag(FLAGS_share_samples);
+    const std::string preloadCache = absl::GetFlag(FLAGS_preload_cache);
     const bool jack_autoconnect = absl::GetFlag(FLAGS_jack_autoconnect);
+    multiOutput = absl::GetFlag(FLAGS_multi_output);
     const bool verboseState = absl::GetFlag(FLAGS_state);
+    const double loadWarning = absl::GetFlag(FLAGS_load_warning);
 
     std::cout << "Flags" << '\n';
     std::cout << "- Client name: " << clientName << '\n';
     std::cout << "- Oversampling: " << oversampling << '\n';
     std::cout << "- Preloaded size: " << preload_size << '\n';
     std::cout << "- Num of voices: " << num_voices << '\n';
+    std::cout << "- Sample streaming: " << stream << '\n';
+    std::cout << "- Compressed sample storage: " << compressed << '\n';
+    std::cout << "- Sample format: " << sampleFormat << '\n';
+    std::cout << "- Sample sharing: " << shareSamples << '\n';
+    std::cout << "- Preload cache: " << preloadCache << '\n';
     std::cout << "- Audio Autoconnect: " << jack_autoconnect << '\n';
+    std::cout << "- Multiple outputs: " << multiOutput << '\n';
     std::cout << "- Verbose State: " << verboseState << '\n';
+    std::cout << "- Load warning: " << loadWarning << '\n';
 
     const auto factor = [&]() {
         if (oversampling == "x1") return 1;
@@ -302,6 +422,12 @@ int main(int argc, char** argv)
         return 1;
     }();
 
+    const auto format = [&]() {
+        if (sampleFormat == "int16") return sfz::Sfizz::SampleInt16;
+        if (sampleFormat == "int24") return sfz::Sfizz::SampleInt24;
+        return sfz::Sfizz::SampleFloat;
+    }();
+
     std::cout << "Positional arguments:";
     for (auto& file : filesToParse)
         std::cout << " " << file << ',';
@@ -310,6 +436,15 @@ int main(int argc, char** argv)
     synth.setOversamplingFactor(factor);
     synth.setPreloadSize(preload_size);
     synth.setNumVoices(num_voices);
+    if (stream)
+        synth.enableSampleStreaming();
+    if (compressed)
+        synth.enableCompressedSampleStorage();
+    synth.setSampleFormat(format);
+    if (shareSamples)
+        synth.enableSampleSharing();
+    if (!preloadCache.empty())
+        synth.setPreloadCacheDirectory(preloadCache);
 
     jack_status_t status;
     client = jack_client_open(clientName.c_str(), JackNullOption, &status);
@@ -340,9 +475,7 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    outputPort1 = jack_port_register(client, "output_1", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    outputPort2 = jack_port_register(client, "output_2", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    if (outputPort1 == nullptr || outputPort2 == nullptr) {
+    if (!registerOutputPorts(1)) {
         std::cerr << "Could not open output ports" << '\n';
         return 1;
     }
@@ -359,11 +492,11 @@ int main(int argc, char** argv)
             return 1;
         }
 
-        if (jack_connect(client, jack_port_name(outputPort1), systemPorts[0])) {
+        if (jack_connect(client, jack_port_name(outputPorts[0]), systemPorts[0])) {
             std::cerr << "Cannot connect to physical output ports (0)" << '\n';
         }
 
-        if (jack_connect(client, jack_port_name(outputPort2), systemPorts[1])) {
+        if (jack_connect(client, jack_port_name(outputPorts[1]), systemPorts[1])) {
             std::cerr << "Cannot connect to physical output ports (1)" << '\n';
         }
         jack_free(systemPorts);
@@ -380,7 +513,9 @@ int main(int argc, char** argv)
     signal(SIGTERM, done);
     signal(SIGQUIT, done);
 
+    LatencyWatcher latencyWatcher(loadWarning);
     while (!shouldClose) {
+        latencyWatcher.check(synth);
         if (verboseState) {
             std::cout << "Active voices: " << synth.getNumActiveVoices() << '\n';
 #ifndef NDEBUG
@@ -3,6 +3,7 @@
 #include "sfizz/MathHelpers.h"
 #include "sfizz/SfzHelpers.h"
 #include "sfizz/SIMDHelpers.h"
+#include "sfizz/Profiler.h"
 #include "sfizz/utility/U8Strings.h"
 #include "MidiHelpers.h"
 #include <st_audiofile_libs.h>
@@ -10,6 +11,8 @@
 #include <fmidi/fmidi.h>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <string>
 
 #define LOG_ERROR(ostream) std::cerr  << ostream << '\n'
 #define LOG_INFO(ostream) if (verbose) { std::cout << ostream << '\n'; }
@@ -61,6 +64,35 @@ void finishedCallback(void * cbdata)
     data->finished = true;
 }
 
+/**
+ * @brief Convert a stereo pair of float channels to interleaved 16-bit PCM,
+ * in a single pass and with the same rounding as `drwav_f32_to_s16`.
+ */
+void stereoToInterleavedPcm16(const float* left, const float* right, int16_t* output, unsigned numFrames)
+{
+    auto toPcm16 = [](float x) {
+        const float c = ((x < -1) ? -1 : ((x > 1) ? 1 : x)) + 1;
+        return static_cast<int16_t>(static_cast<int>(c * 32767.5f) - 32768);
+    };
+
+    for (unsigned i = 0; i < numFrames; ++i) {
+        *output++ = toPcm16(left[i]);
+        *output++ = toPcm16(right[i]);
+    }
+}
+
+/**
+ * @brief Get the path of the file for the stereo output with the given index,
+ * as in the `output` opcode.
+ */
+fs::path stemPath(const fs::path& outputPath, int outputIndex)
+{
+    fs::path path = outputPath;
+    path.replace_filename(
+        outputPath.stem().string() + "_output" + std::to_string(outputIndex) + outputPath.extension().string());
+    return path;
+}
+
 int main(int argc, char** argv)
 {
     cxxopts::Options options("sfizz-render", "Render a midi file through an SFZ file using the sfizz library.");
@@ -72,6 +104,10 @@ int main(int argc, char** argv)
     bool useEOT { false };
     int quality { 2 };
     int polyphony { 64 };
+    int numThreads { 1 };
+    int quantum { 0 };
+    bool parallelEffects { false };
+    bool stems { false };
 
     options.add_options()
         ("sfz", "SFZ file", cxxopts::value<std::string>())
@@ -81,9 +117,14 @@ int main(int argc, char** argv)
         ("s,samplerate", "Output sample rate", cxxopts::value(sampleRate))
         ("q,quality", "Resampling quality", cxxopts::value(quality))
         ("p,polyphony", "Polyphony max", cxxopts::value(polyphony))
+        ("t,threads", "Number of voice rendering threads", cxxopts::value(numThreads))
+        ("quantum", "Render the blocks by sub-blocks of this size", cxxopts::value(quantum))
+        ("parallel-effects", "Process the effect buses on the rendering threads", cxxopts::value(parallelEffects))
         ("v,verbose", "Verbose output", cxxopts::value(verbose))
         ("log", "Produce logs", cxxopts::value<std::string>())
+        ("profile", "Write the timings of each voice to a CSV file", cxxopts::value<std::string>())
         ("use-eot", "End the rendering at the last End of Track Midi message", cxxopts::value(useEOT))
+        ("stems", "Write each stereo output of the instrument to its own WAV file", cxxopts::value(stems))
         ("h,help", "Show help", cxxopts::value(help))
     ;
     auto params = [&]() {
@@ -122,12 +163,21 @@ int main(int argc, char** argv)
     LOG_INFO("Block size: " << blockSize);
     LOG_INFO("Sample rate: " << sampleRate);
     LOG_INFO("Polyphony Max: " << polyphony);
+    LOG_INFO("Render threads: " << numThreads);
+    if (quantum > 0)
+        LOG_INFO("Render quantum: " << quantum);
+    if (parallelEffects)
+        LOG_INFO("Parallel effect buses");
 
     sfz::Synth synth;
     synth.setSamplesPerBlock(blockSize);
     synth.setSampleRate(sampleRate);
     synth.setSampleQuality(sfz::Synth::ProcessMode::ProcessFreewheeling, quality);
     synth.setNumVoices(polyphony);
+    synth.setNumRenderThreads(numThreads);
+    synth.setRenderQuantum(quantum);
+    if (parallelEffects)
+        synth.enableParallelEffects();
     synth.enableFreeWheeling();
 
     bool logging = params.count("log") > 0;
@@ -163,6 +213,61 @@ int main(int argc, char** argv)
                         << blockSize << '\n';
     };
 
+    bool profiling = params.count("profile") > 0;
+    std::ofstream profileFile {};
+    if (profiling) {
+        fs::path profilePath { fs::current_path() / params["profile"].as<std::string>() };
+        profileFile.open(profilePath.string());
+
+        if (profileFile.is_open()) {
+            profileFile << "Block,NumFrames,Dispatch,RenderMethod,Effects,"
+                        << "Voice,Region,SampleQuality,NumFilters,NumEQs,NumLFOs,"
+                        << "Data,Amplitude,Filters,Panning" << '\n';
+            synth.enableProfiling();
+        } else {
+            profiling = false;
+            LOG_INFO("Error opening profile file " << profilePath.string() << "; profiling will be disabled");
+        }
+    }
+
+    // The render calls can record several blocks with sub-block rendering
+    uint64_t numProfiledBlocks { 0 };
+    auto writeProfileLines = [&] {
+        if (!profiling)
+            return;
+
+        const sfz::Profiler& profiler = synth.getProfiler();
+        const uint64_t numBlocks = profiler.getNumBlocks();
+        for (uint64_t age = numBlocks - numProfiledBlocks; age-- > 0; ) {
+            sfz::BlockProfile block;
+            if (!profiler.getBlock(static_cast<unsigned>(age), block))
+                continue;
+
+            for (unsigned i = 0; i < block.numVoices; ++i) {
+                sfz::VoiceProfile voice;
+                if (!profiler.getVoice(static_cast<unsigned>(age), i, voice))
+                    continue;
+
+                profileFile << block.index << ','
+                            << block.numFrames << ','
+                            << block.dispatch << ','
+                            << block.renderMethod << ','
+                            << block.effects << ','
+                            << voice.voiceId << ','
+                            << voice.regionId << ','
+                            << int(voice.sampleQuality) << ','
+                            << int(voice.numFilters) << ','
+                            << int(voice.numEQs) << ','
+                            << int(voice.numLFOs) << ','
+                            << voice.data << ','
+                            << voice.amplitude << ','
+                            << voice.filters << ','
+                            << voice.panning << '\n';
+            }
+        }
+        numProfiledBlocks = numBlocks;
+    };
+
     ERROR_IF(!synth.loadSfzFile(sfzPath), "There was an error loading the SFZ file.");
     LOG_INFO(synth.getNumRegions() << " regions in the SFZ.");
 
@@ -178,7 +283,13 @@ int main(int argc, char** argv)
         LOG_INFO("-- Cutting the rendering at the last MIDI End of Track message");
     }
 
-    drwav outputFile;
+    // One stereo file per output with `--stems`, otherwise the outputs wrap
+    // around a single stereo pair
+    const int numOutputs = stems ? synth.getNumOutputs() : 1;
+    if (stems) {
+        LOG_INFO("Writing " << numOutputs << " stereo outputs to separate files");
+    }
+
     drwav_data_format outputFormat {};
     outputFormat.container = drwav_container_riff;
     outputFormat.format = DR_WAVE_FORMAT_PCM;
@@ -186,50 +297,69 @@ int main(int argc, char** argv)
     outputFormat.sampleRate = sampleRate;
     outputFormat.bitsPerSample = 16;
 
+    std::unique_ptr<drwav[]> outputFiles { new drwav[numOutputs] };
+    std::vector<fs::path> outputPaths;
+    for (int i = 0; i < numOutputs; ++i) {
+        outputPaths.push_back(stems ? stemPath(outputPath, i) : outputPath);
+        const fs::path& path = outputPaths.back();
 #if !defined(_WIN32)
-    drwav_bool32 outputFileOk = drwav_init_file_write(&outputFile, outputPath.c_str(), &outputFormat, nullptr);
+        drwav_bool32 outputFileOk = drwav_init_file_write(&outputFiles[i], path.c_str(), &outputFormat, nullptr);
 #else
-    drwav_bool32 outputFileOk = drwav_init_file_write_w(&outputFile, outputPath.c_str(), &outputFormat, nullptr);
+        drwav_bool32 outputFileOk = drwav_init_file_write_w(&outputFiles[i], path.c_str(), &outputFormat, nullptr);
 #endif
-    ERROR_IF(!outputFileOk, "Error opening the wav file for writing");
+        ERROR_IF(!outputFileOk, "Error opening the wav file " << path.string() << " for writing");
+    }
 
     auto sampleRateDouble = static_cast<double>(sampleRate);
     const double increment { 1.0 / sampleRateDouble };
     uint64_t numFramesWritten { 0 };
-    sfz::AudioBuffer<float> audioBuffer { 2, blockSize };
-    sfz::Buffer<float> interleavedBuffer { 2 * blockSize };
+    sfz::AudioBuffer<float> audioBuffer { static_cast<size_t>(2 * numOutputs), blockSize };
     sfz::Buffer<int16_t> interleavedPcm { 2 * blockSize };
 
+    // Write the rendered block, and get its average power over all outputs
+    auto writeBlock = [&]() {
+        float power = 0.0f;
+        for (int i = 0; i < numOutputs; ++i) {
+            auto left = audioBuffer.getConstSpan(2 * i);
+            auto right = audioBuffer.getConstSpan(2 * i + 1);
+            stereoToInterleavedPcm16(left.data(), right.data(), interleavedPcm.data(), blockSize);
+            const auto numFrames = drwav_write_pcm_frames(&outputFiles[i], blockSize, interleavedPcm.data());
+            if (i == 0)
+                numFramesWritten += numFrames;
+            power += sfz::meanSquared<float>(left) + sfz::meanSquared<float>(right);
+        }
+        return power / (2 * numOutputs);
+    };
+
     fmidi_player_u midiPlayer { fmidi_player_new(midiFile.get()) };
     CallbackData callbackData { synth, 0, false };
     fmidi_player_event_callback(midiPlayer.get(), &midiCallback, &callbackData);
     fmidi_player_finish_callback(midiPlayer.get(), &finishedCallback, &callbackData);
 
+    float averagePower = 0.0f;
     fmidi_player_start(midiPlayer.get());
     while (!callbackData.finished) {
         for (callbackData.delay = 0; callbackData.delay < blockSize && !callbackData.finished; callbackData.delay++)
             fmidi_player_tick(midiPlayer.get(), increment);
         synth.renderBlock(audioBuffer);
-        sfz::writeInterleaved(audioBuffer.getConstSpan(0), audioBuffer.getConstSpan(1), absl::MakeSpan(interleavedBuffer));
-        drwav_f32_to_s16(interleavedPcm.data(), interleavedBuffer.data(), 2 * blockSize);
-        numFramesWritten += drwav_write_pcm_frames(&outputFile, blockSize, interleavedPcm.data());
+        averagePower = writeBlock();
         writeLogLine();
+        writeProfileLines();
     }
 
     if (!useEOT) {
-        auto averagePower = sfz::meanSquared<float>(interleavedBuffer);
         while (averagePower > 1e-12f) {
             synth.renderBlock(audioBuffer);
-            sfz::writeInterleaved(audioBuffer.getConstSpan(0), audioBuffer.getConstSpan(1), absl::MakeSpan(interleavedBuffer));
-            drwav_f32_to_s16(interleavedPcm.data(), interleavedBuffer.data(), 2 * blockSize);
-            numFramesWritten += drwav_write_pcm_frames(&outputFile, blockSize, interleavedPcm.data());
+            averagePower = writeBlock();
             writeLogLine();
-            averagePower = sfz::meanSquared<float>(interleavedBuffer);
+            writeProfileLines();
         }
     }
 
-    drwav_uninit(&outputFile);
-    LOG_INFO("Wrote " << numFramesWritten << " frames of sound data in" << outputPath.string());
+    for (int i = 0; i < numOutputs; ++i) {
+        drwav_uninit(&outputFiles[i]);
+        LOG_INFO("Wrote " << numFramesWritten << " frames of sound data in " << outputPaths[i].string());
+    }
 
     return 0;
 }
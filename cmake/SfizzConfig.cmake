@@ -147,6 +147,10 @@ if(SFIZZ_ASAN)
     add_link_options($<$<COMPILE_LANGUAGE:C,CXX>:-fno-omit-frame-pointer>)
 endif()
 
+if(SFIZZ_RT_CHECKS AND SFIZZ_ASAN)
+    message(FATAL_ERROR "The real-time checks replace the allocator, they cannot be used with ASAN")
+endif()
+
 # Don't show build information when building a different project
 function(show_build_info_if_needed)
     if(PROJECT_IS_MAIN)
@@ -170,6 +174,7 @@ Statically link sndfile:       ${SFIZZ_SNDFILE_STATIC}
 Use clang libc++:              ${USE_LIBCPP}
 Release asserts:               ${SFIZZ_RELEASE_ASSERTS}
 Use ASAN:                      ${SFIZZ_ASAN}
+Real-time checks:              ${SFIZZ_RT_CHECKS}
 
 Use system abseil-cpp:         ${SFIZZ_USE_SYSTEM_ABSEIL}
 Use system catch:              ${SFIZZ_USE_SYSTEM_CATCH}
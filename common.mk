@@ -53,6 +53,7 @@ SFIZZ_SOURCES = \
 	src/sfizz/Defaults.cpp \
 	src/sfizz/effects/Apan.cpp \
 	src/sfizz/Effects.cpp \
+	src/sfizz/EventQueue.cpp \
 	src/sfizz/modulations/ModId.cpp \
 	src/sfizz/modulations/ModKey.cpp \
 	src/sfizz/modulations/ModKeyHash.cpp \
@@ -64,12 +65,14 @@ SFIZZ_SOURCES = \
 	src/sfizz/modulations/sources/FlexEnvelope.cpp \
 	src/sfizz/modulations/sources/LFO.cpp \
 	src/sfizz/effects/Compressor.cpp \
+	src/sfizz/effects/Convolution.cpp \
 	src/sfizz/effects/Disto.cpp \
 	src/sfizz/effects/Eq.cpp \
 	src/sfizz/effects/Filter.cpp \
 	src/sfizz/effects/Fverb.cpp \
 	src/sfizz/effects/Gain.cpp \
 	src/sfizz/effects/Gate.cpp \
+	src/sfizz/effects/impl/PartitionedConvolver.cpp \
 	src/sfizz/effects/impl/ResonantArrayAVX.cpp \
 	src/sfizz/effects/impl/ResonantArray.cpp \
 	src/sfizz/effects/impl/ResonantArraySSE.cpp \
@@ -86,13 +89,16 @@ SFIZZ_SOURCES = \
 	src/sfizz/FileId.cpp \
 	src/sfizz/FileMetadata.cpp \
 	src/sfizz/FilePool.cpp \
+	src/sfizz/FilterBank.cpp \
 	src/sfizz/FilterPool.cpp \
 	src/sfizz/FlexEGDescription.cpp \
 	src/sfizz/FlexEnvelope.cpp \
 	src/sfizz/Interpolators.cpp \
 	src/sfizz/Layer.cpp \
+	src/sfizz/LayerActivationIndex.cpp \
 	src/sfizz/LFO.cpp \
 	src/sfizz/LFODescription.cpp \
+	src/sfizz/MappedFile.cpp \
 	src/sfizz/Messaging.cpp \
 	src/sfizz/Metronome.cpp \
 	src/sfizz/MidiState.cpp \
@@ -104,11 +110,17 @@ SFIZZ_SOURCES = \
 	src/sfizz/parser/ParserPrivate.cpp \
 	src/sfizz/PolyphonyGroup.cpp \
 	src/sfizz/PowerFollower.cpp \
+	src/sfizz/PreloadCache.cpp \
+	src/sfizz/SampleStore.cpp \
 	src/sfizz/Region.cpp \
 	src/sfizz/RegionSet.cpp \
 	src/sfizz/RegionStateful.cpp \
 	src/sfizz/Resources.cpp \
 	src/sfizz/RTSemaphore.cpp \
+	src/sfizz/RTChecks.cpp \
+	src/sfizz/Profiler.cpp \
+	src/sfizz/LatencyMonitor.cpp \
+	src/sfizz/RTWorkerPool.cpp \
 	src/sfizz/ScopedFTZ.cpp \
 	src/sfizz/sfizz.cpp \
 	src/sfizz/sfizz_wrapper.cpp \
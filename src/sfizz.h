@@ -81,6 +81,16 @@ typedef enum {
     SFIZZ_PROCESS_FREEWHEELING,
 } sfizz_process_mode_t;
 
+/**
+ * @brief Format of the preloaded samples in memory
+ * @since 1.3.0
+ */
+typedef enum {
+    SFIZZ_SAMPLE_FORMAT_FLOAT,
+    SFIZZ_SAMPLE_FORMAT_INT16,
+    SFIZZ_SAMPLE_FORMAT_INT24,
+} sfizz_sample_format_t;
+
 /**
  * @brief Creates a sfizz synth.
  *
@@ -147,6 +157,63 @@ SFIZZ_EXPORTED_API bool sfizz_load_file(sfizz_synth_t* synth, const char* path);
  */
 SFIZZ_EXPORTED_API bool sfizz_load_string(sfizz_synth_t* synth, const char* path, const char* text);
 
+/**
+ * @brief Loads an SFZ file in the background, while the current instrument
+ *        keeps playing.
+ *
+ * The instrument is loaded into a separate state, which takes the current
+ * engine settings and MIDI state. The audio thread switches to it at the end of
+ * the next call to a render function, and the previous state is destroyed on a
+ * background thread. A staged instrument which was not adopted yet is replaced.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param path   A null-terminated string representing a path to an SFZ file.
+ *
+ * @return @true when file loading went OK,
+ *         @false if some error occured while loading, in which case the
+ *         current instrument is kept.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread, and may run
+ *   concurrently with @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_stage_file(sfizz_synth_t* synth, const char* path);
+
+/**
+ * @brief Loads an SFZ file from textual data in the background, while the
+ *        current instrument keeps playing.
+ *
+ * This is similar to sfizz_stage_file() in functionality.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param path   The virtual path of the SFZ file.
+ * @param text   The contents of the virtual SFZ file.
+ *
+ * @return @true when file loading went OK,
+ *         @false if some error occured while loading, in which case the
+ *         current instrument is kept.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread, and may run
+ *   concurrently with @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_stage_string(sfizz_synth_t* synth, const char* path, const char* text);
+
+/**
+ * @brief Check whether a staged instrument is waiting to be adopted by the
+ *        audio thread.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread, and may run
+ *   concurrently with @b RT functions
+ */
+SFIZZ_EXPORTED_API bool sfizz_has_staged_state(sfizz_synth_t* synth);
+
 /**
  * @brief Sets the tuning from a Scala file loaded from the file system.
  * @since 0.4.0
@@ -269,6 +336,18 @@ SFIZZ_EXPORTED_API int sfizz_get_num_masters(sfizz_synth_t* synth);
  */
 SFIZZ_EXPORTED_API int sfizz_get_num_curves(sfizz_synth_t* synth);
 
+/**
+ * @brief Return the number of stereo outputs used by the currently loaded SFZ
+ *        file, which is one more than the highest `output` opcode.
+ *
+ * Render at least twice this number of channels with `sfizz_render_block`
+ * to get every output on its own stereo pair.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_num_outputs(sfizz_synth_t* synth);
+
 /**
  * @brief Export a MIDI Name document describing the currently loaded SFZ file.
  * @since 0.3.1
@@ -703,6 +782,65 @@ SFIZZ_EXPORTED_API void sfizz_send_time_position(sfizz_synth_t* synth, int delay
  */
 SFIZZ_EXPORTED_API void sfizz_send_playback_state(sfizz_synth_t* synth, int delay, int playback_state);
 
+/**
+ * @brief Post a MIDI message from any thread.
+ *
+ * The message goes through a lock-free queue, which several threads can feed
+ * at once, and is dispatched at its frame by the call to sfizz_render_block()
+ * which covers it. Unlike the sfizz_send_* functions, this does not need to be
+ * called from the Real-time thread nor before the block.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param frame  The frame at which the event occurs, on the clock given by
+ *               sfizz_get_frame_time(); a negative value means at the start of
+ *               the next block. A frame which is already past is dispatched at
+ *               the start of the next block.
+ * @param data   A MIDI 1.0 channel voice message; the channel is ignored.
+ * @param size   The size of the message.
+ *
+ * @return @false if the message is not supported or the queue is full.
+ *
+ * @par Thread-safety constraints
+ * - the function can be invoked from any thread, concurrently with any other
+ *   function
+ */
+SFIZZ_EXPORTED_API bool sfizz_post_midi_event(sfizz_synth_t* synth, int64_t frame, const uint8_t* data, size_t size);
+
+/**
+ * @brief Post a high-precision CC event from any thread.
+ *
+ * The event is queued as in sfizz_post_midi_event().
+ * @since 1.3.0
+ *
+ * @param synth      The synth.
+ * @param frame      The frame at which the event occurs, as in sfizz_post_midi_event().
+ * @param cc_number  The MIDI CC number.
+ * @param norm_value The normalized CC value, in domain 0 to 1.
+ *
+ * @return @false if the queue is full.
+ *
+ * @par Thread-safety constraints
+ * - the function can be invoked from any thread, concurrently with any other
+ *   function
+ */
+SFIZZ_EXPORTED_API bool sfizz_post_hdcc(sfizz_synth_t* synth, int64_t frame, int cc_number, float norm_value);
+
+/**
+ * @brief Get the frame at which the next call to sfizz_render_block() starts,
+ *        on the clock of the posted events.
+ *
+ * The clock starts at 0 and advances by the size of each rendered block.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - the function can be invoked from any thread, concurrently with any other
+ *   function
+ */
+SFIZZ_EXPORTED_API int64_t sfizz_get_frame_time(sfizz_synth_t* synth);
+
 /**
  * @brief Render a block audio data into a stereo channel.
  *
@@ -850,6 +988,43 @@ SFIZZ_EXPORTED_API int sfizz_get_oscillator_quality(sfizz_synth_t* synth, sfizz_
  */
 SFIZZ_EXPORTED_API void sfizz_set_oscillator_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality);
 
+/**
+ * @brief Get the default filter quality.
+ *
+ * This is the quality setting which the engine uses when the instrument
+ * does not use the opcode `filter_quality`. The engine uses distinct
+ * default quality settings for live mode and freewheeling mode,
+ * which both can be accessed by the means of this function.
+ * @since 1.3.0
+ *
+ * @param      synth  The synth.
+ * @param[in]  mode   The processing mode.
+ *
+ * @return The filter quality for the given mode, in the range 0 to 1.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_filter_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode);
+
+/**
+ * @brief Set the default filter quality.
+ *
+ * This is the quality setting which the engine uses when the instrument
+ * does not use the opcode `filter_quality`. At 0, the coefficients of the
+ * 2-pole filters, peaks, shelves and EQs get interpolated from tables
+ * instead of computed exactly, which is faster when they are modulated.
+ * The engine uses distinct default quality settings for live mode and
+ * freewheeling mode, which both can be accessed by the means of this
+ * function.
+ * @since 1.3.0
+ *
+ * @param      synth    The synth.
+ * @param[in]  mode     The processing mode.
+ * @param[in]  quality  The desired filter quality, in the range 0 to 1.
+ *
+ * @par Thread-safety constraints
+ * - @b RT: the function must be invoked from the Real-time thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_filter_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality);
+
 /**
  * @brief Set whether pressing the sustain pedal cancels the release stage
  * @since 1.2.0
@@ -901,6 +1076,89 @@ SFIZZ_EXPORTED_API void sfizz_set_num_voices(sfizz_synth_t* synth, int num_voice
  */
 SFIZZ_EXPORTED_API int sfizz_get_num_voices(sfizz_synth_t* synth);
 
+/**
+ * @brief Set the number of threads which render the voices.
+ *
+ * With 1 thread, which is the default, all voices are rendered by the thread
+ * calling sfizz_render_block(). With more, the voices are spread over a pool of
+ * real-time worker threads. The output may then differ from the single-threaded
+ * one by rounding errors.
+ *
+ * @since 1.3.0
+ *
+ * @param synth        The synth.
+ * @param num_threads  The number of threads, including the rendering thread.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_num_render_threads(sfizz_synth_t* synth, int num_threads);
+
+/**
+ * @brief Return the number of threads which render the voices.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_num_render_threads(sfizz_synth_t* synth);
+
+/**
+ * @brief Render the blocks by sub-blocks of a given number of frames.
+ *
+ * The events stay sample-accurate, while the voices process fewer frames at a
+ * time, which keeps their working buffers in cache with large blocks. This is
+ * off by default.
+ *
+ * @since 1.3.0
+ *
+ * @param synth       The synth.
+ * @param num_frames  The size of the sub-blocks, for instance 64 or 128, or 0
+ *                    to render the blocks at once.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_render_quantum(sfizz_synth_t* synth, int num_frames);
+
+/**
+ * @brief Return the number of frames rendered at a time within a block, or 0
+ *        if the blocks are rendered at once.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API int sfizz_get_render_quantum(sfizz_synth_t* synth);
+
+/**
+ * @brief Process the effect buses concurrently on the render threads.
+ *
+ * The buses are then mixed into the outputs in the usual order, so the output
+ * is identical to the serial processing. This only has an effect with more
+ * than one render thread.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_parallel_effects(sfizz_synth_t* synth);
+
+/**
+ * @brief Process the effect buses one after the other. This is the default.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_disable_parallel_effects(sfizz_synth_t* synth);
+
 /**
  * @brief Return the number of allocated buffers from the synth.
  * @since 0.2.0
@@ -942,6 +1200,128 @@ SFIZZ_EXPORTED_API void sfizz_enable_freewheeling(sfizz_synth_t* synth);
  */
 SFIZZ_EXPORTED_API void sfizz_disable_freewheeling(sfizz_synth_t* synth);
 
+/**
+ * @brief Enable sample streaming on the synth.
+ *
+ * The samples which do not fit in the preload are streamed from disk through
+ * a fixed-size ring buffer per voice, instead of being loaded whole in memory.
+ * Regions whose loop moves with CCs are still loaded whole.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_sample_streaming(sfizz_synth_t* synth);
+
+/**
+ * @brief Disable sample streaming on the synth.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_disable_sample_streaming(sfizz_synth_t* synth);
+
+/**
+ * @brief Enable the compressed sample storage on the synth.
+ *
+ * The samples are kept in memory as they are stored on disk, for example in
+ * FLAC or WavPack, and only their preload is decoded. The rest is decoded
+ * from memory ahead of the playhead of each voice, through a fixed-size ring
+ * buffer per voice. Regions whose loop moves with CCs are still decoded whole
+ * when played.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_compressed_sample_storage(sfizz_synth_t* synth);
+
+/**
+ * @brief Disable the compressed sample storage on the synth.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_disable_compressed_sample_storage(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the format of the preloaded samples in memory.
+ *
+ * The integer formats take less memory and bandwidth than the floats, and are
+ * converted as the voices interpolate them. The samples are rounded to the
+ * format. This reloads the preloaded samples.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param format  The sample format.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+ */
+SFIZZ_EXPORTED_API void sfizz_set_sample_format(sfizz_synth_t* synth, sfizz_sample_format_t format);
+
+/**
+ * @brief Get the format of the preloaded samples in memory.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API sfizz_sample_format_t sfizz_get_sample_format(sfizz_synth_t* synth);
+
+/**
+ * @brief Enable the sharing of the samples with the other synths.
+ *
+ * The preloaded samples are shared with the other synths of the process
+ * which enable the sharing, so that the synths loading the same samples hold
+ * a single copy of them. The samples are freed when no synth uses them
+ * anymore. This only affects the samples loaded afterwards.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_enable_sample_sharing(sfizz_synth_t* synth);
+
+/**
+ * @brief Disable the sharing of the samples with the other synths.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_disable_sample_sharing(sfizz_synth_t* synth);
+
+/**
+ * @brief Set the directory of the persistent preload cache.
+ *
+ * The cache keeps the preloaded data and the information of the samples
+ * across sessions, so that they are not decoded again when loading an
+ * instrument. An empty path or NULL disables the cache, which is the default.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param path   The cache directory, in UTF-8, created if needed.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_preload_cache_directory(sfizz_synth_t* synth, const char* path);
+
 /**
  * @brief Return a comma separated list of unknown opcodes.
  *
@@ -1056,6 +1436,94 @@ typedef struct
  */
 SFIZZ_EXPORTED_API void sfizz_get_callback_breakdown(sfizz_synth_t* synth, sfizz_callback_breakdown_t* breakdown);
 
+/**
+ * @brief The statistics of the render times of the blocks.
+ * @note The load of a block is the ratio of its render time to its duration.
+ */
+typedef struct
+{
+    uint64_t numBlocks;
+    uint64_t numDeadlineMisses;
+    double maxLoad;
+    double lastLoad;
+    double binWidth;
+    int numBins;
+    uint64_t numStreamUnderruns;
+} sfizz_latency_stats_t;
+
+/**
+ * @brief A block which took longer to render than its duration.
+ * @note Times are in seconds.
+ */
+typedef struct
+{
+    uint64_t block;
+    double duration;
+    double budget;
+    int numVoices;
+    int numEvents;
+} sfizz_deadline_miss_t;
+
+/**
+ * @brief Get the statistics of the render times of the blocks.
+ *
+ * A load above 1 is a deadline miss. The statistics are recorded for every
+ * block since the last reset, except when freewheeling.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ * @param stats  The statistics.
+ *
+ * @par Thread-safety constraints
+ * - @b ANY: the function can be invoked from any thread
+ */
+SFIZZ_EXPORTED_API void sfizz_get_latency_stats(sfizz_synth_t* synth, sfizz_latency_stats_t* stats);
+
+/**
+ * @brief Get the histogram of the loads of the blocks.
+ *
+ * The bin `i` counts the blocks with a load from `i * binWidth` to
+ * `(i + 1) * binWidth`, and the last bin all the blocks above.
+ * @since 1.3.0
+ *
+ * @param synth     The synth.
+ * @param counts    The number of blocks per bin.
+ * @param max_bins  The size of @p counts.
+ *
+ * @return The number of bins written.
+ *
+ * @par Thread-safety constraints
+ * - @b ANY: the function can be invoked from any thread
+ */
+SFIZZ_EXPORTED_API int sfizz_get_latency_histogram(sfizz_synth_t* synth, uint64_t* counts, int max_bins);
+
+/**
+ * @brief Get the last deadline misses, the most recent first, with the
+ * number of active voices and of dispatched events of their block.
+ * @since 1.3.0
+ *
+ * @param synth       The synth.
+ * @param misses      The deadline misses.
+ * @param max_misses  The size of @p misses.
+ *
+ * @return The number of misses written; only the last misses are kept.
+ *
+ * @par Thread-safety constraints
+ * - @b ANY: the function can be invoked from any thread
+ */
+SFIZZ_EXPORTED_API int sfizz_get_deadline_misses(sfizz_synth_t* synth, sfizz_deadline_miss_t* misses, int max_misses);
+
+/**
+ * @brief Forget the statistics of the render times recorded so far.
+ * @since 1.3.0
+ *
+ * @param synth  The synth.
+ *
+ * @par Thread-safety constraints
+ * - @b ANY: the function can be invoked from any thread
+ */
+SFIZZ_EXPORTED_API void sfizz_reset_latency_stats(sfizz_synth_t* synth);
+
 /**
  * @brief Shuts down the current processing, clear buffers and reset the voices.
  * @since 0.3.2
@@ -103,6 +103,16 @@ public:
         ProcessFreewheeling,
     };
 
+    /**
+     * @brief Format of the preloaded samples in memory.
+     * @since 1.3.0
+     */
+    enum SampleFormat {
+        SampleFloat,
+        SampleInt16,
+        SampleInt24,
+    };
+
     /**
      * @brief Empties the current regions and load a new SFZ file into the synth.
      *
@@ -141,6 +151,61 @@ public:
      */
     bool loadSfzString(const std::string& path, const std::string& text);
 
+    /**
+     * @brief Load a new SFZ file in the background, while the current
+     * instrument keeps playing.
+     *
+     * The instrument is loaded into a separate state, which takes the current
+     * engine settings and MIDI state. The audio thread switches to it at the
+     * end of the next call to a render function, and the previous state is
+     * destroyed on a background thread. A staged instrument which was not
+     * adopted yet is replaced.
+     *
+     * @since 1.3.0
+     *
+     * @param path The path to the file to load, as string.
+     *
+     * @return @false if the file was not found or no regions were loaded,
+     *         in which case the current instrument is kept.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread, and may
+     *   run concurrently with @b RT functions
+     */
+    bool stageSfzFile(const std::string& path);
+
+    /**
+     * @brief Load a new SFZ document from memory in the background, while the
+     * current instrument keeps playing.
+     *
+     * This is similar to stageSfzFile() in functionality.
+     *
+     * @since 1.3.0
+     *
+     * @param path The virtual path of the SFZ file, as string.
+     * @param text The contents of the virtual SFZ file.
+     *
+     * @return @false if no regions were loaded,
+     *         @true otherwise.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread, and may
+     *   run concurrently with @b RT functions
+     */
+    bool stageSfzString(const std::string& path, const std::string& text);
+
+    /**
+     * @brief Check whether a staged instrument is waiting to be adopted by
+     * the audio thread.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread, and may
+     *   run concurrently with @b RT functions
+     */
+    bool hasStagedState() const noexcept;
+
     /**
      * @brief Sets the tuning from a Scala file loaded from the file system.
      *
@@ -251,6 +316,16 @@ public:
      */
     int getNumCurves() const noexcept;
 
+    /**
+     * @brief Return the number of stereo outputs used by the current
+     *        instrument, which is one more than the highest `output` opcode.
+     *
+     * Pass at least this number to `renderBlock` to get every output on its
+     * own stereo pair.
+     * @since 1.3.0
+     */
+    int getNumOutputs() const noexcept;
+
     /**
      * @brief Return a list of unsupported opcodes, if any.
      * @since 0.2.0
@@ -360,6 +435,42 @@ public:
      */
     void setOscillatorQuality(ProcessMode mode, int quality);
 
+    /**
+     * @brief Get the default filter quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `filter_quality`. The engine uses distinct
+     * default quality settings for live mode and freewheeling mode,
+     * which both can be accessed by the means of this function.
+     * @since 1.3.0
+     *
+     * @param[in] mode  The processing mode.
+     *
+     * @return The filter quality for the given mode, in the range 0 to 1.
+     */
+    int getFilterQuality(ProcessMode mode);
+
+    /**
+     * @brief Set the default filter quality.
+     *
+     * This is the quality setting which the engine uses when the instrument
+     * does not use the opcode `filter_quality`. At 0, the coefficients of the
+     * 2-pole filters, peaks, shelves and EQs get interpolated from tables
+     * instead of computed exactly, which is faster when they are modulated.
+     * The engine uses distinct default quality settings for live mode and
+     * freewheeling mode, which both can be accessed by the means of this
+     * function.
+     *
+     * @since 1.3.0
+     *
+     * @param[in] mode    The processing mode.
+     * @param[in] quality The desired filter quality, in the range 0 to 1.
+     *
+     * @par Thread-safety constraints
+     * - @b RT: the function must be invoked from the Real-time thread
+     */
+    void setFilterQuality(ProcessMode mode, int quality);
+
     /**
      * @brief Set whether pressing the sustain pedal cancels the release stage
      *
@@ -755,6 +866,64 @@ public:
      */
     void playbackState(int delay, int playbackState);
 
+    /**
+     * @brief Post a MIDI message to the synth, from any thread.
+     *
+     * The message goes through a lock-free queue, which several threads can
+     * feed at once, and is dispatched at its frame by the call to renderBlock()
+     * which covers it. Unlike the other MIDI functions, this does not need to
+     * be called from the Real-time thread nor before the block.
+     *
+     * @since 1.3.0
+     *
+     * @param frame the frame at which the event occurs, on the clock given by
+     *              getFrameTime(); a negative value means at the start of the
+     *              next block. A frame which is already past is dispatched at
+     *              the start of the next block.
+     * @param data  a MIDI 1.0 channel voice message; the channel is ignored.
+     * @param size  the size of the message.
+     *
+     * @return @false if the message is not supported or the queue is full.
+     *
+     * @par Thread-safety constraints
+     * - the function can be invoked from any thread, concurrently with any
+     *   other function
+     */
+    bool postMidiEvent(int64_t frame, const uint8_t* data, size_t size) noexcept;
+
+    /**
+     * @brief Post a high-precision CC event to the synth, from any thread.
+     *
+     * The event is queued as in postMidiEvent().
+     *
+     * @since 1.3.0
+     *
+     * @param frame     the frame at which the event occurs, as in postMidiEvent().
+     * @param ccNumber  the cc number.
+     * @param normValue the normalized cc value, in domain 0 to 1.
+     *
+     * @return @false if the queue is full.
+     *
+     * @par Thread-safety constraints
+     * - the function can be invoked from any thread, concurrently with any
+     *   other function
+     */
+    bool postHdcc(int64_t frame, int ccNumber, float normValue) noexcept;
+
+    /**
+     * @brief Get the frame at which the next call to renderBlock() starts, on
+     *        the clock of the posted events.
+     *
+     * The clock starts at 0 and advances by the size of each rendered block.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - the function can be invoked from any thread, concurrently with any
+     *   other function
+     */
+    int64_t getFrameTime() const noexcept;
+
     /**
      * @brief Render an block of audio data in the buffer.
      *
@@ -797,6 +966,81 @@ public:
      */
     void setNumVoices(int numVoices) noexcept;
 
+    /**
+     * @brief Return the number of threads which render the voices.
+     * @since 1.3.0
+     */
+    int getNumRenderThreads() const noexcept;
+
+    /**
+     * @brief Change the number of threads which render the voices.
+     *
+     * With 1 thread, which is the default, all voices are rendered by the
+     * thread calling renderBlock(). With more, the voices are spread over a
+     * pool of real-time worker threads. The output may then differ from the
+     * single-threaded one by rounding errors.
+     *
+     * @since 1.3.0
+     *
+     * @param numThreads The number of threads, including the rendering thread.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setNumRenderThreads(int numThreads) noexcept;
+
+    /**
+     * @brief Return the number of frames rendered at a time within a block,
+     *        or 0 if the blocks are rendered at once.
+     * @since 1.3.0
+     */
+    int getRenderQuantum() const noexcept;
+
+    /**
+     * @brief Render the blocks by sub-blocks of a given number of frames.
+     *
+     * The events stay sample-accurate, while the voices process fewer frames
+     * at a time, which keeps their working buffers in cache with large blocks.
+     * This is off by default.
+     *
+     * @since 1.3.0
+     *
+     * @param numFrames The size of the sub-blocks, for instance 64 or 128,
+     *                  or 0 to render the blocks at once.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setRenderQuantum(int numFrames) noexcept;
+
+    /**
+     * @brief Process the effect buses concurrently on the render threads.
+     *
+     * The buses are then mixed into the outputs in the usual order, so the
+     * output is identical to the serial processing. This only has an effect
+     * with more than one render thread.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void enableParallelEffects() noexcept;
+
+    /**
+     * @brief Process the effect buses one after the other. This is the default.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void disableParallelEffects() noexcept;
+
     /**
      * @brief Set the oversampling factor to a new value.
      *
@@ -881,6 +1125,122 @@ public:
      */
     void disableFreeWheeling() noexcept;
 
+    /**
+     * @brief Enable sample streaming on the synth.
+     *
+     * The samples which do not fit in the preload are streamed from disk
+     * through a fixed-size ring buffer per voice, instead of being loaded
+     * whole in memory. Regions whose loop moves with CCs are still loaded
+     * whole.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void enableSampleStreaming() noexcept;
+
+    /**
+     * @brief Disable sample streaming on the synth.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void disableSampleStreaming() noexcept;
+
+    /**
+     * @brief Enable the compressed sample storage on the synth.
+     *
+     * The samples are kept in memory as they are stored on disk, for example
+     * in FLAC or WavPack, and only their preload is decoded. The rest is
+     * decoded from memory ahead of the playhead of each voice, through a
+     * fixed-size ring buffer per voice. Regions whose loop moves with CCs are
+     * still decoded whole when played.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void enableCompressedSampleStorage() noexcept;
+
+    /**
+     * @brief Disable the compressed sample storage on the synth.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void disableCompressedSampleStorage() noexcept;
+
+    /**
+     * @brief Set the format of the preloaded samples in memory.
+     *
+     * The integer formats take less memory and bandwidth than the floats,
+     * and are converted as the voices interpolate them. The samples are
+     * rounded to the format. This reloads the preloaded samples.
+     *
+     * @since 1.3.0
+     *
+     * @param format  The sample format.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     * - @b OFF: the function cannot be invoked while a thread is calling @b RT functions
+     */
+    void setSampleFormat(SampleFormat format) noexcept;
+
+    /**
+     * @brief Get the format of the preloaded samples in memory.
+     *
+     * @since 1.3.0
+     */
+    SampleFormat getSampleFormat() const noexcept;
+
+    /**
+     * @brief Enable the sharing of the samples with the other synths.
+     *
+     * The preloaded samples are shared with the other synths of the process
+     * which enable the sharing, so that the synths loading the same samples
+     * hold a single copy of them. The samples are freed when no synth uses
+     * them anymore. This only affects the samples loaded afterwards.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void enableSampleSharing() noexcept;
+
+    /**
+     * @brief Disable the sharing of the samples with the other synths.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void disableSampleSharing() noexcept;
+
+    /**
+     * @brief Set the directory of the persistent preload cache.
+     *
+     * The cache keeps the preloaded data and the information of the samples
+     * across sessions, so that they are not decoded again when loading an
+     * instrument. An empty path disables the cache, which is the default.
+     *
+     * @since 1.3.0
+     *
+     * @param path  The cache directory, created if needed.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setPreloadCacheDirectory(const std::string& path) noexcept;
+
     /**
      * @brief Check if the SFZ should be reloaded.
      *
@@ -986,6 +1346,84 @@ public:
      */
     CallbackBreakdown getCallbackBreakdown() noexcept;
 
+    struct LatencyStats
+    {
+        uint64_t numBlocks;
+        uint64_t numDeadlineMisses;
+        double maxLoad;
+        double lastLoad;
+        double binWidth;
+        int numBins;
+        uint64_t numStreamUnderruns;
+    };
+
+    struct DeadlineMiss
+    {
+        uint64_t block;
+        double duration;
+        double budget;
+        int numVoices;
+        int numEvents;
+    };
+
+    /**
+     * @brief Get the statistics of the render times of the blocks.
+     *
+     * The load of a block is the ratio of its render time to its duration;
+     * a load above 1 is a deadline miss. The statistics are recorded for
+     * every block since the last reset, except when freewheeling.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b ANY: the function can be invoked from any thread
+     */
+    LatencyStats getLatencyStats() const noexcept;
+
+    /**
+     * @brief Get the histogram of the loads of the blocks.
+     *
+     * The bin `i` counts the blocks with a load from `i * binWidth` to
+     * `(i + 1) * binWidth`, and the last bin all the blocks above.
+     *
+     * @since 1.3.0
+     *
+     * @param counts    The number of blocks per bin.
+     * @param maxBins   The size of @p counts.
+     *
+     * @return The number of bins written.
+     *
+     * @par Thread-safety constraints
+     * - @b ANY: the function can be invoked from any thread
+     */
+    int getLatencyHistogram(uint64_t* counts, int maxBins) const noexcept;
+
+    /**
+     * @brief Get the last deadline misses, the most recent first, with the
+     * number of active voices and of dispatched events of their block.
+     *
+     * @since 1.3.0
+     *
+     * @param misses    The deadline misses.
+     * @param maxMisses The size of @p misses.
+     *
+     * @return The number of misses written; only the last misses are kept.
+     *
+     * @par Thread-safety constraints
+     * - @b ANY: the function can be invoked from any thread
+     */
+    int getDeadlineMisses(DeadlineMiss* misses, int maxMisses) const noexcept;
+
+    /**
+     * @brief Forget the statistics of the render times recorded so far.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b ANY: the function can be invoked from any thread
+     */
+    void resetLatencyStats() noexcept;
+
     /**
      * @brief Shuts down the current processing, clear buffers and reset the voices.
      *
@@ -6,15 +6,49 @@
 
 #include "AudioReader.h"
 #include "FileMetadata.h"
+#include "MappedFile.h"
 #include <absl/memory/memory.h>
 #include <st_audiofile.hpp>
 #if defined(SFIZZ_USE_SNDFILE)
 #include <sndfile.h>
 #endif
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace sfz {
 
+size_t AudioReader::readNextBlockPlanar(AudioSpan<float> output)
+{
+    const unsigned numChannels = channels();
+    const size_t numFrames = output.getNumFrames();
+    ASSERT(output.getNumChannels() == numChannels);
+
+    if (numChannels == 1)
+        return readNextBlock(output.getChannel(0), numFrames);
+
+    interleavedBuffer_.resize(numChannels * numFrames);
+    float* interleaved = interleavedBuffer_.data();
+    const size_t readFrames = readNextBlock(interleaved, numFrames);
+
+    if (numChannels == 2) {
+        readInterleaved(
+            absl::MakeConstSpan(interleaved, 2 * readFrames),
+            output.getSpan(0).first(readFrames), output.getSpan(1).first(readFrames));
+    }
+    else {
+        for (unsigned c = 0; c < numChannels; ++c) {
+            float* channel = output.getChannel(c);
+            for (size_t i = 0; i < readFrames; ++i)
+                channel[i] = interleaved[i * numChannels + c];
+        }
+    }
+
+    return readFrames;
+}
+
 class BasicSndfileReader : public AudioReader {
 public:
     explicit BasicSndfileReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader)
@@ -96,6 +130,7 @@ public:
     explicit ForwardReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 };
 
 ForwardReader::ForwardReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader)
@@ -117,6 +152,11 @@ size_t ForwardReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool ForwardReader::seek(uint64_t frame)
+{
+    return handle_.seek(frame);
+}
+
 //------------------------------------------------------------------------------
 
 template <size_t N, class T = float>
@@ -165,6 +205,7 @@ public:
     explicit ReverseReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 
 private:
     uint64_t position_ {};
@@ -200,6 +241,16 @@ size_t ReverseReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool ReverseReader::seek(uint64_t frame)
+{
+    const uint64_t frames = handle_.get_frame_count();
+    if (frame > frames)
+        return false;
+
+    position_ = frames - frame;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 
 /**
@@ -210,12 +261,14 @@ public:
     explicit NoSeekReverseReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 
 private:
     void readWholeFile();
 
 private:
     std::unique_ptr<float[]> fileBuffer_;
+    uint64_t fileFrames_ { 0 };
     uint64_t fileFramesLeft_ { 0 };
 };
 
@@ -252,13 +305,560 @@ size_t NoSeekReverseReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool NoSeekReverseReader::seek(uint64_t frame)
+{
+    if (!fileBuffer_)
+        readWholeFile();
+
+    if (frame > fileFrames_)
+        return false;
+
+    fileFramesLeft_ = fileFrames_ - frame;
+    return true;
+}
+
 void NoSeekReverseReader::readWholeFile()
 {
     const uint64_t frames = handle_.get_frame_count();
     const unsigned channels = handle_.get_channels();
     float* fileBuffer = new float[channels * frames];
     fileBuffer_.reset(fileBuffer);
-    fileFramesLeft_ = handle_.read_f32(fileBuffer, frames);
+    fileFrames_ = handle_.read_f32(fileBuffer, frames);
+    fileFramesLeft_ = fileFrames_;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * @brief Sample encodings of uncompressed PCM files
+ */
+enum class PcmEncoding { U8, S8, S16, S24, S32, F32, F64 };
+
+/**
+ * @brief Location and format of the sample data in an uncompressed PCM file
+ */
+struct PcmLayout {
+    int type { st_audio_file_other };
+    PcmEncoding encoding { PcmEncoding::S16 };
+    bool bigEndian { false };
+    unsigned channels { 0 };
+    unsigned sampleRate { 0 };
+    unsigned sampleBytes { 0 };
+    size_t dataOffset { 0 };
+    int64_t frames { 0 };
+};
+
+static uint32_t readLE16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+static uint32_t readLE32(const unsigned char* p) { return readLE16(p) | (readLE16(p + 2) << 16); }
+static uint32_t readBE16(const unsigned char* p) { return (p[0] << 8) | p[1]; }
+static uint32_t readBE32(const unsigned char* p) { return (readBE16(p) << 16) | readBE16(p + 2); }
+
+static double readExtended80(const unsigned char* p)
+{
+    const int exponent = ((p[0] & 0x7f) << 8) | p[1];
+    uint64_t mantissa = 0;
+    for (unsigned i = 0; i < 8; ++i)
+        mantissa = (mantissa << 8) | p[2 + i];
+    if (exponent == 0 && mantissa == 0)
+        return 0.0;
+    const double value = std::ldexp(static_cast<double>(mantissa), exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+static unsigned pcmSampleBytes(PcmEncoding encoding)
+{
+    switch (encoding) {
+    case PcmEncoding::U8:
+    case PcmEncoding::S8:
+        return 1;
+    case PcmEncoding::S16:
+        return 2;
+    case PcmEncoding::S24:
+        return 3;
+    case PcmEncoding::S32:
+    case PcmEncoding::F32:
+        return 4;
+    case PcmEncoding::F64:
+        return 8;
+    }
+    return 0;
+}
+
+static bool validatePcmLayout(PcmLayout& layout, uint64_t dataSize, uint64_t maxFrames)
+{
+    if (layout.channels < 1 || layout.channels > config::maxChannels || layout.sampleRate == 0)
+        return false;
+
+    layout.sampleBytes = pcmSampleBytes(layout.encoding);
+    const uint64_t frameBytes = layout.channels * layout.sampleBytes;
+    layout.frames = static_cast<int64_t>(std::min(dataSize / frameBytes, maxFrames));
+    return true;
+}
+
+/**
+ * @brief Locate the sample data of an uncompressed RIFF/WAVE file
+ */
+static bool parseWavLayout(const unsigned char* data, size_t size, PcmLayout& layout)
+{
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+
+    layout.type = st_audio_file_wav;
+    layout.bigEndian = false;
+
+    bool haveFormat = false;
+    uint32_t formatTag = 0;
+    uint32_t bitsPerSample = 0;
+    uint32_t blockAlign = 0;
+
+    uint64_t position = 12;
+    while (position + 8 <= size) {
+        const unsigned char* chunk = data + position;
+        const uint64_t chunkSize = readLE32(chunk + 4);
+        const uint64_t bodyOffset = position + 8;
+        const uint64_t available = size - bodyOffset;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || chunkSize > available)
+                return false;
+            const unsigned char* format = data + bodyOffset;
+            formatTag = readLE16(format);
+            layout.channels = readLE16(format + 2);
+            layout.sampleRate = readLE32(format + 4);
+            blockAlign = readLE16(format + 12);
+            bitsPerSample = readLE16(format + 14);
+            if (formatTag == 0xFFFE) { // WAVE_FORMAT_EXTENSIBLE
+                if (chunkSize < 40)
+                    return false;
+                formatTag = readLE16(format + 24);
+            }
+            haveFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat)
+                return false;
+
+            if (formatTag == 1) { // WAVE_FORMAT_PCM
+                switch (bitsPerSample) {
+                case 8: layout.encoding = PcmEncoding::U8; break;
+                case 16: layout.encoding = PcmEncoding::S16; break;
+                case 24: layout.encoding = PcmEncoding::S24; break;
+                case 32: layout.encoding = PcmEncoding::S32; break;
+                default: return false;
+                }
+            }
+            else if (formatTag == 3) { // WAVE_FORMAT_IEEE_FLOAT
+                switch (bitsPerSample) {
+                case 32: layout.encoding = PcmEncoding::F32; break;
+                case 64: layout.encoding = PcmEncoding::F64; break;
+                default: return false;
+                }
+            }
+            else
+                return false;
+
+            if (blockAlign != layout.channels * (bitsPerSample / 8))
+                return false;
+
+            layout.dataOffset = static_cast<size_t>(bodyOffset);
+            return validatePcmLayout(layout, std::min(chunkSize, available), UINT64_MAX);
+        }
+
+        position = bodyOffset + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Locate the sample data of an uncompressed AIFF or AIFF-C file
+ */
+static bool parseAiffLayout(const unsigned char* data, size_t size, PcmLayout& layout)
+{
+    if (size < 12 || std::memcmp(data, "FORM", 4) != 0)
+        return false;
+
+    const bool isAifc = std::memcmp(data + 8, "AIFC", 4) == 0;
+    if (!isAifc && std::memcmp(data + 8, "AIFF", 4) != 0)
+        return false;
+
+    layout.type = st_audio_file_aiff;
+
+    bool haveCommon = false;
+    bool haveSound = false;
+    uint32_t numFrames = 0;
+    uint32_t bitsPerSample = 0;
+    char compression[4] = { 'N', 'O', 'N', 'E' };
+    uint64_t dataSize = 0;
+
+    uint64_t position = 12;
+    while (position + 8 <= size) {
+        const unsigned char* chunk = data + position;
+        const uint64_t chunkSize = readBE32(chunk + 4);
+        const uint64_t bodyOffset = position + 8;
+        const uint64_t available = size - bodyOffset;
+
+        if (std::memcmp(chunk, "COMM", 4) == 0) {
+            if (chunkSize < (isAifc ? 22u : 18u) || chunkSize > available)
+                return false;
+            const unsigned char* common = data + bodyOffset;
+            layout.channels = readBE16(common);
+            numFrames = readBE32(common + 2);
+            bitsPerSample = readBE16(common + 6);
+            layout.sampleRate = static_cast<unsigned>(std::lround(readExtended80(common + 8)));
+            if (isAifc)
+                std::memcpy(compression, common + 18, 4);
+            haveCommon = true;
+        }
+        else if (std::memcmp(chunk, "SSND", 4) == 0) {
+            if (chunkSize < 8 || available < 8)
+                return false;
+            const uint64_t offset = readBE32(data + bodyOffset);
+            const uint64_t start = bodyOffset + 8 + offset;
+            if (start > size)
+                return false;
+            layout.dataOffset = static_cast<size_t>(start);
+            dataSize = std::min(chunkSize - 8, available - 8);
+            dataSize = (dataSize > offset) ? (dataSize - offset) : 0;
+            haveSound = true;
+        }
+
+        position = bodyOffset + chunkSize + (chunkSize & 1);
+    }
+
+    if (!haveCommon || !haveSound)
+        return false;
+
+    const unsigned sampleBytes = (bitsPerSample + 7) / 8;
+    auto isCompression = [&compression](const char* id) {
+        return std::memcmp(compression, id, 4) == 0;
+    };
+
+    if (isCompression("NONE") || isCompression("twos") || isCompression("sowt")) {
+        layout.bigEndian = !isCompression("sowt");
+        switch (sampleBytes) {
+        case 1: layout.encoding = PcmEncoding::S8; break;
+        case 2: layout.encoding = PcmEncoding::S16; break;
+        case 3: layout.encoding = PcmEncoding::S24; break;
+        case 4: layout.encoding = PcmEncoding::S32; break;
+        default: return false;
+        }
+    }
+    else if (isCompression("fl32") || isCompression("FL32")) {
+        layout.bigEndian = true;
+        layout.encoding = PcmEncoding::F32;
+    }
+    else if (isCompression("fl64") || isCompression("FL64")) {
+        layout.bigEndian = true;
+        layout.encoding = PcmEncoding::F64;
+    }
+    else
+        return false;
+
+    return validatePcmLayout(layout, dataSize, numFrames);
+}
+
+template <bool BigEndian>
+struct PcmBytes {
+    static uint32_t read16(const unsigned char* p) { return BigEndian ? readBE16(p) : readLE16(p); }
+    static uint32_t read24(const unsigned char* p)
+    {
+        return BigEndian ? ((p[0] << 16) | (p[1] << 8) | p[2]) : ((p[2] << 16) | (p[1] << 8) | p[0]);
+    }
+    static uint32_t read32(const unsigned char* p) { return BigEndian ? readBE32(p) : readLE32(p); }
+    static uint64_t read64(const unsigned char* p)
+    {
+        const uint64_t first = read32(p);
+        const uint64_t second = read32(p + 4);
+        return BigEndian ? ((first << 32) | second) : ((second << 32) | first);
+    }
+};
+
+template <PcmEncoding E, bool BigEndian>
+struct PcmDecoder;
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::U8, BigEndian> {
+    static float decode(const unsigned char* p) { return p[0] * (2.0f / 255.0f) - 1.0f; }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::S8, BigEndian> {
+    static float decode(const unsigned char* p) { return static_cast<int8_t>(p[0]) * (1.0f / 128.0f); }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::S16, BigEndian> {
+    static float decode(const unsigned char* p)
+    {
+        return static_cast<int16_t>(PcmBytes<BigEndian>::read16(p)) * (1.0f / 32768.0f);
+    }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::S24, BigEndian> {
+    static float decode(const unsigned char* p)
+    {
+        const int32_t value = static_cast<int32_t>(PcmBytes<BigEndian>::read24(p) << 8) >> 8;
+        return static_cast<float>(value / 8388608.0);
+    }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::S32, BigEndian> {
+    static float decode(const unsigned char* p)
+    {
+        return static_cast<float>(static_cast<int32_t>(PcmBytes<BigEndian>::read32(p)) / 2147483648.0);
+    }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::F32, BigEndian> {
+    static float decode(const unsigned char* p)
+    {
+        const uint32_t bits = PcmBytes<BigEndian>::read32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+template <bool BigEndian>
+struct PcmDecoder<PcmEncoding::F64, BigEndian> {
+    static float decode(const unsigned char* p)
+    {
+        const uint64_t bits = PcmBytes<BigEndian>::read64(p);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return static_cast<float>(value);
+    }
+};
+
+/**
+ * @brief Convert frames of PCM data to float
+ *
+ * @param input the first frame to convert
+ * @param inputStep the distance in bytes to the next frame, negative for a reverse read
+ * @param sampleBytes the size of a sample
+ * @param channels the number of channels
+ * @param outputs the destinations for each channel
+ * @param outputStride the distance between consecutive samples of a destination
+ * @param frames the number of frames to convert
+ */
+using PcmConvertFunction = void (*)(
+    const unsigned char* input, ptrdiff_t inputStep, unsigned sampleBytes, unsigned channels,
+    float* const* outputs, size_t outputStride, size_t frames);
+
+template <class Decoder>
+static void convertPcmFrames(
+    const unsigned char* input, ptrdiff_t inputStep, unsigned sampleBytes, unsigned channels,
+    float* const* outputs, size_t outputStride, size_t frames)
+{
+    for (unsigned c = 0; c < channels; ++c) {
+        const unsigned char* in = input + c * sampleBytes;
+        float* out = outputs[c];
+        for (size_t i = 0; i < frames; ++i) {
+            *out = Decoder::decode(in);
+            in += inputStep;
+            out += outputStride;
+        }
+    }
+}
+
+template <bool BigEndian>
+static PcmConvertFunction selectPcmConvertFunction(PcmEncoding encoding)
+{
+    switch (encoding) {
+    case PcmEncoding::U8:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::U8, BigEndian>>;
+    case PcmEncoding::S8:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::S8, BigEndian>>;
+    case PcmEncoding::S16:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::S16, BigEndian>>;
+    case PcmEncoding::S24:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::S24, BigEndian>>;
+    case PcmEncoding::S32:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::S32, BigEndian>>;
+    case PcmEncoding::F32:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::F32, BigEndian>>;
+    case PcmEncoding::F64:
+        return &convertPcmFrames<PcmDecoder<PcmEncoding::F64, BigEndian>>;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Audio file reader for uncompressed PCM data in memory, in either
+ * direction. The frames are decoded on read, directly from the memory, which
+ * is usually a mapping of the file.
+ */
+class MappedPcmReader : public AudioReader {
+public:
+    MappedPcmReader(std::unique_ptr<MappedFile> file, const unsigned char* data, size_t size, const PcmLayout& layout, bool reverse);
+    AudioReaderType type() const override;
+    int format() const override;
+    int64_t frames() const override;
+    unsigned channels() const override;
+    unsigned sampleRate() const override;
+    size_t readNextBlock(float* buffer, size_t frames) override;
+    size_t readNextBlockPlanar(AudioSpan<float> output) override;
+    bool seek(uint64_t frame) override;
+    bool getInstrumentInfo(InstrumentInfo& instrument) override;
+    bool getWavetableInfo(WavetableInfo& wt) override;
+
+private:
+    size_t readFrames(float* const* outputs, size_t outputStride, size_t frames);
+
+private:
+    std::unique_ptr<MappedFile> file_;
+    const unsigned char* pcmData_ { nullptr };
+    PcmLayout layout_;
+    PcmConvertFunction convert_ { nullptr };
+    bool reverse_ { false };
+    uint64_t position_ { 0 };
+    MemoryMetadataReader mdReader_;
+    std::vector<unsigned char> readBuffer_; // frames read without the mapping
+};
+
+MappedPcmReader::MappedPcmReader(std::unique_ptr<MappedFile> file, const unsigned char* data, size_t size, const PcmLayout& layout, bool reverse)
+    : file_(std::move(file))
+    , pcmData_(data + layout.dataOffset)
+    , layout_(layout)
+    , reverse_(reverse)
+    , mdReader_(data, size)
+{
+    convert_ = layout.bigEndian ?
+        selectPcmConvertFunction<true>(layout.encoding) :
+        selectPcmConvertFunction<false>(layout.encoding);
+    position_ = reverse ? static_cast<uint64_t>(layout.frames) : 0;
+}
+
+AudioReaderType MappedPcmReader::type() const
+{
+    return reverse_ ? AudioReaderType::Reverse : AudioReaderType::Forward;
+}
+
+int MappedPcmReader::format() const
+{
+    return layout_.type;
+}
+
+int64_t MappedPcmReader::frames() const
+{
+    return layout_.frames;
+}
+
+unsigned MappedPcmReader::channels() const
+{
+    return layout_.channels;
+}
+
+unsigned MappedPcmReader::sampleRate() const
+{
+    return layout_.sampleRate;
+}
+
+size_t MappedPcmReader::readNextBlock(float* buffer, size_t frames)
+{
+    std::array<float*, config::maxChannels> outputs;
+    for (unsigned c = 0; c < layout_.channels; ++c)
+        outputs[c] = buffer + c;
+    return readFrames(outputs.data(), layout_.channels, frames);
+}
+
+size_t MappedPcmReader::readNextBlockPlanar(AudioSpan<float> output)
+{
+    ASSERT(output.getNumChannels() == layout_.channels);
+    std::array<float*, config::maxChannels> outputs;
+    for (unsigned c = 0; c < layout_.channels; ++c)
+        outputs[c] = output.getChannel(c);
+    return readFrames(outputs.data(), 1, output.getNumFrames());
+}
+
+size_t MappedPcmReader::readFrames(float* const* outputs, size_t outputStride, size_t frames)
+{
+    const ptrdiff_t frameBytes = layout_.channels * layout_.sampleBytes;
+    const uint64_t position = position_;
+
+    // The frames to read, in file order
+    const uint64_t first = reverse_ ? position - std::min<uint64_t>(frames, position) : position;
+    size_t numFrames = static_cast<size_t>(reverse_ ?
+        position - first : std::min<uint64_t>(frames, static_cast<uint64_t>(layout_.frames) - position));
+    if (numFrames == 0)
+        return 0;
+
+    // The mapping of a file which was modified since it was opened may fault
+    // on access; read the frames plainly then, as far as they still exist
+    const unsigned char* input = pcmData_ + first * frameBytes;
+    if (file_ && !file_->isUnchanged()) {
+        const size_t offset = static_cast<size_t>(input - file_->data());
+        readBuffer_.resize(numFrames * frameBytes);
+        const size_t numBytesRead = file_->read(offset, readBuffer_.data(), readBuffer_.size());
+        const size_t numFramesRead = numBytesRead / frameBytes;
+        if (reverse_ && numFramesRead < numFrames)
+            numFrames = 0;
+        else
+            numFrames = numFramesRead;
+        if (numFrames == 0)
+            return 0;
+        input = readBuffer_.data();
+    }
+
+    if (!reverse_) {
+        convert_(input, frameBytes, layout_.sampleBytes, layout_.channels, outputs, outputStride, numFrames);
+        position_ = position + numFrames;
+    }
+    else {
+        input += (numFrames - 1) * frameBytes;
+        convert_(input, -frameBytes, layout_.sampleBytes, layout_.channels, outputs, outputStride, numFrames);
+        position_ = position - numFrames;
+    }
+    return numFrames;
+}
+
+bool MappedPcmReader::seek(uint64_t frame)
+{
+    const uint64_t frames = static_cast<uint64_t>(layout_.frames);
+    if (frame > frames)
+        return false;
+
+    position_ = reverse_ ? frames - frame : frame;
+    return true;
+}
+
+bool MappedPcmReader::getInstrumentInfo(InstrumentInfo& instrument)
+{
+    if (file_ && !file_->isUnchanged())
+        return false;
+
+    if (!mdReader_.isOpened())
+        mdReader_.open();
+
+    return mdReader_.isOpened() && mdReader_.extractInstrument(instrument);
+}
+
+bool MappedPcmReader::getWavetableInfo(WavetableInfo& wt)
+{
+    if (file_ && !file_->isUnchanged())
+        return false;
+
+    if (!mdReader_.isOpened())
+        mdReader_.open();
+
+    return mdReader_.isOpened() && mdReader_.extractWavetableInfo(wt);
+}
+
+/**
+ * @brief Create a reader for the memory, if it holds an uncompressed PCM file.
+ */
+static AudioReaderPtr createPcmReader(std::unique_ptr<MappedFile> file, const void* memory, size_t length, bool reverse)
+{
+    const unsigned char* data = static_cast<const unsigned char*>(memory);
+    PcmLayout layout;
+    if (!parseWavLayout(data, length, layout) && !parseAiffLayout(data, length, layout))
+        return {};
+
+    return absl::make_unique<MappedPcmReader>(std::move(file), data, length, layout, reverse);
 }
 
 //------------------------------------------------------------------------------
@@ -316,6 +916,7 @@ public:
     unsigned channels() const override { return 1; }
     unsigned sampleRate() const override { return 44100; }
     size_t readNextBlock(float*, size_t) override { return 0; }
+    bool seek(uint64_t frame) override { return frame == 0; }
     bool getInstrumentInfo(InstrumentInfo& ) override { return false; }
 private:
     AudioReaderType type_ {};
@@ -389,6 +990,19 @@ static AudioReaderPtr createAudioReaderWithHandle(ST_AudioFile handle, std::uniq
 
 AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_code* ec)
 {
+    auto file = absl::make_unique<MappedFile>();
+    if (file->open(path)) {
+        if (!reverse)
+            file->adviseSequential();
+        const void* memory = file->data();
+        const size_t length = file->size();
+        if (AudioReaderPtr reader = createPcmReader(std::move(file), memory, length, reverse)) {
+            if (ec)
+                ec->clear();
+            return reader;
+        }
+    }
+
     ST_AudioFile handle;
 #if defined(_WIN32)
     handle.open_file_w(path.wstring().c_str());
@@ -401,6 +1015,12 @@ AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_
 
 AudioReaderPtr createAudioReaderFromMemory(const void* memory, size_t length, bool reverse, std::error_code* ec)
 {
+    if (AudioReaderPtr reader = createPcmReader(nullptr, memory, length, reverse)) {
+        if (ec)
+            ec->clear();
+        return reader;
+    }
+
     ST_AudioFile handle;
     handle.open_memory(memory, length);
     return createAudioReaderWithHandle(std::move(handle),
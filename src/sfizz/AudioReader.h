@@ -5,6 +5,8 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include "AudioSpan.h"
+#include "Buffer.h"
 #include "absl/types/span.h"
 #include "ghc/fs_std.hpp"
 #include <st_audiofile.h>
@@ -40,14 +42,36 @@ public:
     virtual unsigned channels() const = 0;
     virtual unsigned sampleRate() const = 0;
     virtual size_t readNextBlock(float* buffer, size_t frames) = 0;
+    /**
+     * @brief Read the next frames of the file into separate channel buffers.
+     * The number of channels of the output must match the file.
+     *
+     * @param output the destination, which gets filled up to its size
+     * @return the number of frames read
+     */
+    virtual size_t readNextBlockPlanar(AudioSpan<float> output);
+    /**
+     * @brief Move to a frame, counted in the direction of reading, so that
+     * the next block starts there.
+     *
+     * @param frame the frame to read next
+     * @return false if the reader cannot move there
+     */
+    virtual bool seek(uint64_t frame) = 0;
     virtual bool getInstrumentInfo(InstrumentInfo&) { return false; };
     virtual bool getWavetableInfo(WavetableInfo&) { return false; };
+
+private:
+    Buffer<float> interleavedBuffer_;
 };
 
 typedef std::unique_ptr<AudioReader> AudioReaderPtr;
 
 /**
  * @brief Create a file reader of detected type.
+ *
+ * Uncompressed WAV and AIFF files are memory-mapped and decoded directly
+ * from the mapping, other formats are decoded by the audio file library.
  */
 AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_code* ec = nullptr);
 
@@ -33,6 +33,16 @@ namespace config {
     constexpr bool loggingEnabled { false };
     constexpr size_t maxChannels { 32 };
     constexpr int numBackgroundThreads { 4 };
+    constexpr int maxRenderThreads { 16 };
+    constexpr unsigned maxRetiredStates { 8 };
+    constexpr unsigned eventQueueCapacity { 4096 };
+    constexpr int maxRenderQuantum { 8192 };
+    constexpr unsigned maxDeferredEvents { 4096 };
+    constexpr unsigned profilerBlockCapacity { 256 };
+    constexpr unsigned profilerVoiceCapacity { 16384 };
+    constexpr unsigned latencyHistogramBins { 41 }; // the last bin gathers the higher loads
+    constexpr float latencyBinWidth { 0.05f }; // as a ratio of the block duration
+    constexpr unsigned deadlineMissCapacity { 64 };
     constexpr unsigned fileClearingPeriod { 5 }; // in seconds
     constexpr int numVoices { 64 };
     constexpr unsigned maxVoices { 256 };
@@ -58,6 +68,9 @@ namespace config {
     constexpr uint16_t numCCs { 512 };
     constexpr int maxCurves { 256 };
     constexpr int fileChunkSize { 1024 };
+    constexpr int streamingRingFrames { 32768 };
+    constexpr int streamingGuardFrames { 8192 };
+    constexpr int maxFileStreams { 2 * maxVoices }; // the released streams are recycled asynchronously
     constexpr int processChunkSize { 16 };
     constexpr unsigned int defaultAlignment { 16 };
     constexpr int filtersInPool { maxVoices * 2 };
@@ -84,6 +97,13 @@ namespace config {
        modulated filter. The lower, the more CPU resources are consumed.
     */
     constexpr int filterControlInterval { 16 };
+    /**
+       Number of filter channels processed together by the filter bank, and
+       maximum number of filters and EQs chained in each of its channels.
+       Voices with longer chains are filtered one at a time.
+     */
+    constexpr unsigned filterBankLanes { 8 };
+    constexpr unsigned filterBankStages { filtersPerVoice + eqsPerVoice };
     /**
        Amplitude below which an exponential releasing envelope is considered as
        finished.
@@ -94,6 +114,15 @@ namespace config {
        immediate level transitions. (eg. decay->sustain or release->off)
      */
     constexpr float egTransitionTime = 50e-3;
+    /**
+       Amplitude below which the signal of an effect bus is considered silent.
+     */
+    constexpr float effectSilenceThreshold = 1e-6;
+    /**
+       Duration in seconds during which the output of an effect with a decaying
+       tail must stay silent before the effect bus stops processing it.
+     */
+    constexpr float effectSilenceTime = 200e-3;
     /**
        Default metadata for MIDIName documents
      */
@@ -123,6 +152,10 @@ namespace config {
        Background file loading
      */
     static constexpr int backgroundLoaderPthreadPriority = 50; // expressed in %
+    /**
+       Voice rendering worker threads
+     */
+    static constexpr int renderWorkerPthreadPriority = 75; // expressed in %
     /**
        @brief Ratio to target under which smoothing is considered as completed
      */
@@ -108,6 +108,7 @@ FloatSpec filterRandom { 0.0f, {-12000.0f, 12000.0f}, kPermissiveBounds };
 FloatSpec filterKeytrack { 0, {0, 1200}, kPermissiveBounds };
 FloatSpec filterVeltrack { 0, {-12000, 12000}, kPermissiveBounds };
 FloatSpec filterVeltrackMod { 0.0f, {-12000, 12000}, kPermissiveBounds };
+Int32Spec filterQuality { 1, {0, 1}, 0 };
 FloatSpec eqBandwidth { 1.0f, {0.001f, 4.0f}, kPermissiveBounds };
 FloatSpec eqBandwidthMod { 0.0f, {-4.0f, 4.0f}, kPermissiveBounds };
 FloatSpec eqFrequency { 0.0f, {0.0f, 20000.0f}, kPermissiveBounds };
@@ -167,6 +168,7 @@ Int32Spec sampleQuality { 2, {0, 10}, 0 };
 Int32Spec oscillatorQuality { 1, {0, 3}, 0 };
 Int32Spec freewheelingSampleQuality { 10, {0, 10}, 0 };
 Int32Spec freewheelingOscillatorQuality { 3, {0, 3}, 0 };
+Int32Spec freewheelingFilterQuality { 1, {0, 1}, 0 };
 Int32Spec octaveOffset { 0, {-10, 10}, kPermissiveBounds };
 Int32Spec noteOffset { 0, {-127, 127}, kPermissiveBounds };
 
@@ -199,6 +201,7 @@ FloatSpec lofiBitred { 0.0f, {0.0f, 100.0f}, 0 };
 FloatSpec lofiDecim { 0.0f, {0.0f, 100.0f}, 0 };
 FloatSpec rectify { 0.0f, {0.0f, 100.0f}, 0 };
 UInt32Spec stringsNumber { maxStrings, {0, maxStrings}, 0 };
+FloatSpec convWet { 100.0f, {0.0f, 100.0f}, kNormalizePercent };
 BoolSpec sustainCancelsRelease { false, {0, 1}, kEnforceBounds };
 FloatSpec loTimer { 0.0f, {0.0f, float_max}, 0 };
 FloatSpec hiTimer { float_max, {0.0f, float_max}, 0 };
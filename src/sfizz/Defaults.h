@@ -266,6 +266,7 @@ namespace Default
     extern const OpcodeSpec<float> filterKeytrack;
     extern const OpcodeSpec<float> filterVeltrack;
     extern const OpcodeSpec<float> filterVeltrackMod;
+    extern const OpcodeSpec<int32_t> filterQuality;
     extern const OpcodeSpec<float> eqBandwidth;
     extern const OpcodeSpec<float> eqBandwidthMod;
     extern const OpcodeSpec<float> eqFrequency;
@@ -324,6 +325,7 @@ namespace Default
     extern const OpcodeSpec<int32_t> sampleQuality;
     extern const OpcodeSpec<int32_t> freewheelingSampleQuality;
     extern const OpcodeSpec<int32_t> freewheelingOscillatorQuality;
+    extern const OpcodeSpec<int32_t> freewheelingFilterQuality;
     extern const OpcodeSpec<int32_t> octaveOffset;
     extern const OpcodeSpec<int32_t> noteOffset;
     extern const OpcodeSpec<float> effect;
@@ -354,6 +356,7 @@ namespace Default
     extern const OpcodeSpec<float> lofiDecim;
     extern const OpcodeSpec<float> rectify;
     extern const OpcodeSpec<uint32_t> stringsNumber;
+    extern const OpcodeSpec<float> convWet;
     extern const OpcodeSpec<Trigger> trigger;
     extern const OpcodeSpec<OffMode> offMode;
     extern const OpcodeSpec<LoopMode> loopMode;
@@ -1,6 +1,8 @@
 #include "EQPool.h"
+#include "FilterBank.h"
 #include "Region.h"
 #include "Resources.h"
+#include "SynthConfig.h"
 #include "BufferPool.h"
 #include "SIMDHelpers.h"
 #include "utility/SwapAndPop.h"
@@ -28,6 +30,7 @@ void sfz::EQHolder::setup(const Region& region, unsigned eqId, float velocity)
     this->description = &region.equalizers[eqId];
     eq->setType(description->type);
     eq->setChannels(region.isStereo() ? 2 : 1);
+    regionQuality = region.filterQuality;
 
     // Setup the base values
     baseFrequency = description->frequency + velocity * description->vel2frequency;
@@ -51,7 +54,6 @@ void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numF
         return;
     }
 
-    ModMatrix& mm = resources.getModMatrix();
     BufferPool& bufferPool = resources.getBufferPool();
     auto frequencySpan = bufferPool.getBuffer(numFrames);
     auto bandwidthSpan = bufferPool.getBuffer(numFrames);
@@ -60,17 +62,8 @@ void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numF
     if (!frequencySpan || !bandwidthSpan || !gainSpan)
         return;
 
-    fill<float>(*frequencySpan, baseFrequency);
-    if (float* mod = mm.getModulation(frequencyTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *frequencySpan);
-
-    fill<float>(*bandwidthSpan, baseBandwidth);
-    if (float* mod = mm.getModulation(bandwidthTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *bandwidthSpan);
-
-    fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+    eq->setQuality(currentQuality());
+    computeParameters(*frequencySpan, *bandwidthSpan, *gainSpan);
 
     if (!prepared) {
         eq->prepare(frequencySpan->front(), bandwidthSpan->front(), gainSpan->front());
@@ -87,6 +80,70 @@ void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numF
     );
 }
 
+bool sfz::EQHolder::isBiquad() const
+{
+    return description != nullptr && isBiquadType(eq->type());
+}
+
+void sfz::EQHolder::queue(FilterBank& bank, unsigned firstLane, unsigned stage, unsigned numFrames)
+{
+    ASSERT(isBiquad());
+    if (numFrames == 0)
+        return;
+
+    BufferPool& bufferPool = resources.getBufferPool();
+    auto frequencySpan = bufferPool.getBuffer(numFrames);
+    auto bandwidthSpan = bufferPool.getBuffer(numFrames);
+    auto gainSpan = bufferPool.getBuffer(numFrames);
+
+    if (!frequencySpan || !bandwidthSpan || !gainSpan)
+        return;
+
+    eq->setQuality(currentQuality());
+    computeParameters(*frequencySpan, *bandwidthSpan, *gainSpan);
+
+    if (!prepared) {
+        eq->prepare(frequencySpan->front(), bandwidthSpan->front(), gainSpan->front());
+        prepared = true;
+    }
+
+    const unsigned numChannels = eq->channels();
+    for (unsigned c = 0; c < numChannels; ++c)
+        bank.setStage(firstLane + c, stage, eq->biquadState(c));
+
+    // The same steps as FilterEq::processModulated
+    const unsigned interval = config::filterControlInterval;
+    BiquadCoefficients coefs;
+    for (unsigned frame = 0, step = 0; frame < numFrames; frame += interval, ++step) {
+        eq->biquadCoefficients((*frequencySpan)[frame], (*bandwidthSpan)[frame], (*gainSpan)[frame], coefs);
+        for (unsigned c = 0; c < numChannels; ++c)
+            bank.setTarget(firstLane + c, stage, step, coefs);
+    }
+}
+
+int sfz::EQHolder::currentQuality() const
+{
+    return regionQuality ? *regionQuality : resources.getSynthConfig().currentFilterQuality();
+}
+
+void sfz::EQHolder::computeParameters(absl::Span<float> frequencySpan, absl::Span<float> bandwidthSpan, absl::Span<float> gainSpan)
+{
+    ModMatrix& mm = resources.getModMatrix();
+    const size_t numFrames = frequencySpan.size();
+
+    fill<float>(frequencySpan, baseFrequency);
+    if (float* mod = mm.getModulation(frequencyTarget))
+        add<float>(absl::Span<float>(mod, numFrames), frequencySpan);
+
+    fill<float>(bandwidthSpan, baseBandwidth);
+    if (float* mod = mm.getModulation(bandwidthTarget))
+        add<float>(absl::Span<float>(mod, numFrames), bandwidthSpan);
+
+    fill<float>(gainSpan, baseGain);
+    if (float* mod = mm.getModulation(gainTarget))
+        add<float>(absl::Span<float>(mod, numFrames), gainSpan);
+}
+
 void sfz::EQHolder::setSampleRate(float sampleRate)
 {
     eq->init(static_cast<double>(sampleRate));
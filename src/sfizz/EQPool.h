@@ -2,12 +2,15 @@
 #include "SfzFilter.h"
 #include "Defaults.h"
 #include "modulations/ModMatrix.h"
+#include <absl/types/optional.h>
+#include <absl/types/span.h>
 #include <vector>
 #include <memory>
 
 namespace sfz {
 struct Region;
 class Resources;
+class FilterBank;
 struct EQDescription;
 
 class EQHolder
@@ -31,6 +34,21 @@ public:
      * @param numFrames
      */
     void process(const float** inputs, float** outputs, unsigned numFrames);
+    /**
+     * @brief Check whether the EQ is a biquad, which can be queued into a
+     * filter bank instead of being processed alone.
+     */
+    bool isBiquad() const;
+    /**
+     * @brief Queue a block of a biquad EQ into a filter bank, which then
+     * processes it in place in the buffers of the lanes.
+     *
+     * @param bank       the filter bank
+     * @param firstLane  the lane of the first channel
+     * @param stage      the position of the EQ in the chain
+     * @param numFrames
+     */
+    void queue(FilterBank& bank, unsigned firstLane, unsigned stage, unsigned numFrames);
     /**
      * @brief Set the sample rate for the EQ
      *
@@ -42,8 +60,11 @@ public:
      */
     void reset();
 private:
+    int currentQuality() const;
+    void computeParameters(absl::Span<float> frequencySpan, absl::Span<float> bandwidthSpan, absl::Span<float> gainSpan);
     Resources& resources;
-    const EQDescription* description;
+    const EQDescription* description { nullptr };
+    absl::optional<int> regionQuality; // the filter quality of the region, if set
     std::unique_ptr<FilterEq> eq;
     float baseBandwidth { Default::eqBandwidth };
     float baseFrequency { Default::eqFrequency };
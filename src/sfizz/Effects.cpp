@@ -23,6 +23,7 @@
 #include "effects/Rectify.h"
 #include "effects/Gain.h"
 #include "effects/Width.h"
+#include "effects/Convolution.h"
 #include <algorithm>
 
 namespace sfz {
@@ -40,6 +41,7 @@ void EffectFactory::registerStandardEffectTypes()
     registerEffectType("disto", fx::Disto::makeInstance);
     registerEffectType("strings", fx::Strings::makeInstance);
     registerEffectType("fverb", fx::Fverb::makeInstance);
+    registerEffectType("convolution", fx::Convolution::makeInstance);
 
     // extensions (book)
     registerEffectType("rectify", fx::Rectify::makeInstance);
@@ -98,6 +100,7 @@ EffectBus::~EffectBus()
 void EffectBus::addEffect(std::unique_ptr<Effect> fx)
 {
     _effects.emplace_back(std::move(fx));
+    updateTailLength();
 }
 
 const Effect* EffectBus::effectView(unsigned index) const
@@ -110,8 +113,12 @@ const Effect* EffectBus::effectView(unsigned index) const
 
 void EffectBus::clearInputs(unsigned nframes)
 {
-    AudioSpan<float>(_inputs).first(nframes).fill(0.0f);
-    AudioSpan<float>(_outputs).first(nframes).fill(0.0f);
+    if (_inputsActive) {
+        AudioSpan<float>(_inputs).first(nframes).fill(0.0f);
+        _inputsActive = false;
+    }
+    if (!_quiescent)
+        AudioSpan<float>(_outputs).first(nframes).fill(0.0f);
 }
 
 void EffectBus::addToInputs(const float* const addInput[], float addGain, unsigned nframes)
@@ -123,11 +130,12 @@ void EffectBus::addToInputs(const float* const addInput[], float addGain, unsign
         absl::Span<const float> addIn { addInput[c], nframes };
         sfz::multiplyAdd1(addGain, addIn, _inputs.getSpan(c).first(nframes));
     }
+    _inputsActive = true;
 }
 
 void EffectBus::applyGain(const float* gain, unsigned nframes)
 {
-    if (!gain)
+    if (!gain || !_inputsActive)
         return;
 
     absl::Span<const float> gainSpan { gain, nframes };
@@ -138,18 +146,66 @@ void EffectBus::applyGain(const float* gain, unsigned nframes)
 
 void EffectBus::setSampleRate(double sampleRate)
 {
+    _sampleRate = sampleRate;
     for (const auto& effectPtr : _effects)
         effectPtr->setSampleRate(sampleRate);
+    updateTailLength();
 }
 
 void EffectBus::clear()
 {
     for (const auto& effectPtr : _effects)
         effectPtr->clear();
+    _quiescent = true;
+}
+
+void EffectBus::loadFiles(FilePool& filePool)
+{
+    for (const auto& effectPtr : _effects)
+        effectPtr->loadFiles(filePool);
+    updateTailLength();
+}
+
+void EffectBus::setFreewheeling(bool freewheeling)
+{
+    for (const auto& effectPtr : _effects)
+        effectPtr->setFreewheeling(freewheeling);
+}
+
+void EffectBus::updateTailLength()
+{
+    _tailLength = 0;
+    _decayingTail = false;
+    for (const auto& effectPtr : _effects) {
+        _tailLength += effectPtr->getTailLength();
+        _decayingTail = _decayingTail || effectPtr->hasDecayingTail();
+    }
+}
+
+static bool isSilent(const AudioBuffer<float>& buffer, unsigned nframes)
+{
+    constexpr float threshold = config::effectSilenceThreshold;
+    for (unsigned c = 0; c < EffectChannels; ++c) {
+        if (!allWithin(buffer.getConstSpan(c).first(nframes), -threshold, threshold))
+            return false;
+    }
+    return true;
 }
 
 void EffectBus::process(unsigned nframes)
 {
+    const bool inputsSilent = !_inputsActive || isSilent(_inputs, nframes);
+    if (inputsSilent && _quiescent)
+        return;
+
+    if (inputsSilent)
+        _silentInputFrames += nframes;
+    else {
+        _silentInputFrames = 0;
+        _silentOutputFrames = 0;
+        _quiescent = false;
+    }
+
     size_t numEffects = _effects.size();
 
     // TODO: Can we have only one buffer and pass stuff without copies?
@@ -163,10 +219,30 @@ void EffectBus::process(unsigned nframes)
         fx::Nothing().process(
             AudioSpan<float>(_inputs), AudioSpan<float>(_outputs), nframes);
     }
+
+    if (!inputsSilent || _silentInputFrames < _tailLength)
+        return;
+
+    // The inputs were silent long enough for the tails to end; the effects
+    // which ring for longer must also have their output silent for a while
+    if (_decayingTail) {
+        if (!isSilent(_outputs, nframes)) {
+            _silentOutputFrames = 0;
+            return;
+        }
+        _silentOutputFrames += nframes;
+        if (_silentOutputFrames < config::effectSilenceTime * _sampleRate)
+            return;
+    }
+
+    _quiescent = true;
 }
 
 void EffectBus::mixOutputsTo(float* const mainOutput[], float* const mixOutput[], unsigned nframes)
 {
+    if (_quiescent)
+        return;
+
     const float gainToMain = _gainToMain;
     const float gainToMix = _gainToMix;
 
@@ -15,6 +15,7 @@
 
 namespace sfz {
 struct Opcode;
+class FilePool;
 
 enum {
     // Number of channels processed by effects
@@ -23,6 +24,13 @@ enum {
 
 /**
    @brief Abstract base of SFZ effects
+
+   An effect bus stops processing once its inputs have been silent for the
+   sum of the `getTailLength()` of its effects, and, if any of them
+   `hasDecayingTail()`, once its output has then stayed silent for a while.
+   The defaults suit an effect which may ring for an unknown duration; an
+   effect whose output is silent as soon as its input is keeps a tail length
+   of 0 and overrides `hasDecayingTail()` to return false.
  */
 class Effect {
 public:
@@ -49,6 +57,32 @@ public:
      */
     virtual void process(const float* const inputs[], float* const outputs[], unsigned nframes) = 0;
 
+    /**
+       @brief Gets the number of frames during which the effect can still
+              produce output after its input became silent, such as the
+              length of a delay line.
+     */
+    virtual size_t getTailLength() const { return 0; }
+
+    /**
+       @brief Checks whether the effect keeps ringing past its tail length,
+              with a decay of unknown duration. Such an effect is considered
+              quiescent once its output has stayed silent for a while.
+     */
+    virtual bool hasDecayingTail() const { return true; }
+
+    /**
+       @brief Loads the files which the effect refers to, such as an impulse
+              response, once the root directory of the instrument is known.
+     */
+    virtual void loadFiles(FilePool& /* filePool */) {}
+
+    /**
+       @brief Sets whether the rendering is offline, so the effect can wait
+              for its background work instead of skipping it when late.
+     */
+    virtual void setFreewheeling(bool /* freewheeling */) {}
+
     /**
        @brief Type of the factory function used to instantiate an effect given
               the contents of the <effect> block
@@ -160,11 +194,28 @@ public:
      */
     void clear();
 
+    /**
+       @brief Loads the files which the effects in the bus refer to.
+     */
+    void loadFiles(FilePool& filePool);
+
+    /**
+       @brief Sets whether the rendering of all effects in the bus is offline.
+     */
+    void setFreewheeling(bool freewheeling);
+
     /**
        @brief Computes a cycle of the effect bus.
      */
     void process(unsigned nframes);
 
+    /**
+       @brief Checks whether the bus is idle: its inputs are silent and the
+              tails of its effects have decayed. An idle bus neither processes
+              nor mixes anything, until some signal comes into its inputs.
+     */
+    bool isQuiescent() const noexcept { return _quiescent; }
+
     /**
        @brief Mixes the outputs into a pair of stereo signals: Main and Mix.
      */
@@ -184,11 +235,20 @@ public:
      */
     size_t numEffects() const noexcept;
 private:
+    void updateTailLength();
+
     std::vector<std::unique_ptr<Effect>> _effects;
     AudioBuffer<float> _inputs { EffectChannels, config::defaultSamplesPerBlock };
     AudioBuffer<float> _outputs { EffectChannels, config::defaultSamplesPerBlock };
     float _gainToMain { Default::effect };
     float _gainToMix { Default::effect };
+    double _sampleRate { config::defaultSampleRate };
+    bool _inputsActive { false };
+    bool _quiescent { true };
+    size_t _silentInputFrames { 0 };
+    size_t _silentOutputFrames { 0 };
+    size_t _tailLength { 0 };
+    bool _decayingTail { false };
 };
 
 } // namespace sfz
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "EventQueue.h"
+
+namespace sfz {
+
+EventQueue::EventQueue(unsigned capacity)
+    : queue_(capacity)
+{
+    pending_.reserve(queue_.capacity());
+}
+
+bool EventQueue::push(const QueuedEvent& event) noexcept
+{
+    return queue_.try_push(event);
+}
+
+void EventQueue::collectPending() noexcept
+{
+    // Keep the pending events sorted by timestamp with an insertion, since
+    // they mostly arrive in order; ties keep the order of arrival
+    QueuedEvent event;
+    while (pending_.size() < pending_.capacity() && queue_.try_pop(event)) {
+        size_t position = pending_.size();
+        pending_.push_back(event);
+        while (position > 0 && pending_[position - 1].frame > event.frame) {
+            pending_[position] = pending_[position - 1];
+            --position;
+        }
+        pending_[position] = event;
+    }
+}
+
+} // namespace sfz
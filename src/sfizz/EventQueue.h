@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <atomic_queue/atomic_queue.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief An event posted to the synth, timestamped in frames.
+ */
+struct QueuedEvent {
+    enum class Type : uint8_t {
+        Midi, //!< a MIDI 1.0 channel message, in `data`
+        Hdcc, //!< a high-precision CC, in `number` and `value`
+    };
+
+    int64_t frame { 0 };
+    Type type { Type::Midi };
+    uint8_t data[3] {};
+    uint16_t number { 0 };
+    float value { 0.0f };
+};
+
+/**
+ * @brief A bounded queue of timestamped events, which any number of threads
+ * can post to without locking, and which the audio thread drains block by
+ * block.
+ *
+ * The timestamps are frames on the clock of the queue, which starts at 0 and
+ * advances by the size of each drained block. Events which are due before
+ * the block are dispatched at its start, and events due after it are kept
+ * until their block comes. A negative timestamp means as soon as possible.
+ */
+class EventQueue {
+public:
+    /**
+     * @brief Construct a new queue.
+     *
+     * @param capacity the minimum number of events which can wait in the
+     *                 queue; the actual capacity can be larger
+     */
+    explicit EventQueue(unsigned capacity);
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    /**
+     * @brief Post an event. This can be called from any thread.
+     *
+     * @return false if the queue is full and the event was dropped
+     */
+    bool push(const QueuedEvent& event) noexcept;
+
+    /**
+     * @brief Get the frame at which the next block starts.
+     * This can be called from any thread.
+     */
+    int64_t getFrameTime() const noexcept { return frameTime_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Dispatch the events due within the next block, in order of
+     * timestamp, and advance the clock past this block. This must be called
+     * from the audio thread only.
+     *
+     * @param numFrames the size of the block
+     * @param dispatch a callable `void(const QueuedEvent& event, int delay)`
+     */
+    template <class F>
+    void drain(unsigned numFrames, F&& dispatch) noexcept
+    {
+        const int64_t blockStart = frameTime_.load(std::memory_order_relaxed);
+        const int64_t blockEnd = blockStart + numFrames;
+        collectPending();
+
+        size_t numKept = 0;
+        for (const QueuedEvent& event : pending_) {
+            if (event.frame >= blockEnd) {
+                pending_[numKept++] = event;
+                continue;
+            }
+            const int64_t delay = event.frame - blockStart;
+            dispatch(event, delay > 0 ? static_cast<int>(delay) : 0);
+        }
+        pending_.resize(numKept);
+
+        frameTime_.store(blockEnd, std::memory_order_relaxed);
+    }
+
+private:
+    void collectPending() noexcept;
+
+    atomic_queue::AtomicQueueB2<QueuedEvent> queue_;
+    std::vector<QueuedEvent> pending_;
+    std::atomic<int64_t> frameTime_ { 0 };
+};
+
+} // namespace sfz
@@ -24,14 +24,18 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "FilePool.h"
+#include "PreloadCache.h"
+#include "SampleStore.h"
 #include "AudioReader.h"
 #include "Buffer.h"
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
+#include "MappedFile.h"
 #include "Config.h"
 #include "utility/SwapAndPop.h"
 #include "utility/Debug.h"
 #include <ThreadPool.h>
+#include <absl/algorithm/container.h>
 #include <absl/types/span.h>
 #include <absl/strings/match.h>
 #include <absl/memory/memory.h>
@@ -77,17 +81,10 @@ void readBaseFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, uint32
 
     const unsigned channels = reader.channels();
 
-    if (channels == 1) {
-        output.addChannel();
+    if (channels == 1 || channels == 2) {
+        output.addChannels(channels);
         output.clear();
-        reader.readNextBlock(output.channelWriter(0), numFrames);
-    } else if (channels == 2) {
-        output.addChannel();
-        output.addChannel();
-        output.clear();
-        sfz::Buffer<float> tempReadBuffer { 2 * numFrames };
-        reader.readNextBlock(tempReadBuffer.data(), numFrames);
-        sfz::readInterleaved(tempReadBuffer, output.getSpan(0), output.getSpan(1));
+        reader.readNextBlockPlanar(output);
     }
 }
 
@@ -101,7 +98,6 @@ sfz::FileAudioBuffer readFromFile(sfz::AudioReader& reader, uint32_t numFrames)
 void streamFromFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, std::atomic<size_t>* filledFrames = nullptr)
 {
     const auto numFrames = static_cast<size_t>(reader.frames());
-    const auto numChannels = reader.channels();
     const auto chunkSize = static_cast<size_t>(sfz::config::fileChunkSize);
 
     output.reset();
@@ -109,51 +105,230 @@ void streamFromFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, std:
     output.resize(numFrames);
     output.clear();
 
-    sfz::Buffer<float> fileBlock { chunkSize * numChannels };
-    size_t inputFrameCounter { 0 };
-    size_t outputFrameCounter { 0 };
-    bool inputEof = false;
+    size_t frameCounter { 0 };
 
-    while (!inputEof && inputFrameCounter < numFrames)
+    while (frameCounter < numFrames)
     {
-        auto thisChunkSize = std::min(chunkSize, numFrames - inputFrameCounter);
-        const auto numFramesRead = static_cast<size_t>(
-            reader.readNextBlock(fileBlock.data(), thisChunkSize));
+        const auto thisChunkSize = std::min(chunkSize, numFrames - frameCounter);
+        const auto outputChunk = sfz::AudioSpan<float>(output).subspan(frameCounter, thisChunkSize);
+        const auto numFramesRead = reader.readNextBlockPlanar(outputChunk);
         if (numFramesRead == 0)
             break;
 
-        if (numFramesRead < thisChunkSize) {
-            inputEof = true;
-            thisChunkSize = numFramesRead;
-        }
-        const auto outputChunkSize = thisChunkSize;
-
-        for (size_t chanIdx = 0; chanIdx < numChannels; chanIdx++) {
-            const auto outputChunk = output.getSpan(chanIdx).subspan(outputFrameCounter, outputChunkSize);
-            for (size_t i = 0; i < thisChunkSize; ++i)
-                outputChunk[i] = fileBlock[i * numChannels + chanIdx];
-        }
-        inputFrameCounter += thisChunkSize;
-        outputFrameCounter += outputChunkSize;
+        frameCounter += numFramesRead;
 
         if (filledFrames != nullptr)
-            filledFrames->fetch_add(outputChunkSize);
+            filledFrames->fetch_add(numFramesRead);
+
+        if (numFramesRead < thisChunkSize)
+            break;
     }
 }
 
-sfz::FilePool::FilePool()
-    : filesToLoad(alignedNew<FileQueue>()),
-      threadPool(globalThreadPool())
+/**
+ * @brief Get the end of a stream, which goes on with the zeroes past the end of
+ * the file like the file buffers padding. A stream which loops has no end until
+ * the voice decides when it leaves the loop.
+ */
+static size_t getStreamEnd(const sfz::FileStream& stream, size_t fileFrames)
 {
-    loadingJobs.reserve(config::maxVoices);
-    lastUsedFiles.reserve(config::maxVoices);
-    garbageToCollect.reserve(config::maxVoices);
+    const size_t paddedFrames = fileFrames + sfz::config::excessFileFrames;
+    if (stream.getLoopSize() == 0)
+        return max(stream.startFrame, paddedFrames);
+
+    const size_t exit = stream.appliedLoopExit;
+    if (exit == std::numeric_limits<size_t>::max())
+        return exit;
+
+    const size_t loopEnd = static_cast<size_t>(stream.loopLast + 1);
+    return exit + (paddedFrames > loopEnd ? paddedFrames - loopEnd : 0);
 }
 
-sfz::FilePool::~FilePool()
+/**
+ * @brief Move the reader of a stream to a frame of the file, reading up to it
+ * if the reader cannot seek.
+ */
+static bool seekReader(sfz::FileStream& stream, int64_t frame, sfz::Buffer<float>& block)
+{
+    if (stream.reader->seek(static_cast<uint64_t>(frame))) {
+        stream.readerFrame = frame;
+        return true;
+    }
+
+    if (frame < stream.readerFrame) {
+        DBG("[sfizz] Could not move a stream back to frame " << frame);
+        return false;
+    }
+
+    const size_t chunkSize = block.size() / stream.reader->channels();
+    while (stream.readerFrame < frame) {
+        const size_t toSkip = min(chunkSize, static_cast<size_t>(frame - stream.readerFrame));
+        const size_t skipped = stream.reader->readNextBlock(block.data(), toSkip);
+        if (skipped == 0)
+            return false;
+        stream.readerFrame += static_cast<int64_t>(skipped);
+    }
+
+    return true;
+}
+
+sfz::FileStream::FileStream()
+{
+}
+
+sfz::FileStream::~FileStream()
+{
+}
+
+void sfz::FileStream::start(int64_t first, int64_t last, uint32_t exitLap) noexcept
+{
+    if (status.load() != Status::Acquired)
+        return;
+
+    loopFirst = first;
+    loopLast = last;
+    const size_t loopSize = getLoopSize();
+    size_t exit = std::numeric_limits<size_t>::max();
+    if (loopSize > 0 && exitLap != noLoopExit)
+        exit = static_cast<size_t>(last + 1) + exitLap * loopSize;
+    loopExit = exit;
+    loopExitPending = false;
+    appliedLoopExit = exit;
+    status = Status::Starting;
+
+    std::error_code ec;
+    wakeup->post(ec);
+}
+
+void sfz::FileStream::leaveLoop(uint32_t lap) noexcept
+{
+    const size_t loopSize = getLoopSize();
+    if (loopSize == 0)
+        return;
+
+    loopExit = static_cast<size_t>(loopLast + 1) + lap * loopSize;
+    loopExitPending = true;
+
+    std::error_code ec;
+    wakeup->post(ec);
+}
+
+int64_t sfz::FileStream::getFileFrame(size_t position, size_t& numFrames) const noexcept
+{
+    const size_t loopSize = getLoopSize();
+    const int64_t frame = static_cast<int64_t>(position);
+    if (loopSize == 0) {
+        numFrames = std::numeric_limits<size_t>::max();
+        return frame;
+    }
+
+    if (frame <= loopLast) {
+        numFrames = static_cast<size_t>(loopLast + 1 - frame);
+        return frame;
+    }
+
+    if (position >= appliedLoopExit) {
+        numFrames = std::numeric_limits<size_t>::max();
+        return loopLast + 1 + static_cast<int64_t>(position - appliedLoopExit);
+    }
+
+    const size_t lapOffset = (position - static_cast<size_t>(loopLast + 1)) % loopSize;
+    numFrames = min(loopSize - lapOffset, appliedLoopExit - position);
+    return loopFirst + static_cast<int64_t>(lapOffset);
+}
+
+sfz::AudioSpan<const float> sfz::FileStream::getFrames(size_t start, size_t end) noexcept
+{
+    const size_t ringFrames = static_cast<size_t>(config::streamingRingFrames);
+
+    if (status.load() != Status::Streaming)
+        return {};
+
+    if (start < readPosition.load() || end - start > static_cast<size_t>(config::streamingGuardFrames))
+        return {};
+
+    // The frames past a new loop exit are rewritten, and the ones before the
+    // window are not needed anymore
+    readPosition.store(start);
+    const bool rewriting = loopExitPending.load() && end > loopExit.load();
+    if (rewriting || end > writePosition.load()) {
+        // Late, wake up the streaming thread
+        std::error_code ec;
+        wakeup->post(ec);
+        return {};
+    }
+
+    if (start >= notifiedPosition + ringFrames / 4) {
+        notifiedPosition = start;
+        std::error_code ec;
+        wakeup->post(ec);
+    }
+
+    const size_t offset = (start - startFrame) % ringFrames;
+    return AudioSpan<const float>(ring).subspan(offset, end - start);
+}
+
+void sfz::FileStream::skipTo(size_t position) noexcept
+{
+    const size_t ringFrames = static_cast<size_t>(config::streamingRingFrames);
+
+    if (status.load() != Status::Streaming || position <= readPosition.load())
+        return;
+
+    readPosition.store(position);
+    if (position >= notifiedPosition + ringFrames / 4) {
+        notifiedPosition = position;
+        std::error_code ec;
+        wakeup->post(ec);
+    }
+}
+
+bool sfz::FileStream::isSettled() const noexcept
+{
+    switch (status.load()) {
+    case Status::Acquired:
+    case Status::Starting:
+        return false;
+    case Status::Streaming: {
+        if (loopExitPending.load())
+            return false;
+        const size_t target = min(readPosition.load() + config::streamingRingFrames, endFrame.load());
+        return writePosition.load() >= target;
+    }
+    default:
+        return true;
+    }
+}
+
+sfz::SampleSpan sfz::FileDataHolder::getStreamedData(int64_t first, int64_t last, int64_t& offset) noexcept
+{
+    ASSERT(stream);
+    const int64_t margin = config::excessFileFrames;
+
+    // Before the first frame, the interpolation reads into the ring padding
+    offset = max(int64_t(0), first - margin);
+    return stream->getFrames(static_cast<size_t>(offset), static_cast<size_t>(last + margin + 1));
+}
+
+sfz::FilePoolWorkers::FilePoolWorkers()
+    : streams(new FileStream[config::maxFileStreams])
+{
+    for (int i = 0; i < config::maxFileStreams; ++i)
+        streams[i].wakeup = &streamingBarrier;
+
+    dispatchThread = std::thread(&FilePoolWorkers::dispatchingJob, this);
+    garbageThread = std::thread(&FilePoolWorkers::garbageJob, this);
+    streamingThread = std::thread(&FilePoolWorkers::streamingJob, this);
+}
+
+sfz::FilePoolWorkers::~FilePoolWorkers()
 {
     std::error_code ec;
 
+    streamingFlag = false;
+    streamingBarrier.post(ec);
+    streamingThread.join();
+
     garbageFlag = false;
     semGarbageBarrier.post(ec);
     garbageThread.join();
@@ -161,11 +336,60 @@ sfz::FilePool::~FilePool()
     dispatchFlag = false;
     dispatchBarrier.post(ec);
     dispatchThread.join();
+}
+
+void sfz::FilePoolWorkers::attach(FilePool& pool)
+{
+    std::lock_guard<std::mutex> lock { poolsMutex };
+    pools.push_back(&pool);
+}
+
+void sfz::FilePoolWorkers::detach(FilePool& pool)
+{
+    std::lock_guard<std::mutex> lock { poolsMutex };
+    pools.erase(std::remove(pools.begin(), pools.end(), &pool), pools.end());
+}
+
+sfz::FilePool::FilePool()
+    : filesToLoad(alignedNew<FileQueue>()),
+      threadPool(globalThreadPool()),
+      preloadCache(new PreloadCache)
+{
+    loadingJobs.reserve(config::maxVoices);
+    lastUsedFiles.reserve(config::maxVoices);
+    garbageToCollect.reserve(config::maxVoices);
+}
+
+sfz::FilePool::~FilePool()
+{
+    // The threads do not serve the pool anymore once detached
+    if (workers)
+        workers->detach(*this);
 
     for (auto& job : loadingJobs)
         job.wait();
 }
 
+void sfz::FilePool::startWorkers()
+{
+    if (workers)
+        return;
+
+    workers = std::make_shared<FilePoolWorkers>();
+    workers->attach(*this);
+}
+
+void sfz::FilePool::shareWorkers(const FilePool& other)
+{
+    if (!other.workers || workers == other.workers)
+        return;
+
+    if (workers)
+        workers->detach(*this);
+    workers = other.workers;
+    workers->attach(*this);
+}
+
 bool sfz::FilePool::checkSample(std::string& filename) const noexcept
 {
     fs::path path { rootDirectory / filename };
@@ -279,6 +503,45 @@ absl::optional<sfz::FileInformation> getReaderInformation(sfz::AudioReader* read
     return returnedValue;
 }
 
+/**
+ * @brief Read the whole content of a file in memory, as it is stored on disk.
+ */
+static sfz::EncodedFileData readEncodedFile(const fs::path& path) noexcept
+{
+    sfz::MappedFile file;
+    if (!file.open(path)) {
+        DBG("[sfizz] Cannot read the file " << path << " in memory");
+        return {};
+    }
+    return std::make_shared<std::vector<char>>(file.data(), file.data() + file.size());
+}
+
+sfz::AudioReaderPtr sfz::FilePool::createFileReader(const FileId& fileId, const FileData& fileData, std::error_code* ec) const noexcept
+{
+    if (const EncodedFileData& encoded = fileData.encodedData)
+        return createAudioReaderFromMemory(encoded->data(), encoded->size(), fileId.isReverse(), ec);
+
+    const fs::path file { rootDirectory / fileId.filename() };
+    return createAudioReader(file, fileId.isReverse(), ec);
+}
+
+sfz::PreloadedFramesPtr sfz::FilePool::readPreloadedFrames(const FileId& fileId, const FileData& fileData, uint32_t numFrames) const noexcept
+{
+    SampleStore::Key key;
+    if (sampleStore) {
+        key = SampleStore::makeKey(rootDirectory / fileId.filename(), fileId.isReverse(), fileData.information);
+        if (PreloadedFramesPtr shared = sampleStore->find(key, sampleFormat, numFrames))
+            return shared;
+    }
+
+    AudioReaderPtr reader = createFileReader(fileId, fileData);
+    auto frames = std::make_shared<PreloadedFrames>(readFromFile(*reader, numFrames), sampleFormat);
+    if (sampleStore)
+        return sampleStore->insert(key, sampleFormat, std::move(frames));
+
+    return frames;
+}
+
 absl::optional<sfz::FileInformation> sfz::FilePool::checkExistingFileInformation(const FileId& fileId) noexcept
 {
     const auto loadedFile = loadedFiles.find(fileId);
@@ -289,6 +552,10 @@ absl::optional<sfz::FileInformation> sfz::FilePool::checkExistingFileInformation
     if (preloadedFile != preloadedFiles.end())
         return preloadedFile->second.information;
 
+    const auto prefetched = prefetchedInformation.find(fileId);
+    if (prefetched != prefetchedInformation.end())
+        return prefetched->second;
+
     return {};
 }
 
@@ -299,60 +566,267 @@ absl::optional<sfz::FileInformation> sfz::FilePool::getFileInformation(const Fil
         return existingInformation;
 
     const fs::path file { rootDirectory / fileId.filename() };
+    return readFileInformation(file, fileId.isReverse());
+}
+
+/**
+ * @brief Read the size and modification time of a file into its information.
+ */
+static bool readFileStamp(const fs::path& file, sfz::FileInformation& information) noexcept
+{
+    std::error_code ec;
+    const auto size = fs::file_size(file, ec);
+    if (ec)
+        return false;
 
+    const auto modificationTime = fs::last_write_time(file, ec);
+    if (ec)
+        return false;
+
+    information.fileSize = static_cast<uint64_t>(size);
+    information.modificationTime = static_cast<int64_t>(modificationTime.time_since_epoch().count());
+    return true;
+}
+
+absl::optional<sfz::FileInformation> sfz::FilePool::readFileInformation(const fs::path& file, bool reverse) const noexcept
+{
     if (!fs::exists(file))
         return {};
 
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
-    return getReaderInformation(reader.get());
+    absl::optional<FileInformation> information;
+    if (auto cacheEntry = preloadCache->find(file, reverse)) {
+        information = cacheEntry->getInformation();
+    } else {
+        AudioReaderPtr reader = createAudioReader(file, reverse);
+        information = getReaderInformation(reader.get());
+    }
+
+    if (information)
+        readFileStamp(file, *information);
+    return information;
 }
 
-bool sfz::FilePool::preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept
+bool sfz::FilePool::hasChangedOnDisk(const FileId& fileId, const FileInformation& information) const noexcept
 {
-    const auto loadedFile = loadedFiles.find(fileId);
-    if (loadedFile != loadedFiles.end()) {
-        loadedFile->second.preloadCallCount++;
+    // Files loaded from memory have no state on disk
+    if (information.fileSize == 0 && information.modificationTime == 0)
+        return false;
+
+    FileInformation current;
+    if (!readFileStamp(rootDirectory / fileId.filename(), current))
         return true;
+
+    return current.fileSize != information.fileSize
+        || current.modificationTime != information.modificationTime;
+}
+
+void sfz::FilePool::setPreloadCacheDirectory(const fs::path& directory) noexcept
+{
+    preloadCache->setDirectory(directory);
+}
+
+const fs::path& sfz::FilePool::getPreloadCacheDirectory() const noexcept
+{
+    return preloadCache->getDirectory();
+}
+
+void sfz::FilePool::prefetchFileInformation(absl::Span<const FileId> fileIds) noexcept
+{
+    absl::flat_hash_map<FileId, std::future<absl::optional<FileInformation>>> jobs;
+    jobs.reserve(fileIds.size());
+
+    for (const FileId& fileId : fileIds) {
+        if (jobs.contains(fileId) || checkExistingFileInformation(fileId))
+            continue;
+
+        const fs::path file { rootDirectory / fileId.filename() };
+        const bool reverse = fileId.isReverse();
+        jobs[fileId] = threadPool->enqueue([this, file, reverse]() -> absl::optional<FileInformation> {
+            return readFileInformation(file, reverse);
+        });
     }
 
-    auto fileInformation = getFileInformation(fileId);
-    if (!fileInformation)
-        return false;
+    for (auto& job : jobs) {
+        auto information = job.second.get();
+        if (information)
+            prefetchedInformation[job.first] = std::move(*information);
+    }
+}
 
-    fileInformation->maxOffset = maxOffset;
-    const fs::path file { rootDirectory / fileId.filename() };
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+bool sfz::FilePool::preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept
+{
+    const std::pair<FileId, uint32_t> file { fileId, maxOffset };
+    return preloadFiles({ &file, 1 }) == 1;
+}
 
-    const auto frames = static_cast<uint32_t>(reader->frames());
-    const auto framesToLoad = [&]() {
-        if (loadInRam)
-            return frames;
-        else
-            return min(frames, maxOffset + preloadSize);
-    }();
-
-    const auto existingFile = preloadedFiles.find(fileId);
-    if (existingFile != preloadedFiles.end()) {
-        auto& fileData = existingFile->second;
-        if (framesToLoad > fileData.preloadedData.getNumFrames()) {
-            fileData.information.maxOffset = maxOffset;
-            fileData.preloadedData = readFromFile(*reader, framesToLoad);
-            fileData.fullyLoaded = frames == framesToLoad;
+size_t sfz::FilePool::preloadFiles(absl::Span<const std::pair<FileId, uint32_t>> files) noexcept
+{
+    struct PreloadResult {
+        uint32_t frames { 0 };
+        uint32_t framesToLoad { 0 };
+        double sampleRate { 0 };
+        PreloadedFramesPtr preloaded;
+        EncodedFileData encodedData;
+    };
+
+    struct PreloadJob {
+        const FileId* fileId { nullptr };
+        uint32_t maxOffset { 0 };
+        FileInformation information;
+        std::future<PreloadResult> result;
+    };
+
+    startWorkers();
+
+    std::vector<PreloadJob> jobs;
+    jobs.reserve(files.size());
+    size_t numPreloaded = 0;
+
+    // Open and read the files in the background, each job only depends on
+    // the state of the pool before any of them completes
+    for (const auto& file : files) {
+        const FileId& fileId = file.first;
+        const uint32_t maxOffset = file.second;
+
+        const auto loadedFile = loadedFiles.find(fileId);
+        if (loadedFile != loadedFiles.end()) {
+            loadedFile->second.preloadCallCount++;
+            ++numPreloaded;
+            continue;
         }
-        fileData.preloadCallCount++;
-    } else {
-        fileInformation->sampleRate = static_cast<double>(reader->sampleRate());
-        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
-            readFromFile(*reader, framesToLoad),
-            *fileInformation
+
+        // Data read before the file changed on disk is read again
+        const auto staleFile = preloadedFiles.find(fileId);
+        if (staleFile != preloadedFiles.end() && staleFile->second.readerCount == 0
+            && hasChangedOnDisk(fileId, staleFile->second.information))
+            preloadedFiles.erase(staleFile);
+
+        auto fileInformation = getFileInformation(fileId);
+        if (!fileInformation)
+            continue;
+
+        const auto existingFile = preloadedFiles.find(fileId);
+        const bool hasExisting = existingFile != preloadedFiles.end();
+        const size_t existingFrames = hasExisting ? existingFile->second.getNumPreloadedFrames() : 0;
+
+        // Keep the data preloaded on a previous load if it is large enough
+        if (hasExisting) {
+            const uint32_t frames = fileInformation->end + 1;
+            const uint32_t framesToLoad = decodesWholeFiles() ? frames : min(frames, maxOffset + preloadSize);
+            if (framesToLoad <= existingFrames) {
+                FileData& fileData = existingFile->second;
+                fileData.information.maxOffset = max(fileData.information.maxOffset, static_cast<int64_t>(maxOffset));
+                fileData.preloadCallCount++;
+                ++numPreloaded;
+                continue;
+            }
+        }
+
+        const fs::path path { rootDirectory / fileId.filename() };
+        const bool reverse = fileId.isReverse();
+        const bool loadInRam = decodesWholeFiles();
+        const bool readEncoded = compressedStorage && !(hasExisting && existingFile->second.encodedData);
+        const uint32_t preloadSize = this->preloadSize;
+        const SampleFormat sampleFormat = this->sampleFormat;
+        const PreloadCache* cache = loadInRam ? nullptr : preloadCache.get();
+        const FileInformation information = *fileInformation;
+        const std::shared_ptr<SampleStore> store = sampleStore;
+        const SampleStore::Key storeKey = store ? SampleStore::makeKey(path, reverse, information) : SampleStore::Key();
+
+        PreloadJob job;
+        job.fileId = &fileId;
+        job.maxOffset = maxOffset;
+        job.information = *fileInformation;
+        job.result = threadPool->enqueue([=]() -> PreloadResult {
+            PreloadResult result;
+            if (readEncoded)
+                result.encodedData = readEncodedFile(path);
+
+            // Use the frames of another pool if it holds enough of them
+            if (store) {
+                const uint32_t frames = static_cast<uint32_t>(information.end + 1);
+                const uint32_t framesToLoad = loadInRam ? frames : min(frames, maxOffset + preloadSize);
+                if (!hasExisting || framesToLoad > existingFrames) {
+                    if (PreloadedFramesPtr shared = store->find(storeKey, sampleFormat, framesToLoad)) {
+                        result.frames = frames;
+                        result.framesToLoad = min(frames, static_cast<uint32_t>(shared->getNumFrames()));
+                        result.sampleRate = information.sampleRate;
+                        result.preloaded = std::move(shared);
+                        return result;
+                    }
+                }
+            }
+
+            // Copy the frames from the cache file if it stores enough of them
+            auto cacheEntry = cache ? cache->find(path, reverse) : nullptr;
+            if (cacheEntry) {
+                result.frames = cacheEntry->getNumFrames();
+                result.framesToLoad = min(result.frames, maxOffset + preloadSize);
+                result.sampleRate = cacheEntry->getInformation().sampleRate;
+                if (hasExisting && result.framesToLoad <= existingFrames)
+                    return result;
+                FileAudioBuffer data;
+                if (cacheEntry->readPreloadedData(data, result.framesToLoad)) {
+                    result.preloaded = std::make_shared<PreloadedFrames>(std::move(data), sampleFormat);
+                    if (store)
+                        result.preloaded = store->insert(storeKey, sampleFormat, std::move(result.preloaded));
+                    return result;
+                }
+            }
+
+            AudioReaderPtr reader = result.encodedData ?
+                createAudioReaderFromMemory(result.encodedData->data(), result.encodedData->size(), reverse) :
+                createAudioReader(path, reverse);
+            result.frames = static_cast<uint32_t>(reader->frames());
+            result.framesToLoad = loadInRam ? result.frames : min(result.frames, maxOffset + preloadSize);
+            result.sampleRate = static_cast<double>(reader->sampleRate());
+            if (!hasExisting || result.framesToLoad > existingFrames) {
+                FileAudioBuffer data = readFromFile(*reader, result.framesToLoad);
+                if (cache && cache->isEnabled())
+                    cache->store(path, reverse, information, result.frames, data);
+                result.preloaded = std::make_shared<PreloadedFrames>(std::move(data), sampleFormat);
+                if (store)
+                    result.preloaded = store->insert(storeKey, sampleFormat, std::move(result.preloaded));
+            }
+            return result;
         });
+        jobs.push_back(std::move(job));
+    }
 
-        insertedPair.first->second.preloadCallCount++;
-        insertedPair.first->second.status = FileData::Status::Preloaded;
-        insertedPair.first->second.fullyLoaded = framesToLoad == frames;
+    // Merge the results in order
+    for (PreloadJob& job : jobs) {
+        const FileId& fileId = *job.fileId;
+        PreloadResult result = job.result.get();
+
+        const auto existingFile = preloadedFiles.find(fileId);
+        if (existingFile != preloadedFiles.end()) {
+            auto& fileData = existingFile->second;
+            if (result.preloaded && result.framesToLoad > fileData.getNumPreloadedFrames()) {
+                fileData.information.maxOffset = job.maxOffset;
+                fileData.preloaded = std::move(result.preloaded);
+                fileData.fullyLoaded = result.frames == result.framesToLoad;
+            }
+            if (result.encodedData && !fileData.fullyLoaded)
+                fileData.encodedData = std::move(result.encodedData);
+            fileData.preloadCallCount++;
+        } else {
+            job.information.maxOffset = job.maxOffset;
+            job.information.sampleRate = result.sampleRate;
+            auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
+                std::move(result.preloaded),
+                job.information
+            });
+
+            insertedPair.first->second.preloadCallCount++;
+            insertedPair.first->second.status = FileData::Status::Preloaded;
+            insertedPair.first->second.fullyLoaded = result.framesToLoad == result.frames;
+            if (!insertedPair.first->second.fullyLoaded)
+                insertedPair.first->second.encodedData = std::move(result.encodedData);
+        }
+        ++numPreloaded;
     }
 
-    return true;
+    return numPreloaded;
 }
 
 void sfz::FilePool::resetPreloadCallCounts() noexcept
@@ -385,6 +859,8 @@ void sfz::FilePool::removeUnusedPreloadedData() noexcept
 
 sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
 {
+    startWorkers();
+
     auto fileInformation = getFileInformation(fileId);
     if (!fileInformation)
         return {};
@@ -396,11 +872,18 @@ sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
     }
 
     const fs::path file { rootDirectory / fileId.filename() };
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+    const SampleStore::Key storeKey = sampleStore ? SampleStore::makeKey(file, fileId.isReverse(), *fileInformation) : SampleStore::Key();
+    const auto frames = static_cast<uint32_t>(fileInformation->end + 1);
+    PreloadedFramesPtr loaded = sampleStore ? sampleStore->find(storeKey, SampleFormat::Float, frames) : nullptr;
+    if (!loaded) {
+        AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+        loaded = std::make_shared<PreloadedFrames>(readFromFile(*reader, static_cast<uint32_t>(reader->frames())));
+        if (sampleStore)
+            loaded = sampleStore->insert(storeKey, SampleFormat::Float, std::move(loaded));
+    }
 
-    const auto frames = static_cast<uint32_t>(reader->frames());
     auto insertedPair = loadedFiles.insert_or_assign(fileId, {
-        readFromFile(*reader, frames),
+        std::move(loaded),
         *fileInformation
     });
     insertedPair.first->second.preloadCallCount++;
@@ -411,6 +894,8 @@ sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
 
 sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::vector<char>& data) noexcept
 {
+    startWorkers();
+
     const auto loaded = loadedFiles.find(fileId);
     if (loaded != loadedFiles.end())
         return { &loaded->second };
@@ -429,7 +914,7 @@ sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::
     return { &insertedPair.first->second };
 }
 
-sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept
+sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId, bool streamable) noexcept
 {
     const auto loaded = loadedFiles.find(*fileId);
     if (loaded != loadedFiles.end())
@@ -442,6 +927,15 @@ sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>&
     }
 
     auto& fileData = preloaded->second;
+    const bool streaming = sampleStreaming || fileData.encodedData;
+    if (!fileData.fullyLoaded && streaming && streamable && fileData.status != FileData::Status::Done) {
+        if (FileStream* stream = acquireStream(fileId, fileData))
+            return { &fileData, stream };
+
+        // Out of streams, load the whole file instead
+        DBG("[sfizz] No stream available for " << fileId->filename());
+    }
+
     if (!fileData.fullyLoaded) {
         QueuedFileData queuedData { fileId, &fileData };
         if (!filesToLoad->try_push(queuedData)) {
@@ -450,17 +944,45 @@ sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>&
         }
 
         std::error_code ec;
-        dispatchBarrier.post(ec);
+        workers->dispatchBarrier.post(ec);
         ASSERT(!ec);
     }
 
     return { &preloaded->second };
 }
 
+sfz::FileStream* sfz::FilePool::acquireStream(const std::shared_ptr<FileId>& fileId, const FileData& fileData) noexcept
+{
+    for (int i = 0; i < config::maxFileStreams; ++i) {
+        FileStream& stream = workers->streams[i];
+        FileStream::Status status = FileStream::Status::Free;
+        if (!stream.status.compare_exchange_strong(status, FileStream::Status::Acquired))
+            continue;
+
+        // Start early enough to cover the windows which overlap the preload end
+        const size_t preloadedFrames = fileData.getNumPreloadedFrames();
+        const size_t guardFrames = static_cast<size_t>(config::streamingGuardFrames);
+        const size_t startFrame = preloadedFrames > guardFrames ? preloadedFrames - guardFrames : 0;
+
+        // The stream waits for the voice to start it, once it knows the loop
+        stream.id = fileId;
+        stream.pool = this;
+        stream.encodedData = fileData.encodedData;
+        stream.startFrame = startFrame;
+        stream.endFrame = startFrame;
+        stream.writePosition = startFrame;
+        stream.readPosition = startFrame;
+        stream.notifiedPosition = startFrame;
+        return &stream;
+    }
+
+    return nullptr;
+}
+
 void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
 {
     this->preloadSize = preloadSize;
-    if (loadInRam)
+    if (decodesWholeFiles())
         return;
 
     // Update all the preloaded sizes
@@ -468,12 +990,13 @@ void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
         auto& fileId = preloadedFile.first;
         auto& fileData = preloadedFile.second;
         const auto maxOffset = fileData.information.maxOffset;
-        fs::path file { rootDirectory / fileId.filename() };
-        AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
-        const auto frames = reader->frames();
+        const auto frames = fileData.information.end + 1;
         const auto framesToLoad = min(frames, maxOffset + preloadSize);
-        fileData.preloadedData = readFromFile(*reader, static_cast<uint32_t>(framesToLoad));
-        fileData.fullyLoaded = frames == framesToLoad;
+        // Drop the frames first, so that they are only found in the store
+        // if another pool uses them
+        fileData.preloaded.reset();
+        fileData.preloaded = readPreloadedFrames(fileId, fileData, static_cast<uint32_t>(framesToLoad));
+        fileData.fullyLoaded = static_cast<int64_t>(fileData.getNumPreloadedFrames()) >= frames;
     }
 }
 
@@ -487,9 +1010,8 @@ void sfz::FilePool::loadingJob(const QueuedFileData& data) noexcept
         return;
     }
 
-    const fs::path file { rootDirectory / id->filename() };
     std::error_code readError;
-    AudioReaderPtr reader = createAudioReader(file, id->isReverse(), &readError);
+    AudioReaderPtr reader = createFileReader(*id, *data.data, &readError);
 
     if (readError) {
         DBG("[sfizz] reading the file errored for " << *id << " with code " << readError << ": " << readError.message());
@@ -549,6 +1071,21 @@ void sfz::FilePool::clear()
     loadedFiles.clear();
 }
 
+void sfz::FilePool::clearChangedFiles() noexcept
+{
+    std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
+    const auto clearChanged = [this](absl::flat_hash_map<FileId, FileData>& files) {
+        for (auto it = files.begin(), end = files.end(); it != end; ) {
+            auto copyIt = it++;
+            if (copyIt->second.readerCount == 0 && hasChangedOnDisk(copyIt->first, copyIt->second.information))
+                files.erase(copyIt);
+        }
+    };
+
+    clearChanged(preloadedFiles);
+    clearChanged(loadedFiles);
+}
+
 uint32_t sfz::FilePool::getPreloadSize() const noexcept
 {
     return preloadSize;
@@ -560,33 +1097,179 @@ bool is_ready(std::future<R> const& f)
     return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 }
 
-void sfz::FilePool::dispatchingJob() noexcept
+void sfz::FilePoolWorkers::dispatchingJob() noexcept
 {
     while (dispatchBarrier.wait(), dispatchFlag) {
-        std::lock_guard<std::mutex> guard { loadingJobsMutex };
+        std::lock_guard<std::mutex> lock { poolsMutex };
+        for (FilePool* pool : pools)
+            pool->dispatchFiles();
+    }
+}
 
-        QueuedFileData queuedData;
-        if (filesToLoad->try_pop(queuedData)) {
-            if (queuedData.id.expired()) {
-                // file ID was nulled, it means the region was deleted, ignore
-            }
-            else
-                loadingJobs.push_back(
-                    threadPool->enqueue([this](const QueuedFileData& data) { loadingJob(data); }, std::move(queuedData)));
-        }
+void sfz::FilePool::dispatchFiles() noexcept
+{
+    std::lock_guard<std::mutex> guard { loadingJobsMutex };
 
-        // Clear finished jobs
-        swapAndPopAll(loadingJobs, [](std::future<void>& future) {
-            return is_ready(future);
-        });
+    QueuedFileData queuedData;
+    while (filesToLoad->try_pop(queuedData)) {
+        if (queuedData.id.expired()) {
+            // file ID was nulled, it means the region was deleted, ignore
+        }
+        else
+            loadingJobs.push_back(
+                threadPool->enqueue([this](const QueuedFileData& data) { loadingJob(data); }, std::move(queuedData)));
     }
+
+    // Clear finished jobs
+    swapAndPopAll(loadingJobs, [](std::future<void>& future) {
+        return is_ready(future);
+    });
 }
 
-void sfz::FilePool::garbageJob() noexcept
+void sfz::FilePoolWorkers::garbageJob() noexcept
 {
     while (semGarbageBarrier.wait(), garbageFlag) {
-        std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
-        garbageToCollect.clear();
+        std::lock_guard<std::mutex> lock { poolsMutex };
+        for (FilePool* pool : pools)
+            pool->collectGarbage();
+    }
+}
+
+void sfz::FilePool::collectGarbage() noexcept
+{
+    std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
+    garbageToCollect.clear();
+}
+
+void sfz::FilePoolWorkers::streamingJob() noexcept
+{
+    FilePool::raiseCurrentThreadPriority();
+
+    const size_t ringFrames = static_cast<size_t>(config::streamingRingFrames);
+    const size_t guardFrames = static_cast<size_t>(config::streamingGuardFrames);
+    const size_t chunkSize = static_cast<size_t>(config::fileChunkSize);
+    sfz::Buffer<float> fileBlock { chunkSize * 2 };
+
+    while (streamingBarrier.wait(), streamingFlag) {
+        for (int i = 0; i < config::maxFileStreams; ++i) {
+            FileStream& stream = streams[i];
+            FileStream::Status status = stream.status.load();
+
+            if (status == FileStream::Status::Released) {
+                stream.reader.reset();
+                stream.encodedData.reset();
+                stream.id.reset();
+                stream.pool = nullptr;
+                stream.status = FileStream::Status::Free;
+                continue;
+            }
+
+            if (status == FileStream::Status::Starting) {
+                size_t fileFrames = 0;
+                std::shared_ptr<FileId> id = stream.id.lock();
+                if (id) {
+                    std::error_code readError;
+                    if (const EncodedFileData& encoded = stream.encodedData) {
+                        stream.reader = createAudioReaderFromMemory(
+                            encoded->data(), encoded->size(), id->isReverse(), &readError);
+                    } else {
+                        // The pool is gone if it was detached, and the stream
+                        // released then
+                        fs::path file;
+                        {
+                            std::lock_guard<std::mutex> lock { poolsMutex };
+                            if (absl::c_linear_search(pools, stream.pool))
+                                file = stream.pool->rootDirectory / id->filename();
+                        }
+                        if (!file.empty())
+                            stream.reader = createAudioReader(file, id->isReverse(), &readError);
+                    }
+                    if (readError) {
+                        DBG("[sfizz] reading the file errored for " << *id << " with code " << readError << ": " << readError.message());
+                        stream.reader.reset();
+                    }
+                }
+
+                if (stream.reader) {
+                    fileFrames = static_cast<size_t>(stream.reader->frames());
+                    const unsigned numChannels = stream.reader->channels();
+                    if (stream.ring.getNumChannels() != numChannels) {
+                        stream.ring.reset();
+                        stream.ring.addChannels(numChannels);
+                        stream.ring.resize(ringFrames + guardFrames);
+                    }
+                }
+                stream.readerFrame = 0;
+
+                // Zeroes are streamed past the end, like in the file buffers padding
+                stream.endFrame = getStreamEnd(stream, fileFrames);
+                if (!stream.status.compare_exchange_strong(status, FileStream::Status::Streaming))
+                    continue;
+                status = FileStream::Status::Streaming;
+            }
+
+            if (status != FileStream::Status::Streaming)
+                continue;
+
+            const size_t fileFrames = stream.reader ? static_cast<size_t>(stream.reader->frames()) : 0;
+
+            // Rewrite what was streamed past the new end of the loop
+            if (stream.loopExitPending.load()) {
+                const size_t exit = stream.loopExit.load();
+                stream.appliedLoopExit = exit;
+                stream.endFrame = getStreamEnd(stream, fileFrames);
+                if (stream.writePosition.load() > exit)
+                    stream.writePosition.store(exit);
+                stream.loopExitPending.store(false);
+            }
+
+            // Refill the ring up to where the reader is, skipping what it
+            // went past already
+            const unsigned numChannels = static_cast<unsigned>(stream.ring.getNumChannels());
+            const size_t limit = min(stream.readPosition.load() + ringFrames, stream.endFrame.load());
+            size_t position = max(stream.writePosition.load(), stream.readPosition.load());
+            while (position < limit && stream.status.load() == FileStream::Status::Streaming) {
+                size_t contiguousFrames = 0;
+                int64_t fileFrame = stream.getFileFrame(position, contiguousFrames);
+                const size_t ringPosition = (position - stream.startFrame) % ringFrames;
+                const size_t thisChunkSize = min(min(min(chunkSize, limit - position), ringFrames - ringPosition), contiguousFrames);
+
+                // Before the first frame, like past the end, the frames are zeroes
+                size_t numFramesRead = 0;
+                size_t numZeroesBefore = 0;
+                if (fileFrame < 0) {
+                    numZeroesBefore = min(thisChunkSize, static_cast<size_t>(-fileFrame));
+                    fileFrame += static_cast<int64_t>(numZeroesBefore);
+                }
+                if (stream.reader && numZeroesBefore < thisChunkSize && static_cast<size_t>(fileFrame) < fileFrames) {
+                    if (fileFrame == stream.readerFrame || seekReader(stream, fileFrame, fileBlock)) {
+                        numFramesRead = stream.reader->readNextBlock(
+                            fileBlock.data(), min(thisChunkSize - numZeroesBefore, fileFrames - static_cast<size_t>(fileFrame)));
+                        stream.readerFrame = fileFrame + static_cast<int64_t>(numFramesRead);
+                    }
+                }
+
+                for (unsigned chanIdx = 0; chanIdx < numChannels; ++chanIdx) {
+                    const auto ringSpan = stream.ring.getSpan(chanIdx);
+                    const auto outputChunk = ringSpan.subspan(ringPosition, thisChunkSize);
+                    for (size_t i = 0; i < numZeroesBefore; ++i)
+                        outputChunk[i] = 0.0f;
+                    for (size_t i = 0; i < numFramesRead; ++i)
+                        outputChunk[numZeroesBefore + i] = fileBlock[i * numChannels + chanIdx];
+                    for (size_t i = numZeroesBefore + numFramesRead; i < thisChunkSize; ++i)
+                        outputChunk[i] = 0.0f;
+
+                    // Mirror the start of the ring past its end
+                    if (ringPosition < guardFrames) {
+                        const size_t mirrorSize = min(thisChunkSize, guardFrames - ringPosition);
+                        copy<float>(outputChunk.first(mirrorSize), ringSpan.subspan(ringFrames + ringPosition, mirrorSize));
+                    }
+                }
+
+                position += thisChunkSize;
+                stream.writePosition.store(position);
+            }
+        }
     }
 }
 
@@ -598,6 +1281,17 @@ void sfz::FilePool::waitForBackgroundLoading() noexcept
         job.wait();
 
     loadingJobs.clear();
+
+    if (!workers)
+        return;
+
+    // Wait for the streams to be filled ahead of their readers
+    std::error_code ec;
+    workers->streamingBarrier.post(ec);
+    for (int i = 0; i < config::maxFileStreams; ++i) {
+        while (!workers->streams[i].isSettled())
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
 }
 
 void sfz::FilePool::raiseCurrentThreadPriority() noexcept
@@ -637,15 +1331,57 @@ void sfz::FilePool::setRamLoading(bool loadInRam) noexcept
         return;
 
     this->loadInRam = loadInRam;
+    reloadPreloadedFiles();
+}
+
+void sfz::FilePool::setCompressedStorage(bool compressed) noexcept
+{
+    if (compressed == compressedStorage)
+        return;
+
+    compressedStorage = compressed;
+    reloadPreloadedFiles();
+
+    // The files whose preload holds all the frames are never read again
+    for (auto& preloadedFile : preloadedFiles) {
+        auto& fileData = preloadedFile.second;
+        if (compressed && !fileData.fullyLoaded)
+            fileData.encodedData = readEncodedFile(rootDirectory / preloadedFile.first.filename());
+        else
+            fileData.encodedData.reset();
+    }
+}
+
+void sfz::FilePool::setSampleFormat(SampleFormat format) noexcept
+{
+    if (format == sampleFormat)
+        return;
+
+    sampleFormat = format;
+    reloadPreloadedFiles();
+}
 
-    if (loadInRam) {
+void sfz::FilePool::setSharedSampleStore(bool shared) noexcept
+{
+    if (shared == getSharedSampleStore())
+        return;
+
+    if (shared)
+        sampleStore = SampleStore::getGlobal();
+    else
+        sampleStore.reset();
+}
+
+void sfz::FilePool::reloadPreloadedFiles() noexcept
+{
+    if (decodesWholeFiles()) {
         for (auto& preloadedFile : preloadedFiles) {
-            fs::path file { rootDirectory / preloadedFile.first.filename() };
-            AudioReaderPtr reader = createAudioReader(file, preloadedFile.first.isReverse());
             auto& fileData = preloadedFile.second;
-            fileData.preloadedData = readFromFile(
-                *reader,
-                fileData.information.end
+            fileData.preloaded.reset();
+            fileData.preloaded = readPreloadedFrames(
+                preloadedFile.first,
+                fileData,
+                static_cast<uint32_t>(fileData.information.end)
             );
             fileData.fullyLoaded = true;
         }
@@ -707,7 +1443,10 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
         return false;
     });
 
+    if (!workers)
+        return;
+
     std::error_code ec;
-    semGarbageBarrier.post(ec);
+    workers->semGarbageBarrier.post(ec);
     ASSERT(!ec);
 }
@@ -31,6 +31,7 @@
 #include "AudioSpan.h"
 #include "FileId.h"
 #include "FileMetadata.h"
+#include "SampleFormat.h"
 #include "SIMDHelpers.h"
 #include "SpinMutex.h"
 #include "utility/Timing.h"
@@ -39,18 +40,96 @@
 #include <ghc/fs_std.hpp>
 #include <absl/container/flat_hash_map.h>
 #include <absl/types/optional.h>
+#include <absl/types/span.h>
 #include <absl/strings/string_view.h>
 #include <atomic_queue/atomic_queue.h>
 #include <chrono>
 #include <thread>
 #include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <vector>
 class ThreadPool;
 
 namespace sfz {
+class AudioReader;
+class FilePool;
+class PreloadCache;
+class SampleStore;
 using FileAudioBuffer = AudioBuffer<float, 2, config::defaultAlignment,
                                     sfz::config::excessFileFrames, sfz::config::excessFileFrames>;
 using FileAudioBufferPtr = std::shared_ptr<FileAudioBuffer>;
+using EncodedFileData = std::shared_ptr<const std::vector<char>>;
+
+/**
+ * @brief Frames of a file stored as integers, to take less memory than the
+ * decoded floats. The interpolation of the voices converts them on the fly.
+ */
+class CompactFileBuffer {
+public:
+    CompactFileBuffer() = default;
+    /**
+     * @brief Convert decoded frames to a sample format. The buffer stays
+     * empty for the float format.
+     */
+    CompactFileBuffer(const FileAudioBuffer& data, SampleFormat format)
+    : format_(format)
+    {
+        if (format == SampleFormat::Int16)
+            int16Data_ = convertSamples<int16_t>(data);
+        else if (format == SampleFormat::Int24)
+            int24Data_ = convertSamples<Int24>(data);
+        else
+            format_ = SampleFormat::Float;
+    }
+    SampleFormat getFormat() const noexcept { return format_; }
+    bool empty() const noexcept { return format_ == SampleFormat::Float; }
+    size_t getNumFrames() const noexcept
+    {
+        return (format_ == SampleFormat::Int16) ? int16Data_.getNumFrames() : int24Data_.getNumFrames();
+    }
+    SampleSpan getSpan() noexcept
+    {
+        if (format_ == SampleFormat::Int16)
+            return AudioSpan<const int16_t>(int16Data_);
+        return AudioSpan<const Int24>(int24Data_);
+    }
+
+private:
+    SampleFormat format_ { SampleFormat::Float };
+    FileSampleBuffer<int16_t> int16Data_;
+    FileSampleBuffer<Int24> int24Data_;
+};
+
+/**
+ * @brief The preloaded frames of a file, in float or in a compact format.
+ * They are not modified once read, so that the file pools of several
+ * instances can share them through the sample store.
+ */
+struct PreloadedFrames {
+    PreloadedFrames() = default;
+    PreloadedFrames(FileAudioBuffer decoded, SampleFormat format = SampleFormat::Float)
+    : compactData(decoded, format)
+    {
+        if (compactData.empty())
+            data = std::move(decoded);
+    }
+    size_t getNumFrames() const noexcept
+    {
+        return compactData.empty() ? data.getNumFrames() : compactData.getNumFrames();
+    }
+    SampleSpan getSpan() noexcept
+    {
+        if (compactData.empty())
+            return AudioSpan<const float>(data);
+        return compactData.getSpan();
+    }
+
+    FileAudioBuffer data; // empty if the frames are in compactData
+    CompactFileBuffer compactData;
+};
+using PreloadedFramesPtr = std::shared_ptr<PreloadedFrames>;
 
 struct FileInformation {
     int64_t end { Default::sampleEnd };
@@ -62,6 +141,10 @@ struct FileInformation {
     int numChannels { 0 };
     int rootKey { 0 };
     absl::optional<WavetableInfo> wavetable;
+    // The state of the file on disk when it was read, or zeroes for the files
+    // loaded from memory
+    uint64_t fileSize { 0 };
+    int64_t modificationTime { 0 };
 };
 
 // Strict C++11 disallows member initialization if aggregate initialization is to be used...
@@ -70,17 +153,32 @@ struct FileData
     enum class Status { Invalid, Preloaded, Streaming, Done, GarbageCollecting };
     FileData() = default;
     FileData(FileAudioBuffer preloaded, FileInformation info)
-    : preloadedData(std::move(preloaded)), information(std::move(info))
+    : preloaded(std::make_shared<PreloadedFrames>(std::move(preloaded))), information(std::move(info))
     {
 
     }
-    AudioSpan<const float> getData()
+    FileData(PreloadedFramesPtr preloaded, FileInformation info)
+    : preloaded(std::move(preloaded)), information(std::move(info))
+    {
+
+    }
+    SampleSpan getData()
     {
         ASSERT(readerCount > 0);
-        if (status != Status::GarbageCollecting && availableFrames > preloadedData.getNumFrames())
+        if (status != Status::GarbageCollecting && availableFrames > getNumPreloadedFrames())
             return AudioSpan<const float>(fileData).first(availableFrames);
         else
-            return AudioSpan<const float>(preloadedData);
+            return getPreloadedData();
+    }
+    size_t getNumPreloadedFrames() const noexcept
+    {
+        return preloaded ? preloaded->getNumFrames() : 0;
+    }
+    SampleSpan getPreloadedData() noexcept
+    {
+        if (!preloaded)
+            return AudioSpan<const float>();
+        return preloaded->getSpan();
     }
 
     FileData(const FileData& other) = delete;
@@ -89,8 +187,9 @@ struct FileData
     {
         ASSERT(other.readerCount == 0); // Probably should not be moving this...
         information = std::move(other.information);
-        preloadedData = std::move(other.preloadedData);
+        preloaded = std::move(other.preloaded);
         fileData = std::move(other.fileData);
+        encodedData = std::move(other.encodedData);
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
@@ -100,8 +199,9 @@ struct FileData
     {
         ASSERT(other.readerCount == 0); // Probably should not be moving this...
         information = std::move(other.information);
-        preloadedData = std::move(other.preloadedData);
+        preloaded = std::move(other.preloaded);
         fileData = std::move(other.fileData);
+        encodedData = std::move(other.encodedData);
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
@@ -109,9 +209,10 @@ struct FileData
         return *this;
     }
 
-    FileAudioBuffer preloadedData;
+    PreloadedFramesPtr preloaded; // possibly shared with other pools
     FileInformation information;
     FileAudioBuffer fileData {};
+    EncodedFileData encodedData; // the file as stored on disk, if kept in memory
     int preloadCallCount { 0 };
     std::atomic<Status> status { Status::Invalid };
     bool fullyLoaded { false };
@@ -122,6 +223,106 @@ struct FileData
     LEAK_DETECTOR(FileData);
 };
 
+/**
+ * @brief A fixed-size ring buffer, which a background thread refills ahead of
+ * the playhead of a voice playing a file that is not fully loaded.
+ *
+ * The frames are written at their position modulo the ring size, and the first
+ * `config::streamingGuardFrames` frames of the ring are mirrored past its end,
+ * so any window of up to this size can be read contiguously.
+ *
+ * A stream may play a loop: past the loop end, the stream goes on with the
+ * frames from `loopFirst` to `loopLast` over and over, until the voice leaves
+ * the loop at the end of a lap. The frame `i` of the file read during the lap
+ * `r` is then at the position `i + r * getLoopSize()` of the stream.
+ */
+struct FileStream
+{
+    enum class Status { Free, Acquired, Starting, Streaming, Released };
+    static constexpr uint32_t noLoopExit = std::numeric_limits<uint32_t>::max();
+    FileStream();
+    ~FileStream();
+
+    /**
+     * @brief Start filling the stream once acquired, possibly over a loop.
+     * This is to be called from the audio thread.
+     *
+     * @param first the first frame of the loop, crossfade and interpolation
+     *              margin included, or 0 if the stream does not loop
+     * @param last the last frame of the loop, interpolation margin included,
+     *             or -1 if the stream does not loop
+     * @param exitLap the lap after which the stream leaves the loop
+     */
+    void start(int64_t first = 0, int64_t last = -1, uint32_t exitLap = noLoopExit) noexcept;
+
+    /**
+     * @brief Leave the loop at the end of a lap, which must not be over yet.
+     * The frames past it are late until the streaming thread catches up.
+     * This is to be called from the audio thread, at most once after `start`.
+     */
+    void leaveLoop(uint32_t lap) noexcept;
+
+    /**
+     * @brief Get the number of frames the loop adds to the positions of the
+     * stream at each lap, or 0 if the stream does not loop.
+     */
+    size_t getLoopSize() const noexcept
+    {
+        return loopLast < loopFirst ? 0 : static_cast<size_t>(loopLast - loopFirst + 1);
+    }
+
+    /**
+     * @brief Get the frame of the file at a position of the stream, and the
+     * number of frames which follow it contiguously in the file.
+     * This is to be called from the streaming thread.
+     */
+    int64_t getFileFrame(size_t position, size_t& numFrames) const noexcept;
+
+    /**
+     * @brief Get the frames of the stream between the positions `start` and
+     * `end`. The position `start` is at index 0 of the returned span, which is
+     * empty if the frames are not available yet. The frames before `start` are
+     * considered consumed, so `start` must not decrease from one call to the
+     * next. This is to be called from the audio thread.
+     */
+    AudioSpan<const float> getFrames(size_t start, size_t end) noexcept;
+
+    /**
+     * @brief Consume the frames before a position without reading them, when
+     * they are read from the preload instead.
+     * This is to be called from the audio thread.
+     */
+    void skipTo(size_t position) noexcept;
+
+    /**
+     * @brief Check whether the stream is filled as far ahead as possible.
+     */
+    bool isSettled() const noexcept;
+
+    std::atomic<Status> status { Status::Free };
+    std::weak_ptr<FileId> id;
+    size_t startFrame { 0 };
+    std::atomic<size_t> endFrame { 0 };
+    std::atomic<size_t> writePosition { 0 };
+    std::atomic<size_t> readPosition { 0 };
+    size_t notifiedPosition { 0 };
+    RTSemaphore* wakeup { nullptr };
+    const FilePool* pool { nullptr }; // the pool which acquired the stream
+    FileAudioBuffer ring;
+    EncodedFileData encodedData;
+    std::unique_ptr<AudioReader> reader;
+    int64_t readerFrame { 0 }; // the frame the reader reads next
+
+    int64_t loopFirst { 0 };
+    int64_t loopLast { -1 };
+    // The position where the stream leaves the loop, as requested by the voice
+    // and as applied by the streaming thread
+    std::atomic<size_t> loopExit { std::numeric_limits<size_t>::max() };
+    std::atomic<bool> loopExitPending { false };
+    size_t appliedLoopExit { std::numeric_limits<size_t>::max() };
+
+    LEAK_DETECTOR(FileStream);
+};
 
 class FileDataHolder {
 public:
@@ -131,15 +332,19 @@ public:
     FileDataHolder(FileDataHolder&& other)
     {
         this->data = other.data;
+        this->stream = other.stream;
         other.data = nullptr;
+        other.stream = nullptr;
     }
     FileDataHolder& operator=(FileDataHolder&& other)
     {
         this->data = other.data;
+        this->stream = other.stream;
         other.data = nullptr;
+        other.stream = nullptr;
         return *this;
     }
-    FileDataHolder(FileData* data) : data(data)
+    FileDataHolder(FileData* data, FileStream* stream = nullptr) : data(data), stream(stream)
     {
         if (!data)
             return;
@@ -148,6 +353,13 @@ public:
     }
     void reset()
     {
+        if (stream) {
+            stream->status = FileStream::Status::Released;
+            std::error_code ec;
+            stream->wakeup->post(ec);
+            stream = nullptr;
+        }
+
         if (!data)
             return;
 
@@ -155,6 +367,52 @@ public:
         data->lastViewerLeftAt = highResNow();
         data = nullptr;
     }
+    /**
+     * @brief Check whether the data past the preload is read from a stream.
+     */
+    bool isStreaming() const noexcept { return stream != nullptr; }
+    /**
+     * @brief Start the stream, if any, possibly over a loop.
+     * See `FileStream::start`.
+     */
+    void startStream(int64_t loopFirst = 0, int64_t loopLast = -1, uint32_t exitLap = FileStream::noLoopExit) noexcept
+    {
+        if (stream)
+            stream->start(loopFirst, loopLast, exitLap);
+    }
+    /**
+     * @brief Leave the loop of the stream at the end of a lap.
+     */
+    void leaveStreamLoop(uint32_t lap) noexcept
+    {
+        if (stream)
+            stream->leaveLoop(lap);
+    }
+    /**
+     * @brief Consume the frames of the stream before a position, which are
+     * read from the preload.
+     */
+    void skipStreamTo(int64_t position) noexcept
+    {
+        if (stream)
+            stream->skipTo(static_cast<size_t>(position));
+    }
+    /**
+     * @brief Get the position in the stream of a frame of the file, read
+     * during a lap of the loop of the stream.
+     */
+    int64_t getStreamPosition(int frame, uint32_t lap) const noexcept
+    {
+        ASSERT(stream);
+        return frame + static_cast<int64_t>(lap) * static_cast<int64_t>(stream->getLoopSize());
+    }
+    /**
+     * @brief Get the data covering the positions of the stream from `first`
+     * to `last` included, along with the interpolation margins. The position
+     * `offset` is at index 0 of the returned span, which is empty if the data
+     * is not available yet.
+     */
+    SampleSpan getStreamedData(int64_t first, int64_t last, int64_t& offset) noexcept;
     ~FileDataHolder()
     {
         ASSERT(!data || data->readerCount > 0);
@@ -165,6 +423,7 @@ public:
     explicit operator bool() const { return data != nullptr; }
 private:
     FileData* data { nullptr };
+    FileStream* stream { nullptr };
     LEAK_DETECTOR(FileDataHolder);
 };
 
@@ -187,14 +446,55 @@ private:
  * with a reference count of 1.
  */
 
+/**
+ * @brief The background threads of file pools, and the streams which the
+ * voices of these pools read. A synth shares them with the instruments which
+ * it stages, rather than start new ones for each.
+ */
+class FilePoolWorkers {
+public:
+    FilePoolWorkers();
+    ~FilePoolWorkers();
+
+    FilePoolWorkers(const FilePoolWorkers&) = delete;
+    FilePoolWorkers& operator=(const FilePoolWorkers&) = delete;
+
+private:
+    friend class FilePool;
+    void attach(FilePool& pool);
+    void detach(FilePool& pool);
+    void dispatchingJob() noexcept;
+    void garbageJob() noexcept;
+    void streamingJob() noexcept;
+
+    // The pools served by the threads, which they lock while serving them
+    std::mutex poolsMutex;
+    std::vector<FilePool*> pools;
+
+    // Signals
+    volatile bool dispatchFlag { true };
+    volatile bool garbageFlag { true };
+    volatile bool streamingFlag { true };
+    RTSemaphore dispatchBarrier;
+    RTSemaphore semGarbageBarrier;
+    RTSemaphore streamingBarrier;
+
+    // Streams for the voices reading files past their preload
+    std::unique_ptr<FileStream[]> streams;
+
+    std::thread dispatchThread;
+    std::thread garbageThread;
+    std::thread streamingThread;
+    LEAK_DETECTOR(FilePoolWorkers);
+};
 
 class FilePool {
 public:
     /**
      * @brief Construct a new File Pool object.
      *
-     * This creates the background threads based on config::numBackgroundThreads
-     * as well as the garbage collection thread.
+     * The background threads are started when the first file is loaded,
+     * unless the pool shares them with another one.
      */
     FilePool();
 
@@ -231,6 +531,60 @@ public:
      */
     bool preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept;
 
+    /**
+     * @brief Preload several files with their proper offset bounds. The files
+     * are opened and read in parallel on the background threads, and the
+     * result is the same as calling preloadFile() on each of them.
+     *
+     * @param files pairs of a file and its maximum offset
+     * @return the number of files which were preloaded properly
+     */
+    size_t preloadFiles(absl::Span<const std::pair<FileId, uint32_t>> files) noexcept;
+
+    /**
+     * @brief Extract the metadata of several files in parallel on the
+     * background threads. The metadata is kept to serve the subsequent calls
+     * to getFileInformation(), until clearPrefetchedFileInformation().
+     *
+     * @param fileIds
+     */
+    void prefetchFileInformation(absl::Span<const FileId> fileIds) noexcept;
+
+    /**
+     * @brief Forget the metadata extracted by prefetchFileInformation().
+     */
+    void clearPrefetchedFileInformation() noexcept { prefetchedInformation.clear(); }
+
+    /**
+     * @brief Drop the data of the files which changed on disk since they were
+     * read, and keep the rest to reload the same instrument.
+     */
+    void clearChangedFiles() noexcept;
+
+    /**
+     * @brief Check whether the data of a file is held, for example from a
+     * previous load of the instrument.
+     */
+    bool holdsFile(const FileId& fileId) const noexcept
+    {
+        return preloadedFiles.contains(fileId) || loadedFiles.contains(fileId);
+    }
+
+    /**
+     * @brief Set the directory of the persistent preload cache, which keeps
+     * the preloaded data and the information of the samples across sessions.
+     * An empty path disables the cache, which is the default.
+     *
+     * @param directory
+     */
+    void setPreloadCacheDirectory(const fs::path& directory) noexcept;
+
+    /**
+     * @brief Get the directory of the persistent preload cache, empty if
+     * the cache is disabled.
+     */
+    const fs::path& getPreloadCacheDirectory() const noexcept;
+
     /**
      * @brief Load a file and return its information. The file pool will store this
      * data for future requests so use this function responsibly.
@@ -288,9 +642,12 @@ public:
      * @brief Get a handle on a file, which triggers background loading
      *
      * @param fileId the file to preload
+     * @param streamable whether the file is read forward only, in which case
+     *                   it may be streamed if sample streaming is enabled or
+     *                   the file is kept in memory as stored on disk
      * @return FileDataHolder a file data handle
      */
-    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept;
+    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId, bool streamable = false) noexcept;
     /**
      * @brief Change the preloading size. This will trigger a full
      * reload of all samples, so don't call it on the audio thread.
@@ -320,6 +677,14 @@ public:
      * in the queue.
      */
     void waitForBackgroundLoading() noexcept;
+    /**
+     * @brief Use the background threads and the streams of another pool, if
+     * it started them, rather than start its own. Call this before loading
+     * any file.
+     *
+     * @param other
+     */
+    void shareWorkers(const FilePool& other);
     /**
      * @brief Assign the current thread a priority which is appropriate
      * for background sample file processing.
@@ -332,6 +697,65 @@ public:
      * @param loadInRam
      */
     void setRamLoading(bool loadInRam) noexcept;
+    /**
+     * @brief Change whether the files which are not fully preloaded are
+     * streamed through ring buffers instead of being loaded whole in memory.
+     * Only new voices are affected.
+     *
+     * @param streaming
+     */
+    void setSampleStreaming(bool streaming) noexcept { sampleStreaming = streaming; }
+    /**
+     * @brief Check whether the files are streamed.
+     */
+    bool getSampleStreaming() const noexcept { return sampleStreaming; }
+    /**
+     * @brief Change whether the files are kept in memory as they are stored
+     * on disk, compressed or not, instead of being decoded whole. Only the
+     * preload is decoded, and the rest is decoded from memory ahead of the
+     * playhead of each voice through the streams, even if the RAM loading is
+     * enabled. This will trigger a reloading of the preloaded files, so
+     * don't call it on the audio thread.
+     *
+     * @param compressed
+     */
+    void setCompressedStorage(bool compressed) noexcept;
+    /**
+     * @brief Check whether the files are kept in memory as stored on disk.
+     */
+    bool getCompressedStorage() const noexcept { return compressedStorage; }
+    /**
+     * @brief Change the format in which the preloaded samples are kept in
+     * memory. The integer formats take less memory and bandwidth than the
+     * floats, and are converted within the interpolation of the voices.
+     * The samples are rounded to the format, so 24-bit or float sources lose
+     * precision in 16-bit. The files loaded whole while playing and the
+     * streams stay in float. This will trigger a reloading of the preloaded
+     * files, so don't call it on the audio thread.
+     *
+     * @param format
+     */
+    void setSampleFormat(SampleFormat format) noexcept;
+    /**
+     * @brief Get the format of the preloaded samples.
+     */
+    SampleFormat getSampleFormat() const noexcept { return sampleFormat; }
+    /**
+     * @brief Change whether the preloaded frames, and the files loaded by
+     * loadFile(), are shared with the other file pools of the process which
+     * enable the sharing. A file which is already held by another pool with
+     * at least as many frames in the same format is not read again, so the
+     * memory depends on the number of distinct samples rather than on the
+     * number of instances. The frames are freed when the last pool using them
+     * drops them. Only the files loaded afterwards are affected.
+     *
+     * @param shared
+     */
+    void setSharedSampleStore(bool shared) noexcept;
+    /**
+     * @brief Check whether the preloaded frames are shared with other pools.
+     */
+    bool getSharedSampleStore() const noexcept { return sampleStore != nullptr; }
     /**
      * @brief Prepares unused data to be freed on a background thread.
      * This should be called regularly by the Synth, otherwise memory
@@ -341,17 +765,18 @@ public:
 private:
 
     absl::optional<sfz::FileInformation> checkExistingFileInformation(const FileId& fileId) noexcept;
+    std::unique_ptr<AudioReader> createFileReader(const FileId& fileId, const FileData& fileData, std::error_code* ec = nullptr) const noexcept;
+    bool decodesWholeFiles() const noexcept { return loadInRam && !compressedStorage; }
+    void reloadPreloadedFiles() noexcept;
+    PreloadedFramesPtr readPreloadedFrames(const FileId& fileId, const FileData& fileData, uint32_t numFrames) const noexcept;
     fs::path rootDirectory;
 
     bool loadInRam { config::loadInRam };
+    bool sampleStreaming { false };
+    bool compressedStorage { false };
+    SampleFormat sampleFormat { SampleFormat::Float };
     uint32_t preloadSize { config::preloadSize };
 
-    // Signals
-    volatile bool dispatchFlag { true };
-    volatile bool garbageFlag { true };
-    RTSemaphore dispatchBarrier;
-    RTSemaphore semGarbageBarrier;
-
     // Structures for the background loaders
     struct QueuedFileData
     {
@@ -365,13 +790,18 @@ private:
     using FileQueue = atomic_queue::AtomicQueue2<QueuedFileData, config::maxVoices>;
     aligned_unique_ptr<FileQueue> filesToLoad;
 
-    void dispatchingJob() noexcept;
-    void garbageJob() noexcept;
+    friend class FilePoolWorkers;
+    void dispatchFiles() noexcept;
+    void collectGarbage() noexcept;
     void loadingJob(const QueuedFileData& data) noexcept;
     std::mutex loadingJobsMutex;
     std::vector<std::future<void>> loadingJobs;
-    std::thread dispatchThread { &FilePool::dispatchingJob, this };
-    std::thread garbageThread { &FilePool::garbageJob, this };
+
+    // The background threads and the streams, started on the first load
+    // unless they are shared
+    void startWorkers();
+    FileStream* acquireStream(const std::shared_ptr<FileId>& fileId, const FileData& fileData) noexcept;
+    std::shared_ptr<FilePoolWorkers> workers;
 
     SpinMutex garbageAndLastUsedMutex;
     std::vector<FileId> lastUsedFiles;
@@ -382,6 +812,11 @@ private:
     // Preloaded data
     absl::flat_hash_map<FileId, FileData> preloadedFiles;
     absl::flat_hash_map<FileId, FileData> loadedFiles;
+    absl::flat_hash_map<FileId, FileInformation> prefetchedInformation;
+    absl::optional<FileInformation> readFileInformation(const fs::path& file, bool reverse) const noexcept;
+    bool hasChangedOnDisk(const FileId& fileId, const FileInformation& information) const noexcept;
+    std::unique_ptr<PreloadCache> preloadCache;
+    std::shared_ptr<SampleStore> sampleStore; // null if the frames are not shared
     LEAK_DETECTOR(FilePool);
 };
 }
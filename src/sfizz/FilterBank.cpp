@@ -0,0 +1,468 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterBank.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// The coefficient formulas are the ones of the Faust filters in
+// gen/filters, operation for operation, so that filtering a voice in the
+// bank or alone gives the same results. Keep them in sync with the .dsp
+// sources if these change.
+
+namespace sfz {
+
+constexpr unsigned FilterBank::numLanes;
+constexpr unsigned FilterBank::numStages;
+
+bool isBiquadType(FilterType type) noexcept
+{
+    switch (type) {
+    case kFilterLpf2p:
+    case kFilterHpf2p:
+    case kFilterBpf2p:
+    case kFilterBrf2p:
+    case kFilterPeq:
+    case kFilterLsh:
+    case kFilterHsh:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isBiquadType(EqType type) noexcept
+{
+    switch (type) {
+    case kEqPeak:
+    case kEqLshelf:
+    case kEqHshelf:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The Faust filters take the sample rate as an integer
+static double faustSampleRate(double sampleRate) noexcept
+{
+    return static_cast<double>(static_cast<int>(sampleRate));
+}
+
+double biquadSmoothingPole(double sampleRate) noexcept
+{
+    return std::exp(0.0 - (1000.0 / faustSampleRate(sampleRate)));
+}
+
+static double clampedCutoff(float cutoff) noexcept
+{
+    return std::min<double>(20000.0, std::max<double>(1.0, double(cutoff)));
+}
+
+static double resonanceQ(float q) noexcept
+{
+    return std::max<double>(0.001, std::pow(10.0, (0.050000000000000003 * std::min<double>(60.0, std::max<double>(-60.0, double(q))))));
+}
+
+static double shelfGain(float pksh) noexcept
+{
+    return std::pow(10.0, (0.025000000000000001 * std::min<double>(60.0, std::max<double>(-120.0, double(pksh)))));
+}
+
+static double bandwidthQ(double fs, double cutoff, float bw) noexcept
+{
+    const double c2 = 6.2831853071795862 / fs;
+    const double c3 = 2.1775860903036022 / fs;
+    return std::max<double>(0.001, (0.5 / double(std::sinh(double((c3 * ((cutoff * std::min<double>(12.0, std::max<double>(0.01, double(bw)))) / std::sin((c2 * cutoff)))))))));
+}
+
+// Low and high shelves, from the gain, the cosine, and the sine term
+static void lowShelf(double A, double c, double s, BiquadCoefficients& coefs) noexcept
+{
+    const double ap1c = (A + 1.0) * c;
+    const double am1c = (A + -1.0) * c;
+    const double t = am1c + s;
+    const double d = (A + t) + 1.0;
+    coefs.b1 = 2.0 * ((A * (A + (-1.0 - ap1c))) / d);
+    coefs.b0 = (A * ((A + s) + (1.0 - am1c))) / d;
+    coefs.b2 = (A * (A + (1.0 - t))) / d;
+    coefs.a2 = ((A + am1c) + (1.0 - s)) / d;
+    coefs.a1 = (0.0 - (2.0 * ((A + ap1c) + -1.0))) / d;
+}
+
+static void highShelf(double A, double c, double s, BiquadCoefficients& coefs) noexcept
+{
+    const double ap1c = (A + 1.0) * c;
+    const double am1c = (A + -1.0) * c;
+    const double d = (A + s) + (1.0 - am1c);
+    const double t = am1c + s;
+    coefs.b1 = ((0.0 - (2.0 * A)) * ((A + ap1c) + -1.0)) / d;
+    coefs.b0 = (A * ((A + t) + 1.0)) / d;
+    coefs.b2 = (A * ((A + am1c) + (1.0 - s))) / d;
+    coefs.a2 = (A + (1.0 - t)) / d;
+    coefs.a1 = 2.0 * ((A + (-1.0 - ap1c)) / d);
+}
+
+// Peak, from the gain, the sine and the Q
+static void peak(double A, double c, double s, double Q, BiquadCoefficients& coefs) noexcept
+{
+    const double alpha = 0.5 * (s / (Q * A));
+    const double d = alpha + 1.0;
+    const double alphaA = 0.5 * ((A * s) / Q);
+    coefs.b1 = (0.0 - (2.0 * c)) / d;
+    coefs.a1 = coefs.b1;
+    coefs.b0 = (alphaA + 1.0) / d;
+    coefs.b2 = (1.0 - alphaA) / d;
+    coefs.a2 = (1.0 - alpha) / d;
+}
+
+// The 2-pole filters, from the cosine and sine of the cutoff, the Q, and the
+// gain for the peak and shelves
+static bool standardBiquad(FilterType type, double c, double s, double Q, double A, double sqrtA, BiquadCoefficients& coefs) noexcept
+{
+    switch (type) {
+    case kFilterLpf2p: {
+        const double alpha = 0.5 * (s / Q);
+        const double d = alpha + 1.0;
+        coefs.b1 = (1.0 - c) / d;
+        coefs.b0 = 0.5 * coefs.b1;
+        coefs.b2 = coefs.b0;
+        coefs.a2 = (1.0 - alpha) / d;
+        coefs.a1 = (0.0 - (2.0 * c)) / d;
+        break;
+    }
+    case kFilterHpf2p: {
+        const double alpha = 0.5 * (s / Q);
+        const double d = alpha + 1.0;
+        coefs.b1 = (-1.0 - c) / d;
+        coefs.b0 = 0.5 * ((c + 1.0) / d);
+        coefs.b2 = coefs.b0;
+        coefs.a2 = (1.0 - alpha) / d;
+        coefs.a1 = (0.0 - (2.0 * c)) / d;
+        break;
+    }
+    case kFilterBpf2p: {
+        const double alpha = 0.5 * (s / Q);
+        const double d = alpha + 1.0;
+        coefs.b1 = 0.0;
+        coefs.b0 = 0.5 * (s / (Q * d));
+        coefs.b2 = 0.0 - coefs.b0;
+        coefs.a2 = (1.0 - alpha) / d;
+        coefs.a1 = (0.0 - (2.0 * c)) / d;
+        break;
+    }
+    case kFilterBrf2p: {
+        const double alpha = 0.5 * (s / Q);
+        const double d = alpha + 1.0;
+        coefs.b1 = (0.0 - (2.0 * c)) / d;
+        coefs.a1 = coefs.b1;
+        coefs.b0 = 1.0 / d;
+        coefs.b2 = coefs.b0;
+        coefs.a2 = (1.0 - alpha) / d;
+        break;
+    }
+    case kFilterPeq:
+        peak(A, c, s, Q, coefs);
+        break;
+    case kFilterLsh:
+        lowShelf(A, c, (sqrtA * s) / Q, coefs);
+        break;
+    case kFilterHsh:
+        highShelf(A, c, (sqrtA * s) / Q, coefs);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static bool usesShelfGain(FilterType type) noexcept
+{
+    return type == kFilterPeq || type == kFilterLsh || type == kFilterHsh;
+}
+
+static bool equalizerBiquad(EqType type, double c, double s, double Q, double A, BiquadCoefficients& coefs) noexcept
+{
+    switch (type) {
+    case kEqPeak:
+        peak(A, c, s, Q, coefs);
+        break;
+    case kEqLshelf:
+        lowShelf(A, c, (std::sqrt(A) * s) / Q, coefs);
+        break;
+    case kEqHshelf:
+        highShelf(A, c, (std::sqrt(A) * s) / Q, coefs);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+bool computeBiquad(FilterType type, double sampleRate, float cutoff, float q, float pksh, BiquadCoefficients& coefs) noexcept
+{
+    if (!isBiquadType(type))
+        return false;
+
+    const double fs = faustSampleRate(sampleRate);
+    const double w = (6.2831853071795862 / fs) * std::max<double>(0.0, clampedCutoff(cutoff));
+    const double A = usesShelfGain(type) ? shelfGain(pksh) : 1.0;
+    return standardBiquad(type, std::cos(w), std::sin(w), resonanceQ(q), A, std::sqrt(A), coefs);
+}
+
+bool computeBiquad(EqType type, double sampleRate, float cutoff, float bw, float pksh, BiquadCoefficients& coefs) noexcept
+{
+    if (!isBiquadType(type))
+        return false;
+
+    const double fs = faustSampleRate(sampleRate);
+    const double f = clampedCutoff(cutoff);
+    const double w = (6.2831853071795862 / fs) * std::max<double>(0.0, f);
+    return equalizerBiquad(type, std::cos(w), std::sin(w), bandwidthQ(fs, f, bw), shelfGain(pksh), coefs);
+}
+
+//------------------------------------------------------------------------------
+// Tabulated coefficients
+
+namespace {
+
+// Cosine and sine of the cutoff, over octaves of the cutoff relative to the
+// Nyquist frequency, which go up to the Nyquist frequency itself
+constexpr int cutoffOctaves { 20 };
+constexpr int cutoffStepsPerOctave { 128 };
+constexpr int cutoffTableSize { cutoffOctaves * cutoffStepsPerOctave + 1 };
+
+struct CutoffTerms {
+    double c;
+    double s;
+};
+
+const auto cutoffTable = []()
+{
+    std::array<CutoffTerms, cutoffTableSize> table;
+    for (int i = 0; i < cutoffTableSize; ++i) {
+        const int octave = i / cutoffStepsPerOctave - cutoffOctaves;
+        const double fraction = double(i % cutoffStepsPerOctave) / cutoffStepsPerOctave;
+        const double w = 3.1415926535897931 * std::ldexp(1.0 + fraction, octave);
+        table[i] = { std::cos(w), std::sin(w) };
+    }
+    return table;
+}();
+
+// Q of the resonance, in steps of 1/8 dB
+constexpr int resonanceStepsPerDb { 8 };
+constexpr int resonanceTableSize { 120 * resonanceStepsPerDb + 1 };
+
+const auto resonanceTable = []()
+{
+    std::array<double, resonanceTableSize> table;
+    for (int i = 0; i < resonanceTableSize; ++i)
+        table[i] = resonanceQ(float(double(i) / resonanceStepsPerDb - 60.0));
+    return table;
+}();
+
+// Peak/shelf gain and its square root, in steps of 1/4 dB
+constexpr int gainStepsPerDb { 4 };
+constexpr int gainTableSize { 180 * gainStepsPerDb + 1 };
+
+struct GainTerms {
+    double A;
+    double sqrtA;
+};
+
+const auto gainTable = []()
+{
+    std::array<GainTerms, gainTableSize> table;
+    for (int i = 0; i < gainTableSize; ++i) {
+        const double A = shelfGain(float(double(i) / gainStepsPerDb - 120.0));
+        table[i] = { A, std::sqrt(A) };
+    }
+    return table;
+}();
+
+// Split a position in a table into an index and an interpolation factor
+template <size_t Size>
+inline int tableIndex(double position, double& mu) noexcept
+{
+    const int index = std::min(static_cast<int>(position), static_cast<int>(Size) - 2);
+    mu = position - index;
+    return index;
+}
+
+inline bool lookupCutoff(double ratio, double& c, double& s) noexcept
+{
+    if (!(ratio >= 1.0 / (1 << cutoffOctaves) && ratio <= 1.0))
+        return false;
+
+    // The octave is the exponent of the ratio, and the steps of the octave
+    // map linearly to its mantissa
+    uint64_t bits;
+    std::memcpy(&bits, &ratio, sizeof(ratio));
+    const int octave = static_cast<int>(bits >> 52) - 1023;
+    const double fraction = static_cast<double>(bits & ((uint64_t(1) << 52) - 1)) * (1.0 / (uint64_t(1) << 52));
+    const double position = cutoffStepsPerOctave * ((octave + cutoffOctaves) + fraction);
+
+    double mu;
+    const int index = tableIndex<cutoffTableSize>(position, mu);
+    const CutoffTerms& lo = cutoffTable[index];
+    const CutoffTerms& hi = cutoffTable[index + 1];
+    c = lo.c + mu * (hi.c - lo.c);
+    s = lo.s + mu * (hi.s - lo.s);
+    return true;
+}
+
+inline double lookupResonance(float q) noexcept
+{
+    const double db = std::min<double>(60.0, std::max<double>(-60.0, double(q)));
+    double mu;
+    const int index = tableIndex<resonanceTableSize>((db + 60.0) * resonanceStepsPerDb, mu);
+    return resonanceTable[index] + mu * (resonanceTable[index + 1] - resonanceTable[index]);
+}
+
+inline GainTerms lookupGain(float pksh) noexcept
+{
+    const double db = std::min<double>(60.0, std::max<double>(-120.0, double(pksh)));
+    double mu;
+    const int index = tableIndex<gainTableSize>((db + 120.0) * gainStepsPerDb, mu);
+    const GainTerms& lo = gainTable[index];
+    const GainTerms& hi = gainTable[index + 1];
+    return { lo.A + mu * (hi.A - lo.A), lo.sqrtA + mu * (hi.sqrtA - lo.sqrtA) };
+}
+
+} // namespace
+
+bool computeBiquadTabulated(FilterType type, double sampleRate, float cutoff, float q, float pksh, BiquadCoefficients& coefs) noexcept
+{
+    if (!isBiquadType(type))
+        return false;
+
+    double c;
+    double s;
+    if (!lookupCutoff(2.0 * clampedCutoff(cutoff) / faustSampleRate(sampleRate), c, s))
+        return computeBiquad(type, sampleRate, cutoff, q, pksh, coefs);
+
+    const GainTerms gain = usesShelfGain(type) ? lookupGain(pksh) : GainTerms { 1.0, 1.0 };
+    return standardBiquad(type, c, s, lookupResonance(q), gain.A, gain.sqrtA, coefs);
+}
+
+bool computeBiquadTabulated(EqType type, double sampleRate, float cutoff, float bw, float pksh, BiquadCoefficients& coefs) noexcept
+{
+    if (!isBiquadType(type))
+        return false;
+
+    const double fs = faustSampleRate(sampleRate);
+    const double f = clampedCutoff(cutoff);
+    double c;
+    double s;
+    if (!lookupCutoff(2.0 * f / fs, c, s))
+        return computeBiquad(type, sampleRate, cutoff, bw, pksh, coefs);
+
+    // The bandwidth term of `bandwidthQ`, with the tabulated sine
+    const double bandwidth = std::min<double>(12.0, std::max<double>(0.01, double(bw)));
+    const double Q = std::max<double>(0.001, (0.5 / std::sinh((2.1775860903036022 / fs) * (f * bandwidth) / s)));
+    return equalizerBiquad(type, c, s, Q, lookupGain(pksh).A, coefs);
+}
+
+void FilterBank::setSampleRate(float sampleRate) noexcept
+{
+    pole_ = biquadSmoothingPole(sampleRate);
+    gain_ = 1.0 - pole_;
+}
+
+void FilterBank::setSamplesPerBlock(int samplesPerBlock)
+{
+    const unsigned interval = config::filterControlInterval;
+    maxSteps_ = (static_cast<unsigned>(samplesPerBlock) + interval - 1) / interval;
+    targets_.assign(numStages * maxSteps_, Targets());
+    silence_.assign(samplesPerBlock, 0.0f);
+    clear();
+}
+
+void FilterBank::clear() noexcept
+{
+    for (unsigned s = 0; s < usedStages_; ++s) {
+        for (unsigned l = 0; l < usedLanes_; ++l)
+            states_[s][l] = nullptr;
+    }
+
+    for (unsigned l = 0; l < usedLanes_; ++l)
+        buffers_[l] = nullptr;
+
+    usedLanes_ = 0;
+    usedStages_ = 0;
+}
+
+int FilterBank::addLanes(float* const buffers[], unsigned count) noexcept
+{
+    if (count > getNumFreeLanes())
+        return -1;
+
+    const unsigned first = usedLanes_;
+    for (unsigned c = 0; c < count; ++c)
+        buffers_[first + c] = buffers[c];
+
+    usedLanes_ += count;
+    return static_cast<int>(first);
+}
+
+void FilterBank::setStage(unsigned lane, unsigned stage, BiquadState* state) noexcept
+{
+    ASSERT(lane < usedLanes_);
+    ASSERT(stage < numStages);
+    states_[stage][lane] = state;
+    usedStages_ = std::max(usedStages_, stage + 1);
+}
+
+void FilterBank::setTarget(unsigned lane, unsigned stage, unsigned step, const BiquadCoefficients& coefs) noexcept
+{
+    ASSERT(lane < usedLanes_);
+    ASSERT(stage < numStages);
+    ASSERT(step < maxSteps_);
+    targets_[stage * maxSteps_ + step].set(lane, coefs, gain_);
+}
+
+void FilterBank::process(unsigned numFrames) noexcept
+{
+    ASSERT(numFrames <= silence_.size());
+    const unsigned interval = config::filterControlInterval;
+
+    for (unsigned s = 0; s < usedStages_; ++s) {
+        BiquadLanes<numLanes> lanes;
+        const float* in[numLanes];
+        float* out[numLanes];
+
+        // Lanes without this stage run on silence with a cleared state,
+        // which keeps them silent
+        const BiquadState cleared;
+        for (unsigned l = 0; l < numLanes; ++l) {
+            BiquadState* state = (l < usedLanes_) ? states_[s][l] : nullptr;
+            lanes.load(l, state ? *state : cleared);
+            float* buffer = state ? buffers_[l] : silence_.data();
+            in[l] = buffer;
+            out[l] = buffer;
+        }
+
+        const Targets* targets = &targets_[s * maxSteps_];
+        for (unsigned frame = 0, step = 0; frame < numFrames; frame += interval, ++step) {
+            const unsigned current = std::min(numFrames - frame, interval);
+            processBiquadLanes(lanes, targets[step], pole_, in, out, frame, current);
+        }
+
+        for (unsigned l = 0; l < usedLanes_; ++l) {
+            if (BiquadState* state = states_[s][l])
+                lanes.store(l, *state);
+        }
+    }
+
+    clear();
+}
+
+} // namespace sfz
@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include "SfzFilter.h"
+#include "utility/Debug.h"
+#include <vector>
+
+namespace sfz {
+
+/**
+   Coefficients of a biquad, normalized by a0.
+ */
+struct BiquadCoefficients {
+    double b0 { 0 };
+    double b1 { 0 };
+    double b2 { 0 };
+    double a1 { 0 };
+    double a2 { 0 };
+};
+
+/**
+   State of one channel of a biquad. This is the direct form I of the Faust
+   filters, with each coefficient smoothed towards its target by a one-pole
+   lowpass.
+ */
+struct BiquadState {
+    BiquadCoefficients coefs; // current smoothed coefficients
+    double p1 { 0 }; // x[n-1] * b1
+    double p2 { 0 }; // x[n-1] * b2
+    double v1 { 0 }; // x[n-2] * b2 - y[n-2] * a2
+    double y1 { 0 }; // y[n-1]
+
+    void clear() noexcept { *this = BiquadState(); }
+    void prepare(const BiquadCoefficients& targets) noexcept
+    {
+        clear();
+        coefs = targets;
+    }
+};
+
+/**
+   Check whether a filter type has the biquad topology of `BiquadState`.
+ */
+bool isBiquadType(FilterType type) noexcept;
+bool isBiquadType(EqType type) noexcept;
+
+/**
+   Get the pole of the coefficient smoothing of the biquads.
+ */
+double biquadSmoothingPole(double sampleRate) noexcept;
+
+/**
+   Compute the biquad coefficients of a filter, with the same formulas as
+   the Faust filters. Parameters are the ones of `Filter::configure`.
+
+   @return false if the type is not a biquad
+ */
+bool computeBiquad(FilterType type, double sampleRate, float cutoff, float q, float pksh, BiquadCoefficients& coefs) noexcept;
+
+/**
+   Compute the biquad coefficients of an equalizer, with the same formulas as
+   the Faust filters. Parameters are the ones of `FilterEq::configureEq`.
+
+   @return false if the type is not a biquad
+ */
+bool computeBiquad(EqType type, double sampleRate, float cutoff, float bw, float pksh, BiquadCoefficients& coefs) noexcept;
+
+/**
+   Compute the biquad coefficients of a filter like `computeBiquad`, but
+   taking the cosine and sine of the cutoff, the Q and the shelf gain from
+   tables interpolated linearly. The cutoff table has a fixed number of
+   entries per octave of the cutoff relative to the Nyquist frequency.
+
+   This avoids the transcendental functions, for an error in the frequency
+   response which stays within a few hundredths of a dB. A cutoff above the
+   Nyquist frequency falls back to `computeBiquad`.
+
+   @return false if the type is not a biquad
+ */
+bool computeBiquadTabulated(FilterType type, double sampleRate, float cutoff, float q, float pksh, BiquadCoefficients& coefs) noexcept;
+
+/**
+   Compute the biquad coefficients of an equalizer like `computeBiquad`,
+   from the tables of `computeBiquadTabulated`. The bandwidth term is still
+   computed exactly.
+
+   @return false if the type is not a biquad
+ */
+bool computeBiquadTabulated(EqType type, double sampleRate, float cutoff, float bw, float pksh, BiquadCoefficients& coefs) noexcept;
+
+/**
+   Target coefficients of `N` biquads, in structure of arrays, already scaled
+   by the gain of the smoothing.
+ */
+template <unsigned N>
+struct BiquadTargets {
+    double b0[N];
+    double b1[N];
+    double b2[N];
+    double a1[N];
+    double a2[N];
+
+    void set(unsigned lane, const BiquadCoefficients& coefs, double gain) noexcept
+    {
+        b0[lane] = coefs.b0 * gain;
+        b1[lane] = coefs.b1 * gain;
+        b2[lane] = coefs.b2 * gain;
+        a1[lane] = coefs.a1 * gain;
+        a2[lane] = coefs.a2 * gain;
+    }
+};
+
+/**
+   State of `N` biquads, in structure of arrays.
+ */
+template <unsigned N>
+struct BiquadLanes {
+    double b0[N];
+    double b1[N];
+    double b2[N];
+    double a1[N];
+    double a2[N];
+    double p1[N];
+    double p2[N];
+    double v1[N];
+    double y1[N];
+
+    void load(unsigned lane, const BiquadState& state) noexcept
+    {
+        b0[lane] = state.coefs.b0;
+        b1[lane] = state.coefs.b1;
+        b2[lane] = state.coefs.b2;
+        a1[lane] = state.coefs.a1;
+        a2[lane] = state.coefs.a2;
+        p1[lane] = state.p1;
+        p2[lane] = state.p2;
+        v1[lane] = state.v1;
+        y1[lane] = state.y1;
+    }
+
+    void store(unsigned lane, BiquadState& state) const noexcept
+    {
+        state.coefs.b0 = b0[lane];
+        state.coefs.b1 = b1[lane];
+        state.coefs.b2 = b2[lane];
+        state.coefs.a1 = a1[lane];
+        state.coefs.a2 = a2[lane];
+        state.p1 = p1[lane];
+        state.p2 = p2[lane];
+        state.v1 = v1[lane];
+        state.y1 = y1[lane];
+    }
+};
+
+/**
+   Process `N` biquads over at most one control interval, in place or not.
+   The loops run across the biquads so that they map onto SIMD registers;
+   the computation of each biquad is the same as the one of the Faust
+   filter, so the results match.
+
+   @param lanes the states of the biquads
+   @param targets the targets of the coefficients
+   @param pole the pole of the coefficient smoothing
+   @param in the inputs of the biquads
+   @param out the outputs of the biquads
+   @param offset the first frame to process in the inputs and outputs
+   @param numFrames the number of frames, at most `config::filterControlInterval`
+ */
+template <unsigned N>
+void processBiquadLanes(BiquadLanes<N>& lanes, const BiquadTargets<N>& targets, double pole, const float* const in[], float* const out[], unsigned offset, unsigned numFrames) noexcept
+{
+    ASSERT(numFrames <= config::filterControlInterval);
+    double frames[config::filterControlInterval][N];
+
+    for (unsigned l = 0; l < N; ++l) {
+        for (unsigned i = 0; i < numFrames; ++i)
+            frames[i][l] = in[l][offset + i];
+    }
+
+    for (unsigned i = 0; i < numFrames; ++i) {
+        for (unsigned l = 0; l < N; ++l) {
+            const double b0 = pole * lanes.b0[l] + targets.b0[l];
+            const double b1 = pole * lanes.b1[l] + targets.b1[l];
+            const double b2 = pole * lanes.b2[l] + targets.b2[l];
+            const double a1 = pole * lanes.a1[l] + targets.a1[l];
+            const double a2 = pole * lanes.a2[l] + targets.a2[l];
+            const double x = frames[i][l];
+            const double v = lanes.p2[l] - a2 * lanes.y1[l];
+            const double y = (lanes.p1[l] + (x * b0 + lanes.v1[l])) - a1 * lanes.y1[l];
+            lanes.b0[l] = b0;
+            lanes.b1[l] = b1;
+            lanes.b2[l] = b2;
+            lanes.a1[l] = a1;
+            lanes.a2[l] = a2;
+            lanes.p1[l] = x * b1;
+            lanes.p2[l] = x * b2;
+            lanes.v1[l] = v;
+            lanes.y1[l] = y;
+            frames[i][l] = y;
+        }
+    }
+
+    for (unsigned l = 0; l < N; ++l) {
+        for (unsigned i = 0; i < numFrames; ++i)
+            out[l][offset + i] = static_cast<float>(frames[i][l]);
+    }
+}
+
+/**
+   Filters the biquads of many voices at once.
+
+   Each voice takes one lane per channel, and queues the target coefficients
+   of its chain of filters for the block, one stage per filter. The bank then
+   runs each stage on all the lanes together, so the filters of up to
+   `numLanes` channels share the SIMD registers.
+
+   The lanes run in double precision, and each voice still computes its own
+   coefficients before queueing them. There is a single bank per synth, so
+   it only serves the single-threaded render path; the render workers
+   filter their voices one at a time.
+ */
+class FilterBank {
+public:
+    static constexpr unsigned numLanes = config::filterBankLanes;
+    static constexpr unsigned numStages = config::filterBankStages;
+
+    /**
+     * @brief Set the sample rate, which must be the one of the filters.
+     */
+    void setSampleRate(float sampleRate) noexcept;
+    /**
+     * @brief Set the maximum block size. This allocates.
+     */
+    void setSamplesPerBlock(int samplesPerBlock);
+    /**
+     * @brief Forget the lanes, after processing or to abandon a batch.
+     */
+    void clear() noexcept;
+    /**
+     * @brief Check whether no lane is in use.
+     */
+    bool empty() const noexcept { return usedLanes_ == 0; }
+    /**
+     * @brief Get the number of lanes which can still be added.
+     */
+    unsigned getNumFreeLanes() const noexcept { return numLanes - usedLanes_; }
+    /**
+     * @brief Add lanes to filter some buffers in place.
+     *
+     * @param buffers the buffers, which must hold the block until processed
+     * @param count the number of buffers
+     * @return the index of the first lane, or -1 if there is not enough room
+     */
+    int addLanes(float* const buffers[], unsigned count) noexcept;
+    /**
+     * @brief Use a biquad as a stage of a lane for the block.
+     *
+     * @param lane
+     * @param stage
+     * @param state the state of the biquad, which is updated when processed
+     */
+    void setStage(unsigned lane, unsigned stage, BiquadState* state) noexcept;
+    /**
+     * @brief Set the target coefficients of a stage for a control interval.
+     *
+     * @param lane
+     * @param stage
+     * @param step the index of the interval in the block
+     * @param coefs
+     */
+    void setTarget(unsigned lane, unsigned stage, unsigned step, const BiquadCoefficients& coefs) noexcept;
+    /**
+     * @brief Filter the buffers of the lanes, and forget the lanes.
+     *
+     * @param numFrames the size of the block, the same for all lanes
+     */
+    void process(unsigned numFrames) noexcept;
+
+private:
+    using Targets = BiquadTargets<numLanes>;
+    float* buffers_[numLanes] {};
+    BiquadState* states_[numStages][numLanes] {};
+    std::vector<Targets> targets_; // for each stage then each step
+    std::vector<float> silence_; // the buffer of the unused lanes
+    unsigned maxSteps_ { 0 };
+    unsigned usedLanes_ { 0 };
+    unsigned usedStages_ { 0 };
+    double pole_ { 0 };
+    double gain_ { 1 };
+};
+
+} // namespace sfz
@@ -1,6 +1,8 @@
 #include "FilterPool.h"
+#include "FilterBank.h"
 #include "Region.h"
 #include "Resources.h"
+#include "SynthConfig.h"
 #include "BufferPool.h"
 #include "SIMDHelpers.h"
 #include "utility/SwapAndPop.h"
@@ -29,6 +31,7 @@ void sfz::FilterHolder::setup(const Region& region, unsigned filterId, int noteN
     this->description = &region.filters[filterId];
     filter->setType(description->type);
     filter->setChannels(region.isStereo() ? 2 : 1);
+    regionQuality = region.filterQuality;
 
     // Setup the base values
     baseCutoff = description->cutoff;
@@ -71,7 +74,6 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
         return;
     }
 
-    ModMatrix& mm = resources.getModMatrix();
     BufferPool& bufferPool = resources.getBufferPool();
     auto cutoffSpan = bufferPool.getBuffer(numFrames);
     auto resonanceSpan = bufferPool.getBuffer(numFrames);
@@ -80,20 +82,8 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
     if (!cutoffSpan || !resonanceSpan || !gainSpan)
         return;
 
-    fill<float>(*cutoffSpan, baseCutoff);
-    if (float* mod = mm.getModulation(cutoffTarget)) {
-        for (size_t i = 0; i < numFrames; ++i)
-            (*cutoffSpan)[i] *= centsFactor(mod[i]);
-    }
-    sfz::clampAll(*cutoffSpan, Default::filterCutoff.bounds);
-
-    fill<float>(*resonanceSpan, baseResonance);
-    if (float* mod = mm.getModulation(resonanceTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *resonanceSpan);
-
-    fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+    filter->setQuality(currentQuality());
+    computeParameters(*cutoffSpan, *resonanceSpan, *gainSpan);
 
     if (!prepared) {
         filter->prepare(cutoffSpan->front(), resonanceSpan->front(), gainSpan->front());
@@ -110,6 +100,72 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
     );
 }
 
+bool sfz::FilterHolder::isBiquad() const
+{
+    return description != nullptr && isBiquadType(filter->type());
+}
+
+void sfz::FilterHolder::queue(FilterBank& bank, unsigned firstLane, unsigned stage, unsigned numFrames)
+{
+    ASSERT(isBiquad());
+    if (numFrames == 0)
+        return;
+
+    BufferPool& bufferPool = resources.getBufferPool();
+    auto cutoffSpan = bufferPool.getBuffer(numFrames);
+    auto resonanceSpan = bufferPool.getBuffer(numFrames);
+    auto gainSpan = bufferPool.getBuffer(numFrames);
+
+    if (!cutoffSpan || !resonanceSpan || !gainSpan)
+        return;
+
+    filter->setQuality(currentQuality());
+    computeParameters(*cutoffSpan, *resonanceSpan, *gainSpan);
+
+    if (!prepared) {
+        filter->prepare(cutoffSpan->front(), resonanceSpan->front(), gainSpan->front());
+        prepared = true;
+    }
+
+    const unsigned numChannels = filter->channels();
+    for (unsigned c = 0; c < numChannels; ++c)
+        bank.setStage(firstLane + c, stage, filter->biquadState(c));
+
+    // The same steps as Filter::processModulated
+    const unsigned interval = config::filterControlInterval;
+    BiquadCoefficients coefs;
+    for (unsigned frame = 0, step = 0; frame < numFrames; frame += interval, ++step) {
+        filter->biquadCoefficients((*cutoffSpan)[frame], (*resonanceSpan)[frame], (*gainSpan)[frame], coefs);
+        for (unsigned c = 0; c < numChannels; ++c)
+            bank.setTarget(firstLane + c, stage, step, coefs);
+    }
+}
+
+int sfz::FilterHolder::currentQuality() const
+{
+    return regionQuality ? *regionQuality : resources.getSynthConfig().currentFilterQuality();
+}
+
+void sfz::FilterHolder::computeParameters(absl::Span<float> cutoffSpan, absl::Span<float> resonanceSpan, absl::Span<float> gainSpan)
+{
+    ModMatrix& mm = resources.getModMatrix();
+    const size_t numFrames = cutoffSpan.size();
+
+    fill<float>(cutoffSpan, baseCutoff);
+    if (float* mod = mm.getModulation(cutoffTarget)) {
+        for (size_t i = 0; i < numFrames; ++i)
+            cutoffSpan[i] *= centsFactor(mod[i]);
+    }
+    sfz::clampAll(cutoffSpan, Default::filterCutoff.bounds);
+
+    fill<float>(resonanceSpan, baseResonance);
+    if (float* mod = mm.getModulation(resonanceTarget))
+        add<float>(absl::Span<float>(mod, numFrames), resonanceSpan);
+
+    fill<float>(gainSpan, baseGain);
+    if (float* mod = mm.getModulation(gainTarget))
+        add<float>(absl::Span<float>(mod, numFrames), gainSpan);
+}
 
 void sfz::FilterHolder::setSampleRate(float sampleRate)
 {
@@ -5,6 +5,10 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "Interpolators.h"
+#include "SIMDHelpers.h"
+#include "SampleFormat.h"
+#include "utility/Debug.h"
+#include <algorithm>
 
 namespace sfz {
 
@@ -20,4 +24,115 @@ void initializeInterpolators()
     SincInterpolatorTraits<72>::initialize();
 }
 
+template <size_t Points>
+static void interpolateSincBlockWithPoints(
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    const auto& ws = *SincInterpolatorTraits<Points>::windowedSinc;
+    sincInterpolate(ws.getTablePointer(), ws.getTableSize(), Points,
+        inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+}
+
+template <size_t Points, class T>
+static void interpolateSincBlockWithPoints(
+    const T* inputLeft, const T* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    constexpr unsigned chunkFrames = 32;
+    constexpr unsigned capacity = chunkFrames * Points;
+    constexpr int j0 = 1 - int(Points) / 2;
+
+    const T* inputs[2] = { inputLeft, inputRight };
+    const unsigned numChannels = inputRight ? 2 : 1;
+    float converted[2][capacity];
+    int chunkIndices[chunkFrames];
+
+    for (unsigned done = 0; done < size; ) {
+        const unsigned count = std::min(chunkFrames, size - done);
+        const int* chunkSource = indices + done;
+        const auto range = std::minmax_element(chunkSource, chunkSource + count);
+        const int first = *range.first + j0;
+        const unsigned span = static_cast<unsigned>(*range.second - *range.first) + Points;
+
+        if (span <= capacity) {
+            // the windows overlap: convert the frames which they cover
+            for (unsigned c = 0; c < numChannels; ++c) {
+                const T* input = inputs[c] + first;
+                for (unsigned i = 0; i < span; ++i)
+                    converted[c][i] = sampleValue<float>(input[i]);
+            }
+            for (unsigned n = 0; n < count; ++n)
+                chunkIndices[n] = chunkSource[n] - first;
+        } else {
+            // the windows are far apart, as across a loop or at a high pitch:
+            // convert each of them
+            for (unsigned c = 0; c < numChannels; ++c) {
+                for (unsigned n = 0; n < count; ++n) {
+                    const T* input = inputs[c] + chunkSource[n] + j0;
+                    for (unsigned i = 0; i < Points; ++i)
+                        converted[c][n * Points + i] = sampleValue<float>(input[i]);
+                }
+            }
+            for (unsigned n = 0; n < count; ++n)
+                chunkIndices[n] = static_cast<int>(n * Points) - j0;
+        }
+
+        interpolateSincBlockWithPoints<Points>(
+            converted[0], inputRight ? converted[1] : nullptr,
+            outputLeft + done, inputRight ? outputRight + done : nullptr,
+            chunkIndices, coeffs + done, addingGains ? addingGains + done : nullptr, count);
+        done += count;
+    }
+}
+
+template <class T>
+static void interpolateSincBlockOf(InterpolatorModel model,
+    const T* inputLeft, const T* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+#define SINC_CASE(points)                                                  \
+    case kInterpolatorSinc##points:                                        \
+        interpolateSincBlockWithPoints<points>(inputLeft, inputRight,      \
+            outputLeft, outputRight, indices, coeffs, addingGains, size);  \
+        break;
+
+    switch (model) {
+    SINC_CASE(8)
+    SINC_CASE(12)
+    SINC_CASE(16)
+    SINC_CASE(24)
+    SINC_CASE(36)
+    SINC_CASE(48)
+    SINC_CASE(60)
+    SINC_CASE(72)
+    default:
+        ASSERTFALSE;
+        break;
+    }
+
+#undef SINC_CASE
+}
+
+void interpolateSincBlock(InterpolatorModel model,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    interpolateSincBlockOf(model, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+}
+
+void interpolateSincBlock(InterpolatorModel model,
+    const int16_t* inputLeft, const int16_t* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    interpolateSincBlockOf(model, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+}
+
+void interpolateSincBlock(InterpolatorModel model,
+    const Int24* inputLeft, const Int24* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    interpolateSincBlockOf(model, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+}
+
 } // namespace sfz
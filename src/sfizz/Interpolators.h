@@ -5,9 +5,12 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #pragma once
+#include <cstdint>
 
 namespace sfz {
 
+struct Int24;
+
 enum InterpolatorModel : int {
     // a nearest interpolator
     kInterpolatorNearest,
@@ -35,6 +38,14 @@ enum InterpolatorModel : int {
     kInterpolatorSinc72,
 };
 
+/**
+ * @brief Check whether the interpolator model is a windowed-sinc
+ */
+constexpr bool isSincInterpolator(InterpolatorModel model)
+{
+    return model >= kInterpolatorSinc8 && model <= kInterpolatorSinc72;
+}
+
 /**
  * @brief Initialize interpolators
  *
@@ -52,6 +63,8 @@ void initializeInterpolators();
  *
  * @tparam M the interpolator model
  * @tparam R the sample type
+ * @tparam T the type of the values, which are converted to R as they are
+ *           read if they are stored samples in another format
  * @param values Pointer to a value in a larger vector of values.
  *               Depending on the interpolator the algorithm may
  *               read samples before and after. Usually you need
@@ -60,8 +73,45 @@ void initializeInterpolators();
  * @param coeff the interpolation coefficient
  * @return R
  */
-template <InterpolatorModel M, class R>
-R interpolate(const R* values, R coeff);
+template <InterpolatorModel M, class R, class T>
+R interpolate(const T* values, R coeff);
+
+/**
+ * @brief Interpolate a block of frames from a mono or stereo source, using a
+ *        windowed-sinc model
+ *
+ * This computes several frames at once, and the channels share the sinc
+ * coefficients; it dispatches to the SIMD kernel for the running CPU.
+ * The results match `interpolate` within rounding errors.
+ *
+ * @param model the windowed-sinc interpolator model
+ * @param inputLeft the left source, padded as for `interpolate`
+ * @param inputRight the right source, or null for a mono source
+ * @param outputLeft the left output
+ * @param outputRight the right output, unused for a mono source
+ * @param indices the integral source positions of the output frames
+ * @param coeffs the interpolation coefficients of the output frames
+ * @param addingGains if non-null, the gains to mix the interpolated frames
+ *                    into the outputs, instead of replacing them
+ * @param size the number of output frames
+ */
+void interpolateSincBlock(InterpolatorModel model,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept;
+
+/**
+ * @brief Interpolate a block of frames from a source of stored samples, using
+ *        a windowed-sinc model
+ *
+ * The windows of the frames are converted to float by chunks, which go
+ * through the same kernel as a float source.
+ */
+void interpolateSincBlock(InterpolatorModel model,
+    const int16_t* inputLeft, const int16_t* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept;
+void interpolateSincBlock(InterpolatorModel model,
+    const Int24* inputLeft, const Int24* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept;
 
 } // namespace sfz
 
@@ -8,6 +8,7 @@
 #include "WindowedSinc.h"
 #include "MathHelpers.h"
 #include "SIMDConfig.h"
+#include "SampleFormat.h"
 #include <simde/simde-features.h>
 #if SIMDE_NATURAL_VECTOR_SIZE_GE(128)
 #include <simde/x86/sse.h>
@@ -34,8 +35,8 @@ namespace sfz {
 template <InterpolatorModel M, class R>
 class Interpolator;
 
-template <InterpolatorModel M, class R>
-inline R interpolate(const R* values, R coeff)
+template <InterpolatorModel M, class R, class T>
+inline R interpolate(const T* values, R coeff)
 {
     return Interpolator<M, R>::process(values, coeff);
 }
@@ -47,9 +48,10 @@ template <class R>
 class Interpolator<kInterpolatorNearest, R>
 {
 public:
-    static inline R process(const R* values, R coeff)
+    template <class T>
+    static inline R process(const T* values, R coeff)
     {
-        return values[coeff > static_cast<R>(0.5)];
+        return sampleValue<R>(values[coeff > static_cast<R>(0.5)]);
     }
 };
 
@@ -60,9 +62,10 @@ template <class R>
 class Interpolator<kInterpolatorLinear, R>
 {
 public:
-    static inline R process(const R* values, R coeff)
+    template <class T>
+    static inline R process(const T* values, R coeff)
     {
-        return values[0] * (static_cast<R>(1.0) - coeff) + values[1] * coeff;
+        return sampleValue<R>(values[0]) * (static_cast<R>(1.0) - coeff) + sampleValue<R>(values[1]) * coeff;
     }
 };
 
@@ -81,6 +84,14 @@ public:
         simde__m128 y = simde_mm_mul_ps(h, simde_mm_loadu_ps(values - 1));
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    template <class T>
+    static inline float process(const T* values, float coeff)
+    {
+        const float converted[4] = { sampleValue<float>(values[-1]), sampleValue<float>(values[0]),
+                                     sampleValue<float>(values[1]), sampleValue<float>(values[2]) };
+        return process(converted + 1, coeff);
+    }
 };
 #endif
 
@@ -91,12 +102,13 @@ template <class R>
 class Interpolator<kInterpolatorHermite3, R>
 {
 public:
-    static inline R process(const R* values, R coeff)
+    template <class T>
+    static inline R process(const T* values, R coeff)
     {
         R y = 0;
         for (int i = -1; i < 3; ++i) {
             R h = hermite3<R>(i - coeff);
-            y += h * values[i];
+            y += h * sampleValue<R>(values[i]);
         }
         return y;
     }
@@ -117,6 +129,14 @@ public:
         simde__m128 y = simde_mm_mul_ps(h, simde_mm_loadu_ps(values - 1));
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    template <class T>
+    static inline float process(const T* values, float coeff)
+    {
+        const float converted[4] = { sampleValue<float>(values[-1]), sampleValue<float>(values[0]),
+                                     sampleValue<float>(values[1]), sampleValue<float>(values[2]) };
+        return process(converted + 1, coeff);
+    }
 };
 #endif
 
@@ -127,12 +147,13 @@ template <class R>
 class Interpolator<kInterpolatorBspline3, R>
 {
 public:
-    static inline R process(const R* values, R coeff)
+    template <class T>
+    static inline R process(const T* values, R coeff)
     {
         R y = 0;
         for (int i = -1; i < 3; ++i) {
             R h = bspline3<R>(i - coeff);
-            y += h * values[i];
+            y += h * sampleValue<R>(values[i]);
         }
         return y;
     }
@@ -220,6 +241,16 @@ public:
 
         return simde_vaddvq_f32(simde__m128_to_simde_float32x4(y));
     }
+
+    template <class T>
+    static inline float process(const T* values, float coeff)
+    {
+        constexpr int j0 = 1 - int(Points) / 2;
+        float converted[Points];
+        for (int i = 0; i < int(Points); ++i)
+            converted[i] = sampleValue<float>(values[j0 + i]);
+        return process(converted - j0, coeff);
+    }
 };
 #endif
 
@@ -229,7 +260,8 @@ template <class R, size_t Points>
 class SincInterpolator
 {
 public:
-    static inline R process(const R* values, R coeff)
+    template <class T>
+    static inline R process(const T* values, R coeff)
     {
         const auto &ws = *SincInterpolatorTraits<Points>::windowedSinc;
 
@@ -239,9 +271,9 @@ public:
         for (int i = 0; i < int(Points); ++i)
             h[i] = R(ws.getUnchecked(j0 - coeff + i));
 
-        R y = h[0] * values[j0];
+        R y = h[0] * sampleValue<R>(values[j0]);
         for (int i = 1; i < int(Points); ++i)
-            y += h[i] * values[j0 + i];
+            y += h[i] * sampleValue<R>(values[j0 + i]);
 
         return y;
     }
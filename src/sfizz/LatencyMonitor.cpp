@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "LatencyMonitor.h"
+#include <algorithm>
+
+// The miss records are kept like the blocks of the Profiler: a record is
+// written through relaxed atomic words before the counter is advanced, and
+// the readers check the counter again after copying a record to know whether
+// the copy can be trusted.
+
+namespace sfz {
+
+constexpr unsigned LatencyMonitor::numBins;
+constexpr float LatencyMonitor::binWidth;
+
+LatencyMonitor::LatencyMonitor() noexcept
+{
+    for (auto& bin : bins_)
+        bin.store(0, std::memory_order_relaxed);
+}
+
+void LatencyMonitor::record(double duration, double budget, uint32_t numVoices, uint32_t numEvents) noexcept
+{
+    const uint64_t block = blockIndex_++;
+    if (budget <= 0.0)
+        return;
+
+    const float load = static_cast<float>(duration / budget);
+    const unsigned bin = std::min(static_cast<unsigned>(load / binWidth), numBins - 1);
+    bins_[bin].fetch_add(1, std::memory_order_relaxed);
+    numBlocks_.fetch_add(1, std::memory_order_relaxed);
+    lastLoad_.store(load, std::memory_order_relaxed);
+    if (load > maxLoad_.load(std::memory_order_relaxed))
+        maxLoad_.store(load, std::memory_order_relaxed);
+
+    if (load <= 1.0f)
+        return;
+
+    const uint64_t index = numMisses_.load(std::memory_order_relaxed);
+    MissSlot slot;
+    slot.miss.block = block;
+    slot.miss.duration = static_cast<float>(duration);
+    slot.miss.budget = static_cast<float>(budget);
+    slot.miss.numVoices = numVoices;
+    slot.miss.numEvents = numEvents;
+    slot.index = index;
+    // a reader which sees any word of the new record also sees the counter
+    // which invalidated the record it overwrites
+    std::atomic_thread_fence(std::memory_order_release);
+    misses_[index % misses_.size()].store(slot);
+
+    numMisses_.store(index + 1, std::memory_order_release);
+}
+
+void LatencyMonitor::recordStreamUnderruns(uint32_t count) noexcept
+{
+    numStreamUnderruns_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void LatencyMonitor::reset() noexcept
+{
+    for (auto& bin : bins_)
+        bin.store(0, std::memory_order_relaxed);
+    numBlocks_.store(0, std::memory_order_relaxed);
+    maxLoad_.store(0.0f, std::memory_order_relaxed);
+    numStreamUnderruns_.store(0, std::memory_order_relaxed);
+    firstMiss_.store(numMisses_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+uint64_t LatencyMonitor::getNumDeadlineMisses() const noexcept
+{
+    const uint64_t first = firstMiss_.load(std::memory_order_acquire);
+    const uint64_t count = numMisses_.load(std::memory_order_acquire);
+    return count - first;
+}
+
+uint64_t LatencyMonitor::getBinCount(unsigned bin) const noexcept
+{
+    if (bin >= numBins)
+        return 0;
+
+    return bins_[bin].load(std::memory_order_relaxed);
+}
+
+bool LatencyMonitor::isMissValid(uint64_t missIndex) const noexcept
+{
+    const uint64_t count = numMisses_.load(std::memory_order_relaxed);
+    return missIndex >= firstMiss_.load(std::memory_order_relaxed)
+        && missIndex < count && missIndex + misses_.size() > count;
+}
+
+bool LatencyMonitor::getDeadlineMiss(unsigned age, DeadlineMiss& miss) const noexcept
+{
+    const uint64_t count = numMisses_.load(std::memory_order_acquire);
+    if (age >= count)
+        return false;
+
+    const uint64_t missIndex = count - 1 - age;
+    if (!isMissValid(missIndex))
+        return false;
+
+    const MissSlot slot = misses_[missIndex % misses_.size()].load();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!isMissValid(missIndex) || slot.index != missIndex)
+        return false;
+
+    miss = slot.miss;
+    return true;
+}
+
+} // namespace sfz
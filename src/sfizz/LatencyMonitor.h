@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include "utility/AtomicRecord.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief A render cycle which took longer than the duration of its block.
+ */
+struct DeadlineMiss {
+    uint64_t block { 0 }; // index of the block since the monitor started
+    float duration { 0 }; // render time in seconds
+    float budget { 0 }; // block duration in seconds
+    uint32_t numVoices { 0 }; // active voices at the end of the block
+    uint32_t numEvents { 0 }; // events dispatched for the block
+};
+
+/**
+ * @brief The distribution of the render times of the blocks, as a ratio of
+ * the duration of the block, and the last deadline misses.
+ *
+ * The monitor is always on: the audio thread records each block with a few
+ * atomic operations and no allocation, and any thread can read the
+ * statistics back without locking.
+ */
+class LatencyMonitor {
+public:
+    static constexpr unsigned numBins = config::latencyHistogramBins;
+    static constexpr float binWidth = config::latencyBinWidth;
+
+    LatencyMonitor() noexcept;
+    LatencyMonitor(const LatencyMonitor&) = delete;
+    LatencyMonitor& operator=(const LatencyMonitor&) = delete;
+
+    /**
+     * @brief Record the render time of a block.
+     * This must be called from the audio thread.
+     *
+     * @param duration the render time in seconds
+     * @param budget the duration of the block in seconds
+     * @param numVoices the number of active voices
+     * @param numEvents the number of events dispatched for the block
+     */
+    void record(double duration, double budget, uint32_t numVoices, uint32_t numEvents) noexcept;
+
+    /**
+     * @brief Record the voices whose stream was late, and which went silent
+     * for the rest of their block. This must be called from the audio thread,
+     * freewheeling or not.
+     *
+     * @param count the number of late streams
+     */
+    void recordStreamUnderruns(uint32_t count) noexcept;
+
+    /**
+     * @brief Forget the statistics. This can be called from any thread; a
+     * block recorded concurrently may be only partly forgotten.
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Get the number of blocks recorded since the last reset.
+     */
+    uint64_t getNumBlocks() const noexcept { return numBlocks_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of deadline misses since the last reset.
+     */
+    uint64_t getNumDeadlineMisses() const noexcept;
+
+    /**
+     * @brief Get the number of stream underruns since the last reset.
+     */
+    uint64_t getNumStreamUnderruns() const noexcept { return numStreamUnderruns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the highest load since the last reset, as a ratio of the
+     * render time to the block duration.
+     */
+    float getMaxLoad() const noexcept { return maxLoad_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the load of the last block.
+     */
+    float getLastLoad() const noexcept { return lastLoad_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of blocks in a bin of the histogram. The bin
+     * `i` counts the loads from `i * binWidth` to `(i + 1) * binWidth`,
+     * and the last bin all the loads above.
+     */
+    uint64_t getBinCount(unsigned bin) const noexcept;
+
+    /**
+     * @brief Read a deadline miss back. This can be called from any thread.
+     *
+     * @param age 0 for the last miss, 1 for the one before, etc.
+     * @param miss the miss record
+     * @return false if the miss is not in the history
+     */
+    bool getDeadlineMiss(unsigned age, DeadlineMiss& miss) const noexcept;
+
+private:
+    struct MissSlot {
+        DeadlineMiss miss;
+        uint64_t index { 0 };
+    };
+
+    bool isMissValid(uint64_t missIndex) const noexcept;
+
+    std::array<std::atomic<uint64_t>, numBins> bins_;
+    std::atomic<uint64_t> numBlocks_ { 0 };
+    std::atomic<float> maxLoad_ { 0 };
+    std::atomic<float> lastLoad_ { 0 };
+    std::array<AtomicRecord<MissSlot>, config::deadlineMissCapacity> misses_;
+    std::atomic<uint64_t> numMisses_ { 0 };
+    std::atomic<uint64_t> firstMiss_ { 0 }; // first miss after a reset
+    std::atomic<uint64_t> numStreamUnderruns_ { 0 };
+    uint64_t blockIndex_ { 0 };
+};
+
+} // namespace sfz
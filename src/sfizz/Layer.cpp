@@ -40,6 +40,46 @@ void Layer::initializeActivations()
     aftertouchSwitched_ = true;
     programSwitched_ = true;
     ccSwitched_.set();
+    updateActivationBit();
+}
+
+void Layer::setKeySwitched(bool value) noexcept
+{
+    keySwitched_ = value;
+    updateActivationBit();
+}
+
+void Layer::setPreviousKeySwitched(bool value) noexcept
+{
+    previousKeySwitched_ = value;
+    updateActivationBit();
+}
+
+void Layer::bindActivationBit(uint64_t* word, uint64_t mask) noexcept
+{
+    if (activationWord_ && activationWord_ != word)
+        *activationWord_ &= ~activationMask_;
+
+    activationWord_ = word;
+    activationMask_ = word ? mask : 0;
+    updateActivationBit();
+}
+
+void Layer::updateActivationBit() noexcept
+{
+    if (!activationWord_)
+        return;
+
+    const Region& region = region_;
+
+    // The sequence counter advances on each note on, so these are always visited
+    const bool usesSequence = region.usesSequenceSwitches
+        || region.sequenceLength > 1 || region.sequencePosition > 1;
+
+    if (usesSequence || isSwitchedOn())
+        *activationWord_ |= activationMask_;
+    else
+        *activationWord_ &= ~activationMask_;
 }
 
 bool Layer::isSwitchedOn() const noexcept
@@ -155,6 +195,7 @@ void Layer::updateCCState(int ccNumber, float ccValue) noexcept
         return;
 
     ccSwitched_.set(ccNumber, conditions->containsWithEnd(ccValue));
+    updateActivationBit();
 }
 
 bool Layer::registerCC(int ccNumber, float ccValue, float randValue, int extendedArg) noexcept
@@ -194,22 +235,26 @@ bool Layer::registerCC(int ccNumber, float ccValue, float randValue, int extende
 void Layer::registerPitchWheel(float pitch) noexcept
 {
     pitchSwitched_ = region_.bendRange.containsWithEnd(pitch);
+    updateActivationBit();
 }
 
 void Layer::registerProgramChange(int program) noexcept
 {
     programSwitched_ = region_.programRange.containsWithEnd(program);
+    updateActivationBit();
 }
 
 void Layer::registerAftertouch(float aftertouch) noexcept
 {
     aftertouchSwitched_ = region_.aftertouchRange.containsWithEnd(aftertouch);
+    updateActivationBit();
 }
 
 void Layer::registerTempo(float secondsPerQuarter) noexcept
 {
     const float bpm = 60.0f / secondsPerQuarter;
     bpmSwitched_ = region_.bpmRange.containsWithEnd(bpm);
+    updateActivationBit();
 }
 
 void Layer::delaySustainRelease(int noteNumber, float velocity) noexcept
@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 #include <bitset>
+#include <cstdint>
 #include <memory>
 
 namespace sfz {
@@ -125,6 +126,27 @@ public:
      * @param secondsPerQuarter
      */
     void registerProgramChange(int program) noexcept;
+    /**
+     * @brief Set the state of the key switches (sw_last, sw_up, sw_down).
+     *
+     * @param value
+     */
+    void setKeySwitched(bool value) noexcept;
+    /**
+     * @brief Set the state of the previous key switch (sw_previous).
+     *
+     * @param value
+     */
+    void setPreviousKeySwitched(bool value) noexcept;
+    /**
+     * @brief Bind the layer to its bit in the switched on mask of a
+     * `LayerActivationIndex`, which the layer then keeps up to date.
+     * A null word unbinds the layer.
+     *
+     * @param word
+     * @param mask
+     */
+    void bindActivationBit(uint64_t* word, uint64_t mask) noexcept;
 
     // Started notes
     bool sustainPressed_ { false };
@@ -139,6 +161,7 @@ public:
     bool isNoteSostenutoed(int noteNumber) const noexcept;
 
     const MidiState& midiState_;
+    // Use the setters to change the key switches, which update the activation bit
     bool keySwitched_ {};
     bool previousKeySwitched_ {};
     bool sequenceSwitched_ {};
@@ -152,6 +175,11 @@ public:
 
     Region region_;
 
+private:
+    void updateActivationBit() noexcept;
+    uint64_t* activationWord_ { nullptr };
+    uint64_t activationMask_ { 0 };
+
     LEAK_DETECTOR(Layer);
 };
 
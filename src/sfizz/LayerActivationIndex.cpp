@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "LayerActivationIndex.h"
+#include "Region.h"
+#include <algorithm>
+
+namespace sfz {
+
+constexpr unsigned LayerActivationIndex::numVelocityBuckets;
+
+void LayerActivationIndex::build(const std::vector<std::unique_ptr<Layer>>& layers)
+{
+    clear();
+
+    const size_t numLayers = layers.size();
+    layers_.reserve(numLayers);
+    for (const auto& layer : layers)
+        layers_.push_back(layer.get());
+    switchedOn_.assign((numLayers + 63) / 64, 0);
+
+    // Each note only stores the words between its first and last layers
+    for (int note = 0; note < static_cast<int>(windows_.size()); ++note) {
+        size_t first = numLayers;
+        size_t last = 0;
+        for (size_t i = 0; i < numLayers; ++i) {
+            if (layers_[i]->getRegion().keyRange.containsWithEnd(note)) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+
+        NoteWindow& window = windows_[note];
+        window.offset = candidates_.size();
+        if (first > last)
+            continue;
+
+        window.firstWord = static_cast<uint32_t>(first / 64);
+        window.numWords = static_cast<uint32_t>(last / 64 - first / 64 + 1);
+        candidates_.resize(candidates_.size() + window.numWords * numVelocityBuckets, 0);
+        for (size_t i = first; i <= last; ++i)
+            setCandidate(note, i);
+    }
+
+    for (size_t i = 0; i < numLayers; ++i)
+        layers_[i]->bindActivationBit(&switchedOn_[i / 64], uint64_t(1) << (i % 64));
+}
+
+void LayerActivationIndex::clear() noexcept
+{
+    for (Layer* layer : layers_)
+        layer->bindActivationBit(nullptr, 0);
+
+    layers_.clear();
+    switchedOn_.clear();
+    candidates_.clear();
+    windows_.fill(NoteWindow {});
+}
+
+void LayerActivationIndex::refreshLayer(size_t layerIndex) noexcept
+{
+    if (layerIndex >= layers_.size())
+        return;
+
+    for (int note = 0; note < static_cast<int>(windows_.size()); ++note)
+        setCandidate(note, layerIndex);
+
+    layers_[layerIndex]->bindActivationBit(
+        &switchedOn_[layerIndex / 64], uint64_t(1) << (layerIndex % 64));
+}
+
+void LayerActivationIndex::setCandidate(int noteNumber, size_t layerIndex) noexcept
+{
+    const NoteWindow& window = windows_[noteNumber];
+    const size_t word = layerIndex / 64;
+    if (word < window.firstWord || word >= window.firstWord + window.numWords)
+        return;
+
+    const Region& region = layers_[layerIndex]->getRegion();
+    const bool usesSequence = region.usesSequenceSwitches
+        || region.sequenceLength > 1 || region.sequencePosition > 1;
+    unsigned firstBucket = 1;
+    unsigned lastBucket = 0;
+    if (region.keyRange.containsWithEnd(noteNumber)) {
+        if (usesSequence || region.velocityOverride == VelocityOverride::previous) {
+            // The sequence counter advances on the notes of any velocity, and
+            // the velocity of the previous note gets checked instead
+            firstBucket = 0;
+            lastBucket = numVelocityBuckets - 1;
+        } else if (region.velocityRange.getStart() <= region.velocityRange.getEnd()) {
+            firstBucket = velocityBucket(region.velocityRange.getStart());
+            lastBucket = velocityBucket(region.velocityRange.getEnd());
+        }
+    }
+
+    uint64_t* candidates = &candidates_[window.offset + (word - window.firstWord)];
+    const uint64_t mask = uint64_t(1) << (layerIndex % 64);
+    for (unsigned bucket = 0; bucket < numVelocityBuckets; ++bucket) {
+        uint64_t& bits = candidates[bucket * window.numWords];
+        if (bucket >= firstBucket && bucket <= lastBucket)
+            bits |= mask;
+        else
+            bits &= ~mask;
+    }
+}
+
+} // namespace sfz
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Layer.h"
+#include <absl/numeric/bits.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief An index of the layers which can start on a note on event.
+ *
+ * Each layer owns a bit, at the position of the layer in the instrument. For
+ * each note and velocity bucket, the index keeps a mask of the layers whose key
+ * and velocity ranges match, and the layers keep their bit up to date in a
+ * global mask of the switched on layers. A note on event then only visits the
+ * layers present in both masks, in the order of the instrument.
+ *
+ * The masks are conservative: a visited layer still has to accept the event in
+ * `Layer::registerNoteOn`. The layers which use sequences are always visited
+ * on the notes of their key range, whatever the velocity, since their
+ * sequence counter advances on every note on event.
+ */
+class LayerActivationIndex {
+public:
+    static constexpr unsigned numVelocityBuckets = 16;
+
+    LayerActivationIndex() = default;
+    LayerActivationIndex(const LayerActivationIndex&) = delete;
+    LayerActivationIndex& operator=(const LayerActivationIndex&) = delete;
+
+    /**
+     * @brief Build the index, and bind the layers to their bit in the
+     * switched on mask. The layers must stay alive until the index is
+     * cleared or built again.
+     *
+     * @param layers the layers of the instrument
+     */
+    void build(const std::vector<std::unique_ptr<Layer>>& layers);
+    /**
+     * @brief Unbind the layers, and empty the index.
+     */
+    void clear() noexcept;
+    /**
+     * @brief Update the index after a change in the velocity or sequence
+     * opcodes of a layer.
+     *
+     * @param layerIndex the position of the layer in the instrument
+     */
+    void refreshLayer(size_t layerIndex) noexcept;
+    /**
+     * @brief Get the number of indexed layers.
+     */
+    size_t size() const noexcept { return layers_.size(); }
+    /**
+     * @brief Call a function on each layer which may start on a note on event,
+     * in the order of the instrument. The switched on mask is read again after
+     * each call, so the function may change the switches of the layers.
+     *
+     * @param noteNumber
+     * @param velocity
+     * @param function a callable `void(Layer*)`
+     */
+    template <class F>
+    void forEachCandidate(int noteNumber, float velocity, F&& function) const;
+
+    /**
+     * @brief Get the velocity bucket of a normalized velocity.
+     */
+    static unsigned velocityBucket(float velocity) noexcept;
+
+private:
+    void setCandidate(int noteNumber, size_t layerIndex) noexcept;
+
+    struct NoteWindow {
+        uint32_t firstWord { 0 };
+        uint32_t numWords { 0 };
+        size_t offset { 0 }; // first word of the candidates, bucket-major
+    };
+
+    std::vector<Layer*> layers_;
+    std::vector<uint64_t> switchedOn_;
+    std::vector<uint64_t> candidates_;
+    std::array<NoteWindow, 128> windows_ {};
+};
+
+template <class F>
+void LayerActivationIndex::forEachCandidate(int noteNumber, float velocity, F&& function) const
+{
+    if (noteNumber < 0 || noteNumber >= static_cast<int>(windows_.size()))
+        return;
+
+    const NoteWindow& window = windows_[noteNumber];
+    const uint64_t* candidates = candidates_.data() + window.offset
+        + velocityBucket(velocity) * window.numWords;
+
+    for (uint32_t w = 0; w < window.numWords; ++w) {
+        const uint32_t word = window.firstWord + w;
+        uint64_t pending = candidates[w];
+        uint64_t bits;
+        while ((bits = pending & switchedOn_[word]) != 0) {
+            const unsigned bit = static_cast<unsigned>(absl::countr_zero(bits));
+            // Drop this bit and the lower ones, the next ones are read again
+            pending &= ~((uint64_t(2) << bit) - 1);
+            function(layers_[size_t(word) * 64 + bit]);
+        }
+    }
+}
+
+inline unsigned LayerActivationIndex::velocityBucket(float velocity) noexcept
+{
+    if (!(velocity > 0.0f))
+        return 0;
+    const unsigned bucket = static_cast<unsigned>(velocity * numVelocityBuckets);
+    return bucket < numVelocityBuckets ? bucket : numVelocityBuckets - 1;
+}
+
+} // namespace sfz
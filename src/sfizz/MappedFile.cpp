@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace sfz {
+
+#if defined(_WIN32)
+bool MappedFile::open(const fs::path& path, std::error_code* ec) noexcept
+{
+    close();
+
+    auto setError = [ec]() {
+        if (ec)
+            *ec = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+    };
+
+    HANDLE file = CreateFileW(
+        path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        setError();
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        setError();
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        setError();
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        setError();
+        CloseHandle(mapping);
+        return false;
+    }
+
+    data_ = static_cast<const unsigned char*>(data);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+    mapping_ = mapping;
+    if (ec)
+        ec->clear();
+    return true;
+}
+
+void MappedFile::close() noexcept
+{
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = nullptr;
+}
+
+void MappedFile::adviseSequential() noexcept
+{
+}
+
+bool MappedFile::isUnchanged() const noexcept
+{
+    // A file cannot be truncated while a view of it is mapped
+    return data_ != nullptr;
+}
+
+size_t MappedFile::read(size_t offset, void* buffer, size_t size) const noexcept
+{
+    if (offset >= size_)
+        return 0;
+    size = std::min(size, size_ - offset);
+    std::memcpy(buffer, data_ + offset, size);
+    return size;
+}
+#else
+bool MappedFile::open(const fs::path& path, std::error_code* ec) noexcept
+{
+    close();
+
+    auto setError = [ec]() {
+        if (ec)
+            *ec = std::error_code(errno, std::generic_category());
+    };
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        setError();
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        setError();
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        setError();
+        ::close(fd);
+        return false;
+    }
+
+    // Keep the descriptor to check the file and to read it plainly
+    data_ = static_cast<const unsigned char*>(data);
+    size_ = size;
+    fd_ = fd;
+    modificationTime_ = static_cast<int64_t>(st.st_mtime);
+    if (ec)
+        ec->clear();
+    return true;
+}
+
+void MappedFile::close() noexcept
+{
+    if (data_)
+        munmap(const_cast<unsigned char*>(data_), size_);
+    if (fd_ != -1)
+        ::close(fd_);
+    data_ = nullptr;
+    size_ = 0;
+    fd_ = -1;
+    modificationTime_ = 0;
+}
+
+void MappedFile::adviseSequential() noexcept
+{
+    if (data_)
+        madvise(const_cast<unsigned char*>(data_), size_, MADV_SEQUENTIAL);
+}
+
+bool MappedFile::isUnchanged() const noexcept
+{
+    struct stat st;
+    if (fd_ == -1 || fstat(fd_, &st) != 0)
+        return false;
+
+    return static_cast<size_t>(st.st_size) == size_ &&
+        static_cast<int64_t>(st.st_mtime) == modificationTime_;
+}
+
+size_t MappedFile::read(size_t offset, void* buffer, size_t size) const noexcept
+{
+    if (fd_ == -1)
+        return 0;
+
+    size_t count = 0;
+    while (count < size) {
+        const ssize_t n = pread(fd_, static_cast<char*>(buffer) + count, size - count, static_cast<off_t>(offset + count));
+        if (n > 0)
+            count += static_cast<size_t>(n);
+        else if (n == 0 || errno != EINTR)
+            break;
+    }
+    return count;
+}
+#endif
+
+} // namespace sfz
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "ghc/fs_std.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+
+namespace sfz {
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ *
+ * The pages are loaded on access and shared through the page cache of the
+ * system, so several mappings of the same file do not duplicate its memory.
+ *
+ * Accessing the pages of a file which was truncated after it was mapped
+ * raises a bus error on POSIX systems. Long-lived users should check that the
+ * file is unchanged before they access the mapping, and use `read` otherwise.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() noexcept { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Map the file at the given path, closing any previous mapping.
+     *
+     * @return true if the file is mapped
+     */
+    bool open(const fs::path& path, std::error_code* ec = nullptr) noexcept;
+
+    /**
+     * @brief Unmap the file.
+     */
+    void close() noexcept;
+
+    /**
+     * @brief Hint the system that the mapping will be read sequentially.
+     */
+    void adviseSequential() noexcept;
+
+    /**
+     * @brief Check whether the size and modification time of the file are
+     * the same as when it was mapped, so that the mapping is safe to access.
+     */
+    bool isUnchanged() const noexcept;
+
+    /**
+     * @brief Read bytes of the file without going through the mapping.
+     *
+     * @param offset the offset in the file
+     * @param buffer the destination
+     * @param size the number of bytes to read
+     * @return the number of bytes read, which is less than requested past the
+     * current end of the file or on error
+     */
+    size_t read(size_t offset, void* buffer, size_t size) const noexcept;
+
+    explicit operator bool() const noexcept { return data_ != nullptr; }
+    const unsigned char* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+
+private:
+    const unsigned char* data_ { nullptr };
+    size_t size_ { 0 };
+#if defined(_WIN32)
+    void* mapping_ { nullptr };
+#else
+    int fd_ { -1 };
+    int64_t modificationTime_ { 0 };
+#endif
+};
+
+} // namespace sfz
@@ -718,7 +718,8 @@ private:
  *
  */
 namespace Random {
-static fast_rand randomGenerator;
+// thread-local, as voices may be rendered concurrently by several workers
+static thread_local fast_rand randomGenerator;
 } // namespace Random
 
 /**
@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "PreloadCache.h"
+#include "utility/Debug.h"
+#include <absl/strings/str_cat.h>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sfz {
+
+namespace {
+
+constexpr char cacheMagic[8] = { 's', 'f', 'z', 'p', 'r', 'e', 'l', 'd' };
+constexpr uint32_t cacheVersion = 1;
+constexpr uint32_t cacheByteOrder = 0x01020304;
+constexpr size_t cacheDataAlignment = 16;
+
+/**
+ * @brief Identity of a sample file on disk, which a cache file must match
+ */
+struct FileIdentity {
+    std::string path;
+    uint64_t size { 0 };
+    int64_t modificationTime { 0 };
+    uint32_t reverse { 0 };
+};
+
+bool getFileIdentity(const fs::path& file, bool reverse, FileIdentity& identity)
+{
+    std::error_code ec;
+    const fs::path absolute = fs::absolute(file, ec);
+    if (ec)
+        return false;
+
+    const auto size = fs::file_size(absolute, ec);
+    if (ec)
+        return false;
+
+    const auto modificationTime = fs::last_write_time(absolute, ec);
+    if (ec)
+        return false;
+
+    identity.path = absolute.u8string();
+    identity.size = static_cast<uint64_t>(size);
+    identity.modificationTime = static_cast<int64_t>(modificationTime.time_since_epoch().count());
+    identity.reverse = reverse;
+    return true;
+}
+
+/**
+ * @brief 64-bit FNV-1a, which is stable across platforms and runs
+ */
+uint64_t hashString(absl::string_view string)
+{
+    uint64_t hash = 0xcbf29ce484222325u;
+    for (char c : string) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3u;
+    }
+    return hash;
+}
+
+class BlobWriter {
+public:
+    template <class T>
+    void write(const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+    void writeBytes(const void* bytes, size_t size)
+    {
+        const char* first = static_cast<const char*>(bytes);
+        data_.insert(data_.end(), first, first + size);
+    }
+    void align(size_t alignment)
+    {
+        data_.resize((data_.size() + alignment - 1) / alignment * alignment);
+    }
+    const std::vector<char>& data() const noexcept { return data_; }
+
+private:
+    std::vector<char> data_;
+};
+
+class BlobReader {
+public:
+    BlobReader(const unsigned char* data, size_t size)
+        : data_(data), size_(size) {}
+    template <class T>
+    bool read(T& value)
+    {
+        return readBytes(&value, sizeof(T));
+    }
+    bool readBytes(void* bytes, size_t size)
+    {
+        if (size > size_ - position_)
+            return false;
+        std::memcpy(bytes, data_ + position_, size);
+        position_ += size;
+        return true;
+    }
+    void align(size_t alignment)
+    {
+        position_ = std::min(size_, (position_ + alignment - 1) / alignment * alignment);
+    }
+    size_t position() const noexcept { return position_; }
+    size_t remaining() const noexcept { return size_ - position_; }
+
+private:
+    const unsigned char* data_ { nullptr };
+    size_t size_ { 0 };
+    size_t position_ { 0 };
+};
+
+void writeIdentity(BlobWriter& writer, const FileIdentity& identity)
+{
+    writer.writeBytes(cacheMagic, sizeof(cacheMagic));
+    writer.write(cacheVersion);
+    writer.write(cacheByteOrder);
+    writer.write(identity.size);
+    writer.write(identity.modificationTime);
+    writer.write(identity.reverse);
+    writer.write(static_cast<uint32_t>(identity.path.size()));
+    writer.writeBytes(identity.path.data(), identity.path.size());
+}
+
+bool checkIdentity(BlobReader& reader, const FileIdentity& identity)
+{
+    char magic[sizeof(cacheMagic)];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t size;
+    int64_t modificationTime;
+    uint32_t reverse;
+    uint32_t pathSize;
+    if (!reader.readBytes(magic, sizeof(magic)) || std::memcmp(magic, cacheMagic, sizeof(magic)) != 0)
+        return false;
+    if (!reader.read(version) || version != cacheVersion)
+        return false;
+    if (!reader.read(byteOrder) || byteOrder != cacheByteOrder)
+        return false;
+    if (!reader.read(size) || size != identity.size)
+        return false;
+    if (!reader.read(modificationTime) || modificationTime != identity.modificationTime)
+        return false;
+    if (!reader.read(reverse) || reverse != identity.reverse)
+        return false;
+    if (!reader.read(pathSize) || pathSize != identity.path.size() || pathSize > reader.remaining())
+        return false;
+    std::string path(pathSize, '\0');
+    return reader.readBytes(&path[0], pathSize) && path == identity.path;
+}
+
+void writeInformation(BlobWriter& writer, const FileInformation& information)
+{
+    writer.write(information.end);
+    writer.write(information.loopStart);
+    writer.write(information.loopEnd);
+    writer.write(static_cast<uint32_t>(information.hasLoop));
+    writer.write(information.sampleRate);
+    writer.write(static_cast<int32_t>(information.numChannels));
+    writer.write(static_cast<int32_t>(information.rootKey));
+    writer.write(static_cast<uint32_t>(information.wavetable.has_value()));
+    const WavetableInfo wavetable = information.wavetable.value_or(WavetableInfo {});
+    writer.write(wavetable.tableSize);
+    writer.write(static_cast<int32_t>(wavetable.crossTableInterpolation));
+    writer.write(static_cast<uint32_t>(wavetable.oneShot));
+}
+
+bool readInformation(BlobReader& reader, FileInformation& information)
+{
+    uint32_t hasLoop;
+    int32_t numChannels;
+    int32_t rootKey;
+    uint32_t hasWavetable;
+    WavetableInfo wavetable;
+    int32_t crossTableInterpolation;
+    uint32_t oneShot;
+    if (!reader.read(information.end) || !reader.read(information.loopStart)
+        || !reader.read(information.loopEnd) || !reader.read(hasLoop)
+        || !reader.read(information.sampleRate) || !reader.read(numChannels)
+        || !reader.read(rootKey) || !reader.read(hasWavetable)
+        || !reader.read(wavetable.tableSize) || !reader.read(crossTableInterpolation)
+        || !reader.read(oneShot))
+        return false;
+
+    if (numChannels != 1 && numChannels != 2)
+        return false;
+
+    information.hasLoop = hasLoop != 0;
+    information.numChannels = numChannels;
+    information.rootKey = rootKey;
+    if (hasWavetable) {
+        wavetable.crossTableInterpolation = crossTableInterpolation;
+        wavetable.oneShot = oneShot != 0;
+        information.wavetable = wavetable;
+    }
+    return true;
+}
+
+} // namespace
+
+void PreloadCache::setDirectory(const fs::path& directory) noexcept
+{
+    directory_ = directory;
+    if (directory.empty())
+        return;
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec)
+        DBG("[sfizz] Cannot create the preload cache directory " << directory << ": " << ec.message());
+}
+
+fs::path PreloadCache::getCacheFile(const fs::path& file, bool reverse) const
+{
+    const uint64_t hash = hashString(file.u8string());
+    return directory_ / absl::StrCat(absl::Hex(hash, absl::kZeroPad16), reverse ? "-r" : "", ".preload");
+}
+
+std::unique_ptr<PreloadCache::Entry> PreloadCache::find(const fs::path& file, bool reverse) const noexcept
+{
+    // A cache file which cannot be read is a miss
+    try {
+        return readCacheFile(file, reverse);
+    }
+    catch (std::exception& error) {
+        DBG("[sfizz] Cannot read the preload cache file of " << file << ": " << error.what());
+        return {};
+    }
+}
+
+std::unique_ptr<PreloadCache::Entry> PreloadCache::readCacheFile(const fs::path& file, bool reverse) const
+{
+    FileIdentity identity;
+    if (!isEnabled() || !getFileIdentity(file, reverse, identity))
+        return {};
+
+    std::unique_ptr<Entry> entry { new Entry };
+    if (!entry->mapping_.open(getCacheFile(identity.path, reverse)))
+        return {};
+
+    BlobReader reader { entry->mapping_.data(), entry->mapping_.size() };
+    if (!checkIdentity(reader, identity) || !readInformation(reader, entry->information_))
+        return {};
+
+    if (!reader.read(entry->numFrames_) || !reader.read(entry->numPreloadedFrames_))
+        return {};
+
+    reader.align(cacheDataAlignment);
+    const size_t numChannels = static_cast<size_t>(entry->information_.numChannels);
+    const size_t dataSize = numChannels * entry->numPreloadedFrames_ * sizeof(float);
+    if (entry->numPreloadedFrames_ > entry->numFrames_ || dataSize > reader.remaining())
+        return {};
+
+    entry->dataOffset_ = reader.position();
+    return entry;
+}
+
+bool PreloadCache::Entry::readPreloadedData(FileAudioBuffer& output, uint32_t numFrames) const noexcept
+{
+    if (numFrames > numPreloadedFrames_)
+        return false;
+
+    const unsigned numChannels = static_cast<unsigned>(information_.numChannels);
+    try {
+        output.reset();
+        output.resize(numFrames);
+        output.addChannels(numChannels);
+        output.clear();
+    }
+    catch (std::exception& error) {
+        DBG("[sfizz] Cannot allocate the preloaded data: " << error.what());
+        return false;
+    }
+
+    const float* data = reinterpret_cast<const float*>(mapping_.data() + dataOffset_);
+    for (unsigned c = 0; c < numChannels; ++c) {
+        const float* channel = data + c * size_t(numPreloadedFrames_);
+        std::copy(channel, channel + numFrames, output.channelWriter(c));
+    }
+
+    return true;
+}
+
+void PreloadCache::store(const fs::path& file, bool reverse, const FileInformation& information,
+    uint32_t numFrames, const FileAudioBuffer& preloaded) const noexcept
+{
+    // A cache file which cannot be written is a miss the next time
+    try {
+        writeCacheFile(file, reverse, information, numFrames, preloaded);
+    }
+    catch (std::exception& error) {
+        DBG("[sfizz] Cannot write the preload cache file of " << file << ": " << error.what());
+    }
+}
+
+void PreloadCache::writeCacheFile(const fs::path& file, bool reverse, const FileInformation& information,
+    uint32_t numFrames, const FileAudioBuffer& preloaded) const
+{
+    FileIdentity identity;
+    if (!isEnabled() || !getFileIdentity(file, reverse, identity))
+        return;
+
+    const size_t numChannels = preloaded.getNumChannels();
+    if (numChannels != static_cast<size_t>(information.numChannels))
+        return;
+
+    FileInformation storedInformation = information;
+    storedInformation.maxOffset = 0;
+
+    const auto numPreloadedFrames = static_cast<uint32_t>(preloaded.getNumFrames());
+    BlobWriter writer;
+    writeIdentity(writer, identity);
+    writeInformation(writer, storedInformation);
+    writer.write(numFrames);
+    writer.write(numPreloadedFrames);
+    writer.align(cacheDataAlignment);
+    for (size_t c = 0; c < numChannels; ++c)
+        writer.writeBytes(preloaded.channelReader(c), numPreloadedFrames * sizeof(float));
+
+    // Write to a temporary file, and move it in place
+    const fs::path cacheFile = getCacheFile(identity.path, reverse);
+    fs::path temporaryFile = cacheFile;
+    temporaryFile += absl::StrCat(".", std::random_device {}(), ".tmp");
+
+    std::error_code ec;
+    {
+        fs::ofstream stream(temporaryFile, std::ios::binary);
+        const std::vector<char>& data = writer.data();
+        stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!stream) {
+            DBG("[sfizz] Cannot write the preload cache file " << temporaryFile);
+            stream.close();
+            fs::remove(temporaryFile, ec);
+            return;
+        }
+    }
+
+    fs::rename(temporaryFile, cacheFile, ec);
+    if (ec) {
+        DBG("[sfizz] Cannot replace the preload cache file " << cacheFile << ": " << ec.message());
+        fs::remove(temporaryFile, ec);
+    }
+}
+
+} // namespace sfz
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "FilePool.h"
+#include "MappedFile.h"
+#include "utility/LeakDetector.h"
+#include "ghc/fs_std.hpp"
+#include <memory>
+
+namespace sfz {
+
+/**
+ * @brief A directory of files which keep the preloaded head and the
+ * information of samples across sessions, so that loading an instrument again
+ * does not need to decode its samples.
+ *
+ * There is one cache file per sample file and direction. It records the path,
+ * size and modification time of the sample file, and is ignored as soon as
+ * any of them differs. Cache files are replaced atomically, so several
+ * instances can share the directory.
+ */
+class PreloadCache {
+public:
+    /**
+     * @brief A valid cache file, mapped in memory
+     */
+    class Entry {
+    public:
+        /**
+         * @brief Get the information of the sample file
+         */
+        const FileInformation& getInformation() const noexcept { return information_; }
+        /**
+         * @brief Get the total number of frames in the sample file
+         */
+        uint32_t getNumFrames() const noexcept { return numFrames_; }
+        /**
+         * @brief Get the number of frames stored in the cache file
+         */
+        uint32_t getNumPreloadedFrames() const noexcept { return numPreloadedFrames_; }
+        /**
+         * @brief Copy the first frames of the sample into a buffer.
+         *
+         * @return false if the cache file stores fewer frames
+         */
+        bool readPreloadedData(FileAudioBuffer& output, uint32_t numFrames) const noexcept;
+
+    private:
+        friend class PreloadCache;
+        MappedFile mapping_;
+        FileInformation information_;
+        uint32_t numFrames_ { 0 };
+        uint32_t numPreloadedFrames_ { 0 };
+        size_t dataOffset_ { 0 };
+        LEAK_DETECTOR(Entry);
+    };
+
+    /**
+     * @brief Set the cache directory, which is created if needed.
+     * An empty path disables the cache.
+     */
+    void setDirectory(const fs::path& directory) noexcept;
+
+    /**
+     * @brief Get the cache directory, empty if the cache is disabled
+     */
+    const fs::path& getDirectory() const noexcept { return directory_; }
+
+    /**
+     * @brief Check whether the cache is enabled
+     */
+    bool isEnabled() const noexcept { return !directory_.empty(); }
+
+    /**
+     * @brief Find the cache file of a sample file.
+     *
+     * @param file the sample file
+     * @param reverse whether the sample is read in reverse
+     * @return the cache entry, or null if there is none up to date or it
+     * cannot be read
+     */
+    std::unique_ptr<Entry> find(const fs::path& file, bool reverse) const noexcept;
+
+    /**
+     * @brief Write the cache file of a sample file, replacing any previous one.
+     * A file which cannot be written is only missing from the cache.
+     *
+     * @param file the sample file
+     * @param reverse whether the sample is read in reverse
+     * @param information the information of the sample file
+     * @param numFrames the total number of frames of the sample file
+     * @param preloaded the first frames of the sample
+     */
+    void store(const fs::path& file, bool reverse, const FileInformation& information,
+        uint32_t numFrames, const FileAudioBuffer& preloaded) const noexcept;
+
+private:
+    fs::path getCacheFile(const fs::path& file, bool reverse) const;
+    std::unique_ptr<Entry> readCacheFile(const fs::path& file, bool reverse) const;
+    void writeCacheFile(const fs::path& file, bool reverse, const FileInformation& information,
+        uint32_t numFrames, const FileAudioBuffer& preloaded) const;
+    fs::path directory_;
+    LEAK_DETECTOR(PreloadCache);
+};
+
+} // namespace sfz
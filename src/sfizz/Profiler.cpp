@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Profiler.h"
+#include "utility/Debug.h"
+
+// The records are overwritten in place, through relaxed atomic words: a
+// counter is advanced before its slot gets rewritten, and the readers check the counter again after copying
+// a record to know whether the copy can be trusted. The slot of the block
+// which is being written is never readable, so a history of N blocks keeps
+// N - 1 readable blocks.
+
+namespace sfz {
+
+void Profiler::enable(unsigned blockCapacity, unsigned voiceCapacity)
+{
+    ASSERT(blockCapacity > 1);
+    ASSERT(voiceCapacity > 0);
+    blocks_ = std::vector<AtomicRecord<BlockSlot>>(blockCapacity);
+    voices_ = std::vector<AtomicRecord<VoiceProfile>>(voiceCapacity);
+    numBlocks_.store(0);
+    firstBlock_.store(0);
+    numVoices_.store(0);
+    blockVoiceStart_ = 0;
+}
+
+void Profiler::disable()
+{
+    blocks_ = std::vector<AtomicRecord<BlockSlot>>();
+    voices_ = std::vector<AtomicRecord<VoiceProfile>>();
+    numBlocks_.store(0);
+    firstBlock_.store(0);
+    numVoices_.store(0);
+    blockVoiceStart_ = 0;
+}
+
+void Profiler::clear() noexcept
+{
+    firstBlock_.store(numBlocks_.load(std::memory_order_relaxed), std::memory_order_release);
+    blockVoiceStart_ = numVoices_.load(std::memory_order_relaxed);
+}
+
+void Profiler::addVoice(const VoiceProfile& voice) noexcept
+{
+    if (voices_.empty())
+        return;
+
+    const uint64_t index = numVoices_.load(std::memory_order_relaxed);
+    numVoices_.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    voices_[index % voices_.size()].store(voice);
+}
+
+void Profiler::endBlock(uint32_t numFrames, float dispatch, float renderMethod, float effects) noexcept
+{
+    if (blocks_.empty())
+        return;
+
+    const uint64_t index = numBlocks_.load(std::memory_order_relaxed);
+    const uint64_t voiceEnd = numVoices_.load(std::memory_order_relaxed);
+
+    BlockSlot slot;
+    slot.block.index = index;
+    slot.block.numFrames = numFrames;
+    slot.block.numVoices = static_cast<uint32_t>(voiceEnd - blockVoiceStart_);
+    slot.block.dispatch = dispatch;
+    slot.block.renderMethod = renderMethod;
+    slot.block.effects = effects;
+    slot.firstVoice = blockVoiceStart_;
+    blockVoiceStart_ = voiceEnd;
+    // a reader which sees any word of the new block also sees the counter
+    // which invalidated the block it overwrites
+    std::atomic_thread_fence(std::memory_order_release);
+    blocks_[index % blocks_.size()].store(slot);
+
+    numBlocks_.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::getNumBlocks() const noexcept
+{
+    const uint64_t first = firstBlock_.load(std::memory_order_acquire);
+    const uint64_t count = numBlocks_.load(std::memory_order_acquire);
+    return count - first;
+}
+
+bool Profiler::isBlockValid(uint64_t blockIndex) const noexcept
+{
+    const uint64_t count = numBlocks_.load(std::memory_order_relaxed);
+    return blockIndex >= firstBlock_.load(std::memory_order_relaxed)
+        && blockIndex < count && blockIndex + blocks_.size() > count;
+}
+
+bool Profiler::isVoiceValid(uint64_t voiceIndex) const noexcept
+{
+    const uint64_t count = numVoices_.load(std::memory_order_relaxed);
+    return voiceIndex + voices_.size() >= count;
+}
+
+bool Profiler::readSlot(uint64_t blockIndex, BlockSlot& slot) const noexcept
+{
+    if (blocks_.empty())
+        return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!isBlockValid(blockIndex))
+        return false;
+
+    slot = blocks_[blockIndex % blocks_.size()].load();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return isBlockValid(blockIndex) && slot.block.index == blockIndex;
+}
+
+bool Profiler::getBlock(unsigned age, BlockProfile& block) const noexcept
+{
+    const uint64_t count = numBlocks_.load(std::memory_order_acquire);
+    if (age >= count)
+        return false;
+
+    BlockSlot slot;
+    if (!readSlot(count - 1 - age, slot))
+        return false;
+
+    block = slot.block;
+    return true;
+}
+
+bool Profiler::getVoice(unsigned age, unsigned index, VoiceProfile& voice) const noexcept
+{
+    const uint64_t count = numBlocks_.load(std::memory_order_acquire);
+    if (age >= count)
+        return false;
+
+    BlockSlot slot;
+    if (!readSlot(count - 1 - age, slot) || index >= slot.block.numVoices)
+        return false;
+
+    const uint64_t voiceIndex = slot.firstVoice + index;
+    voice = voices_[voiceIndex % voices_.size()].load();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return isVoiceValid(voiceIndex);
+}
+
+} // namespace sfz
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "utility/AtomicRecord.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief The timings of a voice during a render cycle, in seconds, and the
+ * characteristics of the voice which drive its cost.
+ */
+struct VoiceProfile {
+    int voiceId { -1 };
+    int regionId { -1 };
+    uint8_t sampleQuality { 0 };
+    uint8_t numFilters { 0 };
+    uint8_t numEQs { 0 };
+    uint8_t numLFOs { 0 };
+    float data { 0 };
+    float amplitude { 0 };
+    float filters { 0 };
+    float panning { 0 };
+};
+
+/**
+ * @brief The timings of a render cycle, in seconds.
+ */
+struct BlockProfile {
+    uint64_t index { 0 };
+    uint32_t numFrames { 0 };
+    uint32_t numVoices { 0 };
+    float dispatch { 0 };
+    float renderMethod { 0 };
+    float effects { 0 };
+};
+
+/**
+ * @brief A history of the timings of the last render cycles, per block and
+ * per voice.
+ *
+ * The audio thread records the blocks, and any thread can read them back
+ * without locking: a read fails instead if the record was overwritten in
+ * the meantime. The storage is only allocated when the profiler is enabled.
+ */
+class Profiler {
+public:
+    Profiler() = default;
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * @brief Allocate the history and start recording.
+     * This must not be called concurrently with the audio thread.
+     *
+     * @param blockCapacity the number of blocks kept in the history
+     * @param voiceCapacity the number of voice records kept in the history,
+     *                      shared by all the blocks
+     */
+    void enable(unsigned blockCapacity, unsigned voiceCapacity);
+
+    /**
+     * @brief Stop recording and release the history.
+     * This must not be called concurrently with the audio thread.
+     */
+    void disable();
+
+    /**
+     * @brief Whether the profiler is recording.
+     */
+    bool isEnabled() const noexcept { return !blocks_.empty(); }
+
+    /**
+     * @brief Forget the recorded blocks. This must be called from the
+     * audio thread.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief Add the record of a voice to the current block.
+     * This must be called from the audio thread.
+     */
+    void addVoice(const VoiceProfile& voice) noexcept;
+
+    /**
+     * @brief Finish the current block and publish it along with its voices.
+     * This must be called from the audio thread.
+     */
+    void endBlock(uint32_t numFrames, float dispatch, float renderMethod, float effects) noexcept;
+
+    /**
+     * @brief Get the number of blocks recorded since the profiler was
+     * enabled or cleared. This can be called from any thread.
+     */
+    uint64_t getNumBlocks() const noexcept;
+
+    /**
+     * @brief Read a block back. This can be called from any thread.
+     *
+     * @param age 0 for the last block, 1 for the one before, etc.
+     * @param block the block record
+     * @return false if the block is not in the history
+     */
+    bool getBlock(unsigned age, BlockProfile& block) const noexcept;
+
+    /**
+     * @brief Read a voice of a block back. This can be called from any thread.
+     *
+     * @param age 0 for the last block, 1 for the one before, etc.
+     * @param index the index of the voice record in the block, up to
+     *              `BlockProfile::numVoices`
+     * @param voice the voice record
+     * @return false if the voice is not in the history
+     */
+    bool getVoice(unsigned age, unsigned index, VoiceProfile& voice) const noexcept;
+
+private:
+    struct BlockSlot {
+        BlockProfile block;
+        uint64_t firstVoice { 0 };
+    };
+
+    bool readSlot(uint64_t blockIndex, BlockSlot& slot) const noexcept;
+    bool isBlockValid(uint64_t blockIndex) const noexcept;
+    bool isVoiceValid(uint64_t voiceIndex) const noexcept;
+
+    std::vector<AtomicRecord<BlockSlot>> blocks_;
+    std::vector<AtomicRecord<VoiceProfile>> voices_;
+    std::atomic<uint64_t> numBlocks_ { 0 };
+    std::atomic<uint64_t> firstBlock_ { 0 }; // first block after a clear
+    std::atomic<uint64_t> numVoices_ { 0 };
+    uint64_t blockVoiceStart_ { 0 }; // first voice record of the current block
+};
+
+} // namespace sfz
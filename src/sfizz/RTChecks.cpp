@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "RTChecks.h"
+
+#if !SFIZZ_RT_CHECKS
+
+namespace sfz {
+
+size_t getRealtimeViolationCount() noexcept
+{
+    return 0;
+}
+
+void resetRealtimeViolationCount() noexcept
+{
+}
+
+} // namespace sfz
+
+#else // SFIZZ_RT_CHECKS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define SFIZZ_RT_CHECKS_BACKTRACE 1
+#endif
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdarg>
+#endif
+
+// The flags are read from inside the allocator, they must not need
+// an allocation on the first access from a thread
+#if defined(__GNUC__) && !defined(_WIN32)
+#define SFIZZ_RT_TLS thread_local __attribute__((tls_model("initial-exec")))
+#else
+#define SFIZZ_RT_TLS thread_local
+#endif
+
+// On glibc, the C allocator, the mutexes and some system calls are
+// interposed as well, and forward to the internal glibc entry points
+#if defined(__GLIBC__)
+#define SFIZZ_RT_CHECKS_INTERPOSE 1
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+int __pthread_mutex_lock(pthread_mutex_t* mutex);
+int __nanosleep(const struct timespec* duration, struct timespec* remaining);
+ssize_t __read(int fd, void* buffer, size_t count);
+ssize_t __write(int fd, const void* buffer, size_t count);
+int __open(const char* path, int flags, ...);
+}
+#endif
+
+namespace {
+
+SFIZZ_RT_TLS bool threadIsRealtime = false;
+SFIZZ_RT_TLS bool threadIsReporting = false;
+std::atomic<size_t> violationCount { 0 };
+
+void printError(const char* message) noexcept
+{
+#if defined(_WIN32)
+    std::fputs(message, stderr);
+#else
+    ssize_t unused = ::write(STDERR_FILENO, message, std::strlen(message));
+    (void)unused;
+#endif
+}
+
+/**
+ * @brief Count and report an unsafe operation if the thread is real-time.
+ */
+void checkRealtime(const char* operation) noexcept
+{
+    if (!threadIsRealtime || threadIsReporting)
+        return;
+
+    // The report itself is not real-time safe
+    threadIsReporting = true;
+    violationCount.fetch_add(1, std::memory_order_relaxed);
+
+    printError("[sfizz] Real-time violation: ");
+    printError(operation);
+    printError("\n");
+#if SFIZZ_RT_CHECKS_BACKTRACE
+    void* frames[64];
+    const int numFrames = ::backtrace(frames, 64);
+    // skip this function and the intercepted one
+    if (numFrames > 2)
+        ::backtrace_symbols_fd(frames + 2, numFrames - 2, 2);
+#endif
+
+    threadIsReporting = false;
+}
+
+void* rawMalloc(size_t size) noexcept
+{
+#if SFIZZ_RT_CHECKS_INTERPOSE
+    return __libc_malloc(size);
+#else
+    return std::malloc(size);
+#endif
+}
+
+void rawFree(void* ptr) noexcept
+{
+#if SFIZZ_RT_CHECKS_INTERPOSE
+    __libc_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void* checkedNew(size_t size, bool nothrow)
+{
+    checkRealtime("operator new");
+    void* ptr = rawMalloc(size ? size : 1);
+    if (!ptr && !nothrow)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void checkedDelete(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+    checkRealtime("operator delete");
+    rawFree(ptr);
+}
+
+#if defined(__cpp_aligned_new) && !defined(SFIZZ_IMPLEMENT_CXX17_ALIGNED_NEW_SUPPORT)
+void* checkedAlignedNew(size_t size, std::align_val_t alignment, bool nothrow)
+{
+    checkRealtime("operator new");
+    const size_t align = static_cast<size_t>(alignment);
+    void* ptr;
+#if defined(_WIN32)
+    ptr = _aligned_malloc(size ? size : 1, align);
+#elif SFIZZ_RT_CHECKS_INTERPOSE
+    ptr = __libc_memalign(align, size ? size : 1);
+#else
+    if (posix_memalign(&ptr, align < sizeof(void*) ? sizeof(void*) : align, size ? size : 1) != 0)
+        ptr = nullptr;
+#endif
+    if (!ptr && !nothrow)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void checkedAlignedDelete(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+    checkRealtime("operator delete");
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    rawFree(ptr);
+#endif
+}
+#endif
+
+} // namespace
+
+namespace sfz {
+
+ScopedRealtime::ScopedRealtime() noexcept
+    : wasRealtime_(threadIsRealtime)
+{
+    threadIsRealtime = true;
+}
+
+ScopedRealtime::~ScopedRealtime() noexcept
+{
+    threadIsRealtime = wasRealtime_;
+}
+
+ScopedRealtimeExemption::ScopedRealtimeExemption() noexcept
+    : wasRealtime_(threadIsRealtime)
+{
+    threadIsRealtime = false;
+}
+
+ScopedRealtimeExemption::~ScopedRealtimeExemption() noexcept
+{
+    threadIsRealtime = wasRealtime_;
+}
+
+size_t getRealtimeViolationCount() noexcept
+{
+    return violationCount.load(std::memory_order_relaxed);
+}
+
+void resetRealtimeViolationCount() noexcept
+{
+    violationCount.store(0, std::memory_order_relaxed);
+}
+
+} // namespace sfz
+
+//------------------------------------------------------------------------------
+// Replacements of the global allocation functions
+
+void* operator new(size_t size) { return checkedNew(size, false); }
+void* operator new[](size_t size) { return checkedNew(size, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return checkedNew(size, true); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return checkedNew(size, true); }
+void operator delete(void* ptr) noexcept { checkedDelete(ptr); }
+void operator delete[](void* ptr) noexcept { checkedDelete(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { checkedDelete(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { checkedDelete(ptr); }
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, size_t) noexcept { checkedDelete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { checkedDelete(ptr); }
+#endif
+
+#if defined(__cpp_aligned_new) && !defined(SFIZZ_IMPLEMENT_CXX17_ALIGNED_NEW_SUPPORT)
+void* operator new(size_t size, std::align_val_t al) { return checkedAlignedNew(size, al, false); }
+void* operator new[](size_t size, std::align_val_t al) { return checkedAlignedNew(size, al, false); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return checkedAlignedNew(size, al, true); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return checkedAlignedNew(size, al, true); }
+void operator delete(void* ptr, std::align_val_t) noexcept { checkedAlignedDelete(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { checkedAlignedDelete(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { checkedAlignedDelete(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { checkedAlignedDelete(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { checkedAlignedDelete(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { checkedAlignedDelete(ptr); }
+#endif
+
+//------------------------------------------------------------------------------
+// Interposition of the C library
+
+#if SFIZZ_RT_CHECKS_INTERPOSE
+extern "C" {
+
+void* malloc(size_t size) noexcept
+{
+    checkRealtime("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    checkRealtime("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+    checkRealtime("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+    checkRealtime("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    checkRealtime("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept
+{
+    checkRealtime("posix_memalign");
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void* result = __libc_memalign(alignment, size);
+    if (!result)
+        return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+
+void free(void* ptr) noexcept
+{
+    if (ptr)
+        checkRealtime("free");
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    checkRealtime("pthread_mutex_lock");
+    return __pthread_mutex_lock(mutex);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    checkRealtime("nanosleep");
+    return __nanosleep(duration, remaining);
+}
+
+ssize_t read(int fd, void* buffer, size_t count)
+{
+    checkRealtime("read");
+    return __read(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count)
+{
+    checkRealtime("write");
+    return __write(fd, buffer, count);
+}
+
+int open(const char* path, int flags, ...)
+{
+    checkRealtime("open");
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    return __open(path, flags, mode);
+}
+
+} // extern "C"
+#endif // SFIZZ_RT_CHECKS_INTERPOSE
+
+#endif // SFIZZ_RT_CHECKS
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <cstddef>
+
+#ifndef SFIZZ_RT_CHECKS
+#define SFIZZ_RT_CHECKS 0
+#endif
+
+namespace sfz {
+
+/**
+ * @brief Mark the current thread as real-time as an RAII helper.
+ *
+ * In builds with SFIZZ_RT_CHECKS, the memory allocations, mutex locks and
+ * blocking system calls made on a real-time thread are counted and reported
+ * on the standard error, along with the stack of the caller. The scopes can
+ * be nested. In other builds, this does nothing.
+ */
+class ScopedRealtime {
+public:
+#if SFIZZ_RT_CHECKS
+    ScopedRealtime() noexcept;
+    ~ScopedRealtime() noexcept;
+#else
+    ScopedRealtime() noexcept {}
+#endif
+    ScopedRealtime(const ScopedRealtime&) = delete;
+    ScopedRealtime& operator=(const ScopedRealtime&) = delete;
+
+private:
+#if SFIZZ_RT_CHECKS
+    bool wasRealtime_ {};
+#endif
+};
+
+/**
+ * @brief Allow the current thread to perform unsafe operations as an RAII
+ * helper, for the scope of an operation known to be acceptable on a real-time
+ * thread. It does nothing in builds without SFIZZ_RT_CHECKS.
+ */
+class ScopedRealtimeExemption {
+public:
+#if SFIZZ_RT_CHECKS
+    ScopedRealtimeExemption() noexcept;
+    ~ScopedRealtimeExemption() noexcept;
+#else
+    ScopedRealtimeExemption() noexcept {}
+#endif
+    ScopedRealtimeExemption(const ScopedRealtimeExemption&) = delete;
+    ScopedRealtimeExemption& operator=(const ScopedRealtimeExemption&) = delete;
+
+private:
+#if SFIZZ_RT_CHECKS
+    bool wasRealtime_ {};
+#endif
+};
+
+/**
+ * @brief Whether the real-time checks are compiled in.
+ */
+constexpr bool realtimeChecksEnabled() noexcept { return SFIZZ_RT_CHECKS != 0; }
+
+/**
+ * @brief Get the number of unsafe operations seen on the real-time threads
+ * since the start or the last reset. It is always 0 without SFIZZ_RT_CHECKS.
+ */
+size_t getRealtimeViolationCount() noexcept;
+
+/**
+ * @brief Reset the count of unsafe operations.
+ */
+void resetRealtimeViolationCount() noexcept;
+
+} // namespace sfz
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "RTWorkerPool.h"
+#include "ScopedFTZ.h"
+#include "RTChecks.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <system_error>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace sfz {
+
+thread_local unsigned RTWorkerPool::workerIndex_ = 0;
+
+RTWorkerPool::RTWorkerPool(unsigned numThreads)
+    : numThreads_(std::max(1u, numThreads))
+    , segments_(new Segment[numThreads_])
+{
+    wakeups_.reserve(numThreads_ - 1);
+    threads_.reserve(numThreads_ - 1);
+    for (unsigned i = 1; i < numThreads_; ++i)
+        wakeups_.push_back(absl::make_unique<RTSemaphore>());
+    for (unsigned i = 1; i < numThreads_; ++i)
+        threads_.emplace_back(&RTWorkerPool::workerThread, this, i);
+}
+
+RTWorkerPool::~RTWorkerPool()
+{
+    quit_.store(true);
+    for (auto& wakeup : wakeups_)
+        wakeup->post();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+void RTWorkerPool::runTasks(unsigned numTasks, TaskFunction function, void* context) noexcept
+{
+    if (numTasks == 0)
+        return;
+
+    const unsigned numThreads = numThreads_;
+    if (numThreads == 1 || numTasks == 1) {
+        for (unsigned i = 0; i < numTasks; ++i)
+            function(context, i, 0);
+        return;
+    }
+
+    function_ = function;
+    context_ = context;
+
+    for (unsigned w = 0; w < numThreads; ++w) {
+        Segment& segment = segments_[w];
+        segment.next.store(static_cast<unsigned>(uint64_t(numTasks) * w / numThreads), std::memory_order_relaxed);
+        segment.end = static_cast<unsigned>(uint64_t(numTasks) * (w + 1) / numThreads);
+    }
+
+    batch_.store(batchOpen, std::memory_order_release);
+    std::error_code ec;
+    for (auto& wakeup : wakeups_) {
+        wakeup->post(ec);
+        ASSERT(!ec);
+    }
+
+    executeTasks(0);
+
+    // All the tasks are taken; close the batch, and if some workers are
+    // still in it, the last one to leave signals us
+    const unsigned numInBatch = batch_.fetch_and(~batchOpen, std::memory_order_acq_rel) & ~batchOpen;
+    if (numInBatch > 0) {
+        batchDone_.wait(ec);
+        ASSERT(!ec);
+    }
+
+    function_ = nullptr;
+    context_ = nullptr;
+}
+
+void RTWorkerPool::executeTasks(unsigned workerIndex) noexcept
+{
+    const unsigned numThreads = numThreads_;
+    const TaskFunction function = function_;
+    void* context = context_;
+
+    // Drain our own segment first, then steal from the next ones
+    for (unsigned i = 0; i < numThreads; ++i) {
+        Segment& segment = segments_[(workerIndex + i) % numThreads];
+        const unsigned end = segment.end;
+        for (;;) {
+            const unsigned taskIndex = segment.next.fetch_add(1, std::memory_order_relaxed);
+            if (taskIndex >= end)
+                break;
+            function(context, taskIndex, workerIndex);
+        }
+    }
+}
+
+void RTWorkerPool::workerThread(unsigned workerIndex)
+{
+    workerIndex_ = workerIndex;
+    raiseCurrentThreadPriority();
+    ScopedFTZ ftz;
+
+    RTSemaphore& wakeup = *wakeups_[workerIndex - 1];
+    for (;;) {
+        std::error_code ec;
+        wakeup.wait(ec);
+        if (ec)
+            continue;
+        if (quit_.load())
+            break;
+
+        // Join the batch unless it was closed while we were waking up
+        unsigned batch = batch_.load(std::memory_order_relaxed);
+        bool joined = false;
+        while (!joined && (batch & batchOpen))
+            joined = batch_.compare_exchange_weak(batch, batch + 1, std::memory_order_acquire, std::memory_order_relaxed);
+        if (!joined)
+            continue;
+
+        ScopedRealtime realtime;
+        executeTasks(workerIndex);
+        if (batch_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            batchDone_.post(ec);
+    }
+}
+
+void RTWorkerPool::raiseCurrentThreadPriority() noexcept
+{
+#if defined(_WIN32)
+    HANDLE thread = GetCurrentThread();
+    const int priority = THREAD_PRIORITY_TIME_CRITICAL;
+    if (!SetThreadPriority(thread, priority)) {
+        std::system_error error(GetLastError(), std::system_category());
+        DBG("[sfizz] Cannot set render worker thread priority: " << error.what());
+    }
+#else
+    pthread_t thread = pthread_self();
+    int policy;
+    sched_param param;
+
+    if (pthread_getschedparam(thread, &policy, &param) != 0) {
+        DBG("[sfizz] Cannot get render worker thread scheduling parameters");
+        return;
+    }
+
+    policy = SCHED_FIFO;
+    const int minprio = sched_get_priority_min(policy);
+    const int maxprio = sched_get_priority_max(policy);
+    param.sched_priority = minprio + config::renderWorkerPthreadPriority * (maxprio - minprio) / 100;
+
+    if (pthread_setschedparam(thread, policy, &param) != 0) {
+        DBG("[sfizz] Cannot set render worker thread scheduling parameters");
+        return;
+    }
+#endif
+}
+
+} // namespace sfz
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "RTSemaphore.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sfz {
+
+/**
+ * @brief A fixed pool of worker threads, which execute batches of tasks on
+ * behalf of the real-time thread.
+ *
+ * The thread which calls `run` takes part in the processing as the worker 0,
+ * and the pool threads are the workers 1 to N-1. The task indices are split in
+ * contiguous segments, one per worker; a worker which has drained its own
+ * segment steals the remaining tasks of the others. `run` returns after all
+ * the tasks are completed.
+ *
+ * A worker only joins the batch which is open when it wakes up. Once the
+ * calling thread runs out of tasks, it closes the batch and waits on a
+ * semaphore for the tasks which are still running on other workers, if any;
+ * it never waits for a worker which was not scheduled in time.
+ *
+ * Nothing gets allocated nor locked during `run`, waking the workers only
+ * involves posting semaphores.
+ */
+class RTWorkerPool {
+public:
+    /**
+     * @brief Construct a new pool.
+     *
+     * @param numThreads the number of workers, including the calling thread
+     */
+    explicit RTWorkerPool(unsigned numThreads);
+    ~RTWorkerPool();
+
+    RTWorkerPool(const RTWorkerPool&) = delete;
+    RTWorkerPool& operator=(const RTWorkerPool&) = delete;
+
+    /**
+     * @brief Get the number of workers, including the calling thread.
+     */
+    unsigned getNumThreads() const noexcept { return numThreads_; }
+
+    /**
+     * @brief Execute a batch of tasks and wait for their completion.
+     *
+     * @param numTasks the number of tasks
+     * @param function a callable `void(unsigned taskIndex, unsigned workerIndex)`
+     */
+    template <class F>
+    void run(unsigned numTasks, F&& function) noexcept
+    {
+        using Fn = typename std::remove_reference<F>::type;
+        runTasks(numTasks, [](void* context, unsigned taskIndex, unsigned workerIndex) {
+            (*static_cast<Fn*>(context))(taskIndex, workerIndex);
+        }, &function);
+    }
+
+    /**
+     * @brief Get the index of the worker executing the current thread.
+     * This is 0 for any thread which is not a pool thread.
+     */
+    static unsigned currentWorkerIndex() noexcept { return workerIndex_; }
+
+private:
+    using TaskFunction = void (*)(void* context, unsigned taskIndex, unsigned workerIndex);
+    void runTasks(unsigned numTasks, TaskFunction function, void* context) noexcept;
+    void executeTasks(unsigned workerIndex) noexcept;
+    void workerThread(unsigned workerIndex);
+    static void raiseCurrentThreadPriority() noexcept;
+
+    struct Segment {
+        std::atomic<unsigned> next { 0 };
+        unsigned end { 0 };
+        char padding[64 - sizeof(std::atomic<unsigned>) - sizeof(unsigned)];
+    };
+
+    unsigned numThreads_ { 1 };
+    std::unique_ptr<Segment[]> segments_;
+    std::vector<std::unique_ptr<RTSemaphore>> wakeups_;
+    std::vector<std::thread> threads_;
+    // The open flag of the current batch, and the number of workers in it
+    static constexpr unsigned batchOpen = 1u << 31;
+    std::atomic<unsigned> batch_ { 0 };
+    RTSemaphore batchDone_;
+    std::atomic<bool> quit_ { false };
+    TaskFunction function_ { nullptr };
+    void* context_ { nullptr };
+
+    static thread_local unsigned workerIndex_;
+};
+
+} // namespace sfz
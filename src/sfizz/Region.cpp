@@ -573,6 +573,9 @@ bool sfz::Region::parseOpcode(const Opcode& rawOpcode, bool cleanOpcode)
         break;
 
     // Performance parameters: filters
+    case hash("filter_quality"):
+        filterQuality = opcode.readOptional(Default::filterQuality);
+        break;
     case hash("cutoff&"): // also cutoff
         {
             const auto filterIndex = opcode.parameters.empty() ? 0 : (opcode.parameters.back() - 1);
@@ -348,6 +348,7 @@ struct Region {
     // Filters and EQs
     std::vector<EQDescription> equalizers;
     std::vector<FilterDescription> filters;
+    absl::optional<int> filterQuality; // filter_quality, for the filters and EQs
 
     // Performance parameters: pitch
     uint8_t pitchKeycenter { Default::key }; // pitch_keycenter
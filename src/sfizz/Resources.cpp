@@ -14,13 +14,19 @@
 #include "Tuning.h"
 #include "BeatClock.h"
 #include "Metronome.h"
+#include "RTWorkerPool.h"
 #include "modulations/ModMatrix.h"
+#include <absl/memory/memory.h>
+#include <algorithm>
+#include <vector>
 
 namespace sfz {
 
 struct Resources::Impl {
     SynthConfig synthConfig;
     BufferPool bufferPool;
+    std::vector<std::unique_ptr<BufferPool>> workerBufferPools;
+    int samplesPerBlock { config::defaultSamplesPerBlock };
     MidiState midiState;
     CurveSet curves;
     FilePool filePool;
@@ -53,17 +59,23 @@ void Resources::setSampleRate(float samplerate)
 void Resources::setSamplesPerBlock(int samplesPerBlock)
 {
     Impl& impl = *impl_;
+    impl.samplesPerBlock = samplesPerBlock;
     impl.bufferPool.setBufferSize(samplesPerBlock);
+    for (auto& pool : impl.workerBufferPools)
+        pool->setBufferSize(samplesPerBlock);
     impl.midiState.setSamplesPerBlock(samplesPerBlock);
     impl.modMatrix.setSamplesPerBlock(samplesPerBlock);
     impl.beatClock.setSamplesPerBlock(samplesPerBlock);
 }
 
-void Resources::clearNonState()
+void Resources::clearNonState(bool keepPreloadedFiles)
 {
     Impl& impl = *impl_;
     impl.curves = CurveSet::createPredefined();
-    impl.filePool.clear();
+    if (keepPreloadedFiles)
+        impl.filePool.clearChangedFiles();
+    else
+        impl.filePool.clear();
     impl.wavePool.clearFileWaves();
     impl.modMatrix.clear();
     impl.metronome.clear();
@@ -77,6 +89,20 @@ void Resources::clearState()
     impl.beatClock.clear();
 }
 
+void Resources::setNumRenderThreads(int numThreads)
+{
+    Impl& impl = *impl_;
+    const size_t numWorkerPools = static_cast<size_t>(std::max(numThreads, 1) - 1);
+
+    impl.workerBufferPools.resize(numWorkerPools);
+    for (auto& pool : impl.workerBufferPools) {
+        if (!pool) {
+            pool = absl::make_unique<BufferPool>();
+            pool->setBufferSize(impl.samplesPerBlock);
+        }
+    }
+}
+
 const SynthConfig& Resources::getSynthConfig() const noexcept
 {
     return impl_->synthConfig;
@@ -84,6 +110,12 @@ const SynthConfig& Resources::getSynthConfig() const noexcept
 
 const BufferPool& Resources::getBufferPool() const noexcept
 {
+    const unsigned workerIndex = RTWorkerPool::currentWorkerIndex();
+    if (workerIndex > 0) {
+        ASSERT(workerIndex <= impl_->workerBufferPools.size());
+        return *impl_->workerBufferPools[workerIndex - 1];
+    }
+
     return impl_->bufferPool;
 }
 
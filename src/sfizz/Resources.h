@@ -33,14 +33,23 @@ public:
     /**
      * @brief Clear resources that are related to a currently loaded SFZ file
      *
+     * @param keepPreloadedFiles keep the preloaded sample data of the files
+     *                           which did not change on disk, to be reused
+     *                           when reloading the same file
      */
-    void clearNonState();
+    void clearNonState(bool keepPreloadedFiles = false);
     /**
      * @brief Clear resources that are unrelated to the currently loaded SFZ file,
      *        i.e. midi state and beat clock.
      *
      */
     void clearState();
+    /**
+     * @brief Set the number of render workers. Each worker other than the
+     *        first one gets its own buffer pool.
+     *
+     */
+    void setNumRenderThreads(int numThreads);
 
     #define ACCESSOR_RW(Accessor, RetTy) \
         RetTy const& Accessor() const noexcept; \
@@ -9,6 +9,7 @@
 #include "utility/Debug.h"
 #include "simd/HelpersSSE.h"
 #include "simd/HelpersAVX.h"
+#include "simd/HelpersNEON.h"
 #include "cpuid/cpuinfo.hpp"
 #include <array>
 #include <mutex>
@@ -44,6 +45,7 @@ struct SIMDDispatch {
     decltype(&sumSquaresScalar<T>) sumSquares = &sumSquaresScalar<T>;
     decltype(&clampAllScalar<T>) clampAll = &clampAllScalar<T>;
     decltype(&allWithinScalar<T>) allWithin = &allWithinScalar<T>;
+    decltype(&sincInterpolateScalar<T>) sincInterpolate = &sincInterpolateScalar<T>;
 
 private:
     std::array<bool, static_cast<unsigned>(SIMDOps::_sentinel)> simdStatus;
@@ -92,6 +94,7 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
             SIMD_OP(sumSquares)
             SIMD_OP(clampAll)
             SIMD_OP(allWithin)
+            SIMD_OP(sincInterpolate)
         }
 #undef SIMD_OP
     }
@@ -101,6 +104,7 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
     if (info.has_avx()) {
         switch (op) {
             default: break;
+            SIMD_OP(sincInterpolate)
         }
     }
 #undef SIMD_OP
@@ -131,6 +135,7 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
             SIMD_OP(sumSquares)
             SIMD_OP(clampAll)
             SIMD_OP(allWithin)
+            SIMD_OP(sincInterpolate)
         }
     }
 #undef SIMD_OP
@@ -141,6 +146,7 @@ void SIMDDispatch<float>::setStatus(SIMDOps op, bool enable)
     if (info.has_neon()) {
         switch (op) {
             default: break;
+            SIMD_OP(sincInterpolate)
         }
     }
 #undef SIMD_OP
@@ -175,6 +181,7 @@ void SIMDDispatch<float>::resetStatus()
     setStatus(SIMDOps::upsampling, true);
     setStatus(SIMDOps::clampAll, false);
     setStatus(SIMDOps::allWithin, true);
+    setStatus(SIMDOps::sincInterpolate, true);
 }
 
 ///
@@ -341,4 +348,12 @@ bool allWithin<float>(const float* input, float low, float high, unsigned size)
     return simdDispatch<float>().allWithin(input, low, high, size);
 }
 
+void sincInterpolate(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    simdDispatch<float>().sincInterpolate(table, tableSize, points,
+        inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+}
+
 }
@@ -64,6 +64,7 @@ enum class SIMDOps {
     upsampling,
     clampAll,
     allWithin,
+    sincInterpolate,
     _sentinel //
 };
 
@@ -753,4 +754,28 @@ bool allWithin(absl::Span<const T> input, T low, T high) noexcept
     return allWithin<T>(input.data(), low, high, input.size());
 }
 
+/**
+ * @brief Interpolate a block of frames from a tabulated windowed sinc, with
+ * one or two input channels which are read at the same positions.
+ *
+ * The sinc coefficients of each output frame are computed once and shared
+ * across the channels.
+ *
+ * @param table the windowed sinc table, with extra elements past the end
+ * @param tableSize the size of the windowed sinc table
+ * @param points the number of points of the sinc, multiple of 4
+ * @param inputLeft the left input, padded by `points / 2` frames on each side
+ * @param inputRight the right input, or null for a mono input
+ * @param outputLeft the left output
+ * @param outputRight the right output, unused for a mono input
+ * @param indices the integral input positions of the output frames
+ * @param coeffs the fractional input positions of the output frames
+ * @param addingGains if non-null, the gains to mix the interpolated frames
+ *                    into the outputs, instead of replacing them
+ * @param size the number of output frames
+ */
+void sincInterpolate(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept;
+
 } // namespace sfz
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Config.h"
+#include "AudioBuffer.h"
+#include "AudioSpan.h"
+#include "MathHelpers.h"
+#include "utility/Debug.h"
+#include <cmath>
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief Format of the samples kept in memory
+ */
+enum class SampleFormat {
+    //! 32-bit float, as decoded
+    Float,
+    //! 16-bit integer
+    Int16,
+    //! 24-bit integer, packed on 3 bytes
+    Int24,
+};
+
+/**
+ * @brief A packed little-endian 24-bit integer sample
+ */
+struct Int24 {
+    uint8_t bytes[3];
+};
+
+/**
+ * @brief Convert a stored sample to a floating-point value in [-1, 1]
+ */
+template <class R>
+inline R sampleValue(float x) noexcept
+{
+    return static_cast<R>(x);
+}
+
+template <class R>
+inline R sampleValue(double x) noexcept
+{
+    return static_cast<R>(x);
+}
+
+template <class R>
+inline R sampleValue(int16_t x) noexcept
+{
+    return static_cast<R>(x) * static_cast<R>(1.0 / 32768.0);
+}
+
+template <class R>
+inline R sampleValue(Int24 x) noexcept
+{
+    // Put the sample in the high bytes, the arithmetic shift extends the sign
+    const uint32_t u = (uint32_t(x.bytes[0]) << 8) | (uint32_t(x.bytes[1]) << 16) | (uint32_t(x.bytes[2]) << 24);
+    return static_cast<R>(static_cast<int32_t>(u) >> 8) * static_cast<R>(1.0 / 8388608.0);
+}
+
+/**
+ * @brief Convert a floating-point value to a stored sample, rounding to the
+ * nearest and clipping. A value which was converted from an integer sample
+ * of the same width converts back exactly.
+ */
+template <class T>
+T storedSample(float x) noexcept;
+
+template <>
+inline float storedSample<float>(float x) noexcept
+{
+    return x;
+}
+
+template <>
+inline int16_t storedSample<int16_t>(float x) noexcept
+{
+    const float y = clamp(x * 32768.0f, -32768.0f, 32767.0f);
+    return static_cast<int16_t>(std::lround(y));
+}
+
+template <>
+inline Int24 storedSample<Int24>(float x) noexcept
+{
+    const double y = clamp(static_cast<double>(x) * 8388608.0, -8388608.0, 8388607.0);
+    const uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(std::lround(y)));
+    return Int24 { { uint8_t(u), uint8_t(u >> 8), uint8_t(u >> 16) } };
+}
+
+/**
+ * @brief Buffer of file samples, with the padding of the file buffers
+ */
+template <class T>
+using FileSampleBuffer = AudioBuffer<T, 2, config::defaultAlignment,
+                                     config::excessFileFrames, config::excessFileFrames>;
+
+/**
+ * @brief Convert the samples of a float file buffer to another format,
+ * along with its padding.
+ */
+template <class T, class Buffer>
+FileSampleBuffer<T> convertSamples(const Buffer& input)
+{
+    FileSampleBuffer<T> output;
+    const size_t numChannels = input.getNumChannels();
+    const size_t numFrames = input.getNumFrames();
+    output.addChannels(numChannels);
+    output.resize(numFrames);
+    for (size_t c = 0; c < numChannels; ++c) {
+        const float* in = input.channelReader(c) - Buffer::PaddingLeft;
+        T* out = output.channelWriter(c) - FileSampleBuffer<T>::PaddingLeft;
+        const size_t size = numFrames + Buffer::PaddingTotal;
+        for (size_t i = 0; i < size; ++i)
+            out[i] = storedSample<T>(in[i]);
+    }
+    return output;
+}
+
+/**
+ * @brief A view on the frames of a file, in one of the sample formats.
+ */
+class SampleSpan {
+public:
+    SampleSpan() = default;
+    SampleSpan(AudioSpan<const float> span) : format_(SampleFormat::Float), floatSpan_(span) {}
+    SampleSpan(AudioSpan<const int16_t> span) : format_(SampleFormat::Int16), int16Span_(span) {}
+    SampleSpan(AudioSpan<const Int24> span) : format_(SampleFormat::Int24), int24Span_(span) {}
+
+    SampleFormat getFormat() const noexcept { return format_; }
+
+    size_t getNumFrames() const noexcept
+    {
+        switch (format_) {
+        case SampleFormat::Int16: return int16Span_.getNumFrames();
+        case SampleFormat::Int24: return int24Span_.getNumFrames();
+        default: return floatSpan_.getNumFrames();
+        }
+    }
+
+    size_t getNumChannels() const noexcept
+    {
+        switch (format_) {
+        case SampleFormat::Int16: return int16Span_.getNumChannels();
+        case SampleFormat::Int24: return int24Span_.getNumChannels();
+        default: return floatSpan_.getNumChannels();
+        }
+    }
+
+    /**
+     * @brief Get the span, which must be in the format of `T`.
+     */
+    template <class T>
+    const AudioSpan<const T>& getSpan() const noexcept;
+
+private:
+    SampleFormat format_ { SampleFormat::Float };
+    AudioSpan<const float> floatSpan_;
+    AudioSpan<const int16_t> int16Span_;
+    AudioSpan<const Int24> int24Span_;
+};
+
+template <>
+inline const AudioSpan<const float>& SampleSpan::getSpan<float>() const noexcept
+{
+    ASSERT(format_ == SampleFormat::Float);
+    return floatSpan_;
+}
+
+template <>
+inline const AudioSpan<const int16_t>& SampleSpan::getSpan<int16_t>() const noexcept
+{
+    ASSERT(format_ == SampleFormat::Int16);
+    return int16Span_;
+}
+
+template <>
+inline const AudioSpan<const Int24>& SampleSpan::getSpan<Int24>() const noexcept
+{
+    ASSERT(format_ == SampleFormat::Int24);
+    return int24Span_;
+}
+
+} // namespace sfz
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "SampleStore.h"
+#include "utility/Debug.h"
+#include <exception>
+
+namespace sfz {
+
+static std::weak_ptr<SampleStore> globalSampleStoreWeakPtr;
+static std::mutex globalSampleStoreMutex;
+
+std::shared_ptr<SampleStore> SampleStore::getGlobal()
+{
+    std::lock_guard<std::mutex> lock(globalSampleStoreMutex);
+    std::shared_ptr<SampleStore> store = globalSampleStoreWeakPtr.lock();
+    if (store)
+        return store;
+
+    store.reset(new SampleStore);
+    globalSampleStoreWeakPtr = store;
+    return store;
+}
+
+SampleStore::Key SampleStore::makeKey(const fs::path& path, bool reverse, const FileInformation& information)
+{
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    if (ec)
+        absolute = path;
+
+    Key key;
+    key.fileId = FileId(absolute.lexically_normal().string(), reverse);
+    key.fileSize = information.fileSize;
+    key.modificationTime = information.modificationTime;
+    return key;
+}
+
+PreloadedFramesPtr SampleStore::find(const Key& key, SampleFormat format, size_t numFrames) noexcept
+{
+    try {
+        return findEntry(key, format, numFrames);
+    }
+    catch (std::exception& error) {
+        DBG("[sfizz] Cannot look up the shared frames of " << key.fileId.filename() << ": " << error.what());
+        return {};
+    }
+}
+
+PreloadedFramesPtr SampleStore::findEntry(const Key& key, SampleFormat format, size_t numFrames)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(EntryKey { key, format });
+    if (it == entries_.end())
+        return {};
+
+    PreloadedFramesPtr frames = it->second.lock();
+    if (!frames) {
+        entries_.erase(it);
+        return {};
+    }
+
+    if (frames->getNumFrames() < numFrames)
+        return {};
+
+    return frames;
+}
+
+PreloadedFramesPtr SampleStore::insert(const Key& key, SampleFormat format, PreloadedFramesPtr frames) noexcept
+{
+    try {
+        return insertEntry(key, format, frames);
+    }
+    catch (std::exception& error) {
+        DBG("[sfizz] Cannot share the frames of " << key.fileId.filename() << ": " << error.what());
+        return frames;
+    }
+}
+
+PreloadedFramesPtr SampleStore::insertEntry(const Key& key, SampleFormat format, const PreloadedFramesPtr& frames)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::weak_ptr<PreloadedFrames>& entry = entries_[EntryKey { key, format }];
+    if (PreloadedFramesPtr existing = entry.lock()) {
+        if (existing->getNumFrames() >= frames->getNumFrames())
+            return existing;
+    }
+    entry = frames;
+
+    // Forget the samples which no pool uses anymore, once in a while
+    if (entries_.size() >= pruneThreshold_) {
+        for (auto it = entries_.begin(), end = entries_.end(); it != end; ) {
+            auto copyIt = it++;
+            if (copyIt->second.expired())
+                entries_.erase(copyIt);
+        }
+        pruneThreshold_ = 2 * entries_.size() + 64;
+    }
+
+    return frames;
+}
+
+size_t SampleStore::getNumSamples() noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t numSamples = 0;
+    for (const auto& entry : entries_)
+        numSamples += entry.second.expired() ? 0 : 1;
+    return numSamples;
+}
+
+} // namespace sfz
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "FilePool.h"
+#include "FileId.h"
+#include "SampleFormat.h"
+#include "utility/LeakDetector.h"
+#include "ghc/fs_std.hpp"
+#include <absl/container/flat_hash_map.h>
+#include <memory>
+#include <mutex>
+
+namespace sfz {
+
+/**
+ * @brief A store of preloaded frames shared by the file pools of a process,
+ * so that the instances which load the same samples hold a single copy of
+ * their frames.
+ *
+ * The entries are keyed by the absolute path of the sample, its direction, its
+ * size and modification time, and the sample format, so that the pools which
+ * read a file before and after it changed on disk do not share their frames.
+ * The store only keeps weak references: the frames belong to the pools which
+ * use them, and are freed along with the last of them.
+ * The pools still manage the rest of the file data, such as the files loaded
+ * whole while playing, on their own.
+ */
+class SampleStore {
+public:
+    /**
+     * @brief The key of a sample file in the store.
+     */
+    struct Key {
+        FileId fileId;
+        uint64_t fileSize { 0 };
+        int64_t modificationTime { 0 };
+
+        bool operator==(const Key& other) const noexcept
+        {
+            return fileSize == other.fileSize && modificationTime == other.modificationTime
+                && fileId == other.fileId;
+        }
+    };
+
+    /**
+     * @brief Get the store of the process, which is created if no pool uses
+     * it yet.
+     */
+    static std::shared_ptr<SampleStore> getGlobal();
+
+    /**
+     * @brief Get the key of a sample file in the store.
+     *
+     * @param path the path of the sample file
+     * @param reverse whether the sample is read backwards
+     * @param information the information of the file, with the size and
+     *                    modification time it had when read
+     */
+    static Key makeKey(const fs::path& path, bool reverse, const FileInformation& information);
+
+    /**
+     * @brief Find the frames of a sample, if a pool holds at least a given
+     * number of them in a format.
+     *
+     * @param key
+     * @param format
+     * @param numFrames the minimum number of frames
+     * @return the frames, or null if none are held or the lookup failed
+     */
+    PreloadedFramesPtr find(const Key& key, SampleFormat format, size_t numFrames) noexcept;
+
+    /**
+     * @brief Share frames which were just read. If a pool has shared at least
+     * as many frames of the sample in the meantime, they are returned instead.
+     * If the store cannot make room for the entry, the frames are returned
+     * without being shared.
+     *
+     * @param key
+     * @param format
+     * @param frames
+     * @return the frames to use
+     */
+    PreloadedFramesPtr insert(const Key& key, SampleFormat format, PreloadedFramesPtr frames) noexcept;
+
+    /**
+     * @brief Get the number of samples whose frames are held by some pool.
+     */
+    size_t getNumSamples() noexcept;
+
+private:
+    struct EntryKey {
+        Key key;
+        SampleFormat format;
+
+        bool operator==(const EntryKey& other) const noexcept
+        {
+            return format == other.format && key == other.key;
+        }
+
+        template <class H>
+        friend H AbslHashValue(H h, const EntryKey& entryKey)
+        {
+            return H::combine(std::move(h), std::hash<FileId>()(entryKey.key.fileId),
+                entryKey.key.fileSize, entryKey.key.modificationTime, static_cast<int>(entryKey.format));
+        }
+    };
+
+    PreloadedFramesPtr findEntry(const Key& key, SampleFormat format, size_t numFrames);
+    PreloadedFramesPtr insertEntry(const Key& key, SampleFormat format, const PreloadedFramesPtr& frames);
+
+    std::mutex mutex_;
+    absl::flat_hash_map<EntryKey, std::weak_ptr<PreloadedFrames>> entries_;
+    size_t pruneThreshold_ { 64 };
+    LEAK_DETECTOR(SampleStore);
+};
+
+} // namespace sfz
@@ -7,6 +7,7 @@
 #include "Config.h"
 #include "SfzFilter.h"
 #include "SfzFilterImpls.hpp"
+#include "FilterBank.h"
 #include "SIMDHelpers.h"
 #include "utility/StringViewHelpers.h"
 #include "utility/Debug.h"
@@ -14,6 +15,40 @@
 
 namespace sfz {
 
+/**
+   Process the channels of a biquad filter, which share their coefficients.
+   This is the computation of the filter bank on a single filter, so the
+   state of the filter evolves the same way whichever processes it.
+ */
+template <unsigned N>
+static void processBiquadChannels(BiquadState* states, double pole, const BiquadCoefficients& coefs, const float *const in[], float *const out[], unsigned offset, unsigned nframes)
+{
+    BiquadLanes<N> lanes;
+    BiquadTargets<N> targets;
+
+    for (unsigned c = 0; c < N; ++c) {
+        lanes.load(c, states[c]);
+        targets.set(c, coefs, 1.0 - pole);
+    }
+
+    const unsigned interval = config::filterControlInterval;
+    for (unsigned frame = 0; frame < nframes; frame += interval) {
+        const unsigned current = std::min(nframes - frame, interval);
+        processBiquadLanes(lanes, targets, pole, in, out, offset + frame, current);
+    }
+
+    for (unsigned c = 0; c < N; ++c)
+        lanes.store(c, states[c]);
+}
+
+static void processBiquadChannels(unsigned channels, BiquadState* states, double pole, const BiquadCoefficients& coefs, const float *const in[], float *const out[], unsigned offset, unsigned nframes)
+{
+    if (channels == 2)
+        processBiquadChannels<2>(states, pole, coefs, in, out, offset, nframes);
+    else
+        processBiquadChannels<1>(states, pole, coefs, in, out, offset, nframes);
+}
+
 //------------------------------------------------------------------------------
 // SFZ v2 multi-mode filter
 
@@ -23,6 +58,26 @@ struct Filter::Impl {
     unsigned fChannels = 1;
     enum { maxChannels = 2 };
 
+    // The biquad types run on these rather than on their Faust DSP
+    BiquadState fBiquads[maxChannels];
+    double fBiquadPole = biquadSmoothingPole(sfz::config::defaultSampleRate);
+
+    void clearBiquads()
+    {
+        for (BiquadState& state : fBiquads)
+            state.clear();
+    }
+
+    // The coefficients are tabulated below quality 1
+    int fQuality = 1;
+
+    bool biquadCoefficients(float cutoff, float q, float pksh, BiquadCoefficients& coefs) const
+    {
+        if (fQuality < 1)
+            return computeBiquadTabulated(fType, fSampleRate, cutoff, q, pksh, coefs);
+        return computeBiquad(fType, fSampleRate, cutoff, q, pksh, coefs);
+    }
+
     union U {
         U() {}
         ~U() {}
@@ -64,6 +119,7 @@ void Filter::init(double sampleRate)
         dsp->init(sampleRate);
 
     P->fSampleRate = sampleRate;
+    P->fBiquadPole = biquadSmoothingPole(sampleRate);
 }
 
 void Filter::clear()
@@ -72,6 +128,8 @@ void Filter::clear()
 
     if (dsp)
         dsp->instanceClear();
+
+    P->clearBiquads();
 }
 
 void Filter::prepare(float cutoff, float q, float pksh)
@@ -81,6 +139,13 @@ void Filter::prepare(float cutoff, float q, float pksh)
     if (!dsp)
         return;
 
+    BiquadCoefficients coefs;
+    if (P->biquadCoefficients(cutoff, q, pksh, coefs)) {
+        for (BiquadState& state : P->fBiquads)
+            state.prepare(coefs);
+        return;
+    }
+
     // compute a dummy 1-frame cycle with smoothing off
 
     float buffer[Impl::maxChannels] = {0};
@@ -108,6 +173,12 @@ void Filter::process(const float *const in[], float *const out[], float cutoff,
         return;
     }
 
+    BiquadCoefficients coefs;
+    if (P->biquadCoefficients(cutoff, q, pksh, coefs)) {
+        processBiquadChannels(channels, P->fBiquads, P->fBiquadPole, coefs, in, out, 0, nframes);
+        return;
+    }
+
     dsp->configureStandard(cutoff, q, pksh);
     dsp->compute(nframes, const_cast<float **>(in), const_cast<float **>(out));
 }
@@ -130,6 +201,13 @@ void Filter::processModulated(const float *const in[], float *const out[], const
         if (current > config::filterControlInterval)
             current = config::filterControlInterval;
 
+        BiquadCoefficients coefs;
+        if (P->biquadCoefficients(cutoff[frame], q[frame], pksh[frame], coefs)) {
+            processBiquadChannels(channels, P->fBiquads, P->fBiquadPole, coefs, in, out, frame, current);
+            frame += current;
+            continue;
+        }
+
         const float *current_in[Impl::maxChannels];
         float *current_out[Impl::maxChannels];
 
@@ -159,6 +237,7 @@ void Filter::setChannels(unsigned channels)
             dsp->~sfzFilterDsp();
 
         P->fChannels = channels;
+        P->clearBiquads();
 
         dsp = P->newDsp(channels, P->fType);
         if (dsp)
@@ -179,6 +258,7 @@ void Filter::setType(FilterType type)
             dsp->~sfzFilterDsp();
 
         P->fType = type;
+        P->clearBiquads();
 
         dsp = P->newDsp(P->fChannels, type);
         if (dsp)
@@ -186,6 +266,29 @@ void Filter::setType(FilterType type)
     }
 }
 
+int Filter::quality() const
+{
+    return P->fQuality;
+}
+
+void Filter::setQuality(int quality)
+{
+    P->fQuality = quality;
+}
+
+BiquadState* Filter::biquadState(unsigned channel)
+{
+    if (!isBiquadType(P->fType) || channel >= P->fChannels)
+        return nullptr;
+
+    return &P->fBiquads[channel];
+}
+
+bool Filter::biquadCoefficients(float cutoff, float q, float pksh, BiquadCoefficients& coefs) const
+{
+    return P->biquadCoefficients(cutoff, q, pksh, coefs);
+}
+
 sfzFilterDsp *Filter::Impl::getDsp(unsigned channels, FilterType type)
 {
     switch (idDsp(channels, type)) {
@@ -221,6 +324,26 @@ struct FilterEq::Impl {
     unsigned fChannels = 1;
     enum { maxChannels = 2 };
 
+    // The biquad types run on these rather than on their Faust DSP
+    BiquadState fBiquads[maxChannels];
+    double fBiquadPole = biquadSmoothingPole(sfz::config::defaultSampleRate);
+
+    void clearBiquads()
+    {
+        for (BiquadState& state : fBiquads)
+            state.clear();
+    }
+
+    // The coefficients are tabulated below quality 1
+    int fQuality = 1;
+
+    bool biquadCoefficients(float cutoff, float bw, float pksh, BiquadCoefficients& coefs) const
+    {
+        if (fQuality < 1)
+            return computeBiquadTabulated(fType, fSampleRate, cutoff, bw, pksh, coefs);
+        return computeBiquad(fType, fSampleRate, cutoff, bw, pksh, coefs);
+    }
+
     union U {
         U() {}
         ~U() {}
@@ -262,6 +385,7 @@ void FilterEq::init(double sampleRate)
         dsp->init(sampleRate);
 
     P->fSampleRate = sampleRate;
+    P->fBiquadPole = biquadSmoothingPole(sampleRate);
 }
 
 void FilterEq::clear()
@@ -270,6 +394,8 @@ void FilterEq::clear()
 
     if (dsp)
         dsp->instanceClear();
+
+    P->clearBiquads();
 }
 
 void FilterEq::prepare(float cutoff, float bw, float pksh)
@@ -279,6 +405,13 @@ void FilterEq::prepare(float cutoff, float bw, float pksh)
     if (!dsp)
         return;
 
+    BiquadCoefficients coefs;
+    if (P->biquadCoefficients(cutoff, bw, pksh, coefs)) {
+        for (BiquadState& state : P->fBiquads)
+            state.prepare(coefs);
+        return;
+    }
+
     // compute a dummy 1-frame cycle with smoothing off
 
     float buffer[Impl::maxChannels] = {0};
@@ -306,6 +439,12 @@ void FilterEq::process(const float *const in[], float *const out[], float cutoff
         return;
     }
 
+    BiquadCoefficients coefs;
+    if (P->biquadCoefficients(cutoff, bw, pksh, coefs)) {
+        processBiquadChannels(channels, P->fBiquads, P->fBiquadPole, coefs, in, out, 0, nframes);
+        return;
+    }
+
     dsp->configureEq(cutoff, bw, pksh);
     dsp->compute(nframes, const_cast<float **>(in), const_cast<float **>(out));
 }
@@ -328,6 +467,13 @@ void FilterEq::processModulated(const float *const in[], float *const out[], con
         if (current > config::filterControlInterval)
             current = config::filterControlInterval;
 
+        BiquadCoefficients coefs;
+        if (P->biquadCoefficients(cutoff[frame], bw[frame], pksh[frame], coefs)) {
+            processBiquadChannels(channels, P->fBiquads, P->fBiquadPole, coefs, in, out, frame, current);
+            frame += current;
+            continue;
+        }
+
         const float *current_in[Impl::maxChannels];
         float *current_out[Impl::maxChannels];
 
@@ -358,6 +504,7 @@ void FilterEq::setChannels(unsigned channels)
             dsp->~sfzFilterDsp();
 
         P->fChannels = channels;
+        P->clearBiquads();
 
         dsp = P->newDsp(channels, P->fType);
         if (dsp)
@@ -378,6 +525,7 @@ void FilterEq::setType(EqType type)
             dsp->~sfzFilterDsp();
 
         P->fType = type;
+        P->clearBiquads();
 
         dsp = P->newDsp(P->fChannels, type);
         if (dsp)
@@ -385,6 +533,29 @@ void FilterEq::setType(EqType type)
     }
 }
 
+int FilterEq::quality() const
+{
+    return P->fQuality;
+}
+
+void FilterEq::setQuality(int quality)
+{
+    P->fQuality = quality;
+}
+
+BiquadState* FilterEq::biquadState(unsigned channel)
+{
+    if (!isBiquadType(P->fType) || channel >= P->fChannels)
+        return nullptr;
+
+    return &P->fBiquads[channel];
+}
+
+bool FilterEq::biquadCoefficients(float cutoff, float bw, float pksh, BiquadCoefficients& coefs) const
+{
+    return P->biquadCoefficients(cutoff, bw, pksh, coefs);
+}
+
 sfzFilterDsp *FilterEq::Impl::getDsp(unsigned channels, EqType type)
 {
     switch (idDsp(channels, type)) {
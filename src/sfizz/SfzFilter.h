@@ -12,6 +12,8 @@
 namespace sfz {
 
 enum FilterType : int;
+struct BiquadState;
+struct BiquadCoefficients;
 
 /**
    Multi-mode filter for SFZ v2
@@ -84,6 +86,32 @@ public:
      */
     void setType(FilterType type);
 
+    /**
+       Get the quality of the coefficients. (cf. `filter_quality`)
+     */
+    int quality() const;
+
+    /**
+       Set the quality of the coefficients. (cf. `filter_quality`)
+       Below 1, the biquad types interpolate their coefficients from tables
+       rather than computing them exactly. The other types are not affected.
+     */
+    void setQuality(int quality);
+
+    /**
+       Get the state of a channel, if the type of filter is a biquad which a
+       `FilterBank` can process, or null otherwise.
+     */
+    BiquadState* biquadState(unsigned channel);
+
+    /**
+       Compute the target coefficients of a biquad type for some parameters.
+       `cutoff` is a frequency expressed in Hz.
+       `q` is a resonance expressed in dB.
+       `pksh` is a peak/shelf gain expressed in dB.
+     */
+    bool biquadCoefficients(float cutoff, float q, float pksh, BiquadCoefficients& coefs) const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> P;
@@ -189,6 +217,32 @@ public:
      */
     void setType(EqType type);
 
+    /**
+       Get the quality of the coefficients. (cf. `filter_quality`)
+     */
+    int quality() const;
+
+    /**
+       Set the quality of the coefficients. (cf. `filter_quality`)
+       Below 1, the biquad types interpolate their coefficients from tables
+       rather than computing them exactly. The other types are not affected.
+     */
+    void setQuality(int quality);
+
+    /**
+       Get the state of a channel, if the type of filter is a biquad which a
+       `FilterBank` can process, or null otherwise.
+     */
+    BiquadState* biquadState(unsigned channel);
+
+    /**
+       Compute the target coefficients of a biquad type for some parameters.
+       `cutoff` is a frequency expressed in Hz.
+       `bw` is a bandwidth expressed in octaves.
+       `pksh` is a peak/shelf gain expressed in dB.
+     */
+    bool biquadCoefficients(float cutoff, float bw, float pksh, BiquadCoefficients& coefs) const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> P;
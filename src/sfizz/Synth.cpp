@@ -25,6 +25,11 @@
 #include "Metronome.h"
 #include "SynthConfig.h"
 #include "ScopedFTZ.h"
+#include "RTChecks.h"
+#include "RTWorkerPool.h"
+#include "RTSemaphore.h"
+#include "EventQueue.h"
+#include "LatencyMonitor.h"
 #include "utility/Base64.h"
 #include "utility/StringViewHelpers.h"
 #include "utility/Timing.h"
@@ -32,6 +37,7 @@
 #include "Voice.h"
 #include "Interpolators.h"
 #include "parser/Parser.h"
+#include <atomic_queue/atomic_queue.h>
 #include <absl/algorithm/container.h>
 #include <absl/memory/memory.h>
 #include <absl/strings/str_cat.h>
@@ -39,9 +45,13 @@
 #include <absl/types/optional.h>
 #include <absl/types/span.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <iostream>
+#include <mutex>
 #include <random>
+#include <thread>
 #include <utility>
 
 namespace sfz {
@@ -49,9 +59,182 @@ namespace sfz {
 // unless set to permissive, the loader rejects sfz files with errors
 static constexpr bool loaderParsesPermissively = true;
 
+// the controllers connected by default, unless the regions use them
+struct DefaultControllerConnection {
+    uint16_t cc;
+    uint8_t curve;
+    ModId target;
+};
+static constexpr std::array<DefaultControllerConnection, 3> defaultControllerConnections {{
+    { 7, 4, ModId::Amplitude },
+    { 10, 1, ModId::Pan },
+    { 11, 4, ModId::Amplitude },
+}};
+static constexpr uint16_t defaultControllerSmoothness = 10;
+
+/**
+ * @brief A synth state loaded off the audio thread, along with the MIDI state
+ * it was loaded with. Once adopted, it carries the previous state to the
+ * retirement thread.
+ */
+struct Synth::StagedState {
+    std::unique_ptr<Impl> impl;
+    std::array<float, config::numCCs> ccValues;
+    float pitchBend { 0.0f };
+    float channelAftertouch { 0.0f };
+    int program { 0 };
+    // The generation of the settings it was staged with
+    uint64_t settingsGeneration { 0 };
+    bool sustainCancelsRelease { Default::sustainCancelsRelease };
+};
+
+/**
+ * @brief Hands the staged states over to the audio thread, and destroys the
+ * retired ones on a background thread.
+ */
+struct Synth::StateExchange {
+    ~StateExchange();
+    void startRetirementThread();
+    void retirementThread();
+    void storeSettings(const Impl& impl) noexcept;
+    void applySettings(Impl& impl) const noexcept;
+    void publishMidiState(const MidiState& midiState) noexcept;
+
+    std::atomic<StagedState*> pending { nullptr };
+    atomic_queue::AtomicQueue<StagedState*, config::maxRetiredStates> retired;
+    // The state in use, and the number of stagings reading it; a retired state
+    // is only destroyed once no staging reads it
+    std::atomic<Impl*> current { nullptr };
+    std::atomic<unsigned> numReaders { 0 };
+    RTSemaphore retirementSemaphore;
+    std::atomic<bool> quit { false };
+    std::thread thread;
+
+    // The settings of the current state, which the states get staged with.
+    // The setters change them under the mutex, along with the pending state,
+    // and bump the generation so that the stagings in flight catch up.
+    std::mutex settingsMutex;
+    float sampleRate { config::defaultSampleRate };
+    int samplesPerBlock { config::defaultSamplesPerBlock };
+    int numVoices { config::numVoices };
+    bool sustainCancelsRelease { Default::sustainCancelsRelease };
+    std::shared_ptr<RTWorkerPool> renderWorkers;
+    uint64_t settingsGeneration { 0 };
+    // Bumped whenever the pending state is replaced or changed
+    std::atomic<uint64_t> pendingVersion { 0 };
+
+    // The gain of the current state, which fades out before a staged state
+    // replaces it, and the version of a pending state which could not be
+    // adopted after a fade out; these are for the audio thread only
+    float fadeGain { 1.0f };
+    uint64_t unadoptableVersion { 0 };
+
+    // The MIDI state published by the audio thread at the end of each block;
+    // the staging reads it rather than the MIDI state which it writes to
+    std::array<std::atomic<float>, config::numCCs> ccValues;
+    std::atomic<float> pitchBend { 0.0f };
+    std::atomic<float> channelAftertouch { 0.0f };
+    std::atomic<int> program { 0 };
+};
+
+Synth::StateExchange::~StateExchange()
+{
+    if (thread.joinable()) {
+        quit.store(true);
+        retirementSemaphore.post();
+        thread.join();
+    }
+
+    StagedState* state;
+    while (retired.try_pop(state))
+        delete state;
+    delete pending.exchange(nullptr);
+}
+
+void Synth::StateExchange::startRetirementThread()
+{
+    if (!thread.joinable())
+        thread = std::thread(&StateExchange::retirementThread, this);
+}
+
+void Synth::StateExchange::retirementThread()
+{
+    for (bool running = true; running;) {
+        std::error_code ec;
+        retirementSemaphore.wait(ec);
+        if (ec)
+            continue;
+        running = !quit.load();
+
+        StagedState* state;
+        while (retired.try_pop(state)) {
+            while (numReaders.load() > 0)
+                std::this_thread::yield();
+            delete state;
+        }
+    }
+}
+
+void Synth::StateExchange::storeSettings(const Impl& impl) noexcept
+{
+    sampleRate = impl.sampleRate_;
+    samplesPerBlock = impl.samplesPerBlock_;
+    numVoices = impl.numVoices_;
+    sustainCancelsRelease = impl.resources_.getSynthConfig().sustainCancelsRelease;
+    renderWorkers = impl.renderWorkers_;
+    ++settingsGeneration;
+}
+
+void Synth::StateExchange::applySettings(Impl& impl) const noexcept
+{
+    if (impl.sampleRate_ != sampleRate)
+        impl.setSampleRate(sampleRate);
+    if (impl.samplesPerBlock_ != samplesPerBlock)
+        impl.setSamplesPerBlock(samplesPerBlock);
+    if (impl.numVoices_ != numVoices)
+        impl.resetVoices(numVoices);
+    if (impl.renderWorkers_ != renderWorkers)
+        impl.setRenderWorkers(renderWorkers);
+}
+
+void Synth::StateExchange::publishMidiState(const MidiState& midiState) noexcept
+{
+    for (int cc = 0; cc < config::numCCs; ++cc)
+        ccValues[cc].store(midiState.getCCValue(cc), std::memory_order_relaxed);
+    pitchBend.store(midiState.getPitchBend(), std::memory_order_relaxed);
+    channelAftertouch.store(midiState.getChannelAftertouch(), std::memory_order_relaxed);
+    program.store(midiState.getProgram(), std::memory_order_relaxed);
+}
+
+template <class Setter>
+void Synth::changeSetting(const Setter& setter)
+{
+    StateExchange& exchange = *stateExchange_;
+    std::lock_guard<std::mutex> lock { exchange.settingsMutex };
+
+    // Hold the staged state back while the setting changes, so that the
+    // audio thread does not adopt it with the former one
+    StagedState* state = exchange.pending.exchange(nullptr, std::memory_order_acq_rel);
+    setter(*impl_);
+    if (state)
+        setter(*state->impl);
+    exchange.storeSettings(*impl_);
+    exchange.pending.store(state, std::memory_order_release);
+    if (state)
+        exchange.pendingVersion.fetch_add(1, std::memory_order_release);
+}
+
 Synth::Synth()
 : impl_(new Impl) // NOLINT: (paul) I don't get why clang-tidy complains here
+, stateExchange_(new StateExchange)
+, eventQueue_(new EventQueue(config::eventQueueCapacity))
+, latencyMonitor_(new LatencyMonitor)
+, profiler_(new Profiler)
 {
+    impl_->profiler_ = profiler_.get();
+    stateExchange_->current.store(impl_.get());
+    stateExchange_->storeSettings(*impl_);
+    stateExchange_->publishMidiState(impl_->resources_.getMidiState());
 }
 
 // Need to define the dtor after Impl has been defined
@@ -80,6 +263,8 @@ Synth::Impl::Impl()
     genADSREnvelope_.reset(new ADSREnvelopeSource(voiceManager_));
     genChannelAftertouch_.reset(new ChannelAftertouchSource(voiceManager_, midiState));
     genPolyAftertouch_.reset(new PolyAftertouchSource(voiceManager_, midiState));
+
+    updateFilterBank();
 }
 
 Synth::Impl::~Impl()
@@ -156,6 +341,15 @@ void Synth::Impl::onParseWarning(const SourceRange& range, const std::string& me
 void Synth::Impl::buildRegion(const std::vector<Opcode>& regionOpcodes)
 {
     int regionNumber = static_cast<int>(layers_.size());
+    const uint64_t signature = computeLayerSignature(regionOpcodes);
+    layerSignatures_.push_back({ signature, 0 });
+
+    if (Layer* reusedLayer = reuseLayer(regionNumber, signature, regionOpcodes)) {
+        layers_.emplace_back(reusedLayer);
+        registerRegion(*reusedLayer);
+        return;
+    }
+
     MidiState& midiState = resources_.getMidiState();
     Layer* lastLayer = new Layer(regionNumber, defaultPath_, midiState);
     layers_.emplace_back(lastLayer);
@@ -192,6 +386,14 @@ void Synth::Impl::buildRegion(const std::vector<Opcode>& regionOpcodes)
     if (octaveOffset_ != 0 || noteOffset_ != 0)
         lastRegion->offsetAllKeys(octaveOffset_ * 12 + noteOffset_);
 
+    registerRegion(*lastLayer);
+}
+
+void Synth::Impl::registerRegion(Layer& layer)
+{
+    Layer* lastLayer = &layer;
+    Region* lastRegion = &layer.getRegion();
+
     if (lastRegion->lastKeyswitch)
         lastKeyswitchLists_[*lastRegion->lastKeyswitch].push_back(lastLayer);
 
@@ -238,6 +440,82 @@ void Synth::Impl::buildRegion(const std::vector<Opcode>& regionOpcodes)
     lastLayer->initializeActivations();
 }
 
+uint64_t Synth::Impl::computeLayerSignature(const std::vector<Opcode>& regionOpcodes) const noexcept
+{
+    uint64_t signature = hash(defaultPath_);
+    signature = hashNumber(octaveOffset_ * 12 + noteOffset_, signature);
+
+    auto hashOpcodes = [&signature](const std::vector<Opcode>& opcodes) {
+        signature = hashNumber(opcodes.size(), signature);
+        for (const Opcode& opcode : opcodes) {
+            signature = hash(opcode.name, signature);
+            signature = hashByte('=', signature);
+            signature = hash(opcode.value, signature);
+            signature = hashByte('\n', signature);
+        }
+    };
+
+    hashOpcodes(globalOpcodes_);
+    hashOpcodes(masterOpcodes_);
+    hashOpcodes(groupOpcodes_);
+    hashOpcodes(regionOpcodes);
+    return signature;
+}
+
+Layer* Synth::Impl::reuseLayer(int regionNumber, uint64_t signature, const std::vector<Opcode>& regionOpcodes)
+{
+    const size_t index = static_cast<size_t>(regionNumber);
+    if (index >= reusableLayers_.size() || !reusableLayers_[index]
+        || previousSignatures_[index].opcodes != signature)
+        return nullptr;
+
+    // The sample checks are skipped for the reused regions, so their files
+    // must not have changed on disk in the meantime
+    const Region& previousRegion = reusableLayers_[index]->getRegion();
+    if (!previousRegion.isGenerator() && !resources_.getFilePool().holdsFile(*previousRegion.sampleId))
+        return nullptr;
+
+    Layer* layer = reusableLayers_[index].release();
+    Region& region = layer->getRegion();
+    region.parent = nullptr;
+    layer->delayedSustainReleases_.clear();
+    layer->delayedSostenutoReleases_.clear();
+
+    // The default controllers get connected again if still unused
+    const uint8_t defaultConnections = previousSignatures_[index].defaultConnections;
+    for (size_t i = 0; i < defaultControllerConnections.size(); ++i) {
+        if (defaultConnections & (1u << i)) {
+            const DefaultControllerConnection& connection = defaultControllerConnections[i];
+            const ModKey source = ModKey::createCC(connection.cc, connection.curve, defaultControllerSmoothness, 0);
+            const ModKey target = ModKey::createNXYZ(connection.target, region.id);
+            region.connections.erase(
+                std::remove_if(region.connections.begin(), region.connections.end(),
+                    [&](const Region::Connection& c) { return c.source == source && c.target == target; }),
+                region.connections.end());
+        }
+    }
+
+    // Report the unknown opcodes as parsing the region would
+    auto reportUnknownOpcodes = [this](const std::vector<Opcode>& opcodes) {
+        if (previousUnknownOpcodes_.empty())
+            return;
+        for (const Opcode& opcode : opcodes) {
+            const auto matches = [&](absl::string_view sv) { return sv.compare(opcode.name) == 0; };
+            if (absl::c_find_if(previousUnknownOpcodes_, matches) != previousUnknownOpcodes_.end()
+                && absl::c_find_if(unknownOpcodes_, matches) == unknownOpcodes_.end())
+                unknownOpcodes_.emplace_back(opcode.name);
+        }
+    };
+
+    reportUnknownOpcodes(globalOpcodes_);
+    reportUnknownOpcodes(masterOpcodes_);
+    reportUnknownOpcodes(groupOpcodes_);
+    reportUnknownOpcodes(regionOpcodes);
+
+    reusedLayers_.insert(layer);
+    return layer;
+}
+
 void Synth::Impl::addEffectBusesIfNecessary(uint16_t output)
 {
     while (effectBuses_.size() <= output) {
@@ -268,6 +546,7 @@ void Synth::Impl::clear()
     filePool.waitForBackgroundLoading();
 
     voiceManager_.reset();
+    activationIndex_.clear();
     for (auto& list : lastKeyswitchLists_)
         list.clear();
     for (auto& list : downKeyswitchLists_)
@@ -283,7 +562,7 @@ void Synth::Impl::clear()
     currentSet_ = nullptr;
     sets_.clear();
     layers_.clear();
-    resources_.clearNonState();
+    resources_.clearNonState(reloading);
     rootPath_.clear();
     numGroups_ = 0;
     numMasters_ = 0;
@@ -549,6 +828,7 @@ void Synth::Impl::handleEffectOpcodes(const std::vector<Opcode>& rawMembers)
     auto fx = effectFactory_.makeEffect(members);
     fx->setSampleRate(sampleRate_);
     fx->setSamplesPerBlock(samplesPerBlock_);
+    fx->setFreewheeling(resources_.getSynthConfig().freeWheeling);
     getOrCreateBus(busIndex).addEffect(std::move(fx));
 }
 
@@ -610,6 +890,24 @@ void Synth::Impl::prepareSfzLoad(const fs::path& path)
     auto newPath_ = path.string();
     reloading = (lastPath_ == newPath_);
 
+    // Keep the current layers aside, the ones whose opcodes did not change
+    // are reused instead of being built again
+    reusableLayers_.clear();
+    previousSignatures_.clear();
+    previousUnknownOpcodes_.clear();
+    reusedLayers_.clear();
+    if (reloading) {
+        for (LayerPtr& layer : layers_) {
+            const size_t number = static_cast<size_t>(layer->getRegion().getId().number());
+            if (reusableLayers_.size() <= number)
+                reusableLayers_.resize(number + 1);
+            reusableLayers_[number] = std::move(layer);
+        }
+        previousSignatures_ = std::move(layerSignatures_);
+        previousUnknownOpcodes_ = unknownOpcodes_;
+    }
+    layerSignatures_.clear();
+
     clear();
 
 #ifndef NDEBUG
@@ -659,6 +957,7 @@ bool Synth::loadSfzFile(const fs::path& file)
     }
 
     impl.finalizeSfzLoad();
+    stateExchange_->publishMidiState(impl.resources_.getMidiState());
     return true;
 }
 
@@ -686,6 +985,257 @@ bool Synth::loadSfzString(const fs::path& path, absl::string_view text)
     }
 
     impl.finalizeSfzLoad();
+    stateExchange_->publishMidiState(impl.resources_.getMidiState());
+    return true;
+}
+
+bool Synth::stageSfzFile(const fs::path& file)
+{
+    Synth staging;
+    std::unique_ptr<StagedState> state { new StagedState };
+    prepareStagingSynth(staging, *state);
+
+    if (!staging.loadSfzFile(file))
+        return false;
+
+    state->impl = std::move(staging.impl_);
+    publishStagedState(std::move(state));
+    return true;
+}
+
+bool Synth::stageSfzString(const fs::path& path, absl::string_view text)
+{
+    Synth staging;
+    std::unique_ptr<StagedState> state { new StagedState };
+    prepareStagingSynth(staging, *state);
+
+    if (!staging.loadSfzString(path, text))
+        return false;
+
+    state->impl = std::move(staging.impl_);
+    publishStagedState(std::move(state));
+    return true;
+}
+
+bool Synth::hasStagedState() const noexcept
+{
+    return stateExchange_->pending.load() != nullptr;
+}
+
+void Synth::prepareStagingSynth(Synth& staging, StagedState& state) const
+{
+    // The audio thread may retire the current state while it gets read here
+    StateExchange& exchange = *stateExchange_;
+    exchange.numReaders.fetch_add(1);
+    const Impl& impl = *exchange.current.load();
+    Impl& next = *staging.impl_;
+
+    // The settings and the MIDI state which the audio thread changes are read
+    // from their snapshots; the volume and the quality settings are carried
+    // over on adoption
+    {
+        std::lock_guard<std::mutex> lock { exchange.settingsMutex };
+        exchange.applySettings(next);
+        next.resources_.getSynthConfig().sustainCancelsRelease = exchange.sustainCancelsRelease;
+        state.settingsGeneration = exchange.settingsGeneration;
+        state.sustainCancelsRelease = exchange.sustainCancelsRelease;
+    }
+
+    // Share the background threads and the render workers rather than start
+    // new ones; the settings carry the workers
+    next.resources_.getFilePool().shareWorkers(impl.resources_.getFilePool());
+    staging.setRenderQuantum(impl.renderQuantum_);
+    next.parallelEffects_ = impl.parallelEffects_;
+    staging.setPreloadSize(impl.resources_.getFilePool().getPreloadSize());
+    staging.setPreloadCacheDirectory(impl.resources_.getFilePool().getPreloadCacheDirectory());
+    staging.setBroadcastCallback(impl.broadcastReceiver, impl.broadcastData);
+    next.resources_.getFilePool().setSampleStreaming(
+        impl.resources_.getFilePool().getSampleStreaming());
+    next.resources_.getFilePool().setCompressedStorage(
+        impl.resources_.getFilePool().getCompressedStorage());
+    next.resources_.getFilePool().setSampleFormat(
+        impl.resources_.getFilePool().getSampleFormat());
+    next.resources_.getFilePool().setSharedSampleStore(
+        impl.resources_.getFilePool().getSharedSampleStore());
+
+    for (const auto& definition : impl.parser_.getExternalDefinitions())
+        next.parser_.addExternalDefinition(definition.first, definition.second);
+
+    // Staging the current file again acts as a reload, which keeps the CC values
+    next.lastPath_ = impl.lastPath_;
+    next.defaultCCValues_ = impl.defaultCCValues_;
+
+    MidiState& nextMidiState = next.resources_.getMidiState();
+    for (int cc = 0; cc < config::numCCs; ++cc) {
+        state.ccValues[cc] = exchange.ccValues[cc].load(std::memory_order_relaxed);
+        nextMidiState.ccEvent(0, cc, state.ccValues[cc]);
+    }
+    state.pitchBend = exchange.pitchBend.load(std::memory_order_relaxed);
+    state.channelAftertouch = exchange.channelAftertouch.load(std::memory_order_relaxed);
+    state.program = exchange.program.load(std::memory_order_relaxed);
+    nextMidiState.pitchBendEvent(0, state.pitchBend);
+    nextMidiState.channelAftertouchEvent(0, state.channelAftertouch);
+    nextMidiState.programChangeEvent(0, state.program);
+
+    exchange.numReaders.fetch_sub(1);
+}
+
+void Synth::publishStagedState(std::unique_ptr<StagedState> state)
+{
+    StateExchange& exchange = *stateExchange_;
+    exchange.startRetirementThread();
+
+    // The profiler of the staging synth is gone, profile into this one
+    state->impl->profiler_ = profiler_.get();
+
+    // Catch up with the settings changed while the state was loading
+    std::lock_guard<std::mutex> lock { exchange.settingsMutex };
+    if (state->settingsGeneration != exchange.settingsGeneration) {
+        Impl& next = *state->impl;
+        exchange.applySettings(next);
+        if (state->sustainCancelsRelease != exchange.sustainCancelsRelease)
+            next.resources_.getSynthConfig().sustainCancelsRelease = exchange.sustainCancelsRelease;
+        state->settingsGeneration = exchange.settingsGeneration;
+    }
+
+    // A staged state which was not adopted yet gets replaced
+    delete exchange.pending.exchange(state.release(), std::memory_order_acq_rel);
+    exchange.pendingVersion.fetch_add(1, std::memory_order_release);
+}
+
+bool Synth::fadeOutForStagedState(AudioSpan<float> buffer) noexcept
+{
+    StateExchange& exchange = *stateExchange_;
+    const Impl& impl = *impl_;
+
+    // Only the audio thread pushes retired states, so one can be pushed unless
+    // the queue is full
+    const bool replacing = exchange.pending.load(std::memory_order_relaxed)
+        && exchange.pendingVersion.load(std::memory_order_acquire) != exchange.unadoptableVersion
+        && !exchange.retired.was_full();
+
+    // A silent state is replaced right away
+    if (exchange.fadeGain == 1.0f) {
+        if (!replacing)
+            return false;
+        if (impl.voiceManager_.getNumActiveVoices() == 0)
+            return true;
+    }
+
+    // Fade out for the replacement, or back in if there is none anymore
+    const float target = replacing ? 0.0f : 1.0f;
+    const float step = 1.0f / (config::fastReleaseDuration * impl.sampleRate_);
+    const size_t numFrames = buffer.getNumFrames();
+    const size_t numChannels = buffer.getNumChannels();
+    float gain = exchange.fadeGain;
+    for (size_t i = 0; i < numFrames; ++i) {
+        gain = (target < gain) ? max(target, gain - step) : min(target, gain + step);
+        for (size_t c = 0; c < numChannels; ++c)
+            buffer.getChannel(c)[i] *= gain;
+    }
+
+    exchange.fadeGain = gain;
+    return replacing && gain == 0.0f;
+}
+
+bool Synth::adoptStagedState() noexcept
+{
+    StateExchange& exchange = *stateExchange_;
+    if (!exchange.pending.load(std::memory_order_relaxed))
+        return false;
+
+    // The audio thread is the only producer of retired states, so a push
+    // succeeds unless the queue is full; stay on the current state until then
+    if (exchange.retired.was_full())
+        return false;
+
+    StagedState* state = exchange.pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (!state)
+        return false;
+
+    Impl& current = *impl_;
+    Impl& next = *state->impl;
+
+    // The setters keep the staged state in step; should it still not match the
+    // buffers of the host, keep it pending rather than overrun them, unless a
+    // newer state replaced it in the meantime
+    if (next.sampleRate_ != current.sampleRate_ || next.samplesPerBlock_ != current.samplesPerBlock_) {
+        StagedState* expected = nullptr;
+        if (!exchange.pending.compare_exchange_strong(expected, state, std::memory_order_acq_rel)
+            && exchange.retired.try_push(state)) {
+            std::error_code ec;
+            exchange.retirementSemaphore.post(ec);
+        }
+        return false;
+    }
+
+    const MidiState& midiState = current.resources_.getMidiState();
+    MidiState& nextMidiState = next.resources_.getMidiState();
+
+    // Carry over the MIDI state which changed since the staging; the layers
+    // are updated without triggering anything
+    for (int cc = 0; cc < config::numCCs; ++cc) {
+        const float value = midiState.getCCValue(cc);
+        if (value == state->ccValues[cc])
+            continue;
+        nextMidiState.ccEvent(0, cc, value);
+        for (const Impl::LayerPtr& layer : next.layers_)
+            layer->updateCCState(cc, value);
+    }
+
+    const float pitchBend = midiState.getPitchBend();
+    if (pitchBend != state->pitchBend) {
+        nextMidiState.pitchBendEvent(0, pitchBend);
+        for (const Impl::LayerPtr& layer : next.layers_)
+            layer->registerPitchWheel(pitchBend);
+    }
+
+    const float channelAftertouch = midiState.getChannelAftertouch();
+    if (channelAftertouch != state->channelAftertouch) {
+        nextMidiState.channelAftertouchEvent(0, channelAftertouch);
+        for (const Impl::LayerPtr& layer : next.layers_)
+            layer->registerAftertouch(channelAftertouch);
+    }
+
+    const int program = midiState.getProgram();
+    if (program != state->program) {
+        nextMidiState.programChangeEvent(0, program);
+        for (const Impl::LayerPtr& layer : next.layers_)
+            layer->registerProgramChange(program);
+    }
+
+    // Keep the tuning and the musical time of the current state
+    current.resources_.getTuning().swap(next.resources_.getTuning());
+    next.resources_.getStretch() = current.resources_.getStretch();
+    std::swap(current.resources_.getBeatClock(), next.resources_.getBeatClock());
+    const float tempo = static_cast<float>(next.resources_.getBeatClock().getBeatsPerSecond());
+    for (const Impl::LayerPtr& layer : next.layers_)
+        layer->registerTempo(tempo);
+
+    next.broadcastReceiver = current.broadcastReceiver;
+    next.broadcastData = current.broadcastData;
+
+    // Keep the volume and the quality settings of the host; the staged state
+    // keeps the release behavior which its file may have hinted
+    next.volume_ = current.volume_;
+    SynthConfig& nextConfig = next.resources_.getSynthConfig();
+    const bool sustainCancelsRelease = nextConfig.sustainCancelsRelease;
+    nextConfig = current.resources_.getSynthConfig();
+    nextConfig.sustainCancelsRelease = sustainCancelsRelease;
+
+    // The staged state now carries the previous one to the retirement thread;
+    // the new one starts from silence
+    state->impl.swap(impl_);
+    exchange.current.store(impl_.get());
+    exchange.fadeGain = 1.0f;
+    if (!exchange.retired.try_push(state)) {
+        ASSERTFALSE;
+        return true;
+    }
+
+    std::error_code ec;
+    exchange.retirementSemaphore.post(ec);
+    ASSERT(!ec);
     return true;
 }
 
@@ -705,6 +1255,13 @@ void Synth::Impl::finalizeSfzLoad()
     // a string representation used for OSC purposes
     rootPath_ = u8EncodedString(rootDirectory);
 
+    for (const auto& buses : effectBuses_) {
+        for (const EffectBusPtr& bus : buses) {
+            if (bus)
+                bus->loadFiles(filePool);
+        }
+    }
+
     size_t currentRegionIndex = 0;
     size_t currentRegionCount = layers_.size();
 
@@ -729,13 +1286,29 @@ void Synth::Impl::finalizeSfzLoad()
 
     FlexEGs::clearUnusedCurves();
 
+    // Extract the sample metadata in parallel beforehand
+    {
+        std::vector<FileId> sampleIds;
+        sampleIds.reserve(currentRegionCount);
+        for (const LayerPtr& layerPtr : layers_) {
+            Region& region = layerPtr->getRegion();
+            if (reusedLayers_.contains(layerPtr.get()))
+                continue;
+            if (!region.isGenerator() && filePool.checkSampleId(*region.sampleId))
+                sampleIds.push_back(*region.sampleId);
+        }
+        filePool.prefetchFileInformation(sampleIds);
+    }
+
     while (currentRegionIndex < currentRegionCount) {
         Layer& layer = *layers_[currentRegionIndex];
         Region& region = layer.getRegion();
 
+        // A reused region was checked against its sample on a previous load
+        const bool reused = reusedLayers_.contains(&layer);
         absl::optional<FileInformation> fileInformation;
 
-        if (!region.isGenerator()) {
+        if (!region.isGenerator() && !reused) {
             if (!filePool.checkSampleId(*region.sampleId)) {
                 removeCurrentRegion();
                 continue;
@@ -754,7 +1327,7 @@ void Synth::Impl::finalizeSfzLoad()
                 bool allZeros = true;
                 int numChannels = sample->information.numChannels;
                 for (int i = 0; i < numChannels; ++i) {
-                    allZeros &= allWithin(sample->preloadedData.getConstSpan(i),
+                    allZeros &= allWithin(sample->preloaded->data.getConstSpan(i),
                         -config::virtuallyZero, config::virtuallyZero);
                 }
 
@@ -765,7 +1338,7 @@ void Synth::Impl::finalizeSfzLoad()
             }
         }
 
-        if (!region.isOscillator()) {
+        if (!region.isOscillator() && !reused) {
             region.sampleEnd = min(region.sampleEnd, fileInformation->end);
 
             if (fileInformation->hasLoop) {
@@ -794,9 +1367,11 @@ void Synth::Impl::finalizeSfzLoad()
 
             if (region.pitchKeycenterFromSample)
                 region.pitchKeycenter = fileInformation->rootKey;
+        }
 
+        if (!region.isOscillator()) {
             // TODO: adjust with LFO targets
-            const auto maxOffset = [region]() {
+            const auto maxOffset = [&region]() {
                 uint64_t sumOffsetCC = region.offset + region.offsetRandom;
                 for (const auto& offsets : region.offsetCC)
                     sumOffsetCC += offsets.data;
@@ -815,7 +1390,7 @@ void Synth::Impl::finalizeSfzLoad()
 
         if (region.lastKeyswitch) {
             if (currentSwitch_)
-                layer.keySwitched_ = (*currentSwitch_ == *region.lastKeyswitch);
+                layer.setKeySwitched(*currentSwitch_ == *region.lastKeyswitch);
 
             if (region.keyswitchLabel)
                 setKeyswitchLabel(*region.lastKeyswitch, *region.keyswitchLabel);
@@ -824,7 +1399,7 @@ void Synth::Impl::finalizeSfzLoad()
         if (region.lastKeyswitchRange) {
             auto& range = *region.lastKeyswitchRange;
             if (currentSwitch_)
-                layer.keySwitched_ = range.containsWithEnd(*currentSwitch_);
+                layer.setKeySwitched(range.containsWithEnd(*currentSwitch_));
 
             if (region.keyswitchLabel) {
                 for (uint8_t note = range.getStart(), end = range.getEnd(); note <= end; note++)
@@ -893,8 +1468,9 @@ void Synth::Impl::finalizeSfzLoad()
     if (reloading)
         filePool.resetPreloadCallCounts();
 
-    for (const auto& toLoad: filesToLoad)
-        filePool.preloadFile(toLoad.first, toLoad.second);
+    const std::vector<std::pair<FileId, uint32_t>> preloads(filesToLoad.begin(), filesToLoad.end());
+    filePool.preloadFiles(preloads);
+    filePool.clearPrefetchedFileInformation();
 
     // Remove preloaded data with no linked regions
     if (reloading)
@@ -906,6 +1482,7 @@ void Synth::Impl::finalizeSfzLoad()
             << " out of " << layers_.size() << " regions");
     }
     layers_.resize(currentRegionCount);
+    activationIndex_.build(layers_);
 
     // collect all CCs used in regions, with matrix not yet connected
     BitArray<config::numCCs> usedCCs;
@@ -920,24 +1497,24 @@ void Synth::Impl::finalizeSfzLoad()
     // connect default controllers, except if these CC are already used
     for (const LayerPtr& layerPtr : layers_) {
         Region& region = layerPtr->getRegion();
-        constexpr unsigned defaultSmoothness = 10;
-        if (!usedCCs.test(7)) {
-            region.getOrCreateConnection(
-                ModKey::createCC(7, 4, defaultSmoothness, 0),
-                ModKey::createNXYZ(ModId::Amplitude, region.id)).sourceDepth = 1.0f;
-        }
-        if (!usedCCs.test(10)) {
-            region.getOrCreateConnection(
-                ModKey::createCC(10, 1, defaultSmoothness, 0),
-                ModKey::createNXYZ(ModId::Pan, region.id)).sourceDepth = 1.0f;
-        }
-        if (!usedCCs.test(11)) {
-            region.getOrCreateConnection(
-                ModKey::createCC(11, 4, defaultSmoothness, 0),
-                ModKey::createNXYZ(ModId::Amplitude, region.id)).sourceDepth = 1.0f;
+        LayerSignature& signature = layerSignatures_[region.id.number()];
+        for (size_t i = 0; i < defaultControllerConnections.size(); ++i) {
+            const DefaultControllerConnection& connection = defaultControllerConnections[i];
+            if (!usedCCs.test(connection.cc)) {
+                region.getOrCreateConnection(
+                    ModKey::createCC(connection.cc, connection.curve, defaultControllerSmoothness, 0),
+                    ModKey::createNXYZ(connection.target, region.id)).sourceDepth = 1.0f;
+                signature.defaultConnections |= 1u << i;
+            }
         }
     }
 
+    // Release the layers which were not reused
+    reusableLayers_.clear();
+    previousSignatures_.clear();
+    previousUnknownOpcodes_.clear();
+    reusedLayers_.clear();
+
     modificationTime_ = checkModificationTime();
 
     settingsPerVoice_.maxFilters = maxFilters;
@@ -952,6 +1529,7 @@ void Synth::Impl::finalizeSfzLoad()
 
     applySettingsPerVoice();
     addEffectBusesIfNecessary(numOutputs_);
+    updateRenderTaskBuffers();
     setupModMatrix();
 
     // cache the set of used CCs for future access
@@ -1049,21 +1627,30 @@ std::vector<const Voice*> Synth::getActiveVoices() const noexcept
 
 void Synth::setSamplesPerBlock(int samplesPerBlock) noexcept
 {
-    Impl& impl = *impl_;
+    changeSetting([samplesPerBlock](Impl& impl) {
+        impl.setSamplesPerBlock(samplesPerBlock);
+    });
+}
+
+void Synth::Impl::setSamplesPerBlock(int samplesPerBlock) noexcept
+{
     ASSERT(samplesPerBlock <= config::maxBlockSize);
 
-    impl.samplesPerBlock_ = samplesPerBlock;
-    for (auto& voice : impl.voiceManager_)
+    samplesPerBlock_ = samplesPerBlock;
+    for (auto& voice : voiceManager_)
         voice.setSamplesPerBlock(samplesPerBlock);
 
-    impl.resources_.setSamplesPerBlock(samplesPerBlock);
+    resources_.setSamplesPerBlock(samplesPerBlock);
 
-    for (int i = 0; i < impl.numOutputs_; ++i) {
-        for (auto& bus : impl.getEffectBusesForOutput(i)) {
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (auto& bus : getEffectBusesForOutput(i)) {
             if (bus)
                 bus->setSamplesPerBlock(samplesPerBlock);
         }
     }
+
+    updateRenderTaskBuffers();
+    updateFilterBank();
 }
 
 int Synth::getSamplesPerBlock() const noexcept
@@ -1074,16 +1661,22 @@ int Synth::getSamplesPerBlock() const noexcept
 
 void Synth::setSampleRate(float sampleRate) noexcept
 {
-    Impl& impl = *impl_;
+    changeSetting([sampleRate](Impl& impl) {
+        impl.setSampleRate(sampleRate);
+    });
+}
 
-    impl.sampleRate_ = sampleRate;
-    for (auto& voice : impl.voiceManager_)
+void Synth::Impl::setSampleRate(float sampleRate) noexcept
+{
+    sampleRate_ = sampleRate;
+    for (auto& voice : voiceManager_)
         voice.setSampleRate(sampleRate);
 
-    impl.resources_.setSampleRate(sampleRate);
+    resources_.setSampleRate(sampleRate);
+    filterBank_.setSampleRate(sampleRate);
 
-    for (int i = 0; i < impl.numOutputs_; ++i) {
-        for (auto& bus : impl.getEffectBusesForOutput(i)) {
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (auto& bus : getEffectBusesForOutput(i)) {
             if (bus)
                 bus->setSampleRate(sampleRate);
         }
@@ -1091,6 +1684,128 @@ void Synth::setSampleRate(float sampleRate) noexcept
 }
 
 void Synth::renderBlock(AudioSpan<float> buffer) noexcept
+{
+    ScopedRealtime realtime;
+    const auto blockStart = highResNow();
+    eventQueue_->drain(static_cast<unsigned>(buffer.getNumFrames()), [this](const QueuedEvent& event, int delay) {
+        dispatchQueuedEvent(event, delay);
+    });
+
+    Impl& impl = *impl_;
+    const int numFrames = static_cast<int>(buffer.getNumFrames());
+    const int quantum = impl.renderQuantum_;
+    if (quantum <= 0 || (numFrames <= quantum && impl.deferredEvents_.empty()))
+        renderCurrentState(buffer);
+    else {
+        for (int start = 0; start < numFrames; start += quantum) {
+            const int length = std::min(quantum, numFrames - start);
+            dispatchDeferredEvents(start, length, start + length >= numFrames);
+            renderCurrentState(buffer.subspan(start, length));
+        }
+        impl.deferredEvents_.clear();
+    }
+
+    // Freewheeling blocks have no deadline
+    const bool freeWheeling = impl.resources_.getSynthConfig().freeWheeling;
+    const double budget = numFrames / impl.sampleRate_;
+    const auto numVoices = static_cast<uint32_t>(impl.voiceManager_.getNumActiveVoices());
+    const uint32_t numEvents = impl.numBlockEvents_;
+    impl.numBlockEvents_ = 0;
+    const uint32_t numStreamUnderruns = impl.numBlockStreamUnderruns_;
+    impl.numBlockStreamUnderruns_ = 0;
+
+    // Switch to a staged instrument at the block boundary, once the current
+    // state is faded out and its buffers are released
+    if (fadeOutForStagedState(buffer) && !adoptStagedState())
+        stateExchange_->unadoptableVersion = stateExchange_->pendingVersion.load(std::memory_order_acquire);
+    stateExchange_->publishMidiState(impl_->resources_.getMidiState());
+
+    const Duration blockDuration = highResNow() - blockStart;
+    if (!freeWheeling)
+        latencyMonitor_->record(blockDuration.count(), budget, numVoices, numEvents);
+    if (numStreamUnderruns > 0)
+        latencyMonitor_->recordStreamUnderruns(numStreamUnderruns);
+}
+
+void Synth::dispatchDeferredEvents(int start, int numFrames, bool lastSubBlock) noexcept
+{
+    using Type = Impl::DeferredEvent::Type;
+    Impl& impl = *impl_;
+
+    // The events are delay-ordered, the ones of this sub-block come first
+    size_t numDispatched = 0;
+    for (const Impl::DeferredEvent& event : impl.deferredEvents_) {
+        if (event.delay >= start + numFrames && !lastSubBlock)
+            break;
+
+        const int delay = std::min(std::max(event.delay - start, 0), numFrames - 1);
+        const float value = static_cast<float>(event.value);
+        switch (event.type) {
+        case Type::NoteOn:
+            hdNoteOn(delay, event.number, value);
+            break;
+        case Type::NoteOff:
+            hdNoteOff(delay, event.number, value);
+            break;
+        case Type::Controller:
+            hdcc(delay, event.number, value);
+            break;
+        case Type::AutomatedController:
+            automateHdcc(delay, event.number, value);
+            break;
+        case Type::ProgramChange:
+            programChange(delay, event.number);
+            break;
+        case Type::PitchWheel:
+            hdPitchWheel(delay, value);
+            break;
+        case Type::ChannelAftertouch:
+            hdChannelAftertouch(delay, value);
+            break;
+        case Type::PolyAftertouch:
+            hdPolyAftertouch(delay, event.number, value);
+            break;
+        case Type::Tempo:
+            tempo(delay, value);
+            break;
+        case Type::TimeSignature:
+            timeSignature(delay, event.number, static_cast<int>(event.value));
+            break;
+        case Type::TimePosition:
+            timePosition(delay, event.number, event.value);
+            break;
+        case Type::PlaybackState:
+            playbackState(delay, event.number);
+            break;
+        }
+        ++numDispatched;
+    }
+
+    impl.deferredEvents_.erase(impl.deferredEvents_.begin(), impl.deferredEvents_.begin() + numDispatched);
+}
+
+bool Synth::Impl::deferEvent(int& delay, DeferredEvent::Type type, int number, double value) noexcept
+{
+    if (renderQuantum_ <= 0 || delay < renderQuantum_)
+        return false;
+
+    // Past the capacity, dispatch at the end of the first sub-block rather
+    // than allocate
+    if (deferredEvents_.size() == deferredEvents_.capacity()) {
+        delay = renderQuantum_ - 1;
+        return false;
+    }
+
+    // Keep the order of delays, in case the caller did not
+    DeferredEvent event { delay, type, number, value };
+    auto it = deferredEvents_.end();
+    while (it != deferredEvents_.begin() && (it - 1)->delay > delay)
+        --it;
+    deferredEvents_.insert(it, event);
+    return true;
+}
+
+void Synth::renderCurrentState(AudioSpan<float> buffer) noexcept
 {
     Impl& impl = *impl_;
     ScopedFTZ ftz;
@@ -1161,32 +1876,78 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
     { // Main render block
         ScopedTiming logger { callbackBreakdown.renderMethod, ScopedTiming::Operation::addToDuration };
 
-        for (auto& voice : impl.voiceManager_) {
-            if (voice.isFree())
-                continue;
+        unsigned numRenderTasks = 0;
+        if (impl.renderWorkers_)
+            numRenderTasks = impl.prepareRenderTasks();
+
+        if (numRenderTasks > 1) {
+            // The workers only read the per-cycle modulations. They filter
+            // each voice on its own: the filter bank is single-threaded.
+            mm.generateGlobalModulations();
+
+            AudioSpan<float> mainTempSpan = *tempSpan;
+            impl.renderWorkers_->run(numRenderTasks, [&impl, mainTempSpan, numFrames](unsigned taskIndex, unsigned workerIndex) {
+                impl.renderVoiceTask(taskIndex, workerIndex, mainTempSpan, numFrames);
+            });
+
+            // Send the tasks to the effect buses in task order, so the sums do
+            // not depend on which worker rendered what
+            for (unsigned t = 0; t < numRenderTasks; ++t) {
+                const Region* region = impl.renderVoices_[impl.renderTaskStarts_[t]]->getRegion();
+                AudioSpan<float> taskSpan = AudioSpan<float>(impl.renderTaskBuffers_[t]).first(numFrames);
+                const auto& effectBuses = impl.getEffectBusesForOutput(region->output);
+                for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
+                    if (auto& bus = effectBuses[i]) {
+                        float addGain = region->getGainToEffectBus(i);
+                        bus->addToInputs(taskSpan, addGain, numFrames);
+                    }
+                }
+            }
 
-            mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+            for (Voice* voice : impl.renderVoices_) {
+                callbackBreakdown.data += voice->getLastDataDuration();
+                callbackBreakdown.amplitude += voice->getLastAmplitudeDuration();
+                callbackBreakdown.filters += voice->getLastFilterDuration();
+                callbackBreakdown.panning += voice->getLastPanningDuration();
+                impl.numBlockStreamUnderruns_ += voice->getLastStreamUnderruns();
+                if (profiler_->isEnabled())
+                    impl.profileVoice(*voice);
+
+                if (voice->toBeCleanedUp())
+                    voice->reset();
+            }
+        }
+        else {
+            for (auto& voice : impl.voiceManager_) {
+                if (voice.isFree())
+                    continue;
+
+                // The voices with biquad filters get queued into the filter
+                // bank, and are finished when it gets processed
+                const unsigned numLanes = voice.getFilterBankLanes();
+                if (numLanes > impl.filterBank_.getNumFreeLanes())
+                    impl.processFilterBank(numFrames);
+
+                mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+
+                bool queued = false;
+                AudioSpan<float> voiceSpan = *tempSpan;
+                if (numLanes > 0) {
+                    voiceSpan = impl.getFilterBankSpan(numFrames);
+                    queued = voice.renderBlockToFilterBank(voiceSpan, impl.filterBank_);
+                }
+                else
+                    voice.renderBlock(voiceSpan);
 
-            const Region* region = voice.getRegion();
-            ASSERT(region != nullptr);
-            const auto& effectBuses = impl.getEffectBusesForOutput(region->output);
+                mm.endVoice();
 
-            voice.renderBlock(*tempSpan);
-            for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
-                if (auto& bus = effectBuses[i]) {
-                    float addGain = region->getGainToEffectBus(i);
-                    bus->addToInputs(*tempSpan, addGain, numFrames);
-                }
+                if (queued)
+                    impl.filterBankVoices_.push_back(&voice);
+                else
+                    impl.finishVoice(voice, voiceSpan, numFrames);
             }
-            callbackBreakdown.data += voice.getLastDataDuration();
-            callbackBreakdown.amplitude += voice.getLastAmplitudeDuration();
-            callbackBreakdown.filters += voice.getLastFilterDuration();
-            callbackBreakdown.panning += voice.getLastPanningDuration();
 
-            mm.endVoice();
-
-            if (voice.toBeCleanedUp())
-                voice.reset();
+            impl.processFilterBank(numFrames);
         }
     }
 
@@ -1195,6 +1956,19 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
         //    without any <effect>, the signal is just going to flow through it.
         ScopedTiming logger { callbackBreakdown.effects, ScopedTiming::Operation::addToDuration };
 
+        // The buses are independent until they are mixed; process them
+        // concurrently if possible, and mix them in order in any case
+        unsigned numEffectTasks = 0;
+        if (impl.parallelEffects_ && impl.renderWorkers_)
+            numEffectTasks = impl.prepareEffectTasks();
+
+        const bool parallelEffects = numEffectTasks > 1;
+        if (parallelEffects) {
+            impl.renderWorkers_->run(numEffectTasks, [&impl, numFrames](unsigned taskIndex, unsigned) {
+                impl.renderEffectBuses_[taskIndex]->process(numFrames);
+            });
+        }
+
         const int numChannels = static_cast<int>(buffer.getNumChannels());
         for (int i = 0; i < impl.numOutputs_; ++i) {
             tempMixSpan->fill(0.0f);
@@ -1203,7 +1977,8 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
             const auto& effectBuses = impl.getEffectBusesForOutput(i);
             for (auto& bus : effectBuses) {
                 if (bus) {
-                    bus->process(numFrames);
+                    if (!parallelEffects)
+                        bus->process(numFrames);
                     bus->mixOutputsTo(outputSpan, *tempMixSpan, numFrames);
                 }
             }
@@ -1243,6 +2018,11 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
         midiState.advanceTime(buffer.getNumFrames());
     }
 
+    profiler_->endBlock(static_cast<uint32_t>(numFrames),
+        static_cast<float>(callbackBreakdown.dispatch),
+        static_cast<float>(callbackBreakdown.renderMethod),
+        static_cast<float>(callbackBreakdown.effects));
+
     ASSERT(!hasNanInf(buffer.getConstSpan(0)));
     ASSERT(!hasNanInf(buffer.getConstSpan(1)));
     SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
@@ -1257,9 +2037,13 @@ void Synth::noteOn(int delay, int noteNumber, int velocity) noexcept
 
 void Synth::hdNoteOn(int delay, int noteNumber, float normalizedVelocity) noexcept
 {
+    ScopedRealtime realtime;
     ASSERT(noteNumber < 128);
     ASSERT(noteNumber >= 0);
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::NoteOn, noteNumber, normalizedVelocity))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     if (impl.lastKeyswitchLists_[noteNumber].empty())
@@ -1276,9 +2060,13 @@ void Synth::noteOff(int delay, int noteNumber, int velocity) noexcept
 
 void Synth::hdNoteOff(int delay, int noteNumber, float normalizedVelocity) noexcept
 {
+    ScopedRealtime realtime;
     ASSERT(noteNumber < 128);
     ASSERT(noteNumber >= 0);
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::NoteOff, noteNumber, normalizedVelocity))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     // FIXME: Some keyboards (e.g. Casio PX5S) can send a real note-off velocity. In this case, do we have a
@@ -1329,10 +2117,10 @@ void Synth::Impl::noteOffDispatch(int delay, int noteNumber, float velocity) noe
     const TriggerEvent triggerEvent { TriggerEventType::NoteOff, noteNumber, velocity };
 
     for (Layer* layer : upKeyswitchLists_[noteNumber])
-        layer->keySwitched_ = true;
+        layer->setKeySwitched(true);
 
     for (Layer* layer : downKeyswitchLists_[noteNumber])
-        layer->keySwitched_ = false;
+        layer->setKeySwitched(false);
 
     for (Layer* layer : noteActivationLists_[noteNumber]) {
         const Region& region = layer->getRegion();
@@ -1355,35 +2143,35 @@ void Synth::Impl::noteOnDispatch(int delay, int noteNumber, float velocity) noex
     if (!lastKeyswitchLists_[noteNumber].empty()) {
         if (currentSwitch_ && *currentSwitch_ != noteNumber) {
             for (Layer* layer : lastKeyswitchLists_[*currentSwitch_])
-                layer->keySwitched_ = false;
+                layer->setKeySwitched(false);
         }
         currentSwitch_ = noteNumber;
     }
 
     for (Layer* layer : lastKeyswitchLists_[noteNumber])
-        layer->keySwitched_ = true;
+        layer->setKeySwitched(true);
 
     for (Layer* layer : upKeyswitchLists_[noteNumber])
-        layer->keySwitched_ = false;
+        layer->setKeySwitched(false);
 
     for (Layer* layer : downKeyswitchLists_[noteNumber])
-        layer->keySwitched_ = true;
+        layer->setKeySwitched(true);
 
-    for (Layer* layer : noteActivationLists_[noteNumber]) {
+    activationIndex_.forEachCandidate(noteNumber, velocity, [&](Layer* layer) {
         if (layer->registerNoteOn(noteNumber, velocity, randValue)) {
             const Region& region = layer->getRegion();
             if (region.useTimerRange && !voiceManager_.withinValidTimerRange(&region, midiState.getInternalClock() + delay, sampleRate_))
-                continue;
+                return;
 
             checkOffGroups(&region, delay, noteNumber);
             TriggerEvent triggerEvent { TriggerEventType::NoteOn, noteNumber, velocity };
             startVoice(layer, delay, triggerEvent, ring);
         }
-    }
+    });
 
     for (Layer* layer : previousKeyswitchLists_) {
         const Region& region = layer->getRegion();
-        layer->previousKeySwitched_ = (region.previousKeyswitch == noteNumber);
+        layer->setPreviousKeySwitched(region.previousKeyswitch == noteNumber);
     }
 }
 
@@ -1461,13 +2249,21 @@ void Synth::Impl::ccDispatch(int delay, int ccNumber, float value, int extendedA
 
 void Synth::hdcc(int delay, int ccNumber, float normValue) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::Controller, ccNumber, normValue))
+        return;
+    ++impl.numBlockEvents_;
     impl.performHdcc(delay, ccNumber, normValue, true);
 }
 
 void Synth::automateHdcc(int delay, int ccNumber, float normValue) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::AutomatedController, ccNumber, normValue))
+        return;
+    ++impl.numBlockEvents_;
     impl.performHdcc(delay, ccNumber, normValue, false);
 }
 
@@ -1534,7 +2330,11 @@ void Synth::pitchWheel(int delay, int pitch) noexcept
 
 void Synth::hdPitchWheel(int delay, float normalizedPitch) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::PitchWheel, 0, normalizedPitch))
+        return;
+    ++impl.numBlockEvents_;
 
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
     impl.resources_.getMidiState().pitchBendEvent(delay, normalizedPitch);
@@ -1552,7 +2352,11 @@ void Synth::hdPitchWheel(int delay, float normalizedPitch) noexcept
 
 void Synth::programChange(int delay, int program) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::ProgramChange, program))
+        return;
+    ++impl.numBlockEvents_;
     impl.resources_.getMidiState().programChangeEvent(delay, program);
     for (const Impl::LayerPtr& layer : impl.layers_)
         layer->registerProgramChange(program);
@@ -1567,7 +2371,11 @@ void Synth::channelAftertouch(int delay, int aftertouch) noexcept
 
 void Synth::hdChannelAftertouch(int delay, float normAftertouch) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::ChannelAftertouch, 0, normAftertouch))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     impl.resources_.getMidiState().channelAftertouchEvent(delay, normAftertouch);
@@ -1591,7 +2399,11 @@ void Synth::polyAftertouch(int delay, int noteNumber, int aftertouch) noexcept
 
 void Synth::hdPolyAftertouch(int delay, int noteNumber, float normAftertouch) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::PolyAftertouch, noteNumber, normAftertouch))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     impl.resources_.getMidiState().polyAftertouchEvent(delay, noteNumber, normAftertouch);
@@ -1604,7 +2416,11 @@ void Synth::hdPolyAftertouch(int delay, int noteNumber, float normAftertouch) no
 
 void Synth::tempo(int delay, float secondsPerBeat) noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::Tempo, 0, secondsPerBeat))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     impl.resources_.getBeatClock().setTempo(delay, secondsPerBeat);
@@ -1618,7 +2434,11 @@ void Synth::bpmTempo(int delay, float beatsPerMinute) noexcept
 
 void Synth::timeSignature(int delay, int beatsPerBar, int beatUnit)
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::TimeSignature, beatsPerBar, beatUnit))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     impl.resources_.getBeatClock().setTimeSignature(delay, TimeSignature(beatsPerBar, beatUnit));
@@ -1626,7 +2446,11 @@ void Synth::timeSignature(int delay, int beatsPerBar, int beatUnit)
 
 void Synth::timePosition(int delay, int bar, double barBeat)
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::TimePosition, bar, barBeat))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     BeatClock& beatClock = impl.resources_.getBeatClock();
@@ -1645,12 +2469,102 @@ void Synth::timePosition(int delay, int bar, double barBeat)
 
 void Synth::playbackState(int delay, int playbackState)
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
+    if (impl.deferEvent(delay, Impl::DeferredEvent::Type::PlaybackState, playbackState))
+        return;
+    ++impl.numBlockEvents_;
     ScopedTiming logger { impl.dispatchDuration_, ScopedTiming::Operation::addToDuration };
 
     impl.resources_.getBeatClock().setPlaying(delay, playbackState == 1);
 }
 
+bool Synth::postMidiEvent(int64_t frame, const uint8_t* data, size_t size) noexcept
+{
+    if (size == 0)
+        return false;
+
+    switch (data[0] & 0xf0) {
+    case 0x80: // note off
+    case 0x90: // note on
+    case 0xa0: // polyphonic aftertouch
+    case 0xb0: // control change
+    case 0xe0: // pitch bend
+        if (size < 3)
+            return false;
+        break;
+    case 0xc0: // program change
+    case 0xd0: // channel aftertouch
+        if (size < 2)
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    QueuedEvent event;
+    event.frame = frame;
+    event.type = QueuedEvent::Type::Midi;
+    std::copy_n(data, std::min<size_t>(size, 3), event.data);
+    return eventQueue_->push(event);
+}
+
+bool Synth::postHdcc(int64_t frame, int ccNumber, float normValue) noexcept
+{
+    if (ccNumber < 0 || ccNumber >= config::numCCs)
+        return false;
+
+    QueuedEvent event;
+    event.frame = frame;
+    event.type = QueuedEvent::Type::Hdcc;
+    event.number = static_cast<uint16_t>(ccNumber);
+    event.value = normValue;
+    return eventQueue_->push(event);
+}
+
+int64_t Synth::getFrameTime() const noexcept
+{
+    return eventQueue_->getFrameTime();
+}
+
+void Synth::dispatchQueuedEvent(const QueuedEvent& event, int delay) noexcept
+{
+    if (event.type == QueuedEvent::Type::Hdcc) {
+        hdcc(delay, event.number, event.value);
+        return;
+    }
+
+    const int data1 = event.data[1] & 0x7f;
+    const int data2 = event.data[2] & 0x7f;
+
+    switch (event.data[0] & 0xf0) {
+    case 0x80:
+        noteOff(delay, data1, data2);
+        break;
+    case 0x90:
+        if (data2 == 0)
+            noteOff(delay, data1, data2);
+        else
+            noteOn(delay, data1, data2);
+        break;
+    case 0xa0:
+        polyAftertouch(delay, data1, data2);
+        break;
+    case 0xb0:
+        cc(delay, data1, data2);
+        break;
+    case 0xc0:
+        programChange(delay, data1);
+        break;
+    case 0xd0:
+        channelAftertouch(delay, data1);
+        break;
+    case 0xe0:
+        pitchWheel(delay, ((data2 << 7) | data1) - 8192);
+        break;
+    }
+}
+
 int Synth::getNumRegions() const noexcept
 {
     Impl& impl = *impl_;
@@ -1675,6 +2589,12 @@ int Synth::getNumCurves() const noexcept
     return static_cast<int>(impl.resources_.getCurves().getNumCurves());
 }
 
+int Synth::getNumOutputs() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.numOutputs_;
+}
+
 std::string Synth::exportMidnam(absl::string_view model) const
 {
     Impl& impl = *impl_;
@@ -1929,9 +2849,46 @@ void Synth::setOscillatorQuality(ProcessMode mode, int quality)
     }
 }
 
+int Synth::getFilterQuality(ProcessMode mode)
+{
+    Impl& impl = *impl_;
+    SynthConfig& synthConfig = impl.resources_.getSynthConfig();
+    switch (mode) {
+    case ProcessLive:
+        return synthConfig.liveFilterQuality;
+    case ProcessFreewheeling:
+        return synthConfig.freeWheelingFilterQuality;
+    default:
+        SFIZZ_CHECK(false);
+        return 0;
+    }
+}
+
+void Synth::setFilterQuality(ProcessMode mode, int quality)
+{
+    SFIZZ_CHECK(quality >= 0 && quality <= 1);
+    Impl& impl = *impl_;
+    quality = clamp(quality, 0, 1);
+    SynthConfig& synthConfig = impl.resources_.getSynthConfig();
+
+    switch (mode) {
+    case ProcessLive:
+        synthConfig.liveFilterQuality = quality;
+        break;
+    case ProcessFreewheeling:
+        synthConfig.freeWheelingFilterQuality = quality;
+        break;
+    default:
+        SFIZZ_CHECK(false);
+        break;
+    }
+}
+
 void Synth::setSustainCancelsRelease(bool value)
 {
-    impl_->resources_.getSynthConfig().sustainCancelsRelease = value;
+    changeSetting([value](Impl& impl) {
+        impl.resources_.getSynthConfig().sustainCancelsRelease = value;
+    });
 }
 
 float Synth::getVolume() const noexcept
@@ -1954,13 +2911,117 @@ int Synth::getNumVoices() const noexcept
 void Synth::setNumVoices(int numVoices) noexcept
 {
     ASSERT(numVoices > 0);
+
+    // fast path
+    if (numVoices == impl_->numVoices_)
+        return;
+
+    changeSetting([numVoices](Impl& impl) {
+        if (numVoices != impl.numVoices_)
+            impl.resetVoices(numVoices);
+    });
+}
+
+int Synth::getNumRenderThreads() const noexcept
+{
     Impl& impl = *impl_;
+    return impl.renderWorkers_ ? static_cast<int>(impl.renderWorkers_->getNumThreads()) : 1;
+}
+
+void Synth::setNumRenderThreads(int numThreads) noexcept
+{
+    numThreads = clamp(numThreads, 1, config::maxRenderThreads);
 
     // fast path
-    if (numVoices == impl.numVoices_)
+    if (numThreads == getNumRenderThreads())
         return;
 
-    impl.resetVoices(numVoices);
+    std::shared_ptr<RTWorkerPool> workers;
+    if (numThreads > 1)
+        workers = std::make_shared<RTWorkerPool>(static_cast<unsigned>(numThreads));
+
+    changeSetting([&workers](Impl& impl) {
+        impl.setRenderWorkers(workers);
+    });
+}
+
+void Synth::Impl::setRenderWorkers(std::shared_ptr<RTWorkerPool> workers)
+{
+    renderWorkers_ = std::move(workers);
+    resources_.setNumRenderThreads(renderWorkers_ ? static_cast<int>(renderWorkers_->getNumThreads()) : 1);
+    updateRenderTaskBuffers();
+}
+
+int Synth::getRenderQuantum() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.renderQuantum_;
+}
+
+void Synth::setRenderQuantum(int numFrames) noexcept
+{
+    Impl& impl = *impl_;
+    impl.renderQuantum_ = clamp(numFrames, 0, config::maxRenderQuantum);
+    impl.deferredEvents_.clear();
+    impl.deferredEvents_.reserve(impl.renderQuantum_ > 0 ? config::maxDeferredEvents : 0);
+}
+
+void Synth::enableParallelEffects() noexcept
+{
+    Impl& impl = *impl_;
+    impl.parallelEffects_ = true;
+}
+
+void Synth::disableParallelEffects() noexcept
+{
+    Impl& impl = *impl_;
+    impl.parallelEffects_ = false;
+}
+
+void Synth::enableProfiling()
+{
+    profiler_->enable(config::profilerBlockCapacity, config::profilerVoiceCapacity);
+}
+
+void Synth::disableProfiling()
+{
+    profiler_->disable();
+}
+
+const Profiler& Synth::getProfiler() const noexcept
+{
+    return *profiler_;
+}
+
+const LatencyMonitor& Synth::getLatencyMonitor() const noexcept
+{
+    return *latencyMonitor_;
+}
+
+void Synth::resetLatencyStats() noexcept
+{
+    latencyMonitor_->reset();
+}
+
+void Synth::Impl::profileVoice(const Voice& voice) noexcept
+{
+    auto clampCount = [](size_t count) {
+        return static_cast<uint8_t>(std::min<size_t>(count, 255));
+    };
+
+    const Region* region = voice.getRegion();
+    VoiceProfile profile;
+    profile.voiceId = voice.getId().number();
+    profile.regionId = region->getId().number();
+    profile.sampleQuality = clampCount(voice.getCurrentSampleQuality());
+    profile.numFilters = clampCount(region->filters.size());
+    profile.numEQs = clampCount(region->equalizers.size());
+    profile.numLFOs = clampCount(region->lfos.size());
+    profile.data = static_cast<float>(voice.getLastDataDuration());
+    profile.amplitude = static_cast<float>(voice.getLastAmplitudeDuration());
+    profile.filters = static_cast<float>(voice.getLastFilterDuration());
+    profile.panning = static_cast<float>(voice.getLastPanningDuration());
+    profiler_->addVoice(profile);
 }
 
 void Synth::Impl::resetVoices(int numVoices)
@@ -1972,11 +3033,17 @@ void Synth::Impl::resetVoices(int numVoices)
 
     voiceManager_.requireNumVoices(numVoices_, resources_);
 
+    size_t numVoiceSlots = 0;
     for (auto& voice : voiceManager_) {
         voice.setSampleRate(this->sampleRate_);
         voice.setSamplesPerBlock(this->samplesPerBlock_);
+        ++numVoiceSlots;
     }
 
+    renderVoices_.reserve(numVoiceSlots);
+    renderTaskStarts_.reserve(numVoiceSlots);
+    updateRenderTaskBuffers();
+
     applySettingsPerVoice();
 }
 
@@ -1985,6 +3052,180 @@ void Synth::Impl::resetCallbackBreakdown()
     callbackBreakdown_ = CallbackBreakdown();
 }
 
+void Synth::Impl::updateRenderTaskBuffers()
+{
+    size_t numBuses = 0;
+    for (const auto& buses : effectBuses_)
+        numBuses += buses.size();
+    renderEffectBuses_.reserve(numBuses);
+
+    // There is at most a task per voice
+    renderTaskBuffers_.clear();
+    if (renderWorkers_) {
+        renderTaskBuffers_.reserve(renderTaskStarts_.capacity());
+        for (size_t i = 0, n = renderTaskStarts_.capacity(); i < n; ++i)
+            renderTaskBuffers_.emplace_back(2, samplesPerBlock_);
+    }
+}
+
+unsigned Synth::Impl::prepareRenderTasks() noexcept
+{
+    renderVoices_.clear();
+    renderTaskStarts_.clear();
+
+    for (auto& voice : voiceManager_) {
+        if (!voice.isFree())
+            renderVoices_.push_back(&voice);
+    }
+
+    // Group the voices by region, since the voices of a region share their
+    // modulation buffers and sources; keep them in order of identifier
+    std::sort(renderVoices_.begin(), renderVoices_.end(), [](const Voice* lhs, const Voice* rhs) {
+        const int lhsRegion = lhs->getRegion()->getId().number();
+        const int rhsRegion = rhs->getRegion()->getId().number();
+        if (lhsRegion != rhsRegion)
+            return lhsRegion < rhsRegion;
+        return lhs->getId().number() < rhs->getId().number();
+    });
+
+    const Region* lastRegion = nullptr;
+    for (size_t i = 0, n = renderVoices_.size(); i < n; ++i) {
+        const Region* region = renderVoices_[i]->getRegion();
+        if (region != lastRegion) {
+            renderTaskStarts_.push_back(static_cast<unsigned>(i));
+            lastRegion = region;
+        }
+    }
+
+    // voices added since the last update: render them serially rather than
+    // allocate
+    if (renderTaskStarts_.size() > renderTaskBuffers_.size())
+        return 0;
+
+    return static_cast<unsigned>(renderTaskStarts_.size());
+}
+
+unsigned Synth::Impl::prepareEffectTasks() noexcept
+{
+    renderEffectBuses_.clear();
+
+    for (int i = 0; i < numOutputs_; ++i) {
+        for (const EffectBusPtr& bus : getEffectBusesForOutput(i)) {
+            if (!bus)
+                continue;
+            // buses created since the last update: process them serially
+            // rather than allocate
+            if (renderEffectBuses_.size() == renderEffectBuses_.capacity()) {
+                renderEffectBuses_.clear();
+                return 0;
+            }
+            renderEffectBuses_.push_back(bus.get());
+        }
+    }
+
+    return static_cast<unsigned>(renderEffectBuses_.size());
+}
+
+void Synth::Impl::renderVoiceTask(unsigned taskIndex, unsigned workerIndex, AudioSpan<float> tempSpan, size_t numFrames) noexcept
+{
+    SpanHolder<AudioSpan<float>> workerSpan;
+    if (workerIndex > 0) {
+        workerSpan = resources_.getBufferPool().getStereoBuffer(numFrames);
+        if (!workerSpan) {
+            DBG("[sfizz] Could not get a temporary buffer for render worker " << workerIndex);
+            return;
+        }
+        tempSpan = *workerSpan;
+    }
+
+    ModMatrix& mm = resources_.getModMatrix();
+    const size_t taskStart = renderTaskStarts_[taskIndex];
+    const size_t taskEnd = (taskIndex + 1 < renderTaskStarts_.size()) ?
+        renderTaskStarts_[taskIndex + 1] : renderVoices_.size();
+
+    // The voices of a task share their region, hence their effect bus gains
+    AudioSpan<float> taskSpan = AudioSpan<float>(renderTaskBuffers_[taskIndex]).first(numFrames);
+    taskSpan.fill(0.0f);
+
+    for (size_t v = taskStart; v < taskEnd; ++v) {
+        Voice& voice = *renderVoices_[v];
+        ASSERT(voice.getRegion() != nullptr);
+
+        mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+        voice.renderBlock(tempSpan);
+        taskSpan.add(tempSpan);
+        mm.endVoice();
+    }
+}
+
+void Synth::Impl::finishVoice(Voice& voice, AudioSpan<float> voiceSpan, size_t numFrames) noexcept
+{
+    const Region* region = voice.getRegion();
+    ASSERT(region != nullptr);
+    const auto& effectBuses = getEffectBusesForOutput(region->output);
+
+    for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
+        if (auto& bus = effectBuses[i]) {
+            float addGain = region->getGainToEffectBus(i);
+            bus->addToInputs(voiceSpan, addGain, numFrames);
+        }
+    }
+    callbackBreakdown_.data += voice.getLastDataDuration();
+    callbackBreakdown_.amplitude += voice.getLastAmplitudeDuration();
+    callbackBreakdown_.filters += voice.getLastFilterDuration();
+    callbackBreakdown_.panning += voice.getLastPanningDuration();
+    numBlockStreamUnderruns_ += voice.getLastStreamUnderruns();
+    if (profiler_->isEnabled())
+        profileVoice(voice);
+
+    if (voice.toBeCleanedUp())
+        voice.reset();
+}
+
+void Synth::Impl::updateFilterBank()
+{
+    filterBank_.setSampleRate(sampleRate_);
+    filterBank_.setSamplesPerBlock(samplesPerBlock_);
+
+    filterBankBuffers_.clear();
+    filterBankBuffers_.reserve(FilterBank::numLanes);
+    for (unsigned i = 0; i < FilterBank::numLanes; ++i)
+        filterBankBuffers_.emplace_back(2, samplesPerBlock_);
+
+    filterBankVoices_.clear();
+    filterBankVoices_.reserve(FilterBank::numLanes);
+}
+
+AudioSpan<float> Synth::Impl::getFilterBankSpan(size_t numFrames) noexcept
+{
+    // Each voice takes at least a lane, so there are enough buffers
+    ASSERT(filterBankVoices_.size() < filterBankBuffers_.size());
+    return AudioSpan<float>(filterBankBuffers_[filterBankVoices_.size()]).first(numFrames);
+}
+
+void Synth::Impl::processFilterBank(size_t numFrames) noexcept
+{
+    if (filterBankVoices_.empty())
+        return;
+
+    double bankDuration = 0.0;
+    {
+        ScopedTiming logger { bankDuration };
+        filterBank_.process(static_cast<unsigned>(numFrames));
+    }
+
+    // The voices are finished in the order they were rendered
+    const double filterDuration = bankDuration / filterBankVoices_.size();
+    for (size_t i = 0, n = filterBankVoices_.size(); i < n; ++i) {
+        Voice& voice = *filterBankVoices_[i];
+        AudioSpan<float> voiceSpan = AudioSpan<float>(filterBankBuffers_[i]).first(numFrames);
+        voice.finishBlock(voiceSpan, filterDuration);
+        finishVoice(voice, voiceSpan, numFrames);
+    }
+
+    filterBankVoices_.clear();
+}
+
 void Synth::Impl::applySettingsPerVoice()
 {
     for (auto& voice : voiceManager_) {
@@ -2098,12 +3339,78 @@ uint32_t Synth::getPreloadSize() const noexcept
     return impl.resources_.getFilePool().getPreloadSize();
 }
 
+void Synth::enableSampleStreaming() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSampleStreaming(true);
+}
+
+void Synth::disableSampleStreaming() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSampleStreaming(false);
+}
+
+void Synth::setSampleFormat(SampleFormat format) noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSampleFormat(static_cast<sfz::SampleFormat>(format));
+}
+
+Synth::SampleFormat Synth::getSampleFormat() const noexcept
+{
+    Impl& impl = *impl_;
+    return static_cast<SampleFormat>(impl.resources_.getFilePool().getSampleFormat());
+}
+
+void Synth::enableCompressedSampleStorage() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setCompressedStorage(true);
+}
+
+void Synth::disableCompressedSampleStorage() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setCompressedStorage(false);
+}
+
+void Synth::enableSampleSharing() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSharedSampleStore(true);
+}
+
+void Synth::disableSampleSharing() noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSharedSampleStore(false);
+}
+
+void Synth::setPreloadCacheDirectory(const fs::path& directory) noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setPreloadCacheDirectory(directory);
+}
+
+const fs::path& Synth::getPreloadCacheDirectory() const noexcept
+{
+    const Impl& impl = *impl_;
+    return impl.resources_.getFilePool().getPreloadCacheDirectory();
+}
+
 void Synth::enableFreeWheeling() noexcept
 {
     Impl& impl = *impl_;
     SynthConfig& synthConfig = impl.resources_.getSynthConfig();
     if (!synthConfig.freeWheeling) {
         synthConfig.freeWheeling = true;
+        for (const auto& buses : impl.effectBuses_) {
+            for (const auto& bus : buses) {
+                if (bus)
+                    bus->setFreewheeling(true);
+            }
+        }
         DBG("Enabling freewheeling");
     }
 }
@@ -2113,6 +3420,12 @@ void Synth::disableFreeWheeling() noexcept
     SynthConfig& synthConfig = impl.resources_.getSynthConfig();
     if (synthConfig.freeWheeling) {
         synthConfig.freeWheeling = false;
+        for (const auto& buses : impl.effectBuses_) {
+            for (const auto& bus : buses) {
+                if (bus)
+                    bus->setFreewheeling(false);
+            }
+        }
         DBG("Disabling freewheeling");
     }
 }
@@ -2181,6 +3494,7 @@ const Synth::CallbackBreakdown& Synth::getCallbackBreakdown() const noexcept
 
 void Synth::allSoundOff() noexcept
 {
+    ScopedRealtime realtime;
     Impl& impl = *impl_;
     for (auto& voice : impl.voiceManager_)
         voice.reset();
@@ -28,6 +28,10 @@ class EffectBus;
 struct Region;
 struct Layer;
 class Voice;
+class EventQueue;
+class Profiler;
+class LatencyMonitor;
+struct QueuedEvent;
 
 using CCNamePair = std::pair<uint16_t, std::string>;
 using NoteNamePair = std::pair<uint8_t, std::string>;
@@ -91,6 +95,14 @@ public:
         ProcessLive,
         ProcessFreewheeling,
     };
+    /**
+     * @brief Format of the preloaded samples in memory
+     */
+    enum SampleFormat {
+        SampleFloat,
+        SampleInt16,
+        SampleInt24,
+    };
 
     /**
      * @brief Empties the current regions and load a new SFZ file into the synth.
@@ -119,6 +131,52 @@ public:
      *         @true otherwise.
      */
     bool loadSfzString(const fs::path& path, absl::string_view text);
+    /**
+     * @brief Load a new SFZ file in the background, while the current
+     * instrument keeps playing.
+     *
+     * The instrument is loaded into a separate state, which takes the current
+     * engine settings and MIDI state. The audio thread adopts it at the end of
+     * the next call to renderBlock(), and the previous state is destroyed on a
+     * background thread. If a staged state was not adopted yet, it is replaced.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function may run concurrently with the audio thread,
+     *   but it must not be called from concurrent threads.
+     *
+     * @param file
+     * @return @false if the file was not found or no regions were loaded,
+     *         in which case the current instrument is kept.
+     */
+    bool stageSfzFile(const fs::path& file);
+    /**
+     * @brief Load a new SFZ document from memory in the background, while the
+     * current instrument keeps playing.
+     *
+     * This is similar to stageSfzFile() in functionality.
+     *
+     * @since 1.3.0
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function may run concurrently with the audio thread,
+     *   but it must not be called from concurrent threads.
+     *
+     * @param path The virtual path of the SFZ file, as string.
+     * @param text The contents of the virtual SFZ file.
+     *
+     * @return @false if no regions were loaded,
+     *         @true otherwise.
+     */
+    bool stageSfzString(const fs::path& path, absl::string_view text);
+    /**
+     * @brief Check whether a staged instrument is waiting to be adopted by
+     * the audio thread.
+     *
+     * @since 1.3.0
+     */
+    bool hasStagedState() const noexcept;
     /**
      * @brief Sets the tuning from a Scala file loaded from the file system.
      *
@@ -189,6 +247,16 @@ public:
      * @return int
      */
     int getNumCurves() const noexcept;
+    /**
+     * @brief Get the number of stereo outputs used by the current instrument,
+     *        which is one more than the highest `output` opcode value.
+     *
+     * Render with at least this many stereo pairs to keep the outputs apart,
+     * since the extra outputs wrap around the buffer channels otherwise.
+     *
+     * @return int
+     */
+    int getNumOutputs() const noexcept;
     /**
      * @brief Export a MIDI Name document describing the loaded instrument
      */
@@ -334,6 +402,21 @@ public:
      * @param quality the quality setting
      */
     void setOscillatorQuality(ProcessMode mode, int quality);
+    /**
+     * @brief Get the default filter quality for the given mode.
+     *
+     * @param mode the processing mode
+     *
+     * @return the quality setting
+     */
+    int getFilterQuality(ProcessMode mode);
+    /**
+     * @brief Set the default filter quality for the given mode.
+     *
+     * @param mode the processing mode
+     * @param quality the quality setting
+     */
+    void setFilterQuality(ProcessMode mode, int quality);
     /**
      * @brief Set whether pressing the sustain pedal cancels the releases
      *
@@ -537,6 +620,36 @@ public:
      */
     void playbackState(int delay, int playbackState);
 
+    /**
+     * @brief Post a MIDI message to the synth, from any thread. The message is
+     * queued without locking, and dispatched at its frame by the call to
+     * renderBlock() which covers it.
+     *
+     * @param frame the frame at which the event occurs, on the clock given by
+     *              getFrameTime(); a negative value means at the start of the
+     *              next block.
+     * @param data a MIDI 1.0 channel voice message; the channel is ignored.
+     * @param size the size of the message
+     * @return false if the message is not supported or the queue is full
+     */
+    bool postMidiEvent(int64_t frame, const uint8_t* data, size_t size) noexcept;
+    /**
+     * @brief Post a high precision CC event to the synth, from any thread.
+     * The event is queued as in postMidiEvent().
+     *
+     * @param frame the frame at which the event occurs, as in postMidiEvent()
+     * @param ccNumber the cc number
+     * @param normValue the normalized cc value, in domain 0 to 1
+     * @return false if the queue is full
+     */
+    bool postHdcc(int64_t frame, int ccNumber, float normValue) noexcept;
+    /**
+     * @brief Get the frame at which the next call to renderBlock() starts, on
+     * the clock of the posted events. The clock starts at 0 and advances by
+     * the size of each rendered block. This can be called from any thread.
+     */
+    int64_t getFrameTime() const noexcept;
+
     /**
      * @brief Render an block of audio data in the buffer. This call will reset
      * the synth in its waiting state for the next batch of events. The size of
@@ -580,6 +693,94 @@ public:
      */
     void setNumVoices(int numVoices) noexcept;
 
+    /**
+     * @brief Get the number of threads which render the voices.
+     *
+     * @return int
+     */
+    int getNumRenderThreads() const noexcept;
+    /**
+     * @brief Change the number of threads which render the voices.
+     * With 1 thread, which is the default, all voices are rendered by the
+     * thread calling renderBlock(). With more, the active voices are spread
+     * over a pool of real-time worker threads, the thread calling renderBlock()
+     * being one of them. Voices of a same region are always rendered by a same
+     * worker. The summing order of the voices then changes from one block to
+     * the next, so the output may differ from the single-threaded one by
+     * rounding errors.
+     * This function starts and stops threads; call it out of the RT thread.
+     *
+     * @param numThreads between 1 and config::maxRenderThreads
+     */
+    void setNumRenderThreads(int numThreads) noexcept;
+
+    /**
+     * @brief Get the number of frames rendered at a time within a block.
+     *
+     * @return int 0 if the blocks are rendered at once
+     */
+    int getRenderQuantum() const noexcept;
+    /**
+     * @brief Render the blocks by sub-blocks of a given number of frames.
+     * The events of the block are dispatched at the start of the sub-block
+     * which contains them, so the timing stays sample-accurate, while the
+     * voices process fewer frames at a time. This keeps their working buffers
+     * small with large blocks, as in offline rendering.
+     *
+     * @param numFrames the size of the sub-blocks, up to
+     *                  config::maxRenderQuantum; 0 disables the sub-blocks
+     */
+    void setRenderQuantum(int numFrames) noexcept;
+
+    /**
+     * @brief Process the effect buses concurrently on the render threads.
+     * The buses of all the outputs are processed as separate tasks, then
+     * mixed into the outputs in the usual order, so the output is identical
+     * to the serial processing. This only has an effect with more than one
+     * render thread.
+     */
+    void enableParallelEffects() noexcept;
+
+    /**
+     * @brief Process the effect buses one after the other on the thread
+     * calling renderBlock(). This is the default.
+     */
+    void disableParallelEffects() noexcept;
+
+    /**
+     * @brief Start recording the timings of each render cycle, per stage and
+     * per voice, along with the region, sample quality and number of
+     * filters, EQs and LFOs of the voices. The history of the last cycles
+     * can be read with getProfiler(), or through the `/profile/...` messages.
+     * This allocates the history; call it out of the RT thread.
+     */
+    void enableProfiling();
+
+    /**
+     * @brief Stop recording the timings and release the history.
+     * Call it out of the RT thread.
+     */
+    void disableProfiling();
+
+    /**
+     * @brief Get the profiler which holds the timings of the last cycles.
+     * It can be read from any thread.
+     */
+    const Profiler& getProfiler() const noexcept;
+
+    /**
+     * @brief Get the monitor which holds the histogram of the render times
+     * of the blocks, relative to their duration, and the last deadline
+     * misses. It is always on, and can be read from any thread.
+     */
+    const LatencyMonitor& getLatencyMonitor() const noexcept;
+
+    /**
+     * @brief Forget the render times and deadline misses recorded so far.
+     * This can be called from any thread.
+     */
+    void resetLatencyStats() noexcept;
+
     /**
      * @brief Set the preloaded file size.
      * This function takes a lock and disables the callback; prefer calling
@@ -598,6 +799,94 @@ public:
      */
     uint32_t getPreloadSize() const noexcept;
 
+    /**
+     * @brief Stream the samples which do not fit in the preload from disk,
+     * through a fixed-size ring buffer per voice, instead of loading them whole
+     * in memory. The memory use then depends on the number of playing voices
+     * rather than on the size of the instrument. Regions whose loop moves
+     * with CCs are still loaded whole.
+     * This only affects the voices started afterwards.
+     */
+    void enableSampleStreaming() noexcept;
+
+    /**
+     * @brief Load the samples which do not fit in the preload whole in memory
+     * when they are played. This is the default.
+     */
+    void disableSampleStreaming() noexcept;
+
+    /**
+     * @brief Keep the samples in memory as they are stored on disk, for
+     * example in FLAC or WavPack, instead of decoding them whole. Only the
+     * preload is decoded; the rest of the samples is decoded from memory
+     * ahead of the playhead of each voice, through the ring buffers of the
+     * sample streaming. The instruments are then held in RAM at the size of
+     * their files. Regions whose loop moves with CCs are still decoded whole
+     * when played.
+     * This reloads the preloaded samples.
+     */
+    void enableCompressedSampleStorage() noexcept;
+
+    /**
+     * @brief Decode the samples in memory as they are loaded. This is the
+     * default.
+     */
+    void disableCompressedSampleStorage() noexcept;
+
+    /**
+     * @brief Set the format in which the preloaded samples are kept in
+     * memory. The integer formats take half or three quarters of the memory
+     * of the floats, and the voices convert them as they interpolate. The
+     * samples are rounded to the format, so the 16-bit format is exact for
+     * 16-bit sources only. The samples loaded whole or streamed while
+     * playing are still decoded to float.
+     * This reloads the preloaded samples.
+     *
+     * @param format
+     */
+    void setSampleFormat(SampleFormat format) noexcept;
+
+    /**
+     * @brief Get the format of the preloaded samples in memory.
+     */
+    SampleFormat getSampleFormat() const noexcept;
+
+    /**
+     * @brief Share the preloaded samples, and the files loaded whole for
+     * the wavetables and the convolutions, with the other synths of the
+     * process which enable the sharing. A sample which another synth holds
+     * with enough preloaded frames in the same format is not read again, so
+     * the memory depends on the number of distinct samples rather than on
+     * the number of synths. Each synth still loads and frees the rest of the
+     * samples on its own while playing.
+     * This only affects the samples loaded afterwards.
+     */
+    void enableSampleSharing() noexcept;
+
+    /**
+     * @brief Keep the samples of this synth to itself. This is the default.
+     */
+    void disableSampleSharing() noexcept;
+
+    /**
+     * @brief Set the directory of the persistent preload cache.
+     * The cache keeps the preloaded data and the information of the samples
+     * across sessions, so that they are not decoded again when loading an
+     * instrument. The cache files are checked against the path, size and
+     * modification time of the samples. An empty path disables the cache,
+     * which is the default.
+     * This only affects the instruments loaded afterwards.
+     *
+     * @param directory
+     */
+    void setPreloadCacheDirectory(const fs::path& directory) noexcept;
+
+    /**
+     * @brief Get the directory of the persistent preload cache, empty if the
+     * cache is disabled.
+     */
+    const fs::path& getPreloadCacheDirectory() const noexcept;
+
     /**
      * @brief Gets the number of allocated buffers.
      *
@@ -742,7 +1031,23 @@ public:
 
     struct Impl;
 private:
+    struct StagedState;
+    struct StateExchange;
+    void prepareStagingSynth(Synth& staging, StagedState& state) const;
+    void publishStagedState(std::unique_ptr<StagedState> state);
+    bool fadeOutForStagedState(AudioSpan<float> buffer) noexcept;
+    bool adoptStagedState() noexcept;
+    template <class Setter>
+    void changeSetting(const Setter& setter);
+    void renderCurrentState(AudioSpan<float> buffer) noexcept;
+    void dispatchQueuedEvent(const QueuedEvent& event, int delay) noexcept;
+    void dispatchDeferredEvents(int start, int numFrames, bool lastSubBlock) noexcept;
+
     std::unique_ptr<Impl> impl_;
+    std::unique_ptr<StateExchange> stateExchange_;
+    std::unique_ptr<EventQueue> eventQueue_;
+    std::unique_ptr<LatencyMonitor> latencyMonitor_;
+    std::unique_ptr<Profiler> profiler_;
 
     LEAK_DETECTOR(Synth);
 };
@@ -19,6 +19,9 @@ struct SynthConfig
     int liveOscillatorQuality { Default::oscillatorQuality };
     int freeWheelingOscillatorQuality { Default::freewheelingOscillatorQuality };
 
+    int liveFilterQuality { Default::filterQuality };
+    int freeWheelingFilterQuality { Default::freewheelingFilterQuality };
+
     int currentSampleQuality() const noexcept
     {
         return freeWheeling ? freeWheelingSampleQuality : liveSampleQuality;
@@ -29,6 +32,11 @@ struct SynthConfig
         return freeWheeling ? freeWheelingOscillatorQuality : liveOscillatorQuality;
     }
 
+    int currentFilterQuality() const noexcept
+    {
+        return freeWheeling ? freeWheelingFilterQuality : liveFilterQuality;
+    }
+
     bool sustainCancelsRelease { Default::sustainCancelsRelease };
 };
 }
@@ -41,6 +41,10 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/freewheeling_sample_quality", "i") { m.set(&SynthConfig::freeWheelingSampleQuality, Default::sampleQuality); } break;
         MATCH("/freewheeling_oscillator_quality", "") { m.reply(&SynthConfig::freeWheelingOscillatorQuality); } break;
         MATCH("/freewheeling_oscillator_quality", "i") { m.set(&SynthConfig::freeWheelingOscillatorQuality, Default::oscillatorQuality); } break;
+        MATCH("/filter_quality", "") { m.reply(&SynthConfig::liveFilterQuality); } break;
+        MATCH("/filter_quality", "i") { m.set(&SynthConfig::liveFilterQuality, Default::filterQuality); } break;
+        MATCH("/freewheeling_filter_quality", "") { m.reply(&SynthConfig::freeWheelingFilterQuality); } break;
+        MATCH("/freewheeling_filter_quality", "i") { m.set(&SynthConfig::freeWheelingFilterQuality, Default::filterQuality); } break;
         //----------------------------------------------------------------------
         MATCH("/key/slots", "") { m.reply(impl.keySlots_); } break;
         MATCH("/key&/label", "") { if (auto k = m.sindex(0)) m.reply(impl.getKeyLabel(*k)); } break;
@@ -121,7 +125,7 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/pitch_keycenter", "") { m.reply(&Region::pitchKeycenter); } break;
         MATCH("/region&/pitch_keycenter", "i") { m.set(&Region::pitchKeycenter, Default::key); } break;
         MATCH("/region&/vel_range", "") { m.reply(&Region::velocityRange); } break;
-        MATCH("/region&/vel_range", "ff") { m.set(&Region::velocityRange); } break;
+        MATCH("/region&/vel_range", "ff") { m.set(&Region::velocityRange); m.refreshActivation(); } break;
         MATCH("/region&/bend_range", "") { m.reply(&Region::bendRange); } break;
         MATCH("/region&/bend_range", "ff") { m.set(&Region::bendRange); } break;
         MATCH("/region&/program_range", "") { m.reply(&Region::programRange); } break;
@@ -158,7 +162,7 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/sw_previous", "i") { m.set(&Region::previousKeyswitch, Default::key); } break;
         MATCH("/region&/sw_previous", "s") { m.set(&Region::previousKeyswitch, Default::key); } break;
         MATCH("/region&/sw_vel", "") { m.reply(&Region::velocityOverride); } break;
-        MATCH("/region&/sw_vel", "s") { m.set(&Region::velocityOverride, Default::velocityOverride); } break;
+        MATCH("/region&/sw_vel", "s") { m.set(&Region::velocityOverride, Default::velocityOverride); m.refreshActivation(); } break;
         MATCH("/region&/chanaft_range", "") { m.reply(&Region::aftertouchRange); } break;
         MATCH("/region&/chanaft_range", "ff") { m.set(&Region::aftertouchRange); } break;
         MATCH("/region&/polyaft_range", "") { m.reply(&Region::polyAftertouchRange); } break;
@@ -168,9 +172,9 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/rand_range", "") { m.reply(&Region::randRange); } break;
         MATCH("/region&/rand_range", "ff") { m.set(&Region::randRange, Default::loNormalized, Default::hiNormalized); } break;
         MATCH("/region&/seq_length", "") { m.reply(&Region::sequenceLength); } break;
-        MATCH("/region&/seq_length", "i") { m.set(&Region::sequenceLength, Default::sequence); } break;
+        MATCH("/region&/seq_length", "i") { m.set(&Region::sequenceLength, Default::sequence); m.refreshActivation(); } break;
         MATCH("/region&/seq_position", "") { m.reply(&Region::sequencePosition); } break;
-        MATCH("/region&/seq_position", "i") { m.set(&Region::sequencePosition, Default::sequence); } break;
+        MATCH("/region&/seq_position", "i") { m.set(&Region::sequencePosition, Default::sequence); m.refreshActivation(); } break;
         MATCH("/region&/trigger", "") { m.reply(&Region::trigger); } break;
         MATCH("/region&/trigger", "s") { m.set(&Region::trigger, Default::trigger); } break;
         MATCH("/region&/start_cc_range&", "") { m.reply(&Region::ccTriggers, false); } break;
@@ -461,6 +465,8 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/region&/oscillator_phase", "f") { m.set(&Region::oscillatorPhase, Default::oscillatorPhase); } break;
         MATCH("/region&/oscillator_quality", "") { m.reply(&Region::oscillatorQuality); } break;
         MATCH("/region&/oscillator_quality", "i") { m.set(&Region::oscillatorQuality, Default::oscillatorQuality); } break;
+        MATCH("/region&/filter_quality", "") { m.reply(&Region::filterQuality); } break;
+        MATCH("/region&/filter_quality", "i") { m.set(&Region::filterQuality, Default::filterQuality); } break;
         MATCH("/region&/oscillator_mode", "") { m.reply(&Region::oscillatorMode); } break;
         MATCH("/region&/oscillator_mode", "i") { m.set(&Region::oscillatorMode, Default::oscillatorMode); } break;
         MATCH("/region&/oscillator_multi", "") { m.reply(&Region::oscillatorMulti); } break;
@@ -575,6 +581,23 @@ void sfz::Synth::dispatchMessage(Client& client, int delay, const char* path, co
         MATCH("/voice&/trigger_type", "") { m.reply(&TriggerEvent::type); } break;
         MATCH("/voice&/remaining_delay", "") { m.reply(&Voice::getRemainingDelay); } break;
         MATCH("/voice&/source_position", "") { m.reply(&Voice::getSourcePosition); } break;
+        //----------------------------------------------------------------------
+        MATCH("/profile/enabled", "") { m.reply(profiler_->isEnabled()); } break;
+        MATCH("/profile/num_blocks", "") { m.reply(profiler_->getNumBlocks()); } break;
+        MATCH("/profile/clear", "") { profiler_->clear(); } break;
+        MATCH("/profile/block&", "") { if (auto block = m.getProfiledBlock()) m.reply(*block); } break;
+        MATCH("/profile/block&/voice&", "") { if (auto voice = m.getProfiledVoice()) m.reply(*voice); } break;
+        //----------------------------------------------------------------------
+        MATCH("/latency/num_blocks", "") { m.reply(latencyMonitor_->getNumBlocks()); } break;
+        MATCH("/latency/num_deadline_misses", "") { m.reply(latencyMonitor_->getNumDeadlineMisses()); } break;
+        MATCH("/latency/num_stream_underruns", "") { m.reply(latencyMonitor_->getNumStreamUnderruns()); } break;
+        MATCH("/latency/max_load", "") { m.reply(latencyMonitor_->getMaxLoad()); } break;
+        MATCH("/latency/last_load", "") { m.reply(latencyMonitor_->getLastLoad()); } break;
+        MATCH("/latency/num_bins", "") { m.reply(LatencyMonitor::numBins); } break;
+        MATCH("/latency/bin_width", "") { m.reply(LatencyMonitor::binWidth); } break;
+        MATCH("/latency/bin&", "") { if (auto count = m.getLatencyBin(*latencyMonitor_)) m.reply(*count); } break;
+        MATCH("/latency/deadline_miss&", "") { if (auto miss = m.getDeadlineMiss(*latencyMonitor_)) m.reply(*miss); } break;
+        MATCH("/latency/reset", "") { latencyMonitor_->reset(); } break;
         #undef MATCH
     }
 }
@@ -20,6 +20,8 @@
 #include "SynthConfig.h"
 #include "TriggerEvent.h"
 #include "SynthPrivate.h"
+#include "Profiler.h"
+#include "LatencyMonitor.h"
 #include "utility/Size.h"
 #include <type_traits>
 #include <invoke.hpp/invoke.hpp>
@@ -124,6 +126,25 @@ public:
         else
             client.receive<'h'>(delay, path, static_cast<long int>(value));
     }
+    void reply(const BlockProfile& block)
+    {
+        client.receive<'h', 'i', 'i', 'f', 'f', 'f'>(delay, path,
+            static_cast<long int>(block.index), static_cast<int>(block.numFrames),
+            static_cast<int>(block.numVoices), block.dispatch, block.renderMethod, block.effects);
+    }
+    void reply(const VoiceProfile& voice)
+    {
+        client.receive<'i', 'i', 'i', 'i', 'i', 'i', 'f', 'f', 'f', 'f'>(delay, path,
+            voice.voiceId, voice.regionId, voice.sampleQuality,
+            voice.numFilters, voice.numEQs, voice.numLFOs,
+            voice.data, voice.amplitude, voice.filters, voice.panning);
+    }
+    void reply(const DeadlineMiss& miss)
+    {
+        client.receive<'h', 'f', 'f', 'i', 'i'>(delay, path,
+            static_cast<long int>(miss.block), miss.duration, miss.budget,
+            static_cast<int>(miss.numVoices), static_cast<int>(miss.numEvents));
+    }
     template <size_t N>
     void reply(const BitArray<N>& array)
     {
@@ -589,6 +610,13 @@ public:
         return &layer.getRegion();
     }
 
+    // Update the note on activation index after changing the velocity or
+    // sequence opcodes of a region
+    void refreshActivation()
+    {
+        impl.activationIndex_.refreshLayer(indices[0]);
+    }
+
     FilterDescription* getFilter(Region& region, absl::optional<unsigned> index = {})
     {
         const auto idx = index.value_or(indices[1]);
@@ -663,6 +691,41 @@ public:
         return &voice;
     }
 
+    absl::optional<BlockProfile> getProfiledBlock()
+    {
+        BlockProfile block;
+        if (!impl.profiler_->getBlock(indices[0], block))
+            return {};
+
+        return block;
+    }
+
+    absl::optional<VoiceProfile> getProfiledVoice()
+    {
+        VoiceProfile voice;
+        if (!impl.profiler_->getVoice(indices[0], indices[1], voice))
+            return {};
+
+        return voice;
+    }
+
+    absl::optional<uint64_t> getLatencyBin(const LatencyMonitor& monitor)
+    {
+        if (indices[0] >= LatencyMonitor::numBins)
+            return {};
+
+        return monitor.getBinCount(indices[0]);
+    }
+
+    absl::optional<DeadlineMiss> getDeadlineMiss(const LatencyMonitor& monitor)
+    {
+        DeadlineMiss miss;
+        if (!monitor.getDeadlineMiss(indices[0], miss))
+            return {};
+
+        return miss;
+    }
+
     // Helpers to get and check the values of the indices
     template <class T = unsigned>
     absl::optional<T> index(int i)
@@ -2,10 +2,14 @@
 
 #include "Synth.h"
 #include "Effects.h"
+#include "FilterBank.h"
 #include "SisterVoiceRing.h"
 #include "TriggerEvent.h"
 #include "VoiceManager.h"
 #include "Layer.h"
+#include "LayerActivationIndex.h"
+#include "RTWorkerPool.h"
+#include "Profiler.h"
 #include "BitArray.h"
 #include "modulations/sources/ADSREnvelope.h"
 #include "modulations/sources/Controller.h"
@@ -15,6 +19,7 @@
 #include "modulations/sources/LFO.h"
 #include "parser/Parser.h"
 #include "parser/ParserListener.h"
+#include <absl/container/flat_hash_set.h>
 
 namespace sfz {
 
@@ -102,6 +107,33 @@ struct Synth::Impl final: public Parser::Listener {
      * @param regionOpcodes the opcodes that are specific to the region
      */
     void buildRegion(const std::vector<Opcode>& regionOpcodes);
+
+    /**
+     * @brief Register a built region in the current region set, the keyswitch
+     * lists and the polyphony groups.
+     *
+     * @param layer the layer of the region
+     */
+    void registerRegion(Layer& layer);
+
+    /**
+     * @brief Compute the signature of the opcodes which define a region,
+     * including the inherited ones and the control state.
+     *
+     * @param regionOpcodes the opcodes that are specific to the region
+     */
+    uint64_t computeLayerSignature(const std::vector<Opcode>& regionOpcodes) const noexcept;
+
+    /**
+     * @brief When reloading, take the layer which had the same number in the
+     * previous load if it was built from the same opcodes.
+     *
+     * @param regionNumber the number of the region to build
+     * @param signature the signature of the region opcodes
+     * @param regionOpcodes the opcodes that are specific to the region
+     * @return the reused layer, or null if it must be built again
+     */
+    Layer* reuseLayer(int regionNumber, uint64_t signature, const std::vector<Opcode>& regionOpcodes);
     /**
      * @brief Resets and possibly changes the number of voices (polyphony) in
      * the synth.
@@ -109,6 +141,18 @@ struct Synth::Impl final: public Parser::Listener {
      * @param numVoices
      */
     void resetVoices(int numVoices);
+    /**
+     * @brief Resize the voices, buses and buffers for a block size.
+     *
+     * @param samplesPerBlock
+     */
+    void setSamplesPerBlock(int samplesPerBlock) noexcept;
+    /**
+     * @brief Set the sample rate of the voices, buses and filters.
+     *
+     * @param sampleRate
+     */
+    void setSampleRate(float sampleRate) noexcept;
     /**
      * @brief Make the stored settings take effect in all the voices
      */
@@ -267,6 +311,114 @@ struct Synth::Impl final: public Parser::Listener {
      */
     void resetCallbackBreakdown();
 
+    /**
+     * @brief Record the timings of a voice after it rendered, in the profiler
+     */
+    void profileVoice(const Voice& voice) noexcept;
+
+    /**
+     * @brief Resize the per-task buffers used by the multithreaded voice
+     * rendering, after a change of the workers, voices, buses or block size.
+     */
+    void updateRenderTaskBuffers();
+
+    /**
+     * @brief Render the voices on other workers, or on the calling thread
+     * only if null.
+     */
+    void setRenderWorkers(std::shared_ptr<RTWorkerPool> workers);
+
+    /**
+     * @brief Collect the active voices into render tasks, one per region.
+     *
+     * @return the number of tasks
+     */
+    unsigned prepareRenderTasks() noexcept;
+
+    /**
+     * @brief Collect the effect buses of all the outputs into effect tasks,
+     * one per bus.
+     *
+     * @return the number of tasks, or 0 if they must be processed serially
+     */
+    unsigned prepareEffectTasks() noexcept;
+
+    /**
+     * @brief Render the voices of a render task and mix them into the buffer
+     * of the task.
+     *
+     * @param taskIndex
+     * @param workerIndex
+     * @param tempSpan a temporary stereo buffer for worker 0
+     * @param numFrames
+     */
+    void renderVoiceTask(unsigned taskIndex, unsigned workerIndex, AudioSpan<float> tempSpan, size_t numFrames) noexcept;
+
+    /**
+     * @brief Send a rendered voice to the effect buses, record its timings,
+     * and clean it up if it has finished.
+     *
+     * @param voice
+     * @param voiceSpan the block of the voice
+     * @param numFrames
+     */
+    void finishVoice(Voice& voice, AudioSpan<float> voiceSpan, size_t numFrames) noexcept;
+
+    /**
+     * @brief Resize the filter bank and its buffers, after a change of the
+     * sample rate or block size.
+     */
+    void updateFilterBank();
+
+    /**
+     * @brief Get the buffer of the next voice to queue into the filter bank.
+     *
+     * @param numFrames
+     */
+    AudioSpan<float> getFilterBankSpan(size_t numFrames) noexcept;
+
+    /**
+     * @brief Process the filter bank, and finish the voices queued into it.
+     *
+     * @param numFrames
+     */
+    void processFilterBank(size_t numFrames) noexcept;
+
+    /**
+     * @brief An event which falls past the first render quantum of the block,
+     * kept until the sub-block which contains it gets rendered.
+     */
+    struct DeferredEvent {
+        enum class Type : uint8_t {
+            NoteOn,
+            NoteOff,
+            Controller,
+            AutomatedController,
+            ProgramChange,
+            PitchWheel,
+            ChannelAftertouch,
+            PolyAftertouch,
+            Tempo,
+            TimeSignature,
+            TimePosition,
+            PlaybackState,
+        };
+        int delay;
+        Type type;
+        int number;
+        double value;
+    };
+
+    /**
+     * @brief Defer an event if the block gets rendered by sub-blocks, and the
+     * event falls past the first one.
+     *
+     * @param delay the delay of the event, which gets clamped to the first
+     *              sub-block if the event cannot be deferred
+     * @return true if the event was deferred, false if it must be dispatched now
+     */
+    bool deferEvent(int& delay, DeferredEvent::Type type, int number = 0, double value = 0.0) noexcept;
+
     int numGroups_ { 0 };
     int numMasters_ { 0 };
     int numOutputs_ { 1 };
@@ -310,6 +462,7 @@ struct Synth::Impl final: public Parser::Listener {
     LayerViewVector previousKeyswitchLists_;
     std::array<LayerViewVector, 128> noteActivationLists_;
     std::array<LayerViewVector, config::numCCs> ccActivationLists_;
+    LayerActivationIndex activationIndex_;
 
     // Effect factory and buses
     EffectFactory effectFactory_;
@@ -319,6 +472,23 @@ struct Synth::Impl final: public Parser::Listener {
     void initEffectBuses();
     void addEffectBusesIfNecessary(uint16_t output);
 
+    // Multithreaded voice rendering
+    std::shared_ptr<RTWorkerPool> renderWorkers_; // shared with the staged states
+    VoiceViewVector renderVoices_; // active voices, sorted by region
+    std::vector<unsigned> renderTaskStarts_; // first voice of each task in renderVoices_
+    std::vector<AudioBuffer<float, 2>> renderTaskBuffers_; // the mix of each task, summed in task order
+    bool parallelEffects_ { false };
+    std::vector<EffectBus*> renderEffectBuses_; // the buses of all outputs, as effect tasks
+
+    // Filters of the voices processed together, on the single-threaded path
+    FilterBank filterBank_;
+    std::vector<AudioBuffer<float, 2>> filterBankBuffers_; // one per queued voice
+    VoiceViewVector filterBankVoices_; // the voices queued into the filter bank
+
+    // Sub-block rendering
+    int renderQuantum_ { 0 }; // 0 renders the whole block at once
+    std::vector<DeferredEvent> deferredEvents_;
+
     int samplesPerBlock_ { config::defaultSamplesPerBlock };
     float sampleRate_ { config::defaultSampleRate };
     float volume_ { Default::globalVolume };
@@ -363,6 +533,9 @@ struct Synth::Impl final: public Parser::Listener {
 
     CallbackBreakdown callbackBreakdown_;
     double dispatchDuration_ { 0 };
+    Profiler* profiler_ { nullptr }; // owned by the Synth, which outlives the swaps
+    uint32_t numBlockEvents_ { 0 }; // events dispatched since the last block
+    uint32_t numBlockStreamUnderruns_ { 0 }; // late streams in the voices of the block
 
     std::chrono::time_point<std::chrono::high_resolution_clock> lastGarbageCollection_;
 
@@ -371,6 +544,17 @@ struct Synth::Impl final: public Parser::Listener {
     absl::optional<fs::file_time_type> modificationTime_ { };
     bool reloading { false };
 
+    // Incremental reloading
+    struct LayerSignature {
+        uint64_t opcodes { 0 };
+        uint8_t defaultConnections { 0 }; // default controllers connected on load
+    };
+    std::vector<LayerSignature> layerSignatures_; // indexed by region number
+    std::vector<LayerSignature> previousSignatures_;
+    std::vector<LayerPtr> reusableLayers_; // indexed by region number
+    std::vector<std::string> previousUnknownOpcodes_;
+    absl::flat_hash_set<const Layer*> reusedLayers_;
+
     std::array<float, config::numCCs> defaultCCValues_ { };
     BitArray<config::numCCs> currentUsedCCs_;
     BitArray<config::numCCs> changedCCsThisCycle_;
@@ -66,6 +66,11 @@ public:
      */
     bool shouldReloadScala();
 
+    /**
+     * @brief Exchange the tuning state with another one.
+     */
+    void swap(Tuning& other) noexcept { impl_.swap(other.impl_); }
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
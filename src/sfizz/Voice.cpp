@@ -11,6 +11,7 @@
 #include "Defaults.h"
 #include "EQPool.h"
 #include "FilterPool.h"
+#include "FilterBank.h"
 #include "FlexEnvelope.h"
 #include "Interpolators.h"
 #include "LFO.h"
@@ -62,14 +63,25 @@ struct Voice::Impl
     /**
      * @brief Fill a destination with an interpolated source.
      *
-     * @param source the source sample
+     * @param source the source sample, in any sample format
      * @param dest the destination buffer
      * @param indices the integral parts of the source positions
      * @param coeffs the fractional parts of the source positions
      */
     template <InterpolatorModel M, bool Adding>
     static void fillInterpolated(
-        const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+        const SampleSpan& source, const AudioSpan<float>& dest,
+        absl::Span<const int> indices, absl::Span<const float> coeffs,
+        absl::Span<const float> addingGains);
+
+    /**
+     * @brief Fill a destination with an interpolated source of samples of
+     *        type `T`, which are converted to float as they are read, or
+     *        by chunks of windows for the windowed-sinc models.
+     */
+    template <InterpolatorModel M, bool Adding, class T>
+    static void fillInterpolatedFrom(
+        const AudioSpan<const T>& source, const AudioSpan<float>& dest,
         absl::Span<const int> indices, absl::Span<const float> coeffs,
         absl::Span<const float> addingGains);
 
@@ -85,7 +97,7 @@ struct Voice::Impl
      */
     template <bool Adding>
     static void fillInterpolatedWithQuality(
-        const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+        const SampleSpan& source, const AudioSpan<float>& dest,
         absl::Span<const int> indices, absl::Span<const float> coeffs,
         absl::Span<const float> addingGains, int quality);
 
@@ -129,6 +141,19 @@ struct Voice::Impl
      */
     void panStageMono(AudioSpan<float> buffer) noexcept;
     void panStageStereo(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Compute the pan values of a mono source
+     *
+     * @param panSpan
+     */
+    void panValuesMono(absl::Span<float> panSpan) noexcept;
+    /**
+     * @brief Pan a mono source to stereo
+     *
+     * @param panSpan
+     * @param buffer
+     */
+    void applyPanMono(absl::Span<const float> panSpan, AudioSpan<float> buffer) noexcept;
     /**
      * @brief Amplitude stage for a mono source
      *
@@ -136,6 +161,27 @@ struct Voice::Impl
      */
     void filterStageMono(AudioSpan<float> buffer) noexcept;
     void filterStageStereo(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Queue the filters and EQs into a filter bank, which processes
+     * the channels of the buffer in place later
+     *
+     * @param buffer
+     * @param bank
+     */
+    void filterStageToBank(AudioSpan<float> buffer, FilterBank& bank) noexcept;
+    /**
+     * @brief Fill the buffer with the raw data of the block
+     *
+     * @param buffer
+     * @return false if the voice has nothing to render
+     */
+    bool renderData(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Update the state of the voice after rendering a block
+     *
+     * @param buffer
+     */
+    void endBlock(AudioSpan<float> buffer) noexcept;
     /**
      * @brief Compute the pitch envelope. This envelope is meant to multiply
      * the frequency parameter for each sample (which translates to floating
@@ -185,6 +231,13 @@ struct Voice::Impl
      *
      */
     void updateLoopInformation() noexcept;
+    /**
+     * @brief Start the stream of the promise, if any, over the loop if it
+     * plays past the preload. A loop whose crossfade is too long to be read
+     * from the stream loads the whole file instead.
+     * This requires that the loop information is up to date.
+     */
+    void startStream(FilePool& filePool) noexcept;
 
     /**
      * @brief Check whether the voice is released
@@ -259,6 +312,8 @@ struct Voice::Impl
     } loop_;
 
     FileDataHolder currentPromise_;
+    bool streamLoops_ { false }; // whether the stream plays the loop
+    uint32_t streamLoopExit_ { FileStream::noLoopExit }; // the lap where the stream leaves it
 
     int samplesPerBlock_ { config::defaultSamplesPerBlock };
     float sampleRate_ { config::defaultSampleRate };
@@ -288,6 +343,7 @@ struct Voice::Impl
     float waveRightGain_[config::oscillatorsPerVoice] {};
 
     double dataDuration_;
+    unsigned streamUnderruns_ { 0 }; // in the last block
     double amplitudeDuration_;
     double panningDuration_;
     double filterDuration_;
@@ -478,12 +534,18 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
         impl.setupOscillatorUnison();
     } else {
         FilePool& filePool = resources.getFilePool();
-        impl.currentPromise_ = filePool.getFilePromise(region.sampleId);
+        // The stream follows the loop as long as its bounds are fixed
+        const bool streamable = !region.sampleCount &&
+            (!region.shouldLoop() || (region.loopStartCC.empty() && region.loopEndCC.empty()));
+        impl.currentPromise_ = filePool.getFilePromise(region.sampleId, streamable);
+        if (impl.currentPromise_) {
+            impl.updateLoopInformation();
+            impl.startStream(filePool);
+        }
         if (!impl.currentPromise_) {
             impl.switchState(State::cleanMeUp);
             return false;
         }
-        impl.updateLoopInformation();
         impl.speedRatio_ = static_cast<float>(impl.currentPromise_->information.sampleRate / impl.sampleRate_);
         impl.sourcePosition_ = sampleOffset(region, midiState);
     }
@@ -776,51 +838,139 @@ void Voice::setSamplesPerBlock(int samplesPerBlock) noexcept
 void Voice::renderBlock(AudioSpan<float, 2> buffer) noexcept
 {
     Impl& impl = *impl_;
-    ASSERT(static_cast<int>(buffer.getNumFrames()) <= impl.samplesPerBlock_);
-    buffer.fill(0.0f);
+    if (!impl.renderData(buffer))
+        return;
 
+    if (impl.region_->isStereo()) {
+        impl.ampStageStereo(buffer);
+        impl.panStageStereo(buffer);
+        impl.filterStageStereo(buffer);
+    } else {
+        impl.ampStageMono(buffer);
+        impl.filterStageMono(buffer);
+        impl.panStageMono(buffer);
+    }
+
+    impl.endBlock(buffer);
+}
+
+unsigned Voice::getFilterBankLanes() const noexcept
+{
+    Impl& impl = *impl_;
     const Region* region = impl.region_;
     if (region == nullptr || region->disabled())
-        return;
+        return 0;
 
-    const auto delay = min(static_cast<size_t>(impl.initialDelay_), buffer.getNumFrames());
-    auto delayed_buffer = buffer.subspan(delay);
-    impl.initialDelay_ -= static_cast<int>(delay);
+    const size_t numFilters = region->filters.size();
+    const size_t numEQs = region->equalizers.size();
+    if (numFilters + numEQs == 0 || numFilters + numEQs > FilterBank::numStages)
+        return 0;
 
-    { // Fill buffer with raw data
-        ScopedTiming logger { impl.dataDuration_ };
-        if (region->isOscillator())
-            impl.fillWithGenerator(delayed_buffer);
-        else
-            impl.fillWithData(delayed_buffer);
+    for (size_t i = 0; i < numFilters; ++i) {
+        if (!impl.filters_[i].isBiquad())
+            return 0;
     }
 
-    if (region->isStereo()) {
+    for (size_t i = 0; i < numEQs; ++i) {
+        if (!impl.equalizers_[i].isBiquad())
+            return 0;
+    }
+
+    return region->isStereo() ? 2 : 1;
+}
+
+bool Voice::renderBlockToFilterBank(AudioSpan<float, 2> buffer, FilterBank& bank) noexcept
+{
+    Impl& impl = *impl_;
+    const unsigned numLanes = getFilterBankLanes();
+    if (numLanes == 0 || numLanes > bank.getNumFreeLanes()) {
+        renderBlock(buffer);
+        return false;
+    }
+
+    if (!impl.renderData(buffer))
+        return false;
+
+    if (impl.region_->isStereo()) {
         impl.ampStageStereo(buffer);
         impl.panStageStereo(buffer);
-        impl.filterStageStereo(buffer);
+        impl.filterStageToBank(buffer, bank);
     } else {
         impl.ampStageMono(buffer);
-        impl.filterStageMono(buffer);
-        impl.panStageMono(buffer);
+        impl.filterStageToBank(buffer, bank);
+        // The pan follows the filters; keep its modulation in the unused
+        // right channel until then
+        ScopedTiming logger { impl.panningDuration_ };
+        impl.panValuesMono(buffer.getSpan(1));
+    }
+
+    return true;
+}
+
+void Voice::finishBlock(AudioSpan<float, 2> buffer, double filterDuration) noexcept
+{
+    Impl& impl = *impl_;
+    impl.filterDuration_ += filterDuration;
+
+    if (!impl.region_->isStereo()) {
+        ScopedTiming logger { impl.panningDuration_, ScopedTiming::Operation::addToDuration };
+        const auto rightBuffer = buffer.getSpan(1);
+        auto panSpan = impl.resources_.getBufferPool().getBuffer(buffer.getNumFrames());
+        if (panSpan) {
+            copy<float>(rightBuffer, *panSpan);
+            impl.applyPanMono(*panSpan, buffer);
+        } else {
+            fill(rightBuffer, 0.0f);
+        }
     }
 
+    impl.endBlock(buffer);
+}
+
+bool Voice::Impl::renderData(AudioSpan<float> buffer) noexcept
+{
+    ASSERT(static_cast<int>(buffer.getNumFrames()) <= samplesPerBlock_);
+    buffer.fill(0.0f);
+    streamUnderruns_ = 0;
+
+    const Region* region = region_;
+    if (region == nullptr || region->disabled())
+        return false;
+
+    const auto delay = min(static_cast<size_t>(initialDelay_), buffer.getNumFrames());
+    auto delayed_buffer = buffer.subspan(delay);
+    initialDelay_ -= static_cast<int>(delay);
+
+    { // Fill buffer with raw data
+        ScopedTiming logger { dataDuration_ };
+        if (region->isOscillator())
+            fillWithGenerator(delayed_buffer);
+        else
+            fillWithData(delayed_buffer);
+    }
+
+    return true;
+}
+
+void Voice::Impl::endBlock(AudioSpan<float> buffer) noexcept
+{
+    const Region* region = region_;
     if (!region->flexAmpEG) {
-        if (!impl.egAmplitude_.isSmoothing())
-            impl.switchState(State::cleanMeUp);
+        if (!egAmplitude_.isSmoothing())
+            switchState(State::cleanMeUp);
     }
     else {
-        if (impl.flexEGs_[*region->flexAmpEG]->isFinished())
-            impl.switchState(State::cleanMeUp);
+        if (flexEGs_[*region->flexAmpEG]->isFinished())
+            switchState(State::cleanMeUp);
     }
 
-    impl.powerFollower_.process(buffer);
+    powerFollower_.process(buffer);
 
-    impl.age_ += buffer.getNumFrames();
-    if (impl.triggerDelay_) {
+    age_ += buffer.getNumFrames();
+    if (triggerDelay_) {
         // Should be OK but just in case;
-        impl.age_ = min(impl.age_ - *impl.triggerDelay_, 0);
-        impl.triggerDelay_ = absl::nullopt;
+        age_ = min(age_ - *triggerDelay_, 0);
+        triggerDelay_ = absl::nullopt;
     }
 
 #if 0
@@ -959,8 +1109,6 @@ void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
     ScopedTiming logger { panningDuration_ };
 
     const auto numSamples = buffer.getNumFrames();
-    const auto leftBuffer = buffer.getSpan(0);
-    const auto rightBuffer = buffer.getSpan(1);
 
     BufferPool& bufferPool = resources_.getBufferPool();
 
@@ -968,18 +1116,31 @@ void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
     if (!modulationSpan)
         return;
 
+    panValuesMono(*modulationSpan);
+    applyPanMono(*modulationSpan, buffer);
+}
+
+void Voice::Impl::panValuesMono(absl::Span<float> panSpan) noexcept
+{
     ModMatrix& mm = resources_.getModMatrix();
 
+    fill(panSpan, region_->pan);
+    if (float* mod = mm.getModulation(panTarget_)) {
+        for (size_t i = 0; i < panSpan.size(); ++i)
+            panSpan[i] += mod[i];
+    }
+}
+
+void Voice::Impl::applyPanMono(absl::Span<const float> panSpan, AudioSpan<float> buffer) noexcept
+{
+    const auto leftBuffer = buffer.getSpan(0);
+    const auto rightBuffer = buffer.getSpan(1);
+
     // Prepare for stereo output
     copy<float>(leftBuffer, rightBuffer);
 
     // Apply panning
-    fill(*modulationSpan, region_->pan);
-    if (float* mod = mm.getModulation(panTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
-    }
-    pan(*modulationSpan, leftBuffer, rightBuffer);
+    pan(panSpan, leftBuffer, rightBuffer);
 
     // add +3dB (10^(3/20)) to compensate for the pan stage (-3dB per stage)
     applyGain1(1.4125375446227544f, leftBuffer);
@@ -1064,6 +1225,26 @@ void Voice::Impl::filterStageStereo(AudioSpan<float> buffer) noexcept
     }
 }
 
+void Voice::Impl::filterStageToBank(AudioSpan<float> buffer, FilterBank& bank) noexcept
+{
+    ScopedTiming logger { filterDuration_ };
+    const auto numSamples = static_cast<unsigned>(buffer.getNumFrames());
+    const unsigned numChannels = region_->isStereo() ? 2 : 1;
+    float* channels[2] { buffer.getSpan(0).data(), buffer.getSpan(1).data() };
+
+    const int firstLane = bank.addLanes(channels, numChannels);
+    ASSERT(firstLane >= 0);
+    if (firstLane < 0)
+        return;
+
+    unsigned stage = 0;
+    for (unsigned i = 0; i < region_->filters.size(); ++i)
+        filters_[i].queue(bank, firstLane, stage++, numSamples);
+
+    for (unsigned i = 0; i < region_->equalizers.size(); ++i)
+        equalizers_[i].queue(bank, firstLane, stage++, numSamples);
+}
+
 void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
 {
     const size_t numSamples = buffer.getNumFrames();
@@ -1117,9 +1298,24 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     updateLoopInformation();
     const auto loop = this->loop_;
 
+    // Streamed files are only partially in memory
+    const bool streaming = currentPromise_.isStreaming();
+    const size_t sourceFrames = streaming ?
+        static_cast<size_t>(currentPromise_->information.end + 1) : source.getNumFrames();
+
+    // A streamed loop is left at the end of the lap where the voice is released
+    uint32_t loopLimit = region_->loopCount ? *region_->loopCount : FileStream::noLoopExit;
+    if (streamLoops_) {
+        if (region_->loopMode == LoopMode::loop_sustain && released() && loop_.restarts < streamLoopExit_) {
+            streamLoopExit_ = loop_.restarts;
+            currentPromise_.leaveStreamLoop(streamLoopExit_);
+        }
+        loopLimit = streamLoopExit_;
+    }
+
     // Looping logic
-    const bool hasLoopSamples = static_cast<size_t>(loop.end) < source.getNumFrames();
-    const bool loopCountReached = region_->loopCount && loop_.restarts >= *region_->loopCount;
+    const bool hasLoopSamples = static_cast<size_t>(loop.end) < sourceFrames;
+    const bool loopCountReached = loop_.restarts >= loopLimit;
     const bool loopContinuous = (region_->loopMode == LoopMode::loop_continuous);
     const bool loopSustain = (region_->loopMode == LoopMode::loop_sustain) && !released();
     const bool shouldLoop = hasLoopSamples && (loopSustain || loopContinuous) && !loopCountReached;
@@ -1140,10 +1336,12 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     // loop crossfade partitioning
     absl::Span<int> partitionStarts;
     absl::Span<int> partitionTypes;
+    absl::Span<int> partitionLaps;
     unsigned numPartitions = 0;
     enum PartitionType { kPartitionNormal, kPartitionLoopXfade };
 
-    SpanHolder<absl::Span<int>> partitionBuffers[2];
+    SpanHolder<absl::Span<int>> partitionBuffers[3];
+    int oneShotLap[1] = { static_cast<int>(loop_.restarts) };
     if (shouldLoop) {
         for (auto& buf : partitionBuffers) {
             buf = bufferPool.getIndexBuffer(numSamples);
@@ -1152,6 +1350,7 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         }
         partitionStarts = *partitionBuffers[0];
         partitionTypes = *partitionBuffers[1];
+        partitionLaps = *partitionBuffers[2];
         // Note: partitions will be alternance of Normal/Xfade
         //       computed along with index processing below
     } else {
@@ -1159,10 +1358,11 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         static const int types[1] = { kPartitionNormal };
         partitionStarts = absl::MakeSpan(const_cast<int*>(starts), 1);
         partitionTypes = absl::MakeSpan(const_cast<int*>(types), 1);
+        partitionLaps = absl::MakeSpan(oneShotLap, 1);
         numPartitions = 1;
     }
 
-    const auto sampleEnd = min( int(sampleEnd_), int(currentPromise_->information.end), int(source.getNumFrames())) - 1;
+    const auto sampleEnd = min( int(sampleEnd_), int(currentPromise_->information.end), int(sourceFrames)) - 1;
 
     int blockRestarts { 0 };
     int oldIndex {};
@@ -1177,6 +1377,7 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         if (start) {
             partitionStarts[numPartitions] = blockIndex;
             partitionTypes[numPartitions] = partitionType;
+            partitionLaps[numPartitions] = static_cast<int>(loop_.restarts);
             ++numPartitions;
         }
 
@@ -1201,7 +1402,7 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
             i++;
 
             // Break if we reached the loop count
-            if (wrapped && region_->loopCount && loop_.restarts >= *region_->loopCount)
+            if (wrapped && loop_.restarts >= loopLimit)
                 break;
         }
 
@@ -1237,110 +1438,158 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     // interpolation processing
     const int quality = getCurrentSampleQuality();
 
-    for (unsigned ptNo = 0; ptNo < numPartitions; ++ptNo) {
+    // Streamed partitions are read in windows which the stream can return
+    // contiguously, and a crossfade reads both ends of the loop in a single one
+    const int margin = config::excessFileFrames;
+    const int maxWindow = config::streamingGuardFrames - 2 * margin - 1;
+    const int xfDistance = loop.xfOutStart - loop.xfInStart;
+    bool underrun = false;
+
+    for (unsigned ptNo = 0; ptNo < numPartitions && !underrun; ++ptNo) {
         // current partition
         const int ptType = partitionTypes[ptNo];
-        const unsigned ptStart = partitionStarts[ptNo];
+        const unsigned ptFirst = partitionStarts[ptNo];
         const unsigned ptNextStart = (ptNo + 1 < numPartitions) ? partitionStarts[ptNo + 1] : numSamples;
-        const unsigned ptSize = ptNextStart - ptStart;
-
-        // partition spans
-        AudioSpan<float> ptBuffer = buffer.subspan(ptStart, ptSize);
-        absl::Span<const int> ptIndices = indices->subspan(ptStart, ptSize);
-        absl::Span<const float> ptCoeffs = coeffs->subspan(ptStart, ptSize);
-
-        fillInterpolatedWithQuality<false>(
-            source, ptBuffer, ptIndices, ptCoeffs, {}, quality);
-
-        if (ptType == kPartitionLoopXfade) {
-            auto xfTemp1 = bufferPool.getBuffer(numSamples);
-            auto xfTemp2 = bufferPool.getBuffer(numSamples);
-            auto xfIndicesTemp = bufferPool.getIndexBuffer(numSamples);
-            if (!xfTemp1 || !xfTemp2 || !xfIndicesTemp)
-                return;
-
-            absl::Span<float> xfCurvePos = xfTemp1->first(ptSize);
-
-            // compute crossfade positions
-            for (unsigned i = 0; i < ptSize; ++i) {
-                float pos = float(ptIndices[i]) + ptCoeffs[i];
-                xfCurvePos[i] = (pos - float(loop.xfOutStart)) / float(loop.xfSize);
-            }
-
-            //----------------------------------------------------------------//
-            // Crossfade Out
-            //   -> fade out signal nearing the loop end
-            {
-                // compute out curve
-                absl::Span<float> xfCurve = xfTemp2->first(ptSize);
-                IF_CONSTEXPR (config::loopXfadeCurve == 2) {
-                    const Curve& xfIn = getSCurve();
-                    for (unsigned i = 0; i < ptSize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(1.0f - xfCurvePos[i]);
-                }
-                else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
-                    const Curve& xfOut = curves.getCurve(6);
-                    for (unsigned i = 0; i < ptSize; ++i)
-                        xfCurve[i] = xfOut.evalNormalized(xfCurvePos[i]);
-                }
-                else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
-                    // TODO(jpc) vectorize this
-                    for (unsigned i = 0; i < ptSize; ++i)
-                        xfCurve[i] = clamp(1.0f - xfCurvePos[i], 0.0f, 1.0f);
+        const uint32_t ptLap = static_cast<uint32_t>(partitionLaps[ptNo]);
+
+        for (unsigned ptStart = ptFirst, ptEnd = ptNextStart; ptStart < ptNextStart; ptStart = ptEnd) {
+            SampleSpan ptSource = source;
+            int sourceShift = 0;
+            int xfInShift = 0;
+            if (streaming) {
+                const int first = (*indices)[ptStart];
+                if (ptType == kPartitionNormal) {
+                    ptEnd = ptStart + 1;
+                    while (ptEnd < ptNextStart && (*indices)[ptEnd] - first <= maxWindow)
+                        ++ptEnd;
                 }
-                // apply out curve
-                // (scalar fallback: buffer and curve not aligned)
-                size_t numChannels = ptBuffer.getNumChannels();
-                for (size_t c = 0; c < numChannels; ++c) {
-                    absl::Span<float> channel = ptBuffer.getSpan(c);
-                    for (unsigned i = 0; i < ptSize; ++i)
-                        channel[i] *= xfCurve[i];
+
+                const int last = (*indices)[ptEnd - 1];
+                const int64_t lapPosition = currentPromise_.getStreamPosition(0, ptLap);
+                if (last + margin < static_cast<int>(source.getNumFrames())) {
+                    currentPromise_.skipStreamTo(lapPosition + first - margin);
+                } else {
+                    const int64_t nextLapPosition = currentPromise_.getStreamPosition(0, ptLap + 1);
+                    const int64_t lastPosition = (ptType == kPartitionLoopXfade) ?
+                        nextLapPosition + last - xfDistance : lapPosition + last;
+                    int64_t offset = 0;
+                    ptSource = currentPromise_.getStreamedData(lapPosition + first, lastPosition, offset);
+                    if (ptSource.getNumFrames() == 0) {
+                        ++streamUnderruns_;
+                        buffer.subspan(ptStart).fill(0.0f);
+                        underrun = true;
+                        break;
+                    }
+                    sourceShift = static_cast<int>(offset - lapPosition);
+                    xfInShift = static_cast<int>(offset - nextLapPosition);
                 }
             }
-            //----------------------------------------------------------------//
-            // Crossfade In
-            //   -> fade in signal preceding the loop start
-            {
-                // compute indices of the crossfade input segment
-                absl::Span<int> xfInIndices = xfIndicesTemp->first(ptSize);
-                absl::c_copy(ptIndices, xfInIndices.begin());
-                subtract1(loop.xfOutStart - loop.xfInStart, xfInIndices);
-
-                // disregard the segment whose indices have been pushed
-                // into the negatives, take these virtually as zeroes.
-                unsigned applyOffset = 0;
-                while (applyOffset < ptSize && xfInIndices[applyOffset] < 0)
-                    ++applyOffset;
-                unsigned applySize = ptSize - applyOffset;
-
-                // offset the indices and coeffs
-                xfInIndices = xfInIndices.subspan(applyOffset);
-                absl::Span<const float> xfInCoeffs = ptCoeffs.subspan(applyOffset);
-                // offset the curve positions
-                absl::Span<float> xfInCurvePos = xfCurvePos.subspan(applyOffset);
-                // offset the output buffer
-                AudioSpan<float> xfInBuffer = ptBuffer.subspan(applyOffset);
-
-                // compute in curve
-                absl::Span<float> xfCurve = xfTemp2->first(applySize);
-                IF_CONSTEXPR (config::loopXfadeCurve == 2) {
-                    const Curve& xfIn = getSCurve();
-                    for (unsigned i = 0; i < applySize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+
+            // partition spans
+            const unsigned ptSize = ptEnd - ptStart;
+            AudioSpan<float> ptBuffer = buffer.subspan(ptStart, ptSize);
+            absl::Span<const int> ptIndices = indices->subspan(ptStart, ptSize);
+            absl::Span<const float> ptCoeffs = coeffs->subspan(ptStart, ptSize);
+
+            if (sourceShift != 0)
+                subtract1(sourceShift, indices->subspan(ptStart, ptSize));
+            fillInterpolatedWithQuality<false>(
+                ptSource, ptBuffer, ptIndices, ptCoeffs, {}, quality);
+            if (sourceShift != 0)
+                add1(sourceShift, indices->subspan(ptStart, ptSize));
+
+            if (ptType == kPartitionLoopXfade) {
+                auto xfTemp1 = bufferPool.getBuffer(numSamples);
+                auto xfTemp2 = bufferPool.getBuffer(numSamples);
+                auto xfIndicesTemp = bufferPool.getIndexBuffer(numSamples);
+                if (!xfTemp1 || !xfTemp2 || !xfIndicesTemp)
+                    return;
+
+                absl::Span<float> xfCurvePos = xfTemp1->first(ptSize);
+
+                // compute crossfade positions
+                for (unsigned i = 0; i < ptSize; ++i) {
+                    float pos = float(ptIndices[i]) + ptCoeffs[i];
+                    xfCurvePos[i] = (pos - float(loop.xfOutStart)) / float(loop.xfSize);
                 }
-                else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
-                    const Curve& xfIn = curves.getCurve(5);
-                    for (unsigned i = 0; i < applySize; ++i)
-                        xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+
+                //----------------------------------------------------------------//
+                // Crossfade Out
+                //   -> fade out signal nearing the loop end
+                {
+                    // compute out curve
+                    absl::Span<float> xfCurve = xfTemp2->first(ptSize);
+                    IF_CONSTEXPR (config::loopXfadeCurve == 2) {
+                        const Curve& xfIn = getSCurve();
+                        for (unsigned i = 0; i < ptSize; ++i)
+                            xfCurve[i] = xfIn.evalNormalized(1.0f - xfCurvePos[i]);
+                    }
+                    else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
+                        const Curve& xfOut = curves.getCurve(6);
+                        for (unsigned i = 0; i < ptSize; ++i)
+                            xfCurve[i] = xfOut.evalNormalized(xfCurvePos[i]);
+                    }
+                    else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
+                        // TODO(jpc) vectorize this
+                        for (unsigned i = 0; i < ptSize; ++i)
+                            xfCurve[i] = clamp(1.0f - xfCurvePos[i], 0.0f, 1.0f);
+                    }
+                    // apply out curve
+                    // (scalar fallback: buffer and curve not aligned)
+                    size_t numChannels = ptBuffer.getNumChannels();
+                    for (size_t c = 0; c < numChannels; ++c) {
+                        absl::Span<float> channel = ptBuffer.getSpan(c);
+                        for (unsigned i = 0; i < ptSize; ++i)
+                            channel[i] *= xfCurve[i];
+                    }
                 }
-                else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
-                    // TODO(jpc) vectorize this
-                    for (unsigned i = 0; i < applySize; ++i)
-                        xfCurve[i] = clamp(xfInCurvePos[i], 0.0f, 1.0f);
+                //----------------------------------------------------------------//
+                // Crossfade In
+                //   -> fade in signal preceding the loop start
+                {
+                    // compute indices of the crossfade input segment
+                    absl::Span<int> xfInIndices = xfIndicesTemp->first(ptSize);
+                    absl::c_copy(ptIndices, xfInIndices.begin());
+                    subtract1(xfDistance, xfInIndices);
+
+                    // disregard the segment whose indices have been pushed
+                    // into the negatives, take these virtually as zeroes.
+                    unsigned applyOffset = 0;
+                    while (applyOffset < ptSize && xfInIndices[applyOffset] < 0)
+                        ++applyOffset;
+                    unsigned applySize = ptSize - applyOffset;
+
+                    // offset the indices and coeffs
+                    xfInIndices = xfInIndices.subspan(applyOffset);
+                    absl::Span<const float> xfInCoeffs = ptCoeffs.subspan(applyOffset);
+                    // offset the curve positions
+                    absl::Span<float> xfInCurvePos = xfCurvePos.subspan(applyOffset);
+                    // offset the output buffer
+                    AudioSpan<float> xfInBuffer = ptBuffer.subspan(applyOffset);
+
+                    // compute in curve
+                    absl::Span<float> xfCurve = xfTemp2->first(applySize);
+                    IF_CONSTEXPR (config::loopXfadeCurve == 2) {
+                        const Curve& xfIn = getSCurve();
+                        for (unsigned i = 0; i < applySize; ++i)
+                            xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+                    }
+                    else IF_CONSTEXPR (config::loopXfadeCurve == 1) {
+                        const Curve& xfIn = curves.getCurve(5);
+                        for (unsigned i = 0; i < applySize; ++i)
+                            xfCurve[i] = xfIn.evalNormalized(xfInCurvePos[i]);
+                    }
+                    else IF_CONSTEXPR (config::loopXfadeCurve == 0) {
+                        // TODO(jpc) vectorize this
+                        for (unsigned i = 0; i < applySize; ++i)
+                            xfCurve[i] = clamp(xfInCurvePos[i], 0.0f, 1.0f);
+                    }
+                    // apply in curve
+                    if (xfInShift != 0)
+                        subtract1(xfInShift, xfInIndices);
+                    fillInterpolatedWithQuality<true>(
+                        ptSource, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
                 }
-                // apply in curve
-                fillInterpolatedWithQuality<true>(
-                    source, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
             }
         }
     }
@@ -1358,10 +1607,39 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
 
 template <InterpolatorModel M, bool Adding>
 void Voice::Impl::fillInterpolated(
-    const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+    const SampleSpan& source, const AudioSpan<float>& dest,
+    absl::Span<const int> indices, absl::Span<const float> coeffs,
+    absl::Span<const float> addingGains)
+{
+    switch (source.getFormat()) {
+    case SampleFormat::Float:
+        fillInterpolatedFrom<M, Adding>(source.getSpan<float>(), dest, indices, coeffs, addingGains);
+        break;
+    case SampleFormat::Int16:
+        fillInterpolatedFrom<M, Adding>(source.getSpan<int16_t>(), dest, indices, coeffs, addingGains);
+        break;
+    case SampleFormat::Int24:
+        fillInterpolatedFrom<M, Adding>(source.getSpan<Int24>(), dest, indices, coeffs, addingGains);
+        break;
+    }
+}
+
+template <InterpolatorModel M, bool Adding, class T>
+void Voice::Impl::fillInterpolatedFrom(
+    const AudioSpan<const T>& source, const AudioSpan<float>& dest,
     absl::Span<const int> indices, absl::Span<const float> coeffs,
     absl::Span<const float> addingGains)
 {
+    IF_CONSTEXPR(isSincInterpolator(M)) {
+        const bool stereo = source.getNumChannels() > 1;
+        interpolateSincBlock(M,
+            source.getConstSpan(0).data(), stereo ? source.getConstSpan(1).data() : nullptr,
+            dest.getChannel(0), stereo ? dest.getChannel(1) : nullptr,
+            indices.data(), coeffs.data(), Adding ? addingGains.data() : nullptr,
+            static_cast<unsigned>(indices.size()));
+        return;
+    }
+
     auto* ind = indices.data();
     auto* coeff = coeffs.data();
     auto* addingGain = addingGains.data();
@@ -1400,7 +1678,7 @@ void Voice::Impl::fillInterpolated(
 
 template <bool Adding>
 void Voice::Impl::fillInterpolatedWithQuality(
-    const AudioSpan<const float>& source, const AudioSpan<float>& dest,
+    const SampleSpan& source, const AudioSpan<float>& dest,
     absl::Span<const int> indices, absl::Span<const float> coeffs,
     absl::Span<const float> addingGains, int quality)
 {
@@ -1759,6 +2037,37 @@ void Voice::Impl::updateLoopInformation() noexcept
     loop_.xfInStart = loop_.start - loop_.xfSize;
 }
 
+void Voice::Impl::startStream(FilePool& filePool) noexcept
+{
+    streamLoops_ = false;
+    streamLoopExit_ = FileStream::noLoopExit;
+    if (!currentPromise_.isStreaming())
+        return;
+
+    const Region& region = *region_;
+    const FileInformation& info = currentPromise_->information;
+    const int margin = config::excessFileFrames;
+    const int preloadedFrames = static_cast<int>(currentPromise_->getNumPreloadedFrames());
+    const bool loopsPastPreload = region.shouldLoop() && loop_.end <= static_cast<int>(info.end)
+        && loop_.end + margin >= preloadedFrames;
+    if (!loopsPastPreload) {
+        currentPromise_.startStream();
+        return;
+    }
+
+    // The crossfades read both ends of the loop in a single window
+    if (loop_.xfSize > config::streamingGuardFrames / 4) {
+        currentPromise_.reset();
+        currentPromise_ = filePool.getFilePromise(region.sampleId);
+        return;
+    }
+
+    streamLoops_ = true;
+    if (region.loopCount)
+        streamLoopExit_ = *region.loopCount;
+    currentPromise_.startStream(loop_.xfInStart - margin, loop_.end + margin, streamLoopExit_);
+}
+
 void Voice::setNextSisterVoice(Voice* voice) noexcept
 {
     // Should never be null
@@ -2116,6 +2425,12 @@ double Voice::getLastDataDuration() const noexcept
     return impl.dataDuration_;
 }
 
+unsigned Voice::getLastStreamUnderruns() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.streamUnderruns_;
+}
+
 double Voice::getLastAmplitudeDuration() const noexcept
 {
     Impl& impl = *impl_;
@@ -18,6 +18,7 @@ namespace sfz {
 enum InterpolatorModel : int;
 class LFO;
 class FlexEnvelope;
+class FilterBank;
 struct Layer;
 
 struct ExtendedCCValues {
@@ -198,6 +199,34 @@ public:
      */
     void renderBlock(AudioSpan<float, 2> buffer) noexcept;
 
+    /**
+     * @brief Get the number of filter bank lanes needed to queue the filters
+     * of the voice, or 0 if the voice has to process its filters itself.
+     */
+    unsigned getFilterBankLanes() const noexcept;
+
+    /**
+     * @brief Render a block of data for this voice into the span, like
+     * renderBlock(), but queue the filters into a filter bank.
+     *
+     * If this returns true, the bank filters the span in place later, and
+     * finishBlock() must be called next with the same span to complete the
+     * block. The span must outlive the processing of the bank.
+     *
+     * @param buffer
+     * @param bank
+     * @return true if the filters are queued
+     */
+    bool renderBlockToFilterBank(AudioSpan<float, 2> buffer, FilterBank& bank) noexcept;
+
+    /**
+     * @brief Complete a block which was queued into a filter bank.
+     *
+     * @param buffer
+     * @param filterDuration the share of the voice in the filter bank time
+     */
+    void finishBlock(AudioSpan<float, 2> buffer, double filterDuration) noexcept;
+
     /**
      * @brief Is the voice free?
      *
@@ -385,6 +414,11 @@ public:
     double getLastAmplitudeDuration() const noexcept;
     double getLastFilterDuration() const noexcept;
     double getLastPanningDuration() const noexcept;
+    /**
+     * @brief Get the number of times the stream of the voice was late in the
+     * last block, leaving the rest of the block silent.
+     */
+    unsigned getLastStreamUnderruns() const noexcept;
 
     /**
      * @brief Get the SFZv1 amplitude LFO, if existing
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+/**
+   Note(jpc): implementation status
+
+Extensions
+- [x] conv_ir
+- [x] conv_dry
+- [x] conv_wet
+ */
+
+#include "Convolution.h"
+#include "FilePool.h"
+#include "MathHelpers.h"
+#include "Opcode.h"
+#include "SIMDHelpers.h"
+#include "utility/StringViewHelpers.h"
+#include "utility/Debug.h"
+#include <absl/strings/str_replace.h>
+#include <cmath>
+
+namespace sfz {
+namespace fx {
+
+    void Convolution::setSampleRate(double sampleRate)
+    {
+        if (_sampleRate == sampleRate)
+            return;
+
+        _sampleRate = sampleRate;
+        updateImpulseResponse();
+    }
+
+    void Convolution::setSamplesPerBlock(int samplesPerBlock)
+    {
+        _tempBuffer.resize(samplesPerBlock);
+    }
+
+    void Convolution::clear()
+    {
+        _convolver.clear();
+    }
+
+    void Convolution::process(const float* const inputs[], float* const outputs[], unsigned nframes)
+    {
+        float* wet[EffectChannels] = { _tempBuffer.channelWriter(0), _tempBuffer.channelWriter(1) };
+        _convolver.process(inputs, wet, nframes);
+
+        for (unsigned c = 0; c < EffectChannels; ++c) {
+            auto input = absl::MakeConstSpan(inputs[c], nframes);
+            auto output = absl::MakeSpan(outputs[c], nframes);
+            sfz::applyGain1(_dry, input, output);
+            sfz::multiplyAdd1(_wet, _tempBuffer.getConstSpan(c).first(nframes), output);
+        }
+    }
+
+    size_t Convolution::getTailLength() const
+    {
+        return _convolver.getLength();
+    }
+
+    void Convolution::loadFiles(FilePool& filePool)
+    {
+        if (_impulseFile.empty())
+            return;
+
+        auto fileHandle = filePool.loadFile(FileId(_impulseFile));
+        if (!fileHandle || fileHandle->preloaded->data.getNumChannels() == 0) {
+            DBG("[sfizz] Cannot load the impulse response " << _impulseFile);
+            return;
+        }
+
+        const auto& data = fileHandle->preloaded->data;
+        const size_t numChannels = data.getNumChannels();
+        _impulse = AudioBuffer<float, 2>(numChannels, data.getNumFrames());
+        for (size_t c = 0; c < numChannels; ++c)
+            sfz::copy(data.getConstSpan(c), _impulse.getSpan(c));
+        _impulseSampleRate = fileHandle->information.sampleRate;
+
+        updateImpulseResponse();
+    }
+
+    void Convolution::updateImpulseResponse()
+    {
+        const size_t numChannels = _impulse.getNumChannels();
+        const size_t numFrames = _impulse.getNumFrames();
+        if (numChannels == 0 || numFrames == 0) {
+            _convolver.setImpulseResponse({});
+            return;
+        }
+
+        if (_impulseSampleRate == _sampleRate) {
+            _convolver.setImpulseResponse(AudioSpan<const float>(_impulse));
+            return;
+        }
+
+        AudioBuffer<float, 2> resampled = resampleImpulseResponse(
+            AudioSpan<const float>(_impulse), _impulseSampleRate / _sampleRate);
+        _convolver.setImpulseResponse(AudioSpan<const float>(resampled));
+    }
+
+    AudioBuffer<float, 2> Convolution::resampleImpulseResponse(AudioSpan<const float> impulse, double ratio)
+    {
+        // a Kaiser-windowed sinc, whose cutoff is the lower Nyquist frequency;
+        // it spans `kernelZeros` zero crossings on each side, and is tabulated
+        // with `kernelOversampling` points per crossing
+        constexpr int kernelZeros = 16;
+        constexpr int kernelOversampling = 256;
+        constexpr double kernelBeta = 8.0;
+        std::vector<float> kernel(kernelZeros * kernelOversampling + 2);
+        for (size_t i = 0; i < kernel.size(); ++i) {
+            const double x = std::min(1.0, static_cast<double>(i) / (kernelZeros * kernelOversampling));
+            kernel[i] = static_cast<float>(
+                normalizedSinc(x * kernelZeros) * kaiserWindowSinglePoint(kernelBeta, 0.5 + 0.5 * x));
+        }
+
+        // the gain of the response is kept by the scale of the ratio, and the
+        // cutoff scales the kernel when decimating
+        const double cutoff = std::min(1.0, 1.0 / ratio);
+        const double halfWidth = kernelZeros / cutoff;
+        const float gain = static_cast<float>(ratio * cutoff);
+
+        const size_t numChannels = impulse.getNumChannels();
+        const size_t numFrames = impulse.getNumFrames();
+        const size_t numResampled = static_cast<size_t>(std::ceil(numFrames / ratio));
+        AudioBuffer<float, 2> resampled(numChannels, numResampled);
+        for (size_t c = 0; c < numChannels; ++c) {
+            const auto source = impulse.getConstSpan(c);
+            auto output = resampled.getSpan(c);
+            for (size_t i = 0; i < numResampled; ++i) {
+                const double position = i * ratio;
+                const auto first = static_cast<ptrdiff_t>(std::ceil(position - halfWidth));
+                const auto last = static_cast<ptrdiff_t>(std::floor(position + halfWidth));
+                float sum = 0.0f;
+                for (ptrdiff_t k = std::max<ptrdiff_t>(first, 0), end = std::min<ptrdiff_t>(last, numFrames - 1); k <= end; ++k) {
+                    const double x = std::abs(position - k) * cutoff * kernelOversampling;
+                    const auto index = static_cast<size_t>(x);
+                    const float mu = static_cast<float>(x - index);
+                    sum += source[k] * (kernel[index] + mu * (kernel[index + 1] - kernel[index]));
+                }
+                output[i] = gain * sum;
+            }
+        }
+        return resampled;
+    }
+
+    std::unique_ptr<Effect> Convolution::makeInstance(absl::Span<const Opcode> members)
+    {
+        Convolution* convolution = new Convolution;
+        std::unique_ptr<Effect> fx { convolution };
+
+        for (const Opcode& opc : members) {
+            switch (opc.lettersOnlyHash) {
+            case hash("conv_ir"):
+                convolution->_impulseFile = absl::StrReplaceAll(trim(opc.value), { { "\\", "/" } });
+                break;
+            case hash("conv_dry"):
+                convolution->_dry = opc.read(Default::effect);
+                break;
+            case hash("conv_wet"):
+                convolution->_wet = opc.read(Default::convWet);
+                break;
+            }
+        }
+
+        return fx;
+    }
+
+} // namespace fx
+} // namespace sfz
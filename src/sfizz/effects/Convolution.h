@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "Effects.h"
+#include "AudioBuffer.h"
+#include "impl/PartitionedConvolver.h"
+#include <string>
+
+namespace sfz {
+namespace fx {
+
+    /**
+     * @brief Convolution with an impulse response file
+     */
+    class Convolution : public Effect {
+    public:
+        /**
+         * @brief Initializes with the given sample rate.
+         */
+        void setSampleRate(double sampleRate) override;
+
+        /**
+         * @brief Sets the maximum number of frames to render at a time. The actual
+         * value can be lower but should never be higher.
+         */
+        void setSamplesPerBlock(int samplesPerBlock) override;
+
+        /**
+         * @brief Reset the state to initial.
+         */
+        void clear() override;
+
+        /**
+         * @brief Mix the convolved signal with the input
+         */
+        void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
+
+        /**
+         * @brief Get the length of the impulse response.
+         */
+        size_t getTailLength() const override;
+
+        /**
+         * @brief The output is silent once the impulse response has elapsed.
+         */
+        bool hasDecayingTail() const override { return false; }
+
+        /**
+         * @brief Load the impulse response file.
+         */
+        void loadFiles(FilePool& filePool) override;
+
+        /**
+         * @brief Wait for the tail of the convolution when rendering offline.
+         */
+        void setFreewheeling(bool freewheeling) override { _convolver.setFreewheeling(freewheeling); }
+
+        /**
+          * @brief Instantiates given the contents of the <effect> block.
+          */
+        static std::unique_ptr<Effect> makeInstance(absl::Span<const Opcode> members);
+
+        /**
+         * @brief Resample an impulse response, keeping its gain. The response
+         * is band-limited below the lower of the two Nyquist frequencies.
+         *
+         * @param impulse the impulse response
+         * @param ratio the source rate divided by the target rate
+         * @return the resampled response
+         */
+        static AudioBuffer<float, 2> resampleImpulseResponse(AudioSpan<const float> impulse, double ratio);
+
+    private:
+        void updateImpulseResponse();
+
+        std::string _impulseFile;
+        float _dry { Default::effect };
+        float _wet { Default::convWet };
+        double _sampleRate { config::defaultSampleRate };
+
+        AudioBuffer<float, 2> _impulse;
+        double _impulseSampleRate { config::defaultSampleRate };
+
+        PartitionedConvolver _convolver;
+        AudioBuffer<float, 2> _tempBuffer { 2, config::defaultSamplesPerBlock };
+    };
+
+} // namespace fx
+} // namespace sfz
@@ -38,6 +38,7 @@ namespace fx {
 
     struct Fverb::Impl {
         faustFverb dsp;
+        double sampleRate { config::defaultSampleRate };
 
         struct Profile {
             float tailDensity; // %
@@ -140,6 +141,7 @@ namespace fx {
         Impl& impl = *impl_;
         auto& dsp = impl.dsp;
 
+        impl.sampleRate = sampleRate;
         dsp.classInit(sampleRate);
         dsp.instanceConstants(sampleRate);
 
@@ -167,6 +169,13 @@ namespace fx {
         dsp.compute(nframes, const_cast<float**>(inputs), const_cast<float**>(outputs));
     }
 
+    size_t Fverb::getTailLength() const
+    {
+        const Impl& impl = *impl_;
+        const double predelay = 1e-3 * impl.dsp.getPredelay();
+        return static_cast<size_t>(std::ceil(predelay * impl.sampleRate));
+    }
+
     std::unique_ptr<Effect> Fverb::makeInstance(absl::Span<const Opcode> members)
     {
         Fverb* reverb = new Fverb;
@@ -40,6 +40,12 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        /**
+         * @brief Get the length of the predelay, after which the reverb tail
+         * decays.
+         */
+        size_t getTailLength() const override;
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
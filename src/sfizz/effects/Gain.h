@@ -36,6 +36,8 @@ namespace fx {
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
 
+        bool hasDecayingTail() const override { return false; }
+
         /**
           * @brief Instantiates given the contents of the <effect> block.
           */
@@ -35,6 +35,8 @@ namespace fx {
          * @brief Copy the input signal to the output
          */
         void process(const float* const inputs[], float* const outputs[], unsigned nframes) override;
+
+        bool hasDecayingTail() const override { return false; }
     };
 
 } // namespace fx
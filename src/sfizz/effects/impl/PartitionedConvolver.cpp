@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "PartitionedConvolver.h"
+#include "FilePool.h"
+#include "SIMDHelpers.h"
+#include "utility/Debug.h"
+#include <kiss_fftr.h>
+#include <algorithm>
+
+namespace sfz {
+namespace fx {
+
+    void UniformConvolver::FftDeleter::operator()(kiss_fftr_state* cfg) const noexcept
+    {
+        kiss_fftr_free(cfg);
+    }
+
+    void UniformConvolver::init(absl::Span<const float> ir, size_t blockSize)
+    {
+        ASSERT(blockSize > 0 && blockSize % 2 == 0);
+
+        const size_t fftSize = 2 * blockSize;
+        const size_t numBins = blockSize + 1;
+        const size_t numPartitions = std::max<size_t>(1, (ir.size() + blockSize - 1) / blockSize);
+
+        blockSize_ = blockSize;
+        numPartitions_ = numPartitions;
+        forward_.reset(kiss_fftr_alloc(static_cast<int>(fftSize), false, nullptr, nullptr));
+        inverse_.reset(kiss_fftr_alloc(static_cast<int>(fftSize), true, nullptr, nullptr));
+        if (!forward_ || !inverse_)
+            throw std::bad_alloc();
+
+        timeBuffer_.assign(fftSize, 0.0f);
+        resultBuffer_.assign(fftSize, 0.0f);
+        irSpectra_.assign(numPartitions * numBins, Complex {});
+        delayLine_.assign(numPartitions * numBins, Complex {});
+        accumulator_.assign(numBins, Complex {});
+
+        // the partitions are zero-padded to the size of the transform, and
+        // their spectra include the scaling of the inverse transform
+        const float scale = 1.0f / fftSize;
+        for (size_t p = 0; p < numPartitions; ++p) {
+            const size_t start = p * blockSize;
+            const size_t count = std::min(blockSize, ir.size() - std::min(start, ir.size()));
+            std::fill(timeBuffer_.begin(), timeBuffer_.end(), 0.0f);
+            for (size_t i = 0; i < count; ++i)
+                timeBuffer_[i] = scale * ir[start + i];
+            kiss_fftr(forward_.get(), timeBuffer_.data(),
+                reinterpret_cast<kiss_fft_cpx*>(&irSpectra_[p * numBins]));
+        }
+
+        clear();
+    }
+
+    void UniformConvolver::clear() noexcept
+    {
+        std::fill(timeBuffer_.begin(), timeBuffer_.end(), 0.0f);
+        std::fill(delayLine_.begin(), delayLine_.end(), Complex {});
+        position_ = 0;
+    }
+
+    void UniformConvolver::processBlock(const float* input, float* output) noexcept
+    {
+        const size_t blockSize = blockSize_;
+        const size_t numBins = blockSize + 1;
+        const size_t numPartitions = numPartitions_;
+
+        // overlap-save: transform the previous block followed by the new one
+        std::copy(timeBuffer_.begin() + blockSize, timeBuffer_.end(), timeBuffer_.begin());
+        std::copy(input, input + blockSize, timeBuffer_.begin() + blockSize);
+        kiss_fftr(forward_.get(), timeBuffer_.data(),
+            reinterpret_cast<kiss_fft_cpx*>(&delayLine_[position_ * numBins]));
+
+        // multiply the past input spectra with the partitions of the response
+        float* acc = reinterpret_cast<float*>(accumulator_.data());
+        std::fill(acc, acc + 2 * numBins, 0.0f);
+        for (size_t p = 0; p < numPartitions; ++p) {
+            const size_t slot = (position_ + numPartitions - p) % numPartitions;
+            const float* x = reinterpret_cast<const float*>(&delayLine_[slot * numBins]);
+            const float* h = reinterpret_cast<const float*>(&irSpectra_[p * numBins]);
+            for (size_t i = 0; i < 2 * numBins; i += 2) {
+                acc[i] += x[i] * h[i] - x[i + 1] * h[i + 1];
+                acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i];
+            }
+        }
+        position_ = (position_ + 1) % numPartitions;
+
+        // the second half of the circular convolution is the linear one
+        kiss_fftri(inverse_.get(), reinterpret_cast<const kiss_fft_cpx*>(acc), resultBuffer_.data());
+        std::copy(resultBuffer_.begin() + blockSize, resultBuffer_.end(), output);
+    }
+
+    ///
+    PartitionedConvolver::PartitionedConvolver(size_t headSize, size_t middleSize, size_t tailSize)
+        : headSize_(headSize), middleSize_(middleSize), tailSize_(tailSize)
+    {
+        ASSERT(headSize > 0 && headSize % 2 == 0);
+        ASSERT(middleSize % headSize == 0 && tailSize % middleSize == 0);
+    }
+
+    PartitionedConvolver::~PartitionedConvolver()
+    {
+        stopBackgroundThread();
+    }
+
+    void PartitionedConvolver::setImpulseResponse(AudioSpan<const float> ir)
+    {
+        stopBackgroundThread();
+
+        const size_t numIrChannels = ir.getNumChannels();
+        const size_t length = (numIrChannels > 0) ? ir.getNumFrames() : 0;
+        const size_t headSize = headSize_;
+
+        length_ = length;
+        stages_.clear();
+        tail_ = Stage();
+
+        auto irChannel = [&ir, numIrChannels](size_t c) {
+            return ir.getConstSpan(std::min(c, numIrChannels - 1));
+        };
+
+        auto setupStage = [&](Stage& stage, size_t blockSize, size_t start, size_t end) {
+            stage.blockSize = blockSize;
+            stage.convolvers.resize(NumChannels);
+            stage.input.assign(NumChannels, std::vector<float>(blockSize));
+            stage.output.assign(NumChannels, std::vector<float>(blockSize));
+            for (size_t c = 0; c < NumChannels; ++c)
+                stage.convolvers[c].init(irChannel(c).subspan(start, end - start), blockSize);
+        };
+
+        for (size_t c = 0; c < NumChannels; ++c) {
+            headTaps_[c].assign(headSize, 0.0f);
+            headHistory_[c].assign(2 * headSize, 0.0f);
+            if (length == 0)
+                continue;
+            auto channel = irChannel(c);
+            for (size_t i = 0, n = std::min(headSize, length); i < n; ++i)
+                headTaps_[c][headSize - 1 - i] = channel[i];
+        }
+        headPosition_ = 0;
+
+        // a segment with partitions of N frames can start at N at the
+        // earliest, and at 2N if it gets a whole block to be computed
+        const size_t middleStart = middleSize_;
+        const size_t tailStart = 2 * tailSize_;
+
+        if (length > headSize) {
+            stages_.emplace_back();
+            setupStage(stages_.back(), headSize, headSize, std::min(length, middleStart));
+        }
+        if (length > middleStart) {
+            stages_.emplace_back();
+            setupStage(stages_.back(), middleSize_, middleStart, std::min(length, tailStart));
+        }
+        if (length > tailStart) {
+            setupStage(tail_, tailSize_, tailStart, length);
+            tailJobInput_.assign(NumChannels, std::vector<float>(tailSize_));
+            tailJobOutput_.assign(NumChannels, std::vector<float>(tailSize_));
+            tailThread_ = std::thread(&PartitionedConvolver::backgroundJob, this);
+        }
+    }
+
+    void PartitionedConvolver::clear() noexcept
+    {
+        // a job which the thread is running is not waited for: its result is
+        // dropped, and its convolvers cleared, once it is collected
+        const bool tailBusy = !cancelTail();
+
+        for (size_t c = 0; c < NumChannels; ++c)
+            std::fill(headHistory_[c].begin(), headHistory_[c].end(), 0.0f);
+        headPosition_ = 0;
+
+        auto clearStage = [](Stage& stage) {
+            stage.fill = 0;
+            for (UniformConvolver& convolver : stage.convolvers)
+                convolver.clear();
+            for (std::vector<float>& buffer : stage.input)
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+            for (std::vector<float>& buffer : stage.output)
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+        };
+
+        for (Stage& stage : stages_)
+            clearStage(stage);
+
+        tail_.fill = 0;
+        for (std::vector<float>& buffer : tail_.input)
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+        for (std::vector<float>& buffer : tail_.output)
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+        if (tailBusy)
+            tailDiscarded_ = true;
+        else
+            clearTailJob();
+    }
+
+    void PartitionedConvolver::process(const float* const inputs[], float* const outputs[], unsigned nframes) noexcept
+    {
+        if (length_ == 0) {
+            for (size_t c = 0; c < NumChannels; ++c)
+                std::fill(outputs[c], outputs[c] + nframes, 0.0f);
+            return;
+        }
+
+        const size_t headSize = headSize_;
+        const bool hasTail = tail_.blockSize > 0;
+
+        // go by chunks which do not cross block boundaries; all the block
+        // sizes are multiples of the head size, so the head is the limit
+        size_t done = 0;
+        while (done < nframes) {
+            const size_t chunk = std::min<size_t>(nframes - done, headSize - headPosition_);
+
+            for (size_t c = 0; c < NumChannels; ++c) {
+                const float* input = inputs[c] + done;
+                float* output = outputs[c] + done;
+
+                float* history = headHistory_[c].data();
+                const float* taps = headTaps_[c].data();
+                size_t position = headPosition_;
+                for (size_t i = 0; i < chunk; ++i) {
+                    history[position] = input[i];
+                    history[position + headSize] = input[i];
+                    ++position;
+                    const float* window = history + position;
+                    float sum = 0.0f;
+                    for (size_t j = 0; j < headSize; ++j)
+                        sum += window[j] * taps[j];
+                    output[i] = sum;
+                }
+
+                auto exchange = [&](Stage& stage) {
+                    std::copy(input, input + chunk, stage.input[c].data() + stage.fill);
+                    add<float>(absl::MakeConstSpan(stage.output[c].data() + stage.fill, chunk),
+                        absl::MakeSpan(output, chunk));
+                };
+                for (Stage& stage : stages_)
+                    exchange(stage);
+                if (hasTail)
+                    exchange(tail_);
+            }
+
+            headPosition_ = (headPosition_ + chunk) % headSize;
+            for (Stage& stage : stages_) {
+                stage.fill += chunk;
+                if (stage.fill == stage.blockSize) {
+                    stage.fill = 0;
+                    runStage(stage);
+                }
+            }
+            if (hasTail) {
+                tail_.fill += chunk;
+                if (tail_.fill == tail_.blockSize) {
+                    tail_.fill = 0;
+                    runTail();
+                }
+            }
+
+            done += chunk;
+        }
+    }
+
+    void PartitionedConvolver::runStage(Stage& stage) noexcept
+    {
+        for (size_t c = 0; c < NumChannels; ++c)
+            stage.convolvers[c].processBlock(stage.input[c].data(), stage.output[c].data());
+    }
+
+    void PartitionedConvolver::runTail() noexcept
+    {
+        // the job started a block ago has the output of the next block; the
+        // job starting now has the whole next block to complete
+        if (!collectTail(freewheeling_)) {
+            // the job still runs on the previous input, so this input block
+            // is dropped and the next block gets no tail
+            tailUnderruns_.fetch_add(1, std::memory_order_relaxed);
+            for (std::vector<float>& buffer : tail_.output)
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+            return;
+        }
+
+        std::swap(tail_.output, tailJobOutput_);
+        std::swap(tail_.input, tailJobInput_);
+
+        std::error_code ec;
+        tailPending_ = true;
+        tailState_.store(TailRequested, std::memory_order_release);
+        tailRequest_.post(ec);
+        ASSERT(!ec);
+    }
+
+    bool PartitionedConvolver::collectTail(bool wait) noexcept
+    {
+        if (!tailPending_)
+            return true;
+
+        // take the job back if the thread has not started it yet
+        int expected = TailRequested;
+        if (tailState_.compare_exchange_strong(expected, TailIdle, std::memory_order_acquire)) {
+            processTailJob();
+            tailPending_ = false;
+            return true;
+        }
+
+        std::error_code ec;
+        if (wait)
+            tailDone_.wait(ec);
+        else if (!tailDone_.try_wait(ec))
+            return false;
+        ASSERT(!ec);
+        tailPending_ = false;
+
+        if (tailDiscarded_)
+            clearTailJob();
+        return true;
+    }
+
+    bool PartitionedConvolver::cancelTail() noexcept
+    {
+        if (!tailPending_)
+            return true;
+
+        int expected = TailRequested;
+        std::error_code ec;
+        if (tailState_.compare_exchange_strong(expected, TailIdle, std::memory_order_acquire)
+            || tailDone_.try_wait(ec)) {
+            ASSERT(!ec);
+            tailPending_ = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    void PartitionedConvolver::clearTailJob() noexcept
+    {
+        for (UniformConvolver& convolver : tail_.convolvers)
+            convolver.clear();
+        for (std::vector<float>& buffer : tailJobOutput_)
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+        tailDiscarded_ = false;
+    }
+
+    void PartitionedConvolver::processTailJob() noexcept
+    {
+        for (size_t c = 0; c < NumChannels; ++c)
+            tail_.convolvers[c].processBlock(tailJobInput_[c].data(), tailJobOutput_[c].data());
+    }
+
+    void PartitionedConvolver::stopBackgroundThread() noexcept
+    {
+        if (!tailThread_.joinable())
+            return;
+
+        collectTail(true);
+
+        std::error_code ec;
+        tailQuit_.store(true);
+        tailRequest_.post(ec);
+        ASSERT(!ec);
+        tailThread_.join();
+        tailQuit_.store(false);
+    }
+
+    void PartitionedConvolver::backgroundJob() noexcept
+    {
+        FilePool::raiseCurrentThreadPriority();
+
+        std::error_code ec;
+        for (;;) {
+            tailRequest_.wait(ec);
+            ASSERT(!ec);
+            if (tailQuit_.load())
+                break;
+
+            // the job may have been taken back in the meantime
+            int expected = TailRequested;
+            if (!tailState_.compare_exchange_strong(expected, TailRunning, std::memory_order_acquire))
+                continue;
+
+            processTailJob();
+            tailState_.store(TailIdle, std::memory_order_release);
+
+            tailDone_.post(ec);
+            ASSERT(!ec);
+        }
+    }
+
+} // namespace fx
+} // namespace sfz
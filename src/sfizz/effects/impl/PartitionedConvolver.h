@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "AudioSpan.h"
+#include "RTSemaphore.h"
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <thread>
+#include <vector>
+
+struct kiss_fftr_state;
+
+namespace sfz {
+namespace fx {
+
+    /**
+     * @brief Convolution of a mono signal with an impulse response segment,
+     * by uniformly partitioned overlap-save FFT convolution.
+     *
+     * Each call consumes a block of input and produces the output for the
+     * same block, so the segment comes out one block late.
+     */
+    class UniformConvolver {
+    public:
+        /**
+         * @brief Set up the convolver, and clear it.
+         *
+         * @param ir the impulse response segment
+         * @param blockSize the size of the partitions and of the blocks; it must be even
+         */
+        void init(absl::Span<const float> ir, size_t blockSize);
+
+        /**
+         * @brief Reset the state to initial.
+         */
+        void clear() noexcept;
+
+        /**
+         * @brief Convolve a block of `blockSize` frames.
+         */
+        void processBlock(const float* input, float* output) noexcept;
+
+    private:
+        struct FftDeleter {
+            void operator()(kiss_fftr_state* cfg) const noexcept;
+        };
+        using FftPtr = std::unique_ptr<kiss_fftr_state, FftDeleter>;
+        using Complex = std::complex<float>;
+
+        size_t blockSize_ { 0 };
+        size_t numPartitions_ { 0 };
+        size_t position_ { 0 };
+        FftPtr forward_;
+        FftPtr inverse_;
+        std::vector<float> timeBuffer_;
+        std::vector<float> resultBuffer_;
+        std::vector<Complex> irSpectra_;
+        std::vector<Complex> delayLine_;
+        std::vector<Complex> accumulator_;
+    };
+
+    /**
+     * @brief Stereo convolution with a long impulse response, without latency.
+     *
+     * The impulse response is cut into segments of increasing sizes: the first
+     * taps are applied directly, the following ones by FFT convolutions with
+     * small then medium partitions, and the tail by an FFT convolution with
+     * large partitions which runs on a background thread. Each segment starts
+     * late enough that its result is ready when it is due, so the sum of the
+     * segments is the exact convolution.
+     *
+     * The processing never waits for the background thread, unless
+     * freewheeling. If the thread has not started the tail when it is due, it
+     * is computed inline; if it is still computing it, the tail of the next
+     * block is skipped and counted as an underrun.
+     */
+    class PartitionedConvolver {
+    public:
+        enum {
+            NumChannels = 2,
+            DefaultHeadSize = 64,
+            DefaultMiddleSize = 1024,
+            DefaultTailSize = 8192,
+        };
+
+        /**
+         * @brief Construct a new convolver.
+         *
+         * @param headSize the number of taps applied directly, which are also
+         *                 the partitions of the first FFT segment
+         * @param middleSize the size of the partitions of the second segment
+         * @param tailSize the size of the partitions of the background segment
+         */
+        PartitionedConvolver(
+            size_t headSize = DefaultHeadSize,
+            size_t middleSize = DefaultMiddleSize,
+            size_t tailSize = DefaultTailSize);
+        ~PartitionedConvolver();
+
+        PartitionedConvolver(const PartitionedConvolver&) = delete;
+        PartitionedConvolver& operator=(const PartitionedConvolver&) = delete;
+
+        /**
+         * @brief Set the impulse response, and clear the state. This is not
+         * real-time safe.
+         *
+         * @param ir the impulse response, with one channel per output channel,
+         *           or a single channel for both
+         */
+        void setImpulseResponse(AudioSpan<const float> ir);
+
+        /**
+         * @brief Get the length of the impulse response, in frames.
+         */
+        size_t getLength() const noexcept { return length_; }
+
+        /**
+         * @brief Reset the state to initial. This does not wait for the
+         * background thread.
+         */
+        void clear() noexcept;
+
+        /**
+         * @brief Set whether to wait for a late tail, when rendering offline.
+         */
+        void setFreewheeling(bool freewheeling) noexcept { freewheeling_ = freewheeling; }
+
+        /**
+         * @brief Get the number of blocks whose tail was skipped, because the
+         * background thread was late.
+         */
+        size_t getNumTailUnderruns() const noexcept { return tailUnderruns_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Convolve the stereo input into the output, which must not
+         * overlap the input.
+         */
+        void process(const float* const inputs[], float* const outputs[], unsigned nframes) noexcept;
+
+    private:
+        struct Stage {
+            size_t blockSize { 0 };
+            size_t fill { 0 };
+            std::vector<UniformConvolver> convolvers;
+            std::vector<std::vector<float>> input;
+            std::vector<std::vector<float>> output;
+        };
+
+        enum TailState {
+            TailIdle,
+            TailRequested,
+            TailRunning,
+        };
+
+        void stopBackgroundThread() noexcept;
+        bool collectTail(bool wait) noexcept;
+        bool cancelTail() noexcept;
+        void clearTailJob() noexcept;
+        void runStage(Stage& stage) noexcept;
+        void runTail() noexcept;
+        void processTailJob() noexcept;
+        void backgroundJob() noexcept;
+
+        const size_t headSize_;
+        const size_t middleSize_;
+        const size_t tailSize_;
+        size_t length_ { 0 };
+
+        // directly applied taps, reversed, and the doubled delay lines
+        std::vector<float> headTaps_[NumChannels];
+        std::vector<float> headHistory_[NumChannels];
+        size_t headPosition_ { 0 };
+
+        std::vector<Stage> stages_;
+
+        // the background stage, and the copies it works on
+        Stage tail_;
+        std::vector<std::vector<float>> tailJobInput_;
+        std::vector<std::vector<float>> tailJobOutput_;
+        bool tailPending_ { false };
+        bool freewheeling_ { false };
+        bool tailDiscarded_ { false };
+        std::atomic<size_t> tailUnderruns_ { 0 };
+        std::atomic<int> tailState_ { TailIdle };
+        std::thread tailThread_;
+        RTSemaphore tailRequest_;
+        RTSemaphore tailDone_;
+        std::atomic<bool> tailQuit_ { false };
+    };
+
+} // namespace fx
+} // namespace sfz
@@ -7,13 +7,18 @@
 #include "sfizz_import.h"
 #include "ForeignInstrument.h"
 
-bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const char** format)
+typedef bool (LoadFileFunction)(sfizz_synth_t*, const char*);
+typedef bool (LoadStringFunction)(sfizz_synth_t*, const char*, const char*);
+
+static bool loadOrImportFile(
+    sfizz_synth_t* synth, const char* path, const char** format,
+    LoadFileFunction* loadFile, LoadStringFunction* loadString)
 {
     const sfz::InstrumentFormatRegistry& ireg = sfz::InstrumentFormatRegistry::getInstance();
     const sfz::InstrumentFormat* ifmt = ireg.getMatchingFormat(path);
 
     if (!ifmt) {
-        if (!sfizz_load_file(synth, path))
+        if (!loadFile(synth, path))
             return false;
         if (format)
             *format = nullptr;
@@ -22,7 +27,7 @@ bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const cha
         auto importer = ifmt->createImporter();
         std::string virtualPath = std::string(path) + ".sfz";
         std::string sfzText = importer->convertToSfz(path);
-        if (!sfizz_load_string(synth, virtualPath.c_str(), sfzText.c_str()))
+        if (!loadString(synth, virtualPath.c_str(), sfzText.c_str()))
             return false;
         if (format)
             *format = ifmt->name();
@@ -30,3 +35,13 @@ bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const cha
 
     return true;
 }
+
+bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const char** format)
+{
+    return loadOrImportFile(synth, path, format, &sfizz_load_file, &sfizz_load_string);
+}
+
+bool sfizz_stage_or_import_file(sfizz_synth_t* synth, const char* path, const char** format)
+{
+    return loadOrImportFile(synth, path, format, &sfizz_stage_file, &sfizz_stage_string);
+}
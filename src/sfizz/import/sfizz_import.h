@@ -33,6 +33,30 @@ extern "C" {
  */
 bool sfizz_load_or_import_file(sfizz_synth_t* synth, const char* path, const char** format);
 
+/**
+ * @brief Loads or imports an instrument file in the background, while the
+ *        current instrument keeps playing.
+ *
+ * This is similar to sfizz_load_or_import_file(), using sfizz_stage_file()
+ * and sfizz_stage_string() for the loading.
+ * @since 1.3.0
+ *
+ * @param synth   The synth.
+ * @param path    A null-terminated string representing a path to an instrument
+ *                in SFZ format, or another format which can be imported.
+ * @param format  An optional pointer to a string pointer, which receives the
+ *                null-terminated name of the format if the file was imported,
+ *                or null if the file was loaded directly as SFZ.
+ *
+ * @return @true when file loading went OK,
+ *         @false if some error occured while loading.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread, and may run
+ *   concurrently with @b RT functions
+ */
+bool sfizz_stage_or_import_file(sfizz_synth_t* synth, const char* path, const char** format);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
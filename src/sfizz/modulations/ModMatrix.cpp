@@ -10,11 +10,13 @@
 #include "ModGenerator.h"
 #include "Buffer.h"
 #include "Config.h"
+#include "RTWorkerPool.h"
 #include "SIMDHelpers.h"
 #include "utility/Debug.h"
 #include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/string_view.h>
+#include <array>
 #include <vector>
 #include <algorithm>
 
@@ -25,10 +27,16 @@ struct ModMatrix::Impl {
     uint32_t samplesPerBlock_ {};
 
     uint32_t numFrames_ {};
-    NumericId<Voice> currentVoiceId_ {};
-    NumericId<Region> currentRegionId_ {};
 
-    float currentVoiceTriggerValue_ {};
+    struct VoiceCursor {
+        NumericId<Voice> voiceId {};
+        NumericId<Region> regionId {};
+        float triggerValue {};
+    };
+
+    // one voice cursor per render worker
+    std::array<VoiceCursor, config::maxRenderThreads> cursors_;
+    VoiceCursor& currentCursor() noexcept { return cursors_[RTWorkerPool::currentWorkerIndex()]; }
 
     struct Source {
         ModKey key;
@@ -44,10 +52,22 @@ struct ModMatrix::Impl {
         float velToDepth_ {};
     };
 
+    // a connection compiled for evaluation, stored contiguously per target
+    struct ConnectionStep {
+        uint32_t sourceIndex {};
+        int sourceFlags {};
+        float sourceDepth {};
+        float velToDepth {};
+        TargetId sourceDepthModId {};
+    };
+
     struct Target {
         ModKey key;
         uint32_t region {};
         absl::flat_hash_map<uint32_t, ConnectionData> connectedSources;
+        int flags {};
+        uint32_t firstStep {};
+        uint32_t numSteps {};
         bool bufferReady {};
         Buffer<float> buffer;
     };
@@ -64,8 +84,43 @@ struct ModMatrix::Impl {
 
     std::vector<Source> sources_;
     std::vector<Target> targets_;
+    std::vector<ConnectionStep> steps_;
+
+    void compileConnections();
 };
 
+void ModMatrix::Impl::compileConnections()
+{
+    steps_.clear();
+
+    for (Target& target : targets_) {
+        target.flags = target.key.flags();
+        target.firstStep = static_cast<uint32_t>(steps_.size());
+
+        // keep the iteration order of the connections, so the modulations
+        // are summed in the same order as before
+        for (const auto& cs : target.connectedSources) {
+            const Source& source = sources_[cs.first];
+            const int sourceFlags = source.key.flags();
+
+            // per-voice sources only modulate the targets of the same region
+            if ((sourceFlags & kModIsPerVoice) &&
+                (!(target.flags & kModIsPerVoice) || source.key.region() != target.key.region()))
+                continue;
+
+            ConnectionStep step;
+            step.sourceIndex = cs.first;
+            step.sourceFlags = sourceFlags;
+            step.sourceDepth = cs.second.sourceDepth_;
+            step.velToDepth = (sourceFlags & kModIsPerVoice) ? cs.second.velToDepth_ : 0.0f;
+            step.sourceDepthModId = cs.second.sourceDepthModId_;
+            steps_.push_back(step);
+        }
+
+        target.numSteps = static_cast<uint32_t>(steps_.size()) - target.firstStep;
+    }
+}
+
 ModMatrix::ModMatrix()
     : impl_(new Impl)
 {
@@ -89,6 +144,7 @@ void ModMatrix::clear()
     impl.targetIndicesForGlobal_.clear();
     impl.sourceIndicesForRegion_.clear();
     impl.targetIndicesForRegion_.clear();
+    impl.steps_.clear();
     impl.maxRegionIdx_ = -1;
 }
 
@@ -164,6 +220,7 @@ ModMatrix::TargetId ModMatrix::registerTarget(const ModKey& key)
 
     Impl::Target &target = impl.targets_.back();
     target.key = key;
+    target.flags = key.flags();
     target.bufferReady = false;
     target.buffer.resize(impl.samplesPerBlock_);
 
@@ -261,6 +318,8 @@ void ModMatrix::init()
             impl.targetIndicesForRegion_[target.key.region().number()].push_back(i);
         }
     }
+
+    impl.compileConnections();
 }
 
 void ModMatrix::initVoice(NumericId<Voice> voiceId, NumericId<Region> regionId, unsigned delay)
@@ -318,6 +377,24 @@ void ModMatrix::beginCycle(unsigned numFrames)
     }
 }
 
+void ModMatrix::generateGlobalModulations()
+{
+    Impl& impl = *impl_;
+    const uint32_t numFrames = impl.numFrames_;
+
+    for (auto idx: impl.sourceIndicesForGlobal_) {
+        Impl::Source& source = impl.sources_[idx];
+        if (!source.bufferReady) {
+            absl::Span<float> buffer(source.buffer.data(), numFrames);
+            source.gen->generate(source.key, {}, buffer);
+            source.bufferReady = true;
+        }
+    }
+
+    for (auto idx: impl.targetIndicesForGlobal_)
+        getModulation(TargetId(static_cast<int>(idx)));
+}
+
 void ModMatrix::endCycle()
 {
     Impl& impl = *impl_;
@@ -338,10 +415,10 @@ void ModMatrix::beginVoice(NumericId<Voice> voiceId, NumericId<Region> regionId,
 {
     Impl& impl = *impl_;
 
-    impl.currentVoiceId_ = voiceId;
-    impl.currentRegionId_ = regionId;
-
-    impl.currentVoiceTriggerValue_ = triggerValue;
+    Impl::VoiceCursor& cursor = impl.currentCursor();
+    cursor.voiceId = voiceId;
+    cursor.regionId = regionId;
+    cursor.triggerValue = triggerValue;
 
     ASSERT(regionId);
 
@@ -361,8 +438,9 @@ void ModMatrix::endVoice()
 {
     Impl& impl = *impl_;
     const uint32_t numFrames = impl.numFrames_;
-    const NumericId<Voice> voiceId = impl.currentVoiceId_;
-    const NumericId<Region> regionId = impl.currentRegionId_;
+    Impl::VoiceCursor& cursor = impl.currentCursor();
+    const NumericId<Voice> voiceId = cursor.voiceId;
+    const NumericId<Region> regionId = cursor.regionId;
 
     ASSERT(regionId);
     ASSERT(static_cast<size_t>(regionId.number()) < impl.sourceIndicesForRegion_.size());
@@ -377,10 +455,7 @@ void ModMatrix::endVoice()
         }
     }
 
-    impl.currentVoiceId_ = {};
-    impl.currentRegionId_ = {};
-
-    impl.currentVoiceTriggerValue_ = 0.0f;
+    cursor = {};
 }
 
 float* ModMatrix::getModulation(TargetId targetId)
@@ -389,11 +464,12 @@ float* ModMatrix::getModulation(TargetId targetId)
         return nullptr;
 
     Impl& impl = *impl_;
-    const NumericId<Region> regionId = impl.currentRegionId_;
-    const float triggerValue = impl.currentVoiceTriggerValue_;
+    const Impl::VoiceCursor& cursor = impl.currentCursor();
+    const NumericId<Region> regionId = cursor.regionId;
+    const float triggerValue = cursor.triggerValue;
     const uint32_t targetIndex = targetId.number();
     Impl::Target &target = impl.targets_[targetIndex];
-    const int targetFlags = target.key.flags();
+    const int targetFlags = target.flags;
 
     const uint32_t numFrames = impl.numFrames_;
     absl::Span<float> buffer(target.buffer.data(), numFrames);
@@ -410,82 +486,70 @@ float* ModMatrix::getModulation(TargetId targetId)
     // in case there is, be sure to initialize the buffer
     target.bufferReady = true;
 
-    auto sourcesPos = target.connectedSources.begin();
-    auto sourcesEnd = target.connectedSources.end();
-    bool isFirstSource = true;
+    // run the compiled connections of the target, the sources which cannot
+    // apply to this region were left out on compilation
+    const Impl::ConnectionStep* steps = impl.steps_.data() + target.firstStep;
+    const uint32_t numSteps = target.numSteps;
 
     // generate sources in their dedicated buffers
     // then add or multiply, depending on target flags
-    while (sourcesPos != sourcesEnd) {
-        Impl::Source &source = impl.sources_[sourcesPos->first];
-        const int sourceFlags = source.key.flags();
-
-        // only accept per-voice sources of the same region
-        bool useThisSource = true;
-        if (sourceFlags & kModIsPerVoice)
-            useThisSource = (regionId == source.key.region());
-
-        if (useThisSource) {
-            absl::Span<float> sourceBuffer(source.buffer.data(), numFrames);
-
-            // unless source is already done, process it
-            if (!source.bufferReady) {
-                source.gen->generate(source.key, impl.currentVoiceId_, sourceBuffer);
-                source.bufferReady = true;
-            }
+    for (uint32_t stepIndex = 0; stepIndex < numSteps; ++stepIndex) {
+        const Impl::ConnectionStep& step = steps[stepIndex];
+        Impl::Source &source = impl.sources_[step.sourceIndex];
+        absl::Span<float> sourceBuffer(source.buffer.data(), numFrames);
 
-            float sourceDepth = sourcesPos->second.sourceDepth_;
-            if (sourceFlags & kModIsPerVoice) {
-                const float velToDepth = sourcesPos->second.velToDepth_;
-                sourceDepth += triggerValue * velToDepth;
-            }
+        // unless source is already done, process it
+        if (!source.bufferReady) {
+            source.gen->generate(source.key, cursor.voiceId, sourceBuffer);
+            source.bufferReady = true;
+        }
 
-            const float* sourceDepthMod = getModulation(sourcesPos->second.sourceDepthModId_);
+        float sourceDepth = step.sourceDepth;
+        if (step.sourceFlags & kModIsPerVoice)
+            sourceDepth += triggerValue * step.velToDepth;
 
-            if (isFirstSource) {
-                if (sourceDepth == 1 && !sourceDepthMod)
-                    copy(absl::Span<const float>(sourceBuffer), buffer);
-                else if (!sourceDepthMod) {
-                    for (uint32_t i = 0; i < numFrames; ++i)
-                        buffer[i] = sourceDepth * sourceBuffer[i];
-                }
-                else if (targetFlags & kModIsMultiplicative) {
-                    for (uint32_t i = 0; i < numFrames; ++i)
-                        buffer[i] = (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
-                }
+        const float* sourceDepthMod = getModulation(step.sourceDepthModId);
+
+        if (stepIndex == 0) {
+            if (sourceDepth == 1 && !sourceDepthMod)
+                copy(absl::Span<const float>(sourceBuffer), buffer);
+            else if (!sourceDepthMod) {
+                for (uint32_t i = 0; i < numFrames; ++i)
+                    buffer[i] = sourceDepth * sourceBuffer[i];
+            }
+            else if (targetFlags & kModIsMultiplicative) {
+                for (uint32_t i = 0; i < numFrames; ++i)
+                    buffer[i] = (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
+            }
+            else {
+                ASSERT(targetFlags & kModIsAdditive);
+                for (uint32_t i = 0; i < numFrames; ++i)
+                    buffer[i] = (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
+            }
+        }
+        else {
+            if (targetFlags & kModIsMultiplicative) {
+                if (!sourceDepthMod)
+                    multiplyMul1<float>(sourceDepth, sourceBuffer, buffer);
                 else {
-                    ASSERT(targetFlags & kModIsAdditive);
                     for (uint32_t i = 0; i < numFrames; ++i)
-                        buffer[i] = (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
+                        buffer[i] *= (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
                 }
-                isFirstSource = false;
             }
             else {
-                if (targetFlags & kModIsMultiplicative) {
-                    if (!sourceDepthMod)
-                        multiplyMul1<float>(sourceDepth, sourceBuffer, buffer);
-                    else {
-                        for (uint32_t i = 0; i < numFrames; ++i)
-                            buffer[i] *= (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
-                    }
-                }
+                ASSERT(targetFlags & kModIsAdditive);
+                if (!sourceDepthMod)
+                    multiplyAdd1<float>(sourceDepth, sourceBuffer, buffer);
                 else {
-                    ASSERT(targetFlags & kModIsAdditive);
-                    if (!sourceDepthMod)
-                        multiplyAdd1<float>(sourceDepth, sourceBuffer, buffer);
-                    else {
-                        for (uint32_t i = 0; i < numFrames; ++i)
-                            buffer[i] += (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
-                    }
+                    for (uint32_t i = 0; i < numFrames; ++i)
+                        buffer[i] += (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
                 }
             }
         }
-
-        ++sourcesPos;
     }
 
     // if there were no source, fill output with the neutral element
-    if (isFirstSource) {
+    if (numSteps == 0) {
         if (targetFlags & kModIsMultiplicative)
             fill(buffer, 1.0f);
         else {
@@ -133,6 +133,15 @@ public:
      */
     void beginCycle(unsigned numFrames);
 
+    /**
+     * @brief Generate all the per-cycle sources and targets of the current cycle.
+     *
+     * After this, the per-voice processing does not modify any shared state
+     * but the one of its own region. Voices of different regions can then be
+     * processed concurrently, each render worker having its own voice cursor.
+     */
+    void generateGlobalModulations();
+
     /**
      * @brief End modulation processing for the entire cycle.
      * This performs a dummy run of any unused modulations.
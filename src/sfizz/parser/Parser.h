@@ -47,6 +47,7 @@ public:
 
     const IncludeFileSet& getIncludedFiles() const noexcept { return _pathsIncluded; }
     const DefinitionSet& getDefines() const noexcept { return _currentDefinitions; }
+    const DefinitionSet& getExternalDefinitions() const noexcept { return _externalDefinitions; }
 
     size_t getErrorCount() const noexcept { return _errorCount; }
     size_t getWarningCount() const noexcept { return _warningCount; }
@@ -5,10 +5,12 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "Synth.h"
+#include "LatencyMonitor.h"
 #include "Messaging.h"
 #include "sfizz.hpp"
 #include "sfizz_private.hpp"
 #include "absl/memory/memory.h"
+#include <algorithm>
 
 sfz::Sfizz::Sfizz()
     : synth(new sfizz_synth_t)
@@ -55,6 +57,21 @@ bool sfz::Sfizz::loadSfzString(const std::string& path, const std::string& text)
     return synth->synth.loadSfzString(path, text);
 }
 
+bool sfz::Sfizz::stageSfzFile(const std::string& path)
+{
+    return synth->synth.stageSfzFile(path);
+}
+
+bool sfz::Sfizz::stageSfzString(const std::string& path, const std::string& text)
+{
+    return synth->synth.stageSfzString(path, text);
+}
+
+bool sfz::Sfizz::hasStagedState() const noexcept
+{
+    return synth->synth.hasStagedState();
+}
+
 bool sfz::Sfizz::loadScalaFile(const std::string& path)
 {
     return synth->synth.loadScalaFile(path);
@@ -110,6 +127,11 @@ int sfz::Sfizz::getNumCurves() const noexcept
     return synth->synth.getNumCurves();
 }
 
+int sfz::Sfizz::getNumOutputs() const noexcept
+{
+    return synth->synth.getNumOutputs();
+}
+
 const std::vector<std::string>& sfz::Sfizz::getUnknownOpcodes() const noexcept
 {
     return synth->synth.getUnknownOpcodes();
@@ -150,6 +172,16 @@ void sfz::Sfizz::setOscillatorQuality(ProcessMode mode, int quality)
     synth->synth.setOscillatorQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
 }
 
+int sfz::Sfizz::getFilterQuality(ProcessMode mode)
+{
+    return synth->synth.getFilterQuality(static_cast<sfz::Synth::ProcessMode>(mode));
+}
+
+void sfz::Sfizz::setFilterQuality(ProcessMode mode, int quality)
+{
+    synth->synth.setFilterQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
+}
+
 void sfz::Sfizz::setSustainCancelsRelease(bool value)
 {
     synth->synth.setSustainCancelsRelease(value);
@@ -265,6 +297,21 @@ void sfz::Sfizz::playbackState(int delay, int playbackState)
     synth->synth.playbackState(delay, playbackState);
 }
 
+bool sfz::Sfizz::postMidiEvent(int64_t frame, const uint8_t* data, size_t size) noexcept
+{
+    return synth->synth.postMidiEvent(frame, data, size);
+}
+
+bool sfz::Sfizz::postHdcc(int64_t frame, int ccNumber, float normValue) noexcept
+{
+    return synth->synth.postHdcc(frame, ccNumber, normValue);
+}
+
+int64_t sfz::Sfizz::getFrameTime() const noexcept
+{
+    return synth->synth.getFrameTime();
+}
+
 void sfz::Sfizz::renderBlock(float** buffers, size_t numSamples, int numOutputs) noexcept
 {
     sfz::AudioSpan<float> bufferSpan { buffers, static_cast<size_t>(numOutputs * 2), 0, numSamples };
@@ -286,6 +333,36 @@ void sfz::Sfizz::setNumVoices(int numVoices) noexcept
     synth->synth.setNumVoices(numVoices);
 }
 
+int sfz::Sfizz::getNumRenderThreads() const noexcept
+{
+    return synth->synth.getNumRenderThreads();
+}
+
+void sfz::Sfizz::setNumRenderThreads(int numThreads) noexcept
+{
+    synth->synth.setNumRenderThreads(numThreads);
+}
+
+int sfz::Sfizz::getRenderQuantum() const noexcept
+{
+    return synth->synth.getRenderQuantum();
+}
+
+void sfz::Sfizz::setRenderQuantum(int numFrames) noexcept
+{
+    synth->synth.setRenderQuantum(numFrames);
+}
+
+void sfz::Sfizz::enableParallelEffects() noexcept
+{
+    synth->synth.enableParallelEffects();
+}
+
+void sfz::Sfizz::disableParallelEffects() noexcept
+{
+    synth->synth.disableParallelEffects();
+}
+
 bool sfz::Sfizz::setOversamplingFactor(int) noexcept
 {
     return true;
@@ -327,6 +404,51 @@ void sfz::Sfizz::disableFreeWheeling() noexcept
     synth->synth.disableFreeWheeling();
 }
 
+void sfz::Sfizz::enableSampleStreaming() noexcept
+{
+    synth->synth.enableSampleStreaming();
+}
+
+void sfz::Sfizz::disableSampleStreaming() noexcept
+{
+    synth->synth.disableSampleStreaming();
+}
+
+void sfz::Sfizz::setSampleFormat(SampleFormat format) noexcept
+{
+    synth->synth.setSampleFormat(static_cast<sfz::Synth::SampleFormat>(format));
+}
+
+sfz::Sfizz::SampleFormat sfz::Sfizz::getSampleFormat() const noexcept
+{
+    return static_cast<SampleFormat>(synth->synth.getSampleFormat());
+}
+
+void sfz::Sfizz::enableCompressedSampleStorage() noexcept
+{
+    synth->synth.enableCompressedSampleStorage();
+}
+
+void sfz::Sfizz::disableCompressedSampleStorage() noexcept
+{
+    synth->synth.disableCompressedSampleStorage();
+}
+
+void sfz::Sfizz::enableSampleSharing() noexcept
+{
+    synth->synth.enableSampleSharing();
+}
+
+void sfz::Sfizz::disableSampleSharing() noexcept
+{
+    synth->synth.disableSampleSharing();
+}
+
+void sfz::Sfizz::setPreloadCacheDirectory(const std::string& path) noexcept
+{
+    synth->synth.setPreloadCacheDirectory(path);
+}
+
 bool sfz::Sfizz::shouldReloadFile()
 {
     return synth->synth.shouldReloadFile();
@@ -369,6 +491,50 @@ sfz::Sfizz::CallbackBreakdown sfz::Sfizz::getCallbackBreakdown() noexcept
     return breakdown;
 }
 
+sfz::Sfizz::LatencyStats sfz::Sfizz::getLatencyStats() const noexcept
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    LatencyStats stats;
+    stats.numBlocks = monitor.getNumBlocks();
+    stats.numDeadlineMisses = monitor.getNumDeadlineMisses();
+    stats.maxLoad = monitor.getMaxLoad();
+    stats.lastLoad = monitor.getLastLoad();
+    stats.binWidth = sfz::LatencyMonitor::binWidth;
+    stats.numBins = static_cast<int>(sfz::LatencyMonitor::numBins);
+    stats.numStreamUnderruns = monitor.getNumStreamUnderruns();
+    return stats;
+}
+
+int sfz::Sfizz::getLatencyHistogram(uint64_t* counts, int maxBins) const noexcept
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    const int numBins = std::min(maxBins, static_cast<int>(sfz::LatencyMonitor::numBins));
+    for (int i = 0; i < numBins; ++i)
+        counts[i] = monitor.getBinCount(static_cast<unsigned>(i));
+    return std::max(numBins, 0);
+}
+
+int sfz::Sfizz::getDeadlineMisses(DeadlineMiss* misses, int maxMisses) const noexcept
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    int numMisses = 0;
+    sfz::DeadlineMiss miss;
+    while (numMisses < maxMisses && monitor.getDeadlineMiss(static_cast<unsigned>(numMisses), miss)) {
+        DeadlineMiss& out = misses[numMisses++];
+        out.block = miss.block;
+        out.duration = miss.duration;
+        out.budget = miss.budget;
+        out.numVoices = static_cast<int>(miss.numVoices);
+        out.numEvents = static_cast<int>(miss.numEvents);
+    }
+    return numMisses;
+}
+
+void sfz::Sfizz::resetLatencyStats() noexcept
+{
+    synth->synth.resetLatencyStats();
+}
+
 void sfz::Sfizz::allSoundOff() noexcept
 {
     synth->synth.allSoundOff();
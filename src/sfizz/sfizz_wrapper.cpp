@@ -6,10 +6,12 @@
 
 #include "Config.h"
 #include "Synth.h"
+#include "LatencyMonitor.h"
 #include "Messaging.h"
 #include "utility/Macros.h"
 #include "sfizz.h"
 #include "sfizz_private.hpp"
+#include <algorithm>
 #include <limits>
 
 #ifdef __cplusplus
@@ -31,6 +33,21 @@ bool sfizz_load_string(sfizz_synth_t* synth, const char* path, const char* text)
     return synth->synth.loadSfzString(path, text);
 }
 
+bool sfizz_stage_file(sfizz_synth_t* synth, const char* path)
+{
+    return synth->synth.stageSfzFile(path);
+}
+
+bool sfizz_stage_string(sfizz_synth_t* synth, const char* path, const char* text)
+{
+    return synth->synth.stageSfzString(path, text);
+}
+
+bool sfizz_has_staged_state(sfizz_synth_t* synth)
+{
+    return synth->synth.hasStagedState();
+}
+
 bool sfizz_load_scala_file(sfizz_synth_t* synth, const char* path)
 {
     return synth->synth.loadScalaFile(path);
@@ -92,6 +109,10 @@ int sfizz_get_num_curves(sfizz_synth_t* synth)
 {
     return synth->synth.getNumCurves();
 }
+int sfizz_get_num_outputs(sfizz_synth_t* synth)
+{
+    return synth->synth.getNumOutputs();
+}
 char* sfizz_export_midnam(sfizz_synth_t* synth, const char* model)
 {
     return strdup(synth->synth.exportMidnam(model ? model : "").c_str());
@@ -195,6 +216,21 @@ void sfizz_send_playback_state(sfizz_synth_t* synth, int delay, int playback_sta
     synth->synth.playbackState(delay, playback_state);
 }
 
+bool sfizz_post_midi_event(sfizz_synth_t* synth, int64_t frame, const uint8_t* data, size_t size)
+{
+    return synth->synth.postMidiEvent(frame, data, size);
+}
+
+bool sfizz_post_hdcc(sfizz_synth_t* synth, int64_t frame, int cc_number, float norm_value)
+{
+    return synth->synth.postHdcc(frame, cc_number, norm_value);
+}
+
+int64_t sfizz_get_frame_time(sfizz_synth_t* synth)
+{
+    return synth->synth.getFrameTime();
+}
+
 void sfizz_render_block(sfizz_synth_t* synth, float** channels, int num_channels, int num_frames)
 {
     sfz::AudioSpan<float> channelSpan { channels, static_cast<size_t>(num_channels), 0, static_cast<size_t>(num_frames) };
@@ -240,6 +276,16 @@ void sfizz_set_oscillator_quality(sfizz_synth_t* synth, sfizz_process_mode_t mod
     return synth->synth.setOscillatorQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
 }
 
+int sfizz_get_filter_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode)
+{
+    return synth->synth.getFilterQuality(static_cast<sfz::Synth::ProcessMode>(mode));
+}
+
+void sfizz_set_filter_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode, int quality)
+{
+    return synth->synth.setFilterQuality(static_cast<sfz::Synth::ProcessMode>(mode), quality);
+}
+
 void sfizz_set_sustain_cancels_release(sfizz_synth_t* synth, bool value)
 {
     return synth->synth.setSustainCancelsRelease(value);
@@ -265,6 +311,36 @@ int sfizz_get_num_voices(sfizz_synth_t* synth)
     return synth->synth.getNumVoices();
 }
 
+void sfizz_set_num_render_threads(sfizz_synth_t* synth, int num_threads)
+{
+    synth->synth.setNumRenderThreads(num_threads);
+}
+
+int sfizz_get_num_render_threads(sfizz_synth_t* synth)
+{
+    return synth->synth.getNumRenderThreads();
+}
+
+void sfizz_set_render_quantum(sfizz_synth_t* synth, int num_frames)
+{
+    synth->synth.setRenderQuantum(num_frames);
+}
+
+int sfizz_get_render_quantum(sfizz_synth_t* synth)
+{
+    return synth->synth.getRenderQuantum();
+}
+
+void sfizz_enable_parallel_effects(sfizz_synth_t* synth)
+{
+    synth->synth.enableParallelEffects();
+}
+
+void sfizz_disable_parallel_effects(sfizz_synth_t* synth)
+{
+    synth->synth.disableParallelEffects();
+}
+
 int sfizz_get_num_buffers(sfizz_synth_t* synth)
 {
     return synth->synth.getAllocatedBuffers();
@@ -285,6 +361,51 @@ void sfizz_disable_freewheeling(sfizz_synth_t* synth)
     synth->synth.disableFreeWheeling();
 }
 
+void sfizz_enable_sample_streaming(sfizz_synth_t* synth)
+{
+    synth->synth.enableSampleStreaming();
+}
+
+void sfizz_disable_sample_streaming(sfizz_synth_t* synth)
+{
+    synth->synth.disableSampleStreaming();
+}
+
+void sfizz_set_sample_format(sfizz_synth_t* synth, sfizz_sample_format_t format)
+{
+    synth->synth.setSampleFormat(static_cast<sfz::Synth::SampleFormat>(format));
+}
+
+sfizz_sample_format_t sfizz_get_sample_format(sfizz_synth_t* synth)
+{
+    return static_cast<sfizz_sample_format_t>(synth->synth.getSampleFormat());
+}
+
+void sfizz_enable_compressed_sample_storage(sfizz_synth_t* synth)
+{
+    synth->synth.enableCompressedSampleStorage();
+}
+
+void sfizz_disable_compressed_sample_storage(sfizz_synth_t* synth)
+{
+    synth->synth.disableCompressedSampleStorage();
+}
+
+void sfizz_enable_sample_sharing(sfizz_synth_t* synth)
+{
+    synth->synth.enableSampleSharing();
+}
+
+void sfizz_disable_sample_sharing(sfizz_synth_t* synth)
+{
+    synth->synth.disableSampleSharing();
+}
+
+void sfizz_set_preload_cache_directory(sfizz_synth_t* synth, const char* path)
+{
+    synth->synth.setPreloadCacheDirectory(path ? path : "");
+}
+
 char* sfizz_get_unknown_opcodes(sfizz_synth_t* synth)
 {
     const auto unknownOpcodes = synth->synth.getUnknownOpcodes();
@@ -345,6 +466,48 @@ void sfizz_get_callback_breakdown(sfizz_synth_t* synth, sfizz_callback_breakdown
     breakdown->effects = bd.effects;
 }
 
+void sfizz_get_latency_stats(sfizz_synth_t* synth, sfizz_latency_stats_t* stats)
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    stats->numBlocks = monitor.getNumBlocks();
+    stats->numDeadlineMisses = monitor.getNumDeadlineMisses();
+    stats->maxLoad = monitor.getMaxLoad();
+    stats->lastLoad = monitor.getLastLoad();
+    stats->binWidth = sfz::LatencyMonitor::binWidth;
+    stats->numBins = static_cast<int>(sfz::LatencyMonitor::numBins);
+    stats->numStreamUnderruns = monitor.getNumStreamUnderruns();
+}
+
+int sfizz_get_latency_histogram(sfizz_synth_t* synth, uint64_t* counts, int max_bins)
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    const int num_bins = std::min(max_bins, static_cast<int>(sfz::LatencyMonitor::numBins));
+    for (int i = 0; i < num_bins; ++i)
+        counts[i] = monitor.getBinCount(static_cast<unsigned>(i));
+    return std::max(num_bins, 0);
+}
+
+int sfizz_get_deadline_misses(sfizz_synth_t* synth, sfizz_deadline_miss_t* misses, int max_misses)
+{
+    const sfz::LatencyMonitor& monitor = synth->synth.getLatencyMonitor();
+    int num_misses = 0;
+    sfz::DeadlineMiss miss;
+    while (num_misses < max_misses && monitor.getDeadlineMiss(static_cast<unsigned>(num_misses), miss)) {
+        sfizz_deadline_miss_t& out = misses[num_misses++];
+        out.block = miss.block;
+        out.duration = miss.duration;
+        out.budget = miss.budget;
+        out.numVoices = static_cast<int>(miss.numVoices);
+        out.numEvents = static_cast<int>(miss.numEvents);
+    }
+    return num_misses;
+}
+
+void sfizz_reset_latency_stats(sfizz_synth_t* synth)
+{
+    synth->synth.resetLatencyStats();
+}
+
 void sfizz_all_sound_off(sfizz_synth_t* synth)
 {
     return synth->synth.allSoundOff();
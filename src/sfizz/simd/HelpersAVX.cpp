@@ -8,6 +8,7 @@
 #include "../SIMDConfig.h"
 #include "../MathHelpers.h"
 #include "Common.h"
+#include "HelpersScalar.h"
 
 #if SFIZZ_HAVE_AVX
 #include <immintrin.h>
@@ -54,3 +55,157 @@ void gainAVX(const float* gain, const float* input, float* output, unsigned size
     while (output < sentinel)
         *output++ = (*gain++) * (*input++);
 }
+
+#if SFIZZ_HAVE_AVX
+namespace {
+
+// load 2 unaligned vectors of 4 values in the low and high lanes
+inline __m256 loadu2(const float* low, const float* high) noexcept
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+// load 2 pairs of consecutive values in the low and high halves
+inline __m128 loadPairs(const float* low, const float* high) noexcept
+{
+    const __m128 pair = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(low)));
+    return _mm_loadh_pi(pair, reinterpret_cast<const __m64*>(high));
+}
+
+struct SincTableAVX {
+    SincTableAVX(const float* table, unsigned tableSize, unsigned points) noexcept
+        : table(table)
+        , offset(_mm256_set1_ps(points / 2.0f))
+        , scale(_mm256_set1_ps(static_cast<float>((tableSize - 1) / points)))
+    {
+    }
+
+    // interpolate the table at 8 positions, like `AbstractWindowedSinc::getUncheckedX4`
+    __m256 lookup(__m256 x) const noexcept
+    {
+        const __m256 ix = _mm256_mul_ps(_mm256_add_ps(x, offset), scale);
+        const __m256i i0 = _mm256_cvttps_epi32(ix);
+        alignas(32) int j[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(j), i0);
+        const __m256 mu = _mm256_sub_ps(ix, _mm256_cvtepi32_ps(i0));
+
+        const __m256 p0p1 = _mm256_insertf128_ps(_mm256_castps128_ps256(loadPairs(&table[j[0]], &table[j[1]])), loadPairs(&table[j[4]], &table[j[5]]), 1);
+        const __m256 p2p3 = _mm256_insertf128_ps(_mm256_castps128_ps256(loadPairs(&table[j[2]], &table[j[3]])), loadPairs(&table[j[6]], &table[j[7]]), 1);
+        const __m256 y0 = _mm256_shuffle_ps(p0p1, p2p3, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 y1 = _mm256_shuffle_ps(p0p1, p2p3, _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm256_add_ps(y0, _mm256_mul_ps(mu, _mm256_sub_ps(y1, y0)));
+    }
+
+    const float* table;
+    __m256 offset;
+    __m256 scale;
+};
+
+// horizontal sums of each lane of a and b, as (a.low, a.high, b.low, b.high)
+inline __m128 horizontalSumsAVX(__m256 a, __m256 b) noexcept
+{
+    const __m128 a0 = _mm256_castps256_ps128(a);
+    const __m128 a1 = _mm256_extractf128_ps(a, 1);
+    const __m128 b0 = _mm256_castps256_ps128(b);
+    const __m128 b1 = _mm256_extractf128_ps(b, 1);
+    const __m128 a01 = _mm_add_ps(_mm_unpacklo_ps(a0, a1), _mm_unpackhi_ps(a0, a1));
+    const __m128 b01 = _mm_add_ps(_mm_unpacklo_ps(b0, b1), _mm_unpackhi_ps(b0, b1));
+    return _mm_add_ps(_mm_movelh_ps(a01, b01), _mm_movehl_ps(b01, a01));
+}
+
+template <bool Stereo, bool Adding>
+void sincInterpolateAVXImpl(const SincTableAVX& ws, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    const int j0 = 1 - static_cast<int>(points) / 2;
+    const __m256 ramp = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 0.0f, 1.0f, 2.0f, 3.0f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+
+    auto store = [&](unsigned n, float left, float right) {
+        if (Adding) {
+            outputLeft[n] += addingGains[n] * left;
+            if (Stereo)
+                outputRight[n] += addingGains[n] * right;
+        } else {
+            outputLeft[n] = left;
+            if (Stereo)
+                outputRight[n] = right;
+        }
+    };
+
+    // 2 output frames per iteration, one in each 128-bit lane,
+    // sharing the coefficients across channels
+    unsigned n = 0;
+    for (; n + 2 <= size; n += 2) {
+        const float* leftA = inputLeft + indices[n] + j0;
+        const float* leftB = inputLeft + indices[n + 1] + j0;
+        const float* rightA = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        const float* rightB = Stereo ? inputRight + indices[n + 1] + j0 : nullptr;
+        __m256 x = _mm256_add_ps(
+            _mm256_setr_ps(
+                j0 - coeffs[n], j0 - coeffs[n], j0 - coeffs[n], j0 - coeffs[n],
+                j0 - coeffs[n + 1], j0 - coeffs[n + 1], j0 - coeffs[n + 1], j0 - coeffs[n + 1]),
+            ramp);
+        __m256 yLeft = _mm256_setzero_ps();
+        __m256 yRight = _mm256_setzero_ps();
+        for (unsigned i = 0; i < points; i += 4) {
+            const __m256 h = ws.lookup(x);
+            yLeft = _mm256_add_ps(yLeft, _mm256_mul_ps(h, loadu2(leftA + i, leftB + i)));
+            if (Stereo)
+                yRight = _mm256_add_ps(yRight, _mm256_mul_ps(h, loadu2(rightA + i, rightB + i)));
+            x = _mm256_add_ps(x, four);
+        }
+
+        alignas(16) float y[4];
+        _mm_store_ps(y, horizontalSumsAVX(yLeft, yRight));
+        store(n, y[0], y[2]);
+        store(n + 1, y[1], y[3]);
+    }
+
+    // the last frame goes in both lanes
+    if (n < size) {
+        const float* left = inputLeft + indices[n] + j0;
+        const float* right = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        __m256 x = _mm256_add_ps(_mm256_set1_ps(j0 - coeffs[n]), ramp);
+        __m256 yLeft = _mm256_setzero_ps();
+        __m256 yRight = _mm256_setzero_ps();
+        for (unsigned i = 0; i < points; i += 4) {
+            const __m256 h = ws.lookup(x);
+            yLeft = _mm256_add_ps(yLeft, _mm256_mul_ps(h, loadu2(left + i, left + i)));
+            if (Stereo)
+                yRight = _mm256_add_ps(yRight, _mm256_mul_ps(h, loadu2(right + i, right + i)));
+            x = _mm256_add_ps(x, four);
+        }
+
+        alignas(16) float y[4];
+        _mm_store_ps(y, horizontalSumsAVX(yLeft, yRight));
+        store(n, y[0], y[2]);
+    }
+}
+
+} // namespace
+#endif
+
+void sincInterpolateAVX(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_AVX
+    const SincTableAVX ws { table, tableSize, points };
+    if (inputRight) {
+        if (addingGains)
+            sincInterpolateAVXImpl<true, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateAVXImpl<true, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    } else {
+        if (addingGains)
+            sincInterpolateAVXImpl<false, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateAVXImpl<false, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    }
+    _mm256_zeroupper();
+#else
+    sincInterpolateScalar(table, tableSize, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+#endif
+}
@@ -8,3 +8,6 @@
 
 void gain1AVX(float gain, const float* input, float* output, unsigned size) noexcept;
 void gainAVX(const float* gain, const float* input, float* output, unsigned size) noexcept;
+void sincInterpolateAVX(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept;
@@ -5,7 +5,9 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "HelpersNEON.h"
+#include "../SIMDConfig.h"
 #include "Common.h"
+#include "HelpersScalar.h"
 
 #if SFIZZ_HAVE_NEON
 #include <arm_neon.h>
@@ -14,3 +16,139 @@
 using Type = float;
 constexpr unsigned TypeAlignment = 4;
 constexpr unsigned ByteAlignment = TypeAlignment * sizeof(Type);
+
+#if SFIZZ_HAVE_NEON
+namespace {
+
+struct SincTableNEON {
+    SincTableNEON(const float* table, unsigned tableSize, unsigned points) noexcept
+        : table(table)
+        , offset(vdupq_n_f32(points / 2.0f))
+        , scale(vdupq_n_f32(static_cast<float>((tableSize - 1) / points)))
+    {
+    }
+
+    // interpolate the table at 4 positions, like `AbstractWindowedSinc::getUncheckedX4`
+    float32x4_t lookup(float32x4_t x) const noexcept
+    {
+        const float32x4_t ix = vmulq_f32(vaddq_f32(x, offset), scale);
+        const int32x4_t i0 = vcvtq_s32_f32(ix);
+        int32_t j[4];
+        vst1q_s32(j, i0);
+        const float32x4_t mu = vsubq_f32(ix, vcvtq_f32_s32(i0));
+
+        const float32x4_t p0p1 = vcombine_f32(vld1_f32(&table[j[0]]), vld1_f32(&table[j[1]]));
+        const float32x4_t p2p3 = vcombine_f32(vld1_f32(&table[j[2]]), vld1_f32(&table[j[3]]));
+        const float32x4x2_t y = vuzpq_f32(p0p1, p2p3);
+        return vaddq_f32(y.val[0], vmulq_f32(mu, vsubq_f32(y.val[1], y.val[0])));
+    }
+
+    const float* table;
+    float32x4_t offset;
+    float32x4_t scale;
+};
+
+inline float horizontalSumNEON(float32x4_t x) noexcept
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vaddvq_f32(x);
+#else
+    const float32x2_t s = vadd_f32(vget_low_f32(x), vget_high_f32(x));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+template <bool Stereo, bool Adding>
+void sincInterpolateNEONImpl(const SincTableNEON& ws, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    const int j0 = 1 - static_cast<int>(points) / 2;
+    const float rampValues[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const float32x4_t ramp = vld1q_f32(rampValues);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+
+    auto store = [&](unsigned n, float left, float right) {
+        if (Adding) {
+            outputLeft[n] += addingGains[n] * left;
+            if (Stereo)
+                outputRight[n] += addingGains[n] * right;
+        } else {
+            outputLeft[n] = left;
+            if (Stereo)
+                outputRight[n] = right;
+        }
+    };
+
+    // 2 output frames per iteration, sharing the coefficients across channels
+    unsigned n = 0;
+    for (; n + 2 <= size; n += 2) {
+        const float* leftA = inputLeft + indices[n] + j0;
+        const float* leftB = inputLeft + indices[n + 1] + j0;
+        const float* rightA = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        const float* rightB = Stereo ? inputRight + indices[n + 1] + j0 : nullptr;
+        float32x4_t xA = vaddq_f32(vdupq_n_f32(j0 - coeffs[n]), ramp);
+        float32x4_t xB = vaddq_f32(vdupq_n_f32(j0 - coeffs[n + 1]), ramp);
+        float32x4_t yLeftA = vdupq_n_f32(0.0f);
+        float32x4_t yLeftB = vdupq_n_f32(0.0f);
+        float32x4_t yRightA = vdupq_n_f32(0.0f);
+        float32x4_t yRightB = vdupq_n_f32(0.0f);
+        for (unsigned i = 0; i < points; i += 4) {
+            const float32x4_t hA = ws.lookup(xA);
+            const float32x4_t hB = ws.lookup(xB);
+            yLeftA = vaddq_f32(yLeftA, vmulq_f32(hA, vld1q_f32(leftA + i)));
+            yLeftB = vaddq_f32(yLeftB, vmulq_f32(hB, vld1q_f32(leftB + i)));
+            if (Stereo) {
+                yRightA = vaddq_f32(yRightA, vmulq_f32(hA, vld1q_f32(rightA + i)));
+                yRightB = vaddq_f32(yRightB, vmulq_f32(hB, vld1q_f32(rightB + i)));
+            }
+            xA = vaddq_f32(xA, four);
+            xB = vaddq_f32(xB, four);
+        }
+
+        store(n, horizontalSumNEON(yLeftA), horizontalSumNEON(yRightA));
+        store(n + 1, horizontalSumNEON(yLeftB), horizontalSumNEON(yRightB));
+    }
+
+    for (; n < size; ++n) {
+        const float* left = inputLeft + indices[n] + j0;
+        const float* right = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        float32x4_t x = vaddq_f32(vdupq_n_f32(j0 - coeffs[n]), ramp);
+        float32x4_t yLeft = vdupq_n_f32(0.0f);
+        float32x4_t yRight = vdupq_n_f32(0.0f);
+        for (unsigned i = 0; i < points; i += 4) {
+            const float32x4_t h = ws.lookup(x);
+            yLeft = vaddq_f32(yLeft, vmulq_f32(h, vld1q_f32(left + i)));
+            if (Stereo)
+                yRight = vaddq_f32(yRight, vmulq_f32(h, vld1q_f32(right + i)));
+            x = vaddq_f32(x, four);
+        }
+
+        store(n, horizontalSumNEON(yLeft), horizontalSumNEON(yRight));
+    }
+}
+
+} // namespace
+#endif
+
+void sincInterpolateNEON(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_NEON
+    const SincTableNEON ws { table, tableSize, points };
+    if (inputRight) {
+        if (addingGains)
+            sincInterpolateNEONImpl<true, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateNEONImpl<true, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    } else {
+        if (addingGains)
+            sincInterpolateNEONImpl<false, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateNEONImpl<false, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    }
+#else
+    sincInterpolateScalar(table, tableSize, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+#endif
+}
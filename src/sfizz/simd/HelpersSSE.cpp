@@ -8,6 +8,7 @@
 #include "../SIMDConfig.h"
 #include "../MathHelpers.h"
 #include "Common.h"
+#include "HelpersScalar.h"
 #include <array>
 
 #if SFIZZ_HAVE_SSE2
@@ -587,3 +588,143 @@ bool allWithinSSE(const float* input, float low, float high, unsigned size) noex
 
     return true;
 }
+
+#if SFIZZ_HAVE_SSE2
+namespace {
+
+struct SincTableSSE {
+    SincTableSSE(const float* table, unsigned tableSize, unsigned points) noexcept
+        : table(table)
+        , offset(_mm_set1_ps(points / 2.0f))
+        , scale(_mm_set1_ps(static_cast<float>((tableSize - 1) / points)))
+    {
+    }
+
+    // interpolate the table at 4 positions, like `AbstractWindowedSinc::getUncheckedX4`
+    __m128 lookup(__m128 x) const noexcept
+    {
+        const __m128 ix = _mm_mul_ps(_mm_add_ps(x, offset), scale);
+        const __m128i i0 = _mm_cvttps_epi32(ix);
+        alignas(16) int j[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(j), i0);
+        const __m128 mu = _mm_sub_ps(ix, _mm_cvtepi32_ps(i0));
+
+        __m128 p0p1 = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&table[j[0]])));
+        __m128 p2p3 = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&table[j[2]])));
+        p0p1 = _mm_loadh_pi(p0p1, reinterpret_cast<const __m64*>(&table[j[1]]));
+        p2p3 = _mm_loadh_pi(p2p3, reinterpret_cast<const __m64*>(&table[j[3]]));
+        const __m128 y0 = _mm_shuffle_ps(p0p1, p2p3, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 y1 = _mm_shuffle_ps(p0p1, p2p3, _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm_add_ps(y0, _mm_mul_ps(mu, _mm_sub_ps(y1, y0)));
+    }
+
+    const float* table;
+    __m128 offset;
+    __m128 scale;
+};
+
+// horizontal sums of a, b, c, d, in this order
+inline __m128 horizontalSumsSSE(__m128 a, __m128 b, __m128 c, __m128 d) noexcept
+{
+    const __m128 ab = _mm_add_ps(_mm_unpacklo_ps(a, b), _mm_unpackhi_ps(a, b));
+    const __m128 cd = _mm_add_ps(_mm_unpacklo_ps(c, d), _mm_unpackhi_ps(c, d));
+    return _mm_add_ps(_mm_movelh_ps(ab, cd), _mm_movehl_ps(cd, ab));
+}
+
+template <bool Stereo, bool Adding>
+void sincInterpolateSSEImpl(const SincTableSSE& ws, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+    const int j0 = 1 - static_cast<int>(points) / 2;
+    const __m128 ramp = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    auto store = [&](unsigned n, float left, float right) {
+        if (Adding) {
+            outputLeft[n] += addingGains[n] * left;
+            if (Stereo)
+                outputRight[n] += addingGains[n] * right;
+        } else {
+            outputLeft[n] = left;
+            if (Stereo)
+                outputRight[n] = right;
+        }
+    };
+
+    // 2 output frames per iteration, sharing the coefficients across channels
+    unsigned n = 0;
+    for (; n + 2 <= size; n += 2) {
+        const float* leftA = inputLeft + indices[n] + j0;
+        const float* leftB = inputLeft + indices[n + 1] + j0;
+        const float* rightA = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        const float* rightB = Stereo ? inputRight + indices[n + 1] + j0 : nullptr;
+        __m128 xA = _mm_add_ps(_mm_set1_ps(j0 - coeffs[n]), ramp);
+        __m128 xB = _mm_add_ps(_mm_set1_ps(j0 - coeffs[n + 1]), ramp);
+        __m128 yLeftA = _mm_setzero_ps();
+        __m128 yLeftB = _mm_setzero_ps();
+        __m128 yRightA = _mm_setzero_ps();
+        __m128 yRightB = _mm_setzero_ps();
+        for (unsigned i = 0; i < points; i += 4) {
+            const __m128 hA = ws.lookup(xA);
+            const __m128 hB = ws.lookup(xB);
+            yLeftA = _mm_add_ps(yLeftA, _mm_mul_ps(hA, _mm_loadu_ps(leftA + i)));
+            yLeftB = _mm_add_ps(yLeftB, _mm_mul_ps(hB, _mm_loadu_ps(leftB + i)));
+            if (Stereo) {
+                yRightA = _mm_add_ps(yRightA, _mm_mul_ps(hA, _mm_loadu_ps(rightA + i)));
+                yRightB = _mm_add_ps(yRightB, _mm_mul_ps(hB, _mm_loadu_ps(rightB + i)));
+            }
+            xA = _mm_add_ps(xA, four);
+            xB = _mm_add_ps(xB, four);
+        }
+
+        alignas(16) float y[4];
+        _mm_store_ps(y, horizontalSumsSSE(yLeftA, yLeftB, yRightA, yRightB));
+        store(n, y[0], y[2]);
+        store(n + 1, y[1], y[3]);
+    }
+
+    for (; n < size; ++n) {
+        const float* left = inputLeft + indices[n] + j0;
+        const float* right = Stereo ? inputRight + indices[n] + j0 : nullptr;
+        __m128 x = _mm_add_ps(_mm_set1_ps(j0 - coeffs[n]), ramp);
+        __m128 yLeft = _mm_setzero_ps();
+        __m128 yRight = _mm_setzero_ps();
+        for (unsigned i = 0; i < points; i += 4) {
+            const __m128 h = ws.lookup(x);
+            yLeft = _mm_add_ps(yLeft, _mm_mul_ps(h, _mm_loadu_ps(left + i)));
+            if (Stereo)
+                yRight = _mm_add_ps(yRight, _mm_mul_ps(h, _mm_loadu_ps(right + i)));
+            x = _mm_add_ps(x, four);
+        }
+
+        alignas(16) float y[4];
+        _mm_store_ps(y, horizontalSumsSSE(yLeft, yRight, yLeft, yRight));
+        store(n, y[0], y[1]);
+    }
+}
+
+} // namespace
+#endif
+
+void sincInterpolateSSE(const float* table, unsigned tableSize, unsigned points,
+    const float* inputLeft, const float* inputRight, float* outputLeft, float* outputRight,
+    const int* indices, const float* coeffs, const float* addingGains, unsigned size) noexcept
+{
+#if SFIZZ_HAVE_SSE2
+    const SincTableSSE ws { table, tableSize, points };
+    if (inputRight) {
+        if (addingGains)
+            sincInterpolateSSEImpl<true, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateSSEImpl<true, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    } else {
+        if (addingGains)
+            sincInterpolateSSEImpl<false, true>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+        else
+            sincInterpolateSSEImpl<false, false>(ws, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+    }
+#else
+    sincInterpolateScalar(table, tableSize, points, inputLeft, inputRight, outputLeft, outputRight, indices, coeffs, addingGains, size);
+#endif
+}
@@ -6,6 +6,7 @@
 
 #pragma once
 #include <algorithm>
+#include <cstdint>
 
 template<class T>
 inline void readInterleavedScalar(const T* input, T* outputLeft, T* outputRight, unsigned inputSize) noexcept
@@ -236,3 +237,40 @@ bool allWithinScalar(const T* input, T low, T high, unsigned size ) noexcept
 
     return true;
 }
+
+template <class T>
+void sincInterpolateScalar(const T* table, unsigned tableSize, unsigned points,
+    const T* inputLeft, const T* inputRight, T* outputLeft, T* outputRight,
+    const int* indices, const T* coeffs, const T* addingGains, unsigned size) noexcept
+{
+    const T offset = points / T(2);
+    const T scale = static_cast<T>((tableSize - 1) / points);
+    const int j0 = 1 - static_cast<int>(points) / 2;
+
+    for (unsigned n = 0; n < size; ++n) {
+        const T* left = inputLeft + indices[n] + j0;
+        const T* right = inputRight ? inputRight + indices[n] + j0 : nullptr;
+        const T x0 = j0 - coeffs[n];
+        T yLeft = 0;
+        T yRight = 0;
+        for (unsigned i = 0; i < points; ++i) {
+            const T ix = (x0 + static_cast<T>(i) + offset) * scale;
+            const intptr_t i0 = static_cast<intptr_t>(ix);
+            const T mu = ix - static_cast<T>(i0);
+            const T h = table[i0] + mu * (table[i0 + 1] - table[i0]);
+            yLeft += h * left[i];
+            if (right)
+                yRight += h * right[i];
+        }
+
+        if (addingGains) {
+            outputLeft[n] += addingGains[n] * yLeft;
+            if (right)
+                outputRight[n] += addingGains[n] * yRight;
+        } else {
+            outputLeft[n] = yLeft;
+            if (right)
+                outputRight[n] = yRight;
+        }
+    }
+}
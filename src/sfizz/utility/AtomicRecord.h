@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace sfz
+{
+
+/**
+ * @brief Storage for a plain record which is written by a thread while other
+ * threads may read it, as in the history rings of the profiler and the
+ * latency monitor.
+ *
+ * The record is copied through relaxed atomic words, so a concurrent read is
+ * not a data race; it can however return a mix of two records, and the reader
+ * has to check against the writer's counters whether its copy can be trusted.
+ */
+template <class T>
+class AtomicRecord {
+    static_assert(std::is_trivially_copyable<T>::value, "The record must be trivially copyable");
+
+public:
+    AtomicRecord() noexcept
+    {
+        store(T());
+    }
+
+    void store(const T& record) noexcept
+    {
+        std::array<uint64_t, numWords> words {};
+        std::memcpy(words.data(), &record, sizeof(T));
+        for (size_t i = 0; i < numWords; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    T load() const noexcept
+    {
+        std::array<uint64_t, numWords> words;
+        for (size_t i = 0; i < numWords; ++i)
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        T record;
+        std::memcpy(static_cast<void*>(&record), words.data(), sizeof(T));
+        return record;
+    }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::array<std::atomic<uint64_t>, numWords> words_;
+};
+
+} // namespace sfz
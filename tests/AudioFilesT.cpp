@@ -7,6 +7,7 @@
 #include "AudioSpan.h"
 #include "absl/types/span.h"
 #include "sfizz/Synth.h"
+#include "sfizz/AudioReader.h"
 #include "TestHelpers.h"
 #include "catch2/catch.hpp"
 #include "st_audiofile.hpp"
@@ -48,6 +49,79 @@ TEST_CASE("[AudioFiles] Compare WV and WAV")
 }
 #endif
 
+TEST_CASE("[AudioFiles] Memory-mapped PCM reader")
+{
+    for (const char* name : { "kick.wav", "stereo_sample.wav", "looped_flute.wav" }) {
+        const fs::path path = fs::current_path() / "tests/TestFiles" / name;
+        auto file = ST_AudioFile();
+#if defined(_WIN32)
+        file.open_file_w(path.wstring().c_str());
+#else
+        file.open_file(path.string().c_str());
+#endif
+        const unsigned channels = file.get_channels();
+        const size_t frames = file.get_frame_count();
+        std::vector<float> expected (channels * frames);
+        REQUIRE(file.read_f32(expected.data(), frames) == frames);
+
+        auto forward = sfz::createAudioReader(path, false);
+        REQUIRE(forward->type() == sfz::AudioReaderType::Forward);
+        REQUIRE(forward->channels() == channels);
+        REQUIRE(static_cast<size_t>(forward->frames()) == frames);
+        REQUIRE(forward->sampleRate() == static_cast<unsigned>(file.get_sample_rate()));
+        std::vector<float> interleaved (channels * frames);
+        REQUIRE(forward->readNextBlock(interleaved.data(), frames) == frames);
+        REQUIRE(forward->readNextBlock(interleaved.data(), frames) == 0);
+        REQUIRE(approxEqual<float>(interleaved, expected));
+
+        auto reverse = sfz::createAudioReader(path, true);
+        REQUIRE(reverse->type() == sfz::AudioReaderType::Reverse);
+        sfz::AudioBuffer<float> planar { channels, frames };
+        REQUIRE(reverse->readNextBlockPlanar(planar) == frames);
+        std::vector<float> expectedChannel (frames);
+        for (unsigned c = 0; c < channels; ++c) {
+            for (size_t i = 0; i < frames; ++i)
+                expectedChannel[i] = expected[(frames - 1 - i) * channels + c];
+            REQUIRE(approxEqual<float>(planar.getConstSpan(c), expectedChannel));
+        }
+    }
+}
+
+#if !defined(_WIN32)
+TEST_CASE("[AudioFiles] Memory-mapped PCM reader of a truncated file")
+{
+    const fs::path source = fs::current_path() / "tests/TestFiles/kick.wav";
+    const fs::path path = fs::temp_directory_path() / "sfizz_truncated_kick.wav";
+    fs::copy_file(source, path, fs::copy_options::overwrite_existing);
+
+    auto complete = sfz::createAudioReader(path, false);
+    const unsigned channels = complete->channels();
+    const size_t frames = static_cast<size_t>(complete->frames());
+    std::vector<float> expected (channels * frames);
+    REQUIRE(complete->readNextBlock(expected.data(), frames) == frames);
+
+    auto forward = sfz::createAudioReader(path, false);
+    auto reverse = sfz::createAudioReader(path, true);
+    std::vector<float> interleaved (channels * frames);
+    const size_t half = frames / 2;
+    REQUIRE(forward->readNextBlock(interleaved.data(), half) == half);
+
+    // The mapped pages past the end of the file are not accessible anymore
+    fs::resize_file(path, fs::file_size(path) * 3 / 4);
+    const size_t numFramesRead = forward->readNextBlock(&interleaved[half * channels], frames - half);
+    REQUIRE(numFramesRead > 0);
+    REQUIRE(numFramesRead < frames - half);
+    const size_t numSamples = (half + numFramesRead) * channels;
+    REQUIRE(std::equal(interleaved.begin(), interleaved.begin() + numSamples, expected.begin()));
+    REQUIRE(reverse->readNextBlock(interleaved.data(), frames) == 0);
+
+    complete.reset();
+    forward.reset();
+    reverse.reset();
+    fs::remove(path);
+}
+#endif
+
 struct CompareOutputOpts
 {
     int note { 60 };
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/effects/impl/PartitionedConvolver.h"
+#include "sfizz/effects/Convolution.h"
+#include "sfizz/Synth.h"
+#include "sfizz/Effects.h"
+#include "sfizz/AudioBuffer.h"
+#include "TestHelpers.h"
+#include "catch2/catch.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<float> randomSignal(size_t size, unsigned seed)
+{
+    std::minstd_rand prng { seed };
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    std::vector<float> signal(size);
+    for (float& x : signal)
+        x = dist(prng);
+    return signal;
+}
+
+std::vector<float> directConvolution(const std::vector<float>& input, const std::vector<float>& ir)
+{
+    std::vector<float> output(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        double sum = 0.0;
+        for (size_t j = 0; j < ir.size() && j <= i; ++j)
+            sum += double(ir[j]) * input[i - j];
+        output[i] = static_cast<float>(sum);
+    }
+    return output;
+}
+
+// Convolve by irregular chunks, and check against the direct convolution
+void checkConvolution(sfz::fx::PartitionedConvolver& convolver,
+    const std::vector<float>& irLeft, const std::vector<float>& irRight, size_t numFrames)
+{
+    const std::vector<float> inputLeft = randomSignal(numFrames, 3);
+    const std::vector<float> inputRight = randomSignal(numFrames, 4);
+    std::vector<float> outputLeft(numFrames);
+    std::vector<float> outputRight(numFrames);
+
+    std::minstd_rand prng { 5 };
+    std::uniform_int_distribution<size_t> chunkDist { 1, 100 };
+    for (size_t done = 0; done < numFrames;) {
+        const size_t chunk = std::min(chunkDist(prng), numFrames - done);
+        const float* inputs[] = { &inputLeft[done], &inputRight[done] };
+        float* outputs[] = { &outputLeft[done], &outputRight[done] };
+        convolver.process(inputs, outputs, static_cast<unsigned>(chunk));
+        done += chunk;
+    }
+
+    REQUIRE( approxEqual<float>(outputLeft, directConvolution(inputLeft, irLeft), 1e-4f) );
+    REQUIRE( approxEqual<float>(outputRight, directConvolution(inputRight, irRight), 1e-4f) );
+}
+
+} // namespace
+
+TEST_CASE("[Convolution] Long mono response")
+{
+    // small partitions to cover all the segments, including the background one
+    sfz::fx::PartitionedConvolver convolver { 8, 32, 128 };
+    convolver.setFreewheeling(true);
+    const std::vector<float> ir = randomSignal(1000, 1);
+    convolver.setImpulseResponse(sfz::AudioSpan<const float>({ ir.data() }, ir.size()));
+    REQUIRE( convolver.getLength() == ir.size() );
+    checkConvolution(convolver, ir, ir, 3000);
+
+    convolver.clear();
+    checkConvolution(convolver, ir, ir, 3000);
+}
+
+TEST_CASE("[Convolution] Stereo response")
+{
+    sfz::fx::PartitionedConvolver convolver { 8, 32, 128 };
+    convolver.setFreewheeling(true);
+    const std::vector<float> irLeft = randomSignal(300, 1);
+    const std::vector<float> irRight = randomSignal(300, 2);
+    convolver.setImpulseResponse(
+        sfz::AudioSpan<const float>({ irLeft.data(), irRight.data() }, irLeft.size()));
+    checkConvolution(convolver, irLeft, irRight, 1000);
+}
+
+TEST_CASE("[Convolution] Short responses")
+{
+    sfz::fx::PartitionedConvolver convolver { 8, 32, 128 };
+    convolver.setFreewheeling(true);
+    for (size_t length : { 1, 5, 8, 9, 32, 33, 256, 257 }) {
+        const std::vector<float> ir = randomSignal(length, 1);
+        convolver.setImpulseResponse(sfz::AudioSpan<const float>({ ir.data() }, ir.size()));
+        checkConvolution(convolver, ir, ir, 600);
+    }
+}
+
+TEST_CASE("[Convolution] Real-time tail")
+{
+    // without freewheeling, the tail is skipped when the thread is late, so
+    // only the bounds which hold whatever the timing are checked
+    sfz::fx::PartitionedConvolver convolver { 8, 32, 128 };
+    const std::vector<float> ir = randomSignal(1000, 1);
+    convolver.setImpulseResponse(sfz::AudioSpan<const float>({ ir.data() }, ir.size()));
+
+    const size_t numFrames = 3000;
+    const size_t tailStart = 2 * 128;
+    const std::vector<float> input = randomSignal(numFrames, 3);
+    std::vector<float> outputLeft(numFrames);
+    std::vector<float> outputRight(numFrames);
+    for (size_t done = 0; done < numFrames; done += 64) {
+        const size_t chunk = std::min<size_t>(64, numFrames - done);
+        const float* inputs[] = { &input[done], &input[done] };
+        float* outputs[] = { &outputLeft[done], &outputRight[done] };
+        convolver.process(inputs, outputs, static_cast<unsigned>(chunk));
+    }
+
+    const std::vector<float> expected = directConvolution(input, ir);
+    REQUIRE( convolver.getNumTailUnderruns() <= numFrames / 128 );
+    REQUIRE( approxEqual<float>(absl::MakeConstSpan(outputLeft).first(tailStart),
+        absl::MakeConstSpan(expected).first(tailStart), 1e-4f) );
+    REQUIRE( outputRight == outputLeft );
+    if (convolver.getNumTailUnderruns() == 0)
+        REQUIRE( approxEqual<float>(outputLeft, expected, 1e-4f) );
+
+    // clearing does not wait for the thread, and drops the result of its job
+    convolver.clear();
+    convolver.setFreewheeling(true);
+    checkConvolution(convolver, ir, ir, 3000);
+}
+
+TEST_CASE("[Convolution] Without response")
+{
+    sfz::fx::PartitionedConvolver convolver;
+    const std::vector<float> input = randomSignal(64, 1);
+    std::vector<float> output(64, 1.0f);
+    const float* inputs[] = { input.data(), input.data() };
+    float* outputs[] = { output.data(), output.data() };
+    convolver.process(inputs, outputs, 64);
+    REQUIRE( convolver.getLength() == 0 );
+    REQUIRE( output == std::vector<float>(64, 0.0f) );
+}
+
+TEST_CASE("[Convolution] Resampled response")
+{
+    auto resampledSine = [](double frequency, double ratio) {
+        std::vector<float> sine(4000);
+        for (size_t i = 0; i < sine.size(); ++i)
+            sine[i] = static_cast<float>(std::sin(2 * M_PI * frequency * i));
+        auto resampled = sfz::fx::Convolution::resampleImpulseResponse(
+            sfz::AudioSpan<const float>({ sine.data() }, sine.size()), ratio);
+        return std::vector<float>(resampled.getConstSpan(0).begin(), resampled.getConstSpan(0).end());
+    };
+
+    // away from the edges, where the kernel runs out of the response
+    auto middle = [](const std::vector<float>& signal) {
+        return absl::MakeConstSpan(signal).subspan(100, signal.size() - 200);
+    };
+
+    // a low frequency keeps its shape, scaled by the ratio
+    for (double ratio : { 2.0, 96000.0 / 44100.0, 44100.0 / 48000.0 }) {
+        const double frequency = 0.01;
+        const std::vector<float> output = resampledSine(frequency, ratio);
+        REQUIRE( output.size() == static_cast<size_t>(std::ceil(4000 / ratio)) );
+        std::vector<float> expected(output.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+            expected[i] = static_cast<float>(ratio * std::sin(2 * M_PI * frequency * ratio * i));
+        REQUIRE( approxEqual<float>(middle(output), middle(expected), 1e-2f) );
+    }
+
+    // a frequency above the target Nyquist is removed rather than aliased
+    for (double ratio : { 2.0, 96000.0 / 44100.0 }) {
+        const std::vector<float> output = resampledSine(0.45, ratio);
+        for (float x : middle(output))
+            REQUIRE( std::abs(x) < 1e-2f );
+    }
+}
+
+TEST_CASE("[Convolution] Impulse response file")
+{
+    sfz::Synth synth;
+    synth.setSampleRate(44100);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/convolution.sfz", R"(
+        <region> sample=*sine effect1=100
+        <effect> bus=fx1 fx1tomain=100 type=convolution conv_ir=kick.wav
+        <effect> bus=fx2 fx2tomain=100 type=convolution conv_ir=nonexistent.wav
+    )");
+
+    const sfz::EffectBus* bus = synth.getEffectBusView(1);
+    REQUIRE( bus != nullptr );
+    REQUIRE( bus->numEffects() == 1 );
+    const size_t length = bus->effectView(0)->getTailLength();
+    REQUIRE( length > 0 );
+
+    synth.setSampleRate(88200);
+    REQUIRE( bus->effectView(0)->getTailLength() == 2 * length );
+
+    bus = synth.getEffectBusView(2);
+    REQUIRE( bus != nullptr );
+    REQUIRE( bus->effectView(0)->getTailLength() == 0 );
+}
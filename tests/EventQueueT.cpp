@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/EventQueue.h"
+#include "sfizz/Synth.h"
+#include "sfizz/MidiState.h"
+#include "catch2/catch.hpp"
+#include <array>
+#include <thread>
+#include <vector>
+using namespace Catch::literals;
+
+namespace {
+
+sfz::QueuedEvent makeEvent(int64_t frame, uint8_t number)
+{
+    sfz::QueuedEvent event;
+    event.frame = frame;
+    event.data[0] = 0x90;
+    event.data[1] = number;
+    event.data[2] = 100;
+    return event;
+}
+
+struct Dispatched {
+    int number;
+    int delay;
+    bool operator==(const Dispatched& other) const
+    {
+        return number == other.number && delay == other.delay;
+    }
+};
+
+std::vector<Dispatched> drain(sfz::EventQueue& queue, unsigned numFrames)
+{
+    std::vector<Dispatched> dispatched;
+    queue.drain(numFrames, [&dispatched](const sfz::QueuedEvent& event, int delay) {
+        dispatched.push_back({ event.data[1], delay });
+    });
+    return dispatched;
+}
+
+} // namespace
+
+TEST_CASE("[EventQueue] Events are dispatched in the block which covers them")
+{
+    sfz::EventQueue queue { 64 };
+    REQUIRE( queue.getFrameTime() == 0 );
+    REQUIRE( queue.push(makeEvent(300, 3)) );
+    REQUIRE( queue.push(makeEvent(10, 1)) );
+    REQUIRE( queue.push(makeEvent(150, 2)) );
+    REQUIRE( queue.push(makeEvent(100, 4)) );
+
+    REQUIRE( drain(queue, 128) == std::vector<Dispatched> { { 1, 10 }, { 4, 100 } } );
+    REQUIRE( queue.getFrameTime() == 128 );
+    REQUIRE( drain(queue, 128) == std::vector<Dispatched> { { 2, 22 } } );
+    REQUIRE( queue.getFrameTime() == 256 );
+    REQUIRE( drain(queue, 128) == std::vector<Dispatched> { { 3, 44 } } );
+    REQUIRE( drain(queue, 128).empty() );
+    REQUIRE( queue.getFrameTime() == 512 );
+}
+
+TEST_CASE("[EventQueue] Late and immediate events")
+{
+    sfz::EventQueue queue { 64 };
+    drain(queue, 256);
+    REQUIRE( queue.push(makeEvent(200, 1)) );
+    REQUIRE( queue.push(makeEvent(-1, 2)) );
+    REQUIRE( queue.push(makeEvent(256, 3)) );
+    REQUIRE( queue.push(makeEvent(-1, 4)) );
+    REQUIRE( drain(queue, 256) == std::vector<Dispatched> { { 2, 0 }, { 4, 0 }, { 1, 0 }, { 3, 0 } } );
+}
+
+TEST_CASE("[EventQueue] Full queue")
+{
+    sfz::EventQueue queue { 16 };
+    constexpr unsigned maxPushed = 1u << 16;
+    unsigned numPushed = 0;
+    while (numPushed < maxPushed && queue.push(makeEvent(-1, 0)))
+        ++numPushed;
+    REQUIRE( numPushed >= 16 );
+    REQUIRE( numPushed < maxPushed );
+    REQUIRE( drain(queue, 256).size() == numPushed );
+    REQUIRE( queue.push(makeEvent(-1, 0)) );
+}
+
+TEST_CASE("[EventQueue] Several producers")
+{
+    constexpr unsigned numProducers = 4;
+    constexpr unsigned numEvents = 1000;
+    sfz::EventQueue queue { 256 };
+
+    std::array<std::thread, numProducers> producers;
+    for (unsigned p = 0; p < numProducers; ++p) {
+        producers[p] = std::thread([&queue, p]() {
+            for (unsigned i = 0; i < numEvents; ++i) {
+                sfz::QueuedEvent event = makeEvent(-1, static_cast<uint8_t>(p));
+                event.value = static_cast<float>(i);
+                while (!queue.push(event))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    std::array<unsigned, numProducers> received {};
+    bool ordered = true;
+    unsigned numReceived = 0;
+    while (numReceived < numProducers * numEvents) {
+        queue.drain(64, [&](const sfz::QueuedEvent& event, int delay) {
+            const unsigned p = event.data[1];
+            ordered = ordered && delay == 0 && event.value == static_cast<float>(received[p]);
+            ++received[p];
+            ++numReceived;
+        });
+        std::this_thread::yield();
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    REQUIRE( ordered );
+    for (unsigned p = 0; p < numProducers; ++p)
+        REQUIRE( received[p] == numEvents );
+}
+
+TEST_CASE("[EventQueue] Posting events to the synth")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    sfz::AudioBuffer<float> buffer { 2, 256 };
+    synth.loadSfzString("posted.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+
+    const int64_t start = synth.getFrameTime();
+    const uint8_t noteOn[3] { 0x90, 60, 100 };
+    const uint8_t noteOff[3] { 0x80, 60, 0 };
+    const uint8_t sysex[3] { 0xf0, 0x7e, 0x7f };
+    REQUIRE( synth.postMidiEvent(start + 300, noteOn, 3) );
+    REQUIRE( synth.postHdcc(start + 10, 300, 0.25f) );
+    REQUIRE( !synth.postMidiEvent(start, noteOn, 2) );
+    REQUIRE( !synth.postMidiEvent(start, sysex, 3) );
+
+    const sfz::MidiState& midiState = synth.getResources().getMidiState();
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getFrameTime() == start + 256 );
+    REQUIRE( midiState.getCCValue(300) == 0.25_a );
+    REQUIRE( synth.getNumActiveVoices() == 0 );
+
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 1 );
+
+    bool posted = false;
+    std::thread producer([&synth, &noteOff, &posted]() {
+        posted = synth.postMidiEvent(-1, noteOff, 3);
+    });
+    producer.join();
+    REQUIRE( posted );
+    REQUIRE( midiState.isNotePressed(60) );
+    synth.renderBlock(buffer);
+    REQUIRE( !midiState.isNotePressed(60) );
+}
@@ -7,6 +7,9 @@
 #include "TestHelpers.h"
 #include "sfizz/Synth.h"
 #include "sfizz/Voice.h"
+#include "sfizz/FilePool.h"
+#include "sfizz/Resources.h"
+#include "sfizz/SampleStore.h"
 #include "sfizz/SfzHelpers.h"
 #include "sfizz/parser/Parser.h"
 #include "sfizz/modulations/ModId.h"
@@ -780,6 +783,91 @@ TEST_CASE("[Files] Unused samples are cleared on reloading")
     REQUIRE(synth.getNumPreloadedSamples() == 0);
 }
 
+TEST_CASE("[Files] Reloading keeps the unchanged regions")
+{
+    sfz::Synth synth;
+    const fs::path path = fs::current_path() / "tests/TestFiles/incremental_reload.sfz";
+    synth.loadSfzString(path, R"(
+        <region> key=36 sample=kick.wav
+        <region> key=38 sample=snare.wav volume=-6
+        <region> key=42 sample=closedhat.wav
+    )");
+    REQUIRE(synth.getNumRegions() == 3);
+    const sfz::Region* kick = synth.getRegionView(0);
+    const sfz::Region* snare = synth.getRegionView(1);
+    const sfz::Region* hat = synth.getRegionView(2);
+    REQUIRE(kick->ccModDepth(7, sfz::ModId::Amplitude));
+
+    synth.loadSfzString(path, R"(
+        <region> key=36 sample=kick.wav
+        <region> key=38 sample=snare.wav volume=-3
+        <region> key=42 sample=closedhat.wav
+    )");
+    REQUIRE(synth.getNumRegions() == 3);
+    REQUIRE(synth.getRegionView(0) == kick);
+    REQUIRE(synth.getRegionView(1) != snare);
+    REQUIRE(synth.getRegionView(1)->volume == -3.0f);
+    REQUIRE(synth.getRegionView(2) == hat);
+    REQUIRE(synth.getNumPreloadedSamples() == 3);
+    REQUIRE(kick->ccModDepth(7, sfz::ModId::Amplitude));
+
+    // The default controllers are disconnected once used by a region
+    synth.loadSfzString(path, R"(
+        <region> key=36 sample=kick.wav
+        <region> key=38 sample=snare.wav volume=-3 amplitude_oncc7=50
+        <region> key=42 sample=closedhat.wav
+    )");
+    REQUIRE(synth.getRegionView(0) == kick);
+    REQUIRE(!kick->ccModDepth(7, sfz::ModId::Amplitude));
+    REQUIRE(synth.getRegionView(2) == hat);
+
+    // Regions after a removed one are built again
+    synth.loadSfzString(path, R"(
+        <region> key=38 sample=snare.wav volume=-3 amplitude_oncc7=50
+        <region> key=42 sample=closedhat.wav
+    )");
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getRegionView(1)->keyRange.getStart() == 42);
+    REQUIRE(synth.getNumPreloadedSamples() == 2);
+}
+
+TEST_CASE("[Files] Reloading reads the samples which changed on disk")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_changed_sample_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    const fs::path testFiles = fs::current_path() / "tests/TestFiles";
+    fs::copy_file(testFiles / "kick.wav", directory / "sample.wav");
+    fs::copy_file(testFiles / "snare.wav", directory / "snare.wav");
+
+    sfz::Synth synth;
+    const fs::path path = directory / "changed_sample.sfz";
+    const std::string sfz = R"(
+        <region> key=36 sample=sample.wav
+        <region> key=38 sample=snare.wav
+    )";
+    synth.loadSfzString(path, sfz);
+    REQUIRE(synth.getNumRegions() == 2);
+    const sfz::Region* changed = synth.getRegionView(0);
+    const sfz::Region* unchanged = synth.getRegionView(1);
+    REQUIRE(!changed->hasStereoSample);
+
+    fs::copy_file(testFiles / "stereo_sample.wav", directory / "sample.wav", fs::copy_options::overwrite_existing);
+    synth.loadSfzString(path, sfz);
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getRegionView(0) != changed);
+    REQUIRE(synth.getRegionView(0)->hasStereoSample);
+    REQUIRE(synth.getRegionView(1) == unchanged);
+    REQUIRE(synth.getNumPreloadedSamples() == 2);
+
+    auto fileId = std::make_shared<sfz::FileId>("sample.wav");
+    auto information = synth.getResources().getFilePool().getFileInformation(*fileId);
+    REQUIRE(information);
+    REQUIRE(information->numChannels == 2);
+
+    fs::remove_all(directory);
+}
+
 TEST_CASE("[Files] Key center from audio file, with embedded sample data")
 {
     sfz::Synth synth;
@@ -818,3 +906,244 @@ TEST_CASE("[Files] NewDrums: disappearing CCs (#1077)")
 
     REQUIRE( used == expected );
 }
+
+TEST_CASE("[Files] Preloading in parallel")
+{
+    sfz::Synth synth;
+    synth.setPreloadSize(1024);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/parallel_preload.sfz", R"(
+        <region> sample=kick.wav
+        <region> sample=kick.wav offset=2000
+        <region> sample=snare.wav
+        <region> sample=closedhat.wav
+        <region> sample=looped_flute.wav
+        <region> sample=missing.wav
+    )");
+    REQUIRE(synth.getNumRegions() == 5);
+    REQUIRE(synth.getNumPreloadedSamples() == 4);
+
+    sfz::FilePool& filePool = synth.getResources().getFilePool();
+    auto kick = filePool.getFilePromise(std::make_shared<sfz::FileId>("kick.wav"));
+    REQUIRE(kick);
+    REQUIRE(kick->information.maxOffset == 2000);
+    REQUIRE(kick->preloaded->data.getNumFrames() == 3024);
+    REQUIRE(kick->information.sampleRate == 44100.0);
+}
+
+TEST_CASE("[Files] Preloaded samples in integer formats")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/sample_format.sfz";
+    const std::string sfz = R"(
+        <region> sample=kick.wav
+        <region> sample=stereo_sample.wav offset=1000
+    )";
+
+    sfz::Synth reference;
+    reference.setPreloadSize(1024);
+    reference.loadSfzString(sfzPath, sfz);
+
+    sfz::Synth synth;
+    synth.setPreloadSize(1024);
+    synth.setSampleFormat(sfz::Synth::SampleInt24);
+    REQUIRE(synth.getSampleFormat() == sfz::Synth::SampleInt24);
+    synth.loadSfzString(sfzPath, sfz);
+
+    const auto checkFormat = [&](sfz::SampleFormat format) {
+        for (const char* sample : { "kick.wav", "stereo_sample.wav" }) {
+            auto fileId = std::make_shared<sfz::FileId>(sample);
+            auto expected = reference.getResources().getFilePool().getFilePromise(fileId);
+            auto compact = synth.getResources().getFilePool().getFilePromise(fileId);
+            REQUIRE(expected);
+            REQUIRE(compact);
+            REQUIRE(compact->preloaded->data.getNumFrames() == 0);
+            REQUIRE(compact->preloaded->compactData.getFormat() == format);
+            REQUIRE(compact->getNumPreloadedFrames() == expected->preloaded->data.getNumFrames());
+
+            // The 16-bit and 24-bit sources are stored exactly
+            const sfz::SampleSpan data = compact->getPreloadedData();
+            REQUIRE(data.getNumChannels() == expected->preloaded->data.getNumChannels());
+            for (size_t c = 0; c < data.getNumChannels(); ++c) {
+                const auto expectedSpan = expected->preloaded->data.getConstSpan(c);
+                for (size_t i = 0; i < expectedSpan.size(); ++i) {
+                    const float value = (format == sfz::SampleFormat::Int16) ?
+                        sfz::sampleValue<float>(data.getSpan<int16_t>().getConstSpan(c)[i]) :
+                        sfz::sampleValue<float>(data.getSpan<sfz::Int24>().getConstSpan(c)[i]);
+                    if (std::string(sample) == "kick.wav" || format == sfz::SampleFormat::Int24)
+                        REQUIRE(value == expectedSpan[i]);
+                    else
+                        REQUIRE(value == Approx(expectedSpan[i]).margin(1.0 / 32768));
+                }
+            }
+        }
+    };
+
+    checkFormat(sfz::SampleFormat::Int24);
+    synth.setSampleFormat(sfz::Synth::SampleInt16);
+    checkFormat(sfz::SampleFormat::Int16);
+
+    synth.setSampleFormat(sfz::Synth::SampleFloat);
+    auto kick = synth.getResources().getFilePool().getFilePromise(std::make_shared<sfz::FileId>("kick.wav"));
+    REQUIRE(kick->preloaded->compactData.empty());
+    REQUIRE(kick->preloaded->data.getNumFrames() == 1024);
+}
+
+TEST_CASE("[Files] Samples shared between synths")
+{
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/sample_sharing.sfz";
+    const std::string sfz = R"(
+        <region> sample=kick.wav
+        <region> sample=stereo_sample.wav offset=1000
+    )";
+
+    sfz::Synth first;
+    first.enableSampleSharing();
+    first.setPreloadSize(1024);
+    first.loadSfzString(sfzPath, sfz);
+
+    sfz::Synth second;
+    second.enableSampleSharing();
+    second.setPreloadSize(1024);
+    second.loadSfzString(sfzPath, sfz);
+
+    sfz::Synth alone;
+    alone.setPreloadSize(1024);
+    alone.loadSfzString(sfzPath, sfz);
+
+    REQUIRE(sfz::SampleStore::getGlobal()->getNumSamples() == 2);
+
+    for (const char* sample : { "kick.wav", "stereo_sample.wav" }) {
+        auto fileId = std::make_shared<sfz::FileId>(sample);
+        auto firstData = first.getResources().getFilePool().getFilePromise(fileId);
+        auto secondData = second.getResources().getFilePool().getFilePromise(fileId);
+        auto aloneData = alone.getResources().getFilePool().getFilePromise(fileId);
+        REQUIRE(firstData);
+        REQUIRE(secondData);
+        REQUIRE(aloneData);
+        REQUIRE(firstData->preloaded == secondData->preloaded);
+        REQUIRE(firstData->preloaded != aloneData->preloaded);
+        REQUIRE(secondData->fullyLoaded == aloneData->fullyLoaded);
+        REQUIRE(secondData->preloaded->data.getNumFrames() == aloneData->preloaded->data.getNumFrames());
+        for (size_t c = 0; c < aloneData->preloaded->data.getNumChannels(); ++c) {
+            REQUIRE(approxEqual<float>(
+                secondData->preloaded->data.getConstSpan(c), aloneData->preloaded->data.getConstSpan(c), 0.0f));
+        }
+    }
+
+    // A larger preload is read again, and a smaller one reuses it
+    const auto kickId = std::make_shared<sfz::FileId>("kick.wav");
+    second.setPreloadSize(4096);
+    {
+        auto firstKick = first.getResources().getFilePool().getFilePromise(kickId);
+        auto secondKick = second.getResources().getFilePool().getFilePromise(kickId);
+        REQUIRE(firstKick->preloaded != secondKick->preloaded);
+        REQUIRE(secondKick->getNumPreloadedFrames() == 4096);
+    }
+    first.setPreloadSize(2048);
+    {
+        auto firstKick = first.getResources().getFilePool().getFilePromise(kickId);
+        auto secondKick = second.getResources().getFilePool().getFilePromise(kickId);
+        REQUIRE(firstKick->preloaded == secondKick->preloaded);
+    }
+
+    // Another format is not shared
+    second.setSampleFormat(sfz::Synth::SampleInt16);
+    {
+        auto firstKick = first.getResources().getFilePool().getFilePromise(kickId);
+        auto secondKick = second.getResources().getFilePool().getFilePromise(kickId);
+        REQUIRE(firstKick->preloaded != secondKick->preloaded);
+        REQUIRE(secondKick->preloaded->compactData.getFormat() == sfz::SampleFormat::Int16);
+    }
+
+    // The frames are released along with the last synth using them
+    REQUIRE(sfz::SampleStore::getGlobal()->getNumSamples() == 4);
+    second.loadSfzString(sfzPath, "");
+    REQUIRE(sfz::SampleStore::getGlobal()->getNumSamples() == 2);
+    first.loadSfzString(sfzPath, "");
+    REQUIRE(sfz::SampleStore::getGlobal()->getNumSamples() == 0);
+}
+
+TEST_CASE("[Files] Sample sharing skips the files which changed on disk")
+{
+    const fs::path directory = fs::temp_directory_path() / "sfizz_shared_changed_sample_test";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    const fs::path testFiles = fs::current_path() / "tests/TestFiles";
+    fs::copy_file(testFiles / "kick.wav", directory / "sample.wav");
+
+    const fs::path sfzPath = directory / "shared_changed_sample.sfz";
+    const std::string sfz = "<region> sample=sample.wav";
+
+    sfz::Synth first;
+    first.enableSampleSharing();
+    first.loadSfzString(sfzPath, sfz);
+
+    fs::copy_file(testFiles / "stereo_sample.wav", directory / "sample.wav", fs::copy_options::overwrite_existing);
+    sfz::Synth second;
+    second.enableSampleSharing();
+    second.loadSfzString(sfzPath, sfz);
+    REQUIRE(sfz::SampleStore::getGlobal()->getNumSamples() == 2);
+
+    auto fileId = std::make_shared<sfz::FileId>("sample.wav");
+    auto firstData = first.getResources().getFilePool().getFilePromise(fileId);
+    auto secondData = second.getResources().getFilePool().getFilePromise(fileId);
+    REQUIRE(firstData);
+    REQUIRE(secondData);
+    REQUIRE(firstData->preloaded != secondData->preloaded);
+    REQUIRE(firstData->preloaded->data.getNumChannels() == 1);
+    REQUIRE(secondData->preloaded->data.getNumChannels() == 2);
+
+    first.loadSfzString(sfzPath, "");
+    second.loadSfzString(sfzPath, "");
+    fs::remove_all(directory);
+}
+
+TEST_CASE("[Files] Persistent preload cache")
+{
+    const fs::path cacheDirectory = fs::temp_directory_path() / "sfizz_preload_cache_test";
+    fs::remove_all(cacheDirectory);
+
+    const fs::path sfzPath = fs::current_path() / "tests/TestFiles/preload_cache.sfz";
+    const std::string sfz = R"(
+        <region> sample=kick.wav
+        <region> sample=stereo_sample.wav offset=1000
+    )";
+
+    sfz::Synth reference;
+    reference.setPreloadSize(1024);
+    reference.loadSfzString(sfzPath, sfz);
+
+    // The first load writes the cache files, the second one reads them
+    sfz::Synth writer;
+    writer.setPreloadSize(1024);
+    writer.setPreloadCacheDirectory(cacheDirectory);
+    REQUIRE(writer.getPreloadCacheDirectory() == cacheDirectory);
+    writer.loadSfzString(sfzPath, sfz);
+    const auto numCacheFiles = std::distance(fs::directory_iterator(cacheDirectory), fs::directory_iterator());
+    REQUIRE(numCacheFiles == 2);
+
+    sfz::Synth reader;
+    reader.setPreloadSize(1024);
+    reader.setPreloadCacheDirectory(cacheDirectory);
+    reader.loadSfzString(sfzPath, sfz);
+    REQUIRE(reader.getNumPreloadedSamples() == 2);
+
+    for (const char* sample : { "kick.wav", "stereo_sample.wav" }) {
+        auto fileId = std::make_shared<sfz::FileId>(sample);
+        auto expected = reference.getResources().getFilePool().getFilePromise(fileId);
+        auto cached = reader.getResources().getFilePool().getFilePromise(fileId);
+        REQUIRE(expected);
+        REQUIRE(cached);
+        REQUIRE(cached->information.end == expected->information.end);
+        REQUIRE(cached->information.sampleRate == expected->information.sampleRate);
+        REQUIRE(cached->information.numChannels == expected->information.numChannels);
+        REQUIRE(cached->information.maxOffset == expected->information.maxOffset);
+        REQUIRE(cached->preloaded->data.getNumChannels() == expected->preloaded->data.getNumChannels());
+        REQUIRE(cached->preloaded->data.getNumFrames() == expected->preloaded->data.getNumFrames());
+        for (size_t c = 0; c < expected->preloaded->data.getNumChannels(); ++c) {
+            REQUIRE(approxEqual<float>(
+                cached->preloaded->data.getConstSpan(c), expected->preloaded->data.getConstSpan(c)));
+        }
+    }
+
+    fs::remove_all(cacheDirectory);
+}
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/FilterBank.h"
+#include "sfizz/SfzFilter.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "catch2/catch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <random>
+#include <vector>
+using namespace sfz;
+
+namespace {
+constexpr double sampleRate { 44100.0 };
+constexpr unsigned blockSize { 100 }; // not a multiple of the control interval
+
+std::vector<float> noise(unsigned size, unsigned seed)
+{
+    std::minstd_rand prng { seed };
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    std::vector<float> data(size);
+    for (float& x : data)
+        x = dist(prng);
+    return data;
+}
+
+// Error of the frequency response of some coefficients against the exact
+// ones, relative to the response where it is above unity
+double responseError(const BiquadCoefficients& exact, const BiquadCoefficients& coefs)
+{
+    auto response = [](const BiquadCoefficients& k, double w) {
+        const std::complex<double> z = std::polar(1.0, -w);
+        return (k.b0 + k.b1 * z + k.b2 * z * z) / (1.0 + k.a1 * z + k.a2 * z * z);
+    };
+
+    double error = 0.0;
+    for (int i = 0; i < 60; ++i) {
+        const double w = 3.141592653589793 * std::exp2(-i / 6.0);
+        const std::complex<double> reference = response(exact, w);
+        const double difference = std::abs(reference - response(coefs, w));
+        error = std::max(error, difference / std::max(1.0, std::abs(reference)));
+    }
+    return error;
+}
+
+std::vector<float> sweep(unsigned size, float from, float to)
+{
+    std::vector<float> data(size);
+    for (unsigned i = 0; i < size; ++i)
+        data[i] = from + (to - from) * i / size;
+    return data;
+}
+}
+
+TEST_CASE("[FilterBank] Biquad types")
+{
+    REQUIRE( isBiquadType(kFilterLpf2p) );
+    REQUIRE( isBiquadType(kFilterHsh) );
+    REQUIRE( !isBiquadType(kFilterLpf2pSv) );
+    REQUIRE( !isBiquadType(kFilterLpf4p) );
+    REQUIRE( !isBiquadType(kFilterNone) );
+    REQUIRE( isBiquadType(kEqPeak) );
+    REQUIRE( !isBiquadType(kEqNone) );
+
+    Filter filter;
+    filter.init(sampleRate);
+    filter.setType(kFilterLpf4p);
+    BiquadCoefficients coefs;
+    REQUIRE( !filter.biquadCoefficients(1000.0f, 0.0f, 0.0f, coefs) );
+    REQUIRE( filter.biquadState(0) == nullptr );
+    filter.setType(kFilterLpf2p);
+    REQUIRE( filter.biquadCoefficients(1000.0f, 0.0f, 0.0f, coefs) );
+    REQUIRE( filter.biquadState(0) != nullptr );
+    REQUIRE( filter.biquadState(1) == nullptr );
+}
+
+TEST_CASE("[FilterBank] Tabulated coefficients")
+{
+    const FilterType types[] = {
+        kFilterLpf2p, kFilterHpf2p, kFilterBpf2p, kFilterBrf2p,
+        kFilterPeq, kFilterLsh, kFilterHsh,
+    };
+    const EqType eqTypes[] = { kEqPeak, kEqLshelf, kEqHshelf };
+
+    for (double rate : { 44100.0, 48000.0 }) {
+        for (int i = 0; i <= 40; ++i) {
+            const float cutoff = 20.0f * std::pow(1000.0f, i / 40.0f);
+            for (float q = -10.0f; q <= 20.0f; q += 5.0f) {
+                for (float gain = -24.0f; gain <= 24.0f; gain += 12.0f) {
+                    for (FilterType type : types) {
+                        BiquadCoefficients exact;
+                        BiquadCoefficients tabulated;
+                        REQUIRE( computeBiquad(type, rate, cutoff, q, gain, exact) );
+                        REQUIRE( computeBiquadTabulated(type, rate, cutoff, q, gain, tabulated) );
+                        REQUIRE( responseError(exact, tabulated) < 5e-3 );
+                    }
+                    for (EqType type : eqTypes) {
+                        const float bw = std::exp2(q / 10.0f);
+                        BiquadCoefficients exact;
+                        BiquadCoefficients tabulated;
+                        REQUIRE( computeBiquad(type, rate, cutoff, bw, gain, exact) );
+                        REQUIRE( computeBiquadTabulated(type, rate, cutoff, bw, gain, tabulated) );
+                        REQUIRE( responseError(exact, tabulated) < 5e-3 );
+                    }
+                }
+            }
+        }
+    }
+
+    // Not a biquad
+    BiquadCoefficients coefs;
+    REQUIRE( !computeBiquadTabulated(kFilterLpf4p, sampleRate, 1000.0f, 0.0f, 0.0f, coefs) );
+    REQUIRE( !computeBiquadTabulated(kEqNone, sampleRate, 1000.0f, 1.0f, 0.0f, coefs) );
+
+    // Above the Nyquist frequency, the coefficients are exact
+    BiquadCoefficients exact;
+    REQUIRE( computeBiquad(kFilterLpf2p, 32000.0, 18000.0f, 0.0f, 0.0f, exact) );
+    REQUIRE( computeBiquadTabulated(kFilterLpf2p, 32000.0, 18000.0f, 0.0f, 0.0f, coefs) );
+    REQUIRE( coefs.b0 == exact.b0 );
+    REQUIRE( coefs.a1 == exact.a1 );
+
+    // The filters use the tables below quality 1
+    Filter filter;
+    filter.init(sampleRate);
+    filter.setType(kFilterLpf2p);
+    REQUIRE( filter.quality() == 1 );
+    REQUIRE( filter.biquadCoefficients(1234.5f, 3.0f, 0.0f, coefs) );
+    REQUIRE( computeBiquad(kFilterLpf2p, sampleRate, 1234.5f, 3.0f, 0.0f, exact) );
+    REQUIRE( coefs.a1 == exact.a1 );
+    filter.setQuality(0);
+    REQUIRE( filter.biquadCoefficients(1234.5f, 3.0f, 0.0f, coefs) );
+    REQUIRE( coefs.a1 != exact.a1 );
+    REQUIRE( coefs.a1 == Approx(exact.a1).margin(1e-4) );
+}
+
+TEST_CASE("[FilterBank] Lanes match the single filters")
+{
+    const FilterType types[] = {
+        kFilterLpf2p, kFilterHpf2p, kFilterBpf2p, kFilterBrf2p,
+        kFilterPeq, kFilterLsh, kFilterHsh,
+    };
+    constexpr unsigned numFilters = sizeof(types) / sizeof(types[0]);
+    static_assert(numFilters <= FilterBank::numLanes, "Too many filters for the bank");
+
+    const auto cutoff = sweep(blockSize, 200.0f, 5000.0f);
+    const auto q = sweep(blockSize, 0.0f, 12.0f);
+    const auto pksh = sweep(blockSize, -6.0f, 6.0f);
+
+    std::vector<std::vector<float>> expected;
+    std::vector<std::vector<float>> actual;
+    std::vector<std::unique_ptr<Filter>> single;
+    std::vector<std::unique_ptr<Filter>> banked;
+    for (unsigned i = 0; i < numFilters; ++i) {
+        expected.push_back(noise(blockSize, i + 1));
+        actual.push_back(expected.back());
+        for (auto* filters : { &single, &banked }) {
+            filters->emplace_back(new Filter);
+            Filter& filter = *filters->back();
+            filter.init(sampleRate);
+            filter.setChannels(1);
+            filter.setType(types[i]);
+            filter.prepare(cutoff[0], q[0], pksh[0]);
+        }
+    }
+
+    FilterBank bank;
+    bank.setSampleRate(sampleRate);
+    bank.setSamplesPerBlock(blockSize);
+
+    // Run two blocks, to carry the state over
+    for (unsigned block = 0; block < 2; ++block) {
+        for (unsigned i = 0; i < numFilters; ++i) {
+            float* buffer = expected[i].data();
+            single[i]->processModulated(&buffer, &buffer, cutoff.data(), q.data(), pksh.data(), blockSize);
+
+            float* lane = actual[i].data();
+            REQUIRE( bank.addLanes(&lane, 1) == static_cast<int>(i) );
+            bank.setStage(i, 0, banked[i]->biquadState(0));
+            for (unsigned frame = 0, step = 0; frame < blockSize; frame += config::filterControlInterval, ++step) {
+                BiquadCoefficients coefs;
+                REQUIRE( banked[i]->biquadCoefficients(cutoff[frame], q[frame], pksh[frame], coefs) );
+                bank.setTarget(i, 0, step, coefs);
+            }
+        }
+
+        REQUIRE( bank.getNumFreeLanes() == FilterBank::numLanes - numFilters );
+        bank.process(blockSize);
+        REQUIRE( bank.empty() );
+
+        for (unsigned i = 0; i < numFilters; ++i)
+            REQUIRE( actual[i] == expected[i] );
+    }
+}
+
+TEST_CASE("[FilterBank] Chained stages of a stereo lane pair")
+{
+    const auto cutoff = sweep(blockSize, 500.0f, 2000.0f);
+    const auto bw = sweep(blockSize, 0.5f, 2.0f);
+    const auto q = sweep(blockSize, 3.0f, 0.0f);
+    const auto gain = sweep(blockSize, 3.0f, -9.0f);
+
+    std::vector<float> expected[2] { noise(blockSize, 10), noise(blockSize, 11) };
+    std::vector<float> actual[2] { expected[0], expected[1] };
+
+    Filter filters[2];
+    FilterEq eqs[2];
+    for (unsigned i = 0; i < 2; ++i) {
+        filters[i].init(sampleRate);
+        filters[i].setChannels(2);
+        filters[i].setType(kFilterHpf2p);
+        filters[i].prepare(cutoff[0], q[0], 0.0f);
+        eqs[i].init(sampleRate);
+        eqs[i].setChannels(2);
+        eqs[i].setType(kEqLshelf);
+        eqs[i].prepare(cutoff[0], bw[0], gain[0]);
+    }
+
+    float* buffers[2] { expected[0].data(), expected[1].data() };
+    filters[0].processModulated(buffers, buffers, cutoff.data(), q.data(), gain.data(), blockSize);
+    eqs[0].processModulated(buffers, buffers, cutoff.data(), bw.data(), gain.data(), blockSize);
+
+    FilterBank bank;
+    bank.setSampleRate(sampleRate);
+    bank.setSamplesPerBlock(blockSize);
+
+    // Take the lanes after some other, so that the pair is not aligned
+    std::vector<float> other(blockSize, 1.0f);
+    float* otherLane = other.data();
+    REQUIRE( bank.addLanes(&otherLane, 1) == 0 );
+
+    float* lanes[2] { actual[0].data(), actual[1].data() };
+    REQUIRE( bank.addLanes(lanes, 2) == 1 );
+    for (unsigned c = 0; c < 2; ++c) {
+        bank.setStage(1 + c, 0, filters[1].biquadState(c));
+        bank.setStage(1 + c, 1, eqs[1].biquadState(c));
+        for (unsigned frame = 0, step = 0; frame < blockSize; frame += config::filterControlInterval, ++step) {
+            BiquadCoefficients coefs;
+            REQUIRE( filters[1].biquadCoefficients(cutoff[frame], q[frame], gain[frame], coefs) );
+            bank.setTarget(1 + c, 0, step, coefs);
+            REQUIRE( eqs[1].biquadCoefficients(cutoff[frame], bw[frame], gain[frame], coefs) );
+            bank.setTarget(1 + c, 1, step, coefs);
+        }
+    }
+
+    bank.process(blockSize);
+    REQUIRE( actual[0] == expected[0] );
+    REQUIRE( actual[1] == expected[1] );
+
+    // A lane without stages is left untouched
+    REQUIRE( std::all_of(other.begin(), other.end(), [](float x) { return x == 1.0f; }) );
+}
+
+TEST_CASE("[FilterBank] Lane exhaustion")
+{
+    FilterBank bank;
+    bank.setSampleRate(sampleRate);
+    bank.setSamplesPerBlock(blockSize);
+
+    std::vector<float> buffer(blockSize);
+    std::vector<float*> lanes(FilterBank::numLanes + 1, buffer.data());
+    REQUIRE( bank.addLanes(lanes.data(), FilterBank::numLanes + 1) == -1 );
+    REQUIRE( bank.empty() );
+    REQUIRE( bank.addLanes(lanes.data(), FilterBank::numLanes) == 0 );
+    REQUIRE( bank.getNumFreeLanes() == 0 );
+    REQUIRE( bank.addLanes(lanes.data(), 1) == -1 );
+    bank.clear();
+    REQUIRE( bank.getNumFreeLanes() == FilterBank::numLanes );
+}
+
+TEST_CASE("[FilterBank] Batched voices render like separate voices")
+{
+    // Stereo and mono voices with biquads, and one with a filter that the
+    // bank cannot process; the batch must sum to the voices rendered alone
+    const char* regions[] = {
+        "<region> key=60 sample=*saw fil_type=lpf_2p cutoff=800 resonance=6 eq1_freq=300 eq1_gain=6",
+        "<region> key=62 sample=*sine fil_type=hpf_2p cutoff=1200 pan=-50",
+        "<region> key=64 sample=*saw fil_type=lpf_4p cutoff=600",
+        "<region> key=65 sample=*saw fil_type=pkf_2p cutoff=2000 fil_gain=6 fil2_type=lsh fil2_cutoff=200",
+    };
+    const int keys[] = { 60, 62, 64, 65 };
+    constexpr unsigned numRegions = sizeof(regions) / sizeof(regions[0]);
+    constexpr unsigned numFrames = 256;
+    constexpr unsigned numBlocks = 4;
+
+    std::string allRegions;
+    for (const char* region : regions)
+        allRegions.append(region).append("\n");
+
+    Synth together;
+    together.setSamplesPerBlock(numFrames);
+    together.loadSfzString(fs::current_path() / "tests/TestFiles/filter_bank.sfz", allRegions);
+    for (unsigned r = 0; r < numRegions; ++r)
+        together.noteOn(0, keys[r], 100);
+
+    std::unique_ptr<Synth> alone[numRegions];
+    for (unsigned r = 0; r < numRegions; ++r) {
+        alone[r].reset(new Synth);
+        alone[r]->setSamplesPerBlock(numFrames);
+        alone[r]->loadSfzString(fs::current_path() / "tests/TestFiles/filter_bank.sfz", regions[r]);
+        alone[r]->noteOn(0, keys[r], 100);
+    }
+
+    AudioBuffer<float> buffer { 2, numFrames };
+    AudioBuffer<float> voiceBuffer { 2, numFrames };
+    std::vector<float> sum(2 * numFrames);
+    for (unsigned block = 0; block < numBlocks; ++block) {
+        together.renderBlock(buffer);
+        REQUIRE( together.getNumActiveVoices() == static_cast<int>(numRegions) );
+
+        std::fill(sum.begin(), sum.end(), 0.0f);
+        for (unsigned r = 0; r < numRegions; ++r) {
+            alone[r]->renderBlock(voiceBuffer);
+            for (unsigned c = 0; c < 2; ++c) {
+                for (unsigned i = 0; i < numFrames; ++i)
+                    sum[c * numFrames + i] += voiceBuffer.getSpan(c)[i];
+            }
+        }
+
+        for (unsigned c = 0; c < 2; ++c) {
+            for (unsigned i = 0; i < numFrames; ++i)
+                REQUIRE( buffer.getSpan(c)[i] == Approx(sum[c * numFrames + i]).margin(1e-5) );
+        }
+    }
+}
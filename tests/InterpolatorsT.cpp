@@ -5,9 +5,13 @@
 // If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
 
 #include "sfizz/Interpolators.h"
+#include "sfizz/SampleFormat.h"
+#include "sfizz/SIMDHelpers.h"
 #include "catch2/catch.hpp"
 #include <array>
+#include <cmath>
 #include <numeric>
+#include <vector>
 using namespace Catch::literals;
 
 TEST_CASE("[Interpolators] Sample at points")
@@ -127,3 +131,131 @@ TEST_CASE("[Interpolators] Windowed sinc precision")
     Check(windowedSincError(*sfz::SincInterpolatorTraits<60>::windowedSinc));
     Check(windowedSincError(*sfz::SincInterpolatorTraits<72>::windowedSinc));
 }
+
+template <sfz::InterpolatorModel M, class T = float>
+static void checkSincBlock(bool stereo, bool adding, float step = 0.77f)
+{
+    constexpr unsigned numFrames = 67;
+    constexpr unsigned padding = 40;
+    const size_t size = static_cast<size_t>(numFrames * step) + 2 * padding;
+    std::vector<T> left(size);
+    std::vector<T> right(size);
+    for (size_t i = 0; i < size; ++i) {
+        left[i] = sfz::storedSample<T>(0.9f * std::sin(0.3f * i));
+        right[i] = sfz::storedSample<T>(0.9f * std::cos(0.17f * i));
+    }
+
+    std::vector<int> indices(numFrames);
+    std::vector<float> coeffs(numFrames);
+    std::vector<float> gains(numFrames);
+    for (unsigned n = 0; n < numFrames; ++n) {
+        float position = padding + step * n;
+        indices[n] = static_cast<int>(position);
+        coeffs[n] = position - indices[n];
+        gains[n] = 0.5f + 0.01f * n;
+    }
+
+    std::vector<float> outputLeft(numFrames, 1.0f);
+    std::vector<float> outputRight(numFrames, 1.0f);
+    sfz::interpolateSincBlock(M, left.data(), stereo ? right.data() : nullptr,
+        outputLeft.data(), outputRight.data(), indices.data(), coeffs.data(),
+        adding ? gains.data() : nullptr, numFrames);
+
+    for (unsigned n = 0; n < numFrames; ++n) {
+        float g = adding ? gains[n] : 1.0f;
+        float offset = adding ? 1.0f : 0.0f;
+        float expectedLeft = offset + g * sfz::interpolate<M>(&left[indices[n]], coeffs[n]);
+        REQUIRE(outputLeft[n] == Approx(expectedLeft).margin(1e-5));
+        if (stereo) {
+            float expectedRight = offset + g * sfz::interpolate<M>(&right[indices[n]], coeffs[n]);
+            REQUIRE(outputRight[n] == Approx(expectedRight).margin(1e-5));
+        }
+        else
+            REQUIRE(outputRight[n] == 1.0f);
+    }
+}
+
+TEST_CASE("[Interpolators] Windowed sinc blocks match the frame-wise interpolation")
+{
+    sfz::initializeSIMDDispatchers();
+    sfz::initializeInterpolators();
+
+    for (bool simd : { false, true }) {
+        sfz::setSIMDOpStatus<float>(sfz::SIMDOps::sincInterpolate, simd);
+        for (bool stereo : { false, true }) {
+            for (bool adding : { false, true }) {
+                checkSincBlock<sfz::kInterpolatorSinc8>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc12>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc16>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc24>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc36>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc48>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc60>(stereo, adding);
+                checkSincBlock<sfz::kInterpolatorSinc72>(stereo, adding);
+            }
+        }
+    }
+    sfz::resetSIMDOpStatus<float>();
+}
+
+TEST_CASE("[Interpolators] Windowed sinc blocks of stored samples")
+{
+    sfz::initializeSIMDDispatchers();
+    sfz::initializeInterpolators();
+
+    // the windows overlap at a low step, and are far apart at a high one
+    for (float step : { 0.77f, 2.5f, 100.0f }) {
+        for (bool stereo : { false, true }) {
+            for (bool adding : { false, true }) {
+                checkSincBlock<sfz::kInterpolatorSinc8, int16_t>(stereo, adding, step);
+                checkSincBlock<sfz::kInterpolatorSinc24, int16_t>(stereo, adding, step);
+                checkSincBlock<sfz::kInterpolatorSinc72, int16_t>(stereo, adding, step);
+                checkSincBlock<sfz::kInterpolatorSinc8, sfz::Int24>(stereo, adding, step);
+                checkSincBlock<sfz::kInterpolatorSinc72, sfz::Int24>(stereo, adding, step);
+            }
+        }
+    }
+}
+
+template <sfz::InterpolatorModel M, class T>
+static void checkIntegerSamples()
+{
+    std::vector<float> floats(128);
+    std::vector<T> stored(floats.size());
+    for (size_t i = 0; i < floats.size(); ++i) {
+        stored[i] = sfz::storedSample<T>(0.9f * std::sin(0.21f * i));
+        floats[i] = sfz::sampleValue<float>(stored[i]);
+    }
+
+    for (unsigned i = 40; i < floats.size() - 40; ++i) {
+        for (float coeff : { 0.0f, 0.25f, 0.5f, 0.9f }) {
+            REQUIRE(sfz::interpolate<M>(&stored[i], coeff)
+                == Approx(sfz::interpolate<M>(&floats[i], coeff)).margin(1e-6));
+        }
+    }
+}
+
+TEST_CASE("[Interpolators] Integer samples match their conversion to float")
+{
+    sfz::initializeInterpolators();
+
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<int16_t>(0.5f)) == 0.5f);
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<int16_t>(-1.0f)) == -1.0f);
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<int16_t>(2.0f)) == Approx(1.0f).margin(1e-4));
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<sfz::Int24>(-0.25f)) == -0.25f);
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<sfz::Int24>(-1.0f)) == -1.0f);
+    REQUIRE(sfz::sampleValue<float>(sfz::storedSample<sfz::Int24>(2.0f)) == Approx(1.0f).margin(1e-6));
+
+    checkIntegerSamples<sfz::kInterpolatorNearest, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorLinear, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorHermite3, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorBspline3, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorSinc8, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorSinc72, int16_t>();
+    checkIntegerSamples<sfz::kInterpolatorNearest, sfz::Int24>();
+    checkIntegerSamples<sfz::kInterpolatorLinear, sfz::Int24>();
+    checkIntegerSamples<sfz::kInterpolatorHermite3, sfz::Int24>();
+    checkIntegerSamples<sfz::kInterpolatorBspline3, sfz::Int24>();
+    checkIntegerSamples<sfz::kInterpolatorSinc8, sfz::Int24>();
+    checkIntegerSamples<sfz::kInterpolatorSinc72, sfz::Int24>();
+}
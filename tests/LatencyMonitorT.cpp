@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/LatencyMonitor.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "catch2/catch.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace sfz;
+
+TEST_CASE("[LatencyMonitor] Histogram")
+{
+    LatencyMonitor monitor;
+    REQUIRE( monitor.getNumBlocks() == 0 );
+    REQUIRE( monitor.getMaxLoad() == 0.0f );
+
+    monitor.record(0.00012, 0.001, 1, 0);
+    monitor.record(0.00052, 0.001, 1, 0);
+    monitor.record(0.00052, 0.001, 1, 0);
+    monitor.record(0.01, 0.001, 1, 0);
+    REQUIRE( monitor.getNumBlocks() == 4 );
+    REQUIRE( monitor.getBinCount(2) == 1 );
+    REQUIRE( monitor.getBinCount(10) == 2 );
+    REQUIRE( monitor.getBinCount(LatencyMonitor::numBins - 1) == 1 );
+    REQUIRE( monitor.getBinCount(LatencyMonitor::numBins) == 0 );
+    REQUIRE( monitor.getMaxLoad() == Approx(10.0f) );
+    REQUIRE( monitor.getLastLoad() == Approx(10.0f) );
+
+    monitor.reset();
+    REQUIRE( monitor.getNumBlocks() == 0 );
+    REQUIRE( monitor.getBinCount(10) == 0 );
+    REQUIRE( monitor.getMaxLoad() == 0.0f );
+}
+
+TEST_CASE("[LatencyMonitor] Stream underruns")
+{
+    LatencyMonitor monitor;
+    REQUIRE( monitor.getNumStreamUnderruns() == 0 );
+    monitor.recordStreamUnderruns(2);
+    monitor.recordStreamUnderruns(1);
+    REQUIRE( monitor.getNumStreamUnderruns() == 3 );
+    REQUIRE( monitor.getNumBlocks() == 0 );
+
+    monitor.reset();
+    REQUIRE( monitor.getNumStreamUnderruns() == 0 );
+}
+
+TEST_CASE("[LatencyMonitor] Deadline misses")
+{
+    LatencyMonitor monitor;
+    monitor.record(0.0005, 0.001, 2, 1);
+    monitor.record(0.002, 0.001, 12, 3);
+    monitor.record(0.0009, 0.001, 4, 0);
+    monitor.record(0.0015, 0.001, 20, 7);
+    REQUIRE( monitor.getNumDeadlineMisses() == 2 );
+
+    DeadlineMiss miss;
+    REQUIRE( monitor.getDeadlineMiss(0, miss) );
+    REQUIRE( miss.block == 3 );
+    REQUIRE( miss.numVoices == 20 );
+    REQUIRE( miss.numEvents == 7 );
+    REQUIRE( miss.duration == Approx(0.0015f) );
+    REQUIRE( miss.budget == Approx(0.001f) );
+    REQUIRE( monitor.getDeadlineMiss(1, miss) );
+    REQUIRE( miss.block == 1 );
+    REQUIRE( miss.numVoices == 12 );
+    REQUIRE( miss.numEvents == 3 );
+    REQUIRE( !monitor.getDeadlineMiss(2, miss) );
+
+    monitor.reset();
+    REQUIRE( monitor.getNumDeadlineMisses() == 0 );
+    REQUIRE( !monitor.getDeadlineMiss(0, miss) );
+}
+
+TEST_CASE("[LatencyMonitor] Overwritten misses")
+{
+    LatencyMonitor monitor;
+    const unsigned numMisses = 2 * config::deadlineMissCapacity;
+    for (unsigned i = 0; i < numMisses; ++i)
+        monitor.record(0.002, 0.001, i, 0);
+
+    REQUIRE( monitor.getNumDeadlineMisses() == numMisses );
+
+    // The history keeps one miss less than its capacity
+    DeadlineMiss miss;
+    const unsigned lastAge = config::deadlineMissCapacity - 2;
+    REQUIRE( monitor.getDeadlineMiss(lastAge, miss) );
+    REQUIRE( miss.numVoices == numMisses - 1 - lastAge );
+    REQUIRE( !monitor.getDeadlineMiss(lastAge + 1, miss) );
+}
+
+namespace {
+struct LatencyMessage {
+    std::string path;
+    std::string sig;
+    std::vector<sfizz_arg_t> args;
+};
+
+void latencyMessageReceiver(void* data, int, const char* path, const char* sig, const sfizz_arg_t* args)
+{
+    auto& messages = *reinterpret_cast<std::vector<LatencyMessage>*>(data);
+    messages.push_back({ path, sig, std::vector<sfizz_arg_t>(args, args + std::strlen(sig)) });
+}
+}
+
+TEST_CASE("[LatencyMonitor] Render blocks")
+{
+    Synth synth;
+    synth.setSamplesPerBlock(256);
+    AudioBuffer<float> buffer { 2, 256 };
+    std::vector<LatencyMessage> messages;
+    Client client(&messages);
+    client.setReceiveCallback(&latencyMessageReceiver);
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/latency.sfz", R"(
+        <region> key=60 sample=*saw
+    )");
+
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    synth.renderBlock(buffer);
+    synth.renderBlock(buffer);
+
+    const LatencyMonitor& monitor = synth.getLatencyMonitor();
+    REQUIRE( monitor.getNumBlocks() == 3 );
+    REQUIRE( monitor.getMaxLoad() > 0.0f );
+    uint64_t total = 0;
+    for (unsigned i = 0; i < LatencyMonitor::numBins; ++i)
+        total += monitor.getBinCount(i);
+    REQUIRE( total == 3 );
+
+    synth.dispatchMessage(client, 0, "/latency/num_blocks", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/num_bins", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/bin_width", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/bin0", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/bin1000", "", nullptr);
+    REQUIRE( messages.size() == 4 );
+    REQUIRE( messages[0].args[0].h == 3 );
+    REQUIRE( messages[1].args[0].i == static_cast<int>(LatencyMonitor::numBins) );
+    REQUIRE( messages[2].args[0].f == Approx(LatencyMonitor::binWidth) );
+    REQUIRE( messages[3].sig == "h" );
+
+    messages.clear();
+    synth.dispatchMessage(client, 0, "/latency/reset", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/num_blocks", "", nullptr);
+    synth.dispatchMessage(client, 0, "/latency/num_deadline_misses", "", nullptr);
+    REQUIRE( messages.size() == 2 );
+    REQUIRE( messages[0].args[0].h == 0 );
+    REQUIRE( messages[1].args[0].h == 0 );
+
+    synth.enableFreeWheeling();
+    synth.renderBlock(buffer);
+    REQUIRE( monitor.getNumBlocks() == 0 );
+}
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/Profiler.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "catch2/catch.hpp"
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace sfz;
+
+TEST_CASE("[Profiler] Disabled profiler")
+{
+    Profiler profiler;
+    REQUIRE( !profiler.isEnabled() );
+    profiler.addVoice(VoiceProfile());
+    profiler.endBlock(256, 0.0f, 0.0f, 0.0f);
+    REQUIRE( profiler.getNumBlocks() == 0 );
+    BlockProfile block;
+    REQUIRE( !profiler.getBlock(0, block) );
+}
+
+TEST_CASE("[Profiler] Blocks and voices")
+{
+    Profiler profiler;
+    profiler.enable(4, 8);
+    REQUIRE( profiler.isEnabled() );
+
+    for (int b = 0; b < 3; ++b) {
+        for (int v = 0; v < b; ++v) {
+            VoiceProfile voice;
+            voice.voiceId = v;
+            voice.regionId = 10 * b + v;
+            profiler.addVoice(voice);
+        }
+        profiler.endBlock(64 * (b + 1), 0.0f, 0.0f, 0.0f);
+    }
+    REQUIRE( profiler.getNumBlocks() == 3 );
+
+    BlockProfile block;
+    REQUIRE( profiler.getBlock(0, block) );
+    REQUIRE( block.index == 2 );
+    REQUIRE( block.numFrames == 192 );
+    REQUIRE( block.numVoices == 2 );
+    REQUIRE( profiler.getBlock(2, block) );
+    REQUIRE( block.numFrames == 64 );
+    REQUIRE( block.numVoices == 0 );
+    REQUIRE( !profiler.getBlock(3, block) );
+
+    VoiceProfile voice;
+    REQUIRE( profiler.getVoice(0, 1, voice) );
+    REQUIRE( voice.voiceId == 1 );
+    REQUIRE( voice.regionId == 21 );
+    REQUIRE( profiler.getVoice(1, 0, voice) );
+    REQUIRE( voice.regionId == 10 );
+    REQUIRE( !profiler.getVoice(1, 1, voice) );
+
+    profiler.clear();
+    REQUIRE( profiler.getNumBlocks() == 0 );
+    REQUIRE( !profiler.getBlock(0, block) );
+}
+
+TEST_CASE("[Profiler] Overwritten history")
+{
+    Profiler profiler;
+    profiler.enable(4, 8);
+
+    for (int b = 0; b < 10; ++b) {
+        for (int v = 0; v < 3; ++v) {
+            VoiceProfile voice;
+            voice.regionId = b;
+            profiler.addVoice(voice);
+        }
+        profiler.endBlock(64, 0.0f, 0.0f, 0.0f);
+    }
+
+    // The history keeps one block less than its capacity
+    BlockProfile block;
+    REQUIRE( profiler.getBlock(2, block) );
+    REQUIRE( block.index == 7 );
+    REQUIRE( !profiler.getBlock(3, block) );
+
+    // The voices of the older blocks are overwritten first
+    VoiceProfile voice;
+    REQUIRE( profiler.getVoice(0, 2, voice) );
+    REQUIRE( voice.regionId == 9 );
+    REQUIRE( profiler.getVoice(2, 1, voice) );
+    REQUIRE( voice.regionId == 7 );
+    REQUIRE( !profiler.getVoice(2, 0, voice) );
+}
+
+namespace {
+struct ProfileMessage {
+    std::string path;
+    std::string sig;
+    std::vector<sfizz_arg_t> args;
+};
+
+void profileMessageReceiver(void* data, int, const char* path, const char* sig, const sfizz_arg_t* args)
+{
+    auto& messages = *reinterpret_cast<std::vector<ProfileMessage>*>(data);
+    messages.push_back({ path, sig, std::vector<sfizz_arg_t>(args, args + std::strlen(sig)) });
+}
+}
+
+TEST_CASE("[Profiler] Profile messages")
+{
+    Synth synth;
+    synth.setSamplesPerBlock(256);
+    AudioBuffer<float> buffer { 2, 256 };
+    std::vector<ProfileMessage> messages;
+    Client client(&messages);
+    client.setReceiveCallback(&profileMessageReceiver);
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/profile.sfz", R"(
+        <region> key=60 sample=*saw fil_type=lpf_2p cutoff=500 eq1_gain=3 lfo1_freq=2 lfo1_cutoff1=100
+        <region> key=62 sample=*sine sample_quality=4
+    )");
+
+    synth.dispatchMessage(client, 0, "/profile/enabled", "", nullptr);
+    REQUIRE( messages.back().sig == "F" );
+
+    synth.enableProfiling();
+    synth.dispatchMessage(client, 0, "/profile/enabled", "", nullptr);
+    REQUIRE( messages.back().sig == "T" );
+
+    synth.noteOn(0, 60, 100);
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    synth.renderBlock(buffer);
+
+    messages.clear();
+    synth.dispatchMessage(client, 0, "/profile/num_blocks", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/block0", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/block0/voice0", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/block0/voice1", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/block0/voice2", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/block2", "", nullptr);
+    REQUIRE( messages.size() == 4 );
+
+    REQUIRE( messages[0].path == "/profile/num_blocks" );
+    REQUIRE( messages[0].args[0].h == 2 );
+
+    REQUIRE( messages[1].sig == "hiifff" );
+    REQUIRE( messages[1].args[0].h == 1 );
+    REQUIRE( messages[1].args[1].i == 256 );
+    REQUIRE( messages[1].args[2].i == 2 );
+    REQUIRE( messages[1].args[4].f > 0.0f );
+
+    REQUIRE( messages[2].sig == "iiiiiiffff" );
+    REQUIRE( messages[3].sig == "iiiiiiffff" );
+    const sfizz_arg_t* first = messages[2].args.data();
+    const sfizz_arg_t* second = messages[3].args.data();
+    if (first[1].i != 0)
+        std::swap(first, second);
+    REQUIRE( first[1].i == 0 );
+    REQUIRE( first[3].i == 1 );
+    REQUIRE( first[4].i == 1 );
+    REQUIRE( first[5].i == 1 );
+    REQUIRE( second[1].i == 1 );
+    REQUIRE( second[2].i == 4 );
+    REQUIRE( second[3].i == 0 );
+
+    messages.clear();
+    synth.dispatchMessage(client, 0, "/profile/clear", "", nullptr);
+    synth.dispatchMessage(client, 0, "/profile/num_blocks", "", nullptr);
+    REQUIRE( messages.back().args[0].h == 0 );
+
+    synth.disableProfiling();
+    synth.renderBlock(buffer);
+    REQUIRE( synth.getProfiler().getNumBlocks() == 0 );
+}
+
+TEST_CASE("[Profiler] Profiling goes on after a staged swap")
+{
+    Synth synth;
+    synth.setSamplesPerBlock(256);
+    AudioBuffer<float> buffer { 2, 256 };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/profile.sfz", R"(
+        <region> key=60 sample=*saw
+    )");
+
+    synth.enableProfiling();
+    const Profiler& profiler = synth.getProfiler();
+    synth.renderBlock(buffer);
+    REQUIRE( profiler.getNumBlocks() == 1 );
+
+    REQUIRE( synth.stageSfzString(fs::current_path() / "tests/TestFiles/profile_staged.sfz", R"(
+        <region> key=62 sample=*sine
+    )") );
+    synth.renderBlock(buffer);
+    REQUIRE( !synth.hasStagedState() );
+
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( &synth.getProfiler() == &profiler );
+    REQUIRE( profiler.isEnabled() );
+    REQUIRE( profiler.getNumBlocks() == 3 );
+    BlockProfile block;
+    REQUIRE( profiler.getBlock(0, block) );
+    REQUIRE( block.numVoices == 1 );
+}
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "sfizz/RTChecks.h"
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "catch2/catch.hpp"
+#include <ghc/fs_std.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+TEST_CASE("[RTChecks] Allocations on a real-time thread")
+{
+    if (!sfz::realtimeChecksEnabled())
+        return;
+
+    sfz::resetRealtimeViolationCount();
+    {
+        auto outside = std::make_unique<int>(1);
+        REQUIRE( sfz::getRealtimeViolationCount() == 0 );
+
+        sfz::ScopedRealtime realtime;
+        {
+            sfz::ScopedRealtimeExemption exemption;
+            auto exempted = std::make_unique<int>(2);
+        }
+        REQUIRE( sfz::getRealtimeViolationCount() == 0 );
+
+        auto inside = std::make_unique<int>(3);
+        REQUIRE( sfz::getRealtimeViolationCount() == 1 );
+    }
+    REQUIRE( sfz::getRealtimeViolationCount() == 2 );
+    sfz::resetRealtimeViolationCount();
+}
+
+TEST_CASE("[RTChecks] Play the test instruments")
+{
+    // Without the checks compiled in, this is a plain smoke test
+    std::vector<fs::path> instruments;
+    for (const auto& entry : fs::recursive_directory_iterator(fs::current_path() / "tests/TestFiles")) {
+        if (entry.path().extension() == ".sfz")
+            instruments.push_back(entry.path());
+    }
+    std::sort(instruments.begin(), instruments.end());
+    REQUIRE( !instruments.empty() );
+
+    const int blockSize = 256;
+    for (int numThreads : { 1, 4 }) {
+        sfz::Synth synth;
+        synth.setSamplesPerBlock(blockSize);
+        synth.setNumRenderThreads(numThreads);
+        sfz::AudioBuffer<float> buffer { 2, blockSize };
+
+        for (const fs::path& instrument : instruments) {
+            INFO("Instrument: " << instrument << ", threads: " << numThreads);
+            synth.loadSfzFile(instrument);
+            synth.renderBlock(buffer);
+
+            sfz::resetRealtimeViolationCount();
+            for (int note = 24; note < 108; note += 5)
+                synth.noteOn(note % blockSize, note, 100);
+            synth.cc(0, 64, 127);
+            synth.renderBlock(buffer);
+            synth.cc(10, 1, 64);
+            synth.pitchWheel(20, 4000);
+            synth.channelAftertouch(30, 50);
+            synth.polyAftertouch(40, 60, 50);
+            synth.renderBlock(buffer);
+            for (int note = 24; note < 108; note += 5)
+                synth.noteOff(note % blockSize, note, 0);
+            synth.cc(50, 64, 0);
+            for (int i = 0; i < 8; ++i)
+                synth.renderBlock(buffer);
+            synth.allSoundOff();
+            synth.renderBlock(buffer);
+            REQUIRE( sfz::getRealtimeViolationCount() == 0 );
+        }
+    }
+}
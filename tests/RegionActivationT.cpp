@@ -746,3 +746,86 @@ TEST_CASE("[Region activation] Program change")
         REQUIRE(playingSamples(synth) == std::vector<std::string> { "*saw", "*tri", "*sine", "*tri", "*tri" });
     }
 }
+
+TEST_CASE("[Region activation] Keyswitched velocity layers over many regions")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+
+    // 48 articulations of 3 velocity layers, then a CC switch and a sequence
+    std::string sfzFile = "<global> sw_lokey=24 sw_hikey=71 sw_default=24 sample=*sine\n";
+    for (int articulation = 0; articulation < 48; ++articulation) {
+        const std::string switchKey = std::to_string(24 + articulation);
+        sfzFile += "<region> lokey=72 hikey=96 sw_last=" + switchKey + " lovel=1 hivel=42\n";
+        sfzFile += "<region> lokey=72 hikey=96 sw_last=" + switchKey + " lovel=43 hivel=85\n";
+        sfzFile += "<region> lokey=72 hikey=96 sw_last=" + switchKey + " lovel=86 hivel=127\n";
+    }
+    sfzFile += "<region> key=100 sw_last=24 locc1=64 hicc1=127\n";
+    sfzFile += "<region> key=101 sw_last=25 seq_length=2 seq_position=1\n";
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/activation.sfz", sfzFile);
+    REQUIRE(synth.getNumRegions() == 146);
+
+    auto playedRegions = [&](int noteNumber, int velocity) {
+        synth.allSoundOff();
+        synth.renderBlock(buffer);
+        synth.noteOn(0, noteNumber, velocity);
+        synth.renderBlock(buffer);
+        std::vector<int> regions;
+        for (const sfz::Voice* voice : getActiveVoices(synth))
+            regions.push_back(voice->getRegion()->getId().number());
+        return regions;
+    };
+
+    REQUIRE(playedRegions(72, 20) == std::vector<int> { 0 });
+    REQUIRE(playedRegions(96, 127) == std::vector<int> { 2 });
+    synth.noteOn(0, 70, 64);
+    REQUIRE(playedRegions(80, 64) == std::vector<int> { 139 });
+    REQUIRE(playedRegions(80, 43) == std::vector<int> { 139 });
+    REQUIRE(playedRegions(80, 42) == std::vector<int> { 138 });
+    synth.noteOn(0, 24, 64);
+    REQUIRE(playedRegions(80, 100) == std::vector<int> { 2 });
+
+    // CC switches
+    REQUIRE(playedRegions(100, 64).empty());
+    synth.cc(0, 1, 100);
+    REQUIRE(playedRegions(100, 64) == std::vector<int> { 144 });
+    synth.cc(0, 1, 10);
+    REQUIRE(playedRegions(100, 64).empty());
+
+    // The sequence advances while the region is switched off
+    REQUIRE(playedRegions(101, 64).empty());
+    synth.noteOn(0, 25, 64);
+    REQUIRE(playedRegions(101, 64).empty());
+    REQUIRE(playedRegions(101, 64) == std::vector<int> { 145 });
+}
+
+TEST_CASE("[Region activation] Sequences across velocity layers")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/activation.sfz", R"(
+        <group> key=60 seq_length=2 sample=*sine
+        <region> lovel=1 hivel=63 seq_position=1
+        <region> lovel=1 hivel=63 seq_position=2
+        <region> lovel=64 hivel=127 seq_position=1
+        <region> lovel=64 hivel=127 seq_position=2
+    )");
+    REQUIRE(synth.getNumRegions() == 4);
+
+    auto playedRegions = [&](int velocity) {
+        synth.allSoundOff();
+        synth.renderBlock(buffer);
+        synth.noteOn(0, 60, velocity);
+        synth.renderBlock(buffer);
+        std::vector<int> regions;
+        for (const sfz::Voice* voice : getActiveVoices(synth))
+            regions.push_back(voice->getRegion()->getId().number());
+        return regions;
+    };
+
+    // The sequences of both layers advance on every note
+    REQUIRE(playedRegions(20) == std::vector<int> { 0 });
+    REQUIRE(playedRegions(100) == std::vector<int> { 3 });
+    REQUIRE(playedRegions(100) == std::vector<int> { 2 });
+    REQUIRE(playedRegions(20) == std::vector<int> { 1 });
+}
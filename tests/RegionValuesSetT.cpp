@@ -49,6 +49,11 @@ TEST_CASE("Set values", "[parsing][OSC]")
         REQUIRE( d.sendAndRead("/oscillator_quality", 2) == 2);
         REQUIRE( d.sendAndRead("/freewheeling_sample_quality", 6) == 6);
         REQUIRE( d.sendAndRead("/freewheeling_oscillator_quality", 2) == 2);
+        REQUIRE( d.read<int32_t>("/filter_quality") == 1);
+        REQUIRE( d.read<int32_t>("/freewheeling_filter_quality") == 1);
+        REQUIRE( d.sendAndRead("/filter_quality", 0) == 0);
+        REQUIRE( d.sendAndRead("/freewheeling_filter_quality", 0) == 0);
+        REQUIRE( d.sendAndRead<int32_t>("/region0/filter_quality", 0) == 0);
     }
 
     SECTION("Sustain cancels release") {
@@ -1587,6 +1587,18 @@ SECTION("Amp Veltrack")
         REQUIRE( d.read<OSC>("/region2/oscillator_quality") == OSC::None);
     }
 
+    SECTION("Filter quality")
+    {
+        d.load(R"(
+            <region> sample=kick.wav
+            <region> sample=kick.wav filter_quality=0
+            <region> sample=kick.wav filter_quality=1 filter_quality=-2
+        )");
+        REQUIRE( d.read<OSC>("/region0/filter_quality") == OSC::None);
+        REQUIRE( d.read<int32_t>("/region1/filter_quality") == 0);
+        REQUIRE( d.read<OSC>("/region2/filter_quality") == OSC::None);
+    }
+
     SECTION("Oscillator mode/multi")
     {
         d.load(R"(
@@ -7,6 +7,7 @@
 #include "sfizz/Synth.h"
 #include "sfizz/Region.h"
 #include "sfizz/Layer.h"
+#include "sfizz/LatencyMonitor.h"
 #include "sfizz/SisterVoiceRing.h"
 #include "sfizz/SfzHelpers.h"
 #include "sfizz/utility/NumericId.h"
@@ -14,6 +15,8 @@
 #include "TestHelpers.h"
 #include "catch2/catch.hpp"
 #include <algorithm>
+#include <atomic>
+#include <thread>
 using namespace Catch::literals;
 using namespace sfz::literals;
 
@@ -378,6 +381,69 @@ TEST_CASE("[Synth] Effect on a third bus")
     REQUIRE( bus->gainToMix() == 0 );
 }
 
+TEST_CASE("[Synth] Idle effect buses are skipped")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    auto isSilent = [&buffer]() {
+        for (unsigned c = 0; c < 2; ++c) {
+            for (float value : buffer.getConstSpan(c)) {
+                if (value != 0.0f)
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/Effects/idle.sfz", R"(
+        <region> lokey=0 hikey=127 sample=*sine effect1=100 ampeg_release=0.01
+        <effect> directtomain=100 fx1tomain=100 type=fverb bus=fx1 reverb_type=small_room
+            reverb_input=100 reverb_wet=100 reverb_predelay=0.05
+    )");
+    auto main = synth.getEffectBusView(0);
+    auto reverb = synth.getEffectBusView(1);
+    REQUIRE( main != nullptr );
+    REQUIRE( reverb != nullptr );
+    REQUIRE( reverb->numEffects() == 1 );
+
+    synth.renderBlock(buffer);
+    REQUIRE( main->isQuiescent() );
+    REQUIRE( reverb->isQuiescent() );
+
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( !main->isQuiescent() );
+    REQUIRE( !reverb->isQuiescent() );
+    synth.noteOff(0, 60, 0);
+
+    int numBlocks = 0;
+    const int maxBlocks = 60 * static_cast<int>(sfz::config::defaultSampleRate) / synth.getSamplesPerBlock();
+    while (synth.getNumActiveVoices() > 0 && numBlocks++ < maxBlocks)
+        synth.renderBlock(buffer);
+    REQUIRE( synth.getNumActiveVoices() == 0 );
+    synth.renderBlock(buffer);
+    REQUIRE( main->isQuiescent() );
+    // The reverb keeps ringing after the voice ended, past its predelay
+    REQUIRE( !reverb->isQuiescent() );
+
+    bool tailRendered = false;
+    while (!reverb->isQuiescent() && numBlocks++ < maxBlocks) {
+        synth.renderBlock(buffer);
+        tailRendered = tailRendered || !isSilent();
+    }
+    REQUIRE( tailRendered );
+    REQUIRE( reverb->isQuiescent() );
+    synth.renderBlock(buffer);
+    REQUIRE( isSilent() );
+
+    // Wakes up as soon as a voice plays again
+    synth.noteOn(0, 60, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( !main->isQuiescent() );
+    REQUIRE( !reverb->isQuiescent() );
+    REQUIRE( !isSilent() );
+}
+
 TEST_CASE("[Synth] Gain to mix")
 {
     sfz::Synth synth;
@@ -451,6 +517,26 @@ TEST_CASE("[Synth] Effect on the second output, with two outputs")
     REQUIRE( bus->gainToMix() == 0 );
 }
 
+TEST_CASE("[Synth] Render each output on its own stereo pair")
+{
+    sfz::Synth synth;
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/outputs.sfz", R"(
+        <region> key=60 sample=*sine
+        <region> key=62 sample=*sine output=2
+    )");
+    REQUIRE( synth.getNumOutputs() == 3 );
+
+    sfz::AudioBuffer<float> buffer { 6, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(0)) == 0.0f );
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(1)) == 0.0f );
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(2)) == 0.0f );
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(3)) == 0.0f );
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(4)) > 0.0f );
+    REQUIRE( sfz::sumSquares<float>(buffer.getConstSpan(5)) > 0.0f );
+}
+
 TEST_CASE("[Synth] Basic curves")
 {
     sfz::Synth synth;
@@ -2202,4 +2288,488 @@ TEST_CASE("[Synth] Note on and off with delay")
     for (int i = 0; i < 100; ++i)
         synth.renderBlock(buffer);
     CHECK(synth.getNumActiveVoices() == 0);
-}
\ No newline at end of file
+}
+
+TEST_CASE("[Synth] Multithreaded voice rendering matches the single-threaded one")
+{
+    sfz::Synth serialSynth;
+    sfz::Synth parallelSynth;
+    sfz::Synth otherParallelSynth;
+    parallelSynth.setNumRenderThreads(4);
+    otherParallelSynth.setNumRenderThreads(4);
+    REQUIRE(serialSynth.getNumRenderThreads() == 1);
+    REQUIRE(parallelSynth.getNumRenderThreads() == 4);
+
+    const std::string sfz = R"(
+        <region> key=60 sample=*sine lfo1_freq=3 lfo1_pitch=50
+        <region> key=62 sample=*saw cutoff=800 fil_type=lpf_2p lfo1_freq=5 lfo1_cutoff=1200
+        <region> key=64 sample=*triangle amplitude_oncc20=100 effect1=50
+        <region> key=65 sample=*square pan_oncc10=100 pan_curvecc10=1
+        <region> key=67 sample=*sine transpose=12 ampeg_attack=0.01 ampeg_release=0.1
+        <effect> bus=fx1 type=lofi bitred=50
+    )";
+    for (sfz::Synth* synth : { &serialSynth, &parallelSynth, &otherParallelSynth }) {
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/render_threads.sfz", sfz);
+        synth->cc(0, 20, 64);
+        synth->cc(0, 10, 32);
+        for (int note : { 60, 62, 64, 65, 67 })
+            synth->noteOn(0, note, 100);
+        synth->noteOff(300, 67, 0);
+    }
+
+    sfz::AudioBuffer<float> serialBuffer { 2, static_cast<unsigned>(serialSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> parallelBuffer { 2, static_cast<unsigned>(parallelSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> otherParallelBuffer { 2, static_cast<unsigned>(otherParallelSynth.getSamplesPerBlock()) };
+    for (int i = 0; i < 10; ++i) {
+        serialSynth.renderBlock(serialBuffer);
+        parallelSynth.renderBlock(parallelBuffer);
+        otherParallelSynth.renderBlock(otherParallelBuffer);
+        REQUIRE(serialSynth.getNumActiveVoices() == parallelSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(serialBuffer.getConstSpan(0), parallelBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(serialBuffer.getConstSpan(1), parallelBuffer.getConstSpan(1)));
+        // The workers may take different tasks, but the mix is the same
+        for (unsigned c = 0; c < 2; ++c) {
+            const auto span = parallelBuffer.getConstSpan(c);
+            const auto otherSpan = otherParallelBuffer.getConstSpan(c);
+            REQUIRE(std::equal(span.begin(), span.end(), otherSpan.begin()));
+        }
+    }
+
+    parallelSynth.setNumRenderThreads(1);
+    REQUIRE(parallelSynth.getNumRenderThreads() == 1);
+}
+
+TEST_CASE("[Synth] Streamed samples match the ones loaded in memory")
+{
+    sfz::Synth loadedSynth;
+    sfz::Synth streamedSynth;
+    streamedSynth.enableSampleStreaming();
+
+    const std::string sfz = R"(
+        <region> key=60 sample=stereo_sample.wav
+    )";
+    for (sfz::Synth* synth : { &loadedSynth, &streamedSynth }) {
+        synth->enableFreeWheeling();
+        synth->setPreloadSize(4096);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/sample_streaming.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+    }
+
+    sfz::AudioBuffer<float> loadedBuffer { 2, static_cast<unsigned>(loadedSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> streamedBuffer { 2, static_cast<unsigned>(streamedSynth.getSamplesPerBlock()) };
+    const int numBlocks = 100000 / loadedSynth.getSamplesPerBlock();
+    for (int i = 0; i < numBlocks; ++i) {
+        loadedSynth.renderBlock(loadedBuffer);
+        streamedSynth.renderBlock(streamedBuffer);
+        REQUIRE(loadedSynth.getNumActiveVoices() == streamedSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(loadedBuffer.getConstSpan(0), streamedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(loadedBuffer.getConstSpan(1), streamedBuffer.getConstSpan(1)));
+    }
+}
+
+TEST_CASE("[Synth] Streamed samples play in large blocks at a high pitch")
+{
+    // A block reads twice the guard of the stream rings
+    constexpr int blockSize = 8192;
+    sfz::Synth loadedSynth;
+    sfz::Synth streamedSynth;
+    streamedSynth.enableSampleStreaming();
+
+    const std::string sfz = R"(
+        <region> key=60 sample=stereo_sample.wav transpose=12
+    )";
+    for (sfz::Synth* synth : { &loadedSynth, &streamedSynth }) {
+        synth->enableFreeWheeling();
+        synth->setSamplesPerBlock(blockSize);
+        synth->setPreloadSize(4096);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/sample_streaming.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+    }
+
+    sfz::AudioBuffer<float> loadedBuffer { 2, blockSize };
+    sfz::AudioBuffer<float> streamedBuffer { 2, blockSize };
+    for (int i = 0; i < 6; ++i) {
+        loadedSynth.renderBlock(loadedBuffer);
+        streamedSynth.renderBlock(streamedBuffer);
+        REQUIRE(loadedSynth.getNumActiveVoices() == streamedSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(loadedBuffer.getConstSpan(0), streamedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(loadedBuffer.getConstSpan(1), streamedBuffer.getConstSpan(1)));
+    }
+    REQUIRE(streamedSynth.getLatencyMonitor().getNumStreamUnderruns() == 0);
+}
+
+TEST_CASE("[Synth] Compressed samples match the ones decoded in memory")
+{
+    sfz::Synth decodedSynth;
+    sfz::Synth compressedSynth;
+    compressedSynth.enableCompressedSampleStorage();
+
+    const std::string sfz = R"(
+        <region> key=60 sample=kick.flac
+        <region> key=62 sample=kick.flac offset=20000
+    )";
+    for (sfz::Synth* synth : { &decodedSynth, &compressedSynth }) {
+        synth->enableFreeWheeling();
+        synth->setPreloadSize(1024);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/compressed_storage.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+        synth->noteOn(10, 62, 127);
+    }
+
+    sfz::AudioBuffer<float> decodedBuffer { 2, static_cast<unsigned>(decodedSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> compressedBuffer { 2, static_cast<unsigned>(compressedSynth.getSamplesPerBlock()) };
+    const int numBlocks = 50000 / decodedSynth.getSamplesPerBlock();
+    for (int i = 0; i < numBlocks; ++i) {
+        decodedSynth.renderBlock(decodedBuffer);
+        compressedSynth.renderBlock(compressedBuffer);
+        REQUIRE(decodedSynth.getNumActiveVoices() == compressedSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(0), compressedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(1), compressedBuffer.getConstSpan(1)));
+    }
+
+    // Switching the storage back reloads the decoded preloads
+    compressedSynth.disableCompressedSampleStorage();
+    compressedSynth.noteOn(0, 60, 127);
+    decodedSynth.noteOn(0, 60, 127);
+    for (int i = 0; i < numBlocks; ++i) {
+        decodedSynth.renderBlock(decodedBuffer);
+        compressedSynth.renderBlock(compressedBuffer);
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(0), compressedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(1), compressedBuffer.getConstSpan(1)));
+    }
+}
+
+TEST_CASE("[Synth] Compressed looping samples match the ones decoded in memory")
+{
+    sfz::Synth decodedSynth;
+    sfz::Synth compressedSynth;
+    compressedSynth.enableCompressedSampleStorage();
+
+    const std::string sfz = R"(
+        <region> key=60 sample=kick.flac loop_mode=loop_continuous loop_start=4000 loop_end=30000
+        <region> key=62 sample=kick.flac loop_mode=loop_sustain loop_start=2000 loop_end=20000 ampeg_release=1
+        <region> key=64 sample=kick.flac loop_mode=loop_continuous loop_start=10000 loop_end=12000 loop_count=3
+    )";
+    for (sfz::Synth* synth : { &decodedSynth, &compressedSynth }) {
+        synth->enableFreeWheeling();
+        synth->setPreloadSize(1024);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/compressed_storage.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+        synth->noteOn(0, 62, 127);
+        synth->noteOn(0, 64, 127);
+    }
+
+    sfz::AudioBuffer<float> decodedBuffer { 2, static_cast<unsigned>(decodedSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> compressedBuffer { 2, static_cast<unsigned>(compressedSynth.getSamplesPerBlock()) };
+    const int numBlocks = 200000 / decodedSynth.getSamplesPerBlock();
+    for (int i = 0; i < numBlocks; ++i) {
+        // Leave the sustained loop in the middle of a lap, and play past it
+        if (i == 100000 / decodedSynth.getSamplesPerBlock()) {
+            decodedSynth.noteOff(0, 62, 0);
+            compressedSynth.noteOff(0, 62, 0);
+        }
+        decodedSynth.renderBlock(decodedBuffer);
+        compressedSynth.renderBlock(compressedBuffer);
+        REQUIRE(decodedSynth.getNumActiveVoices() == compressedSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(0), compressedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(1), compressedBuffer.getConstSpan(1)));
+    }
+    REQUIRE(compressedSynth.getLatencyMonitor().getNumStreamUnderruns() == 0);
+}
+
+TEST_CASE("[Synth] Compressed looping samples play in large blocks at a high pitch")
+{
+    // A block wraps around the loop several times
+    constexpr int blockSize = 8192;
+    sfz::Synth decodedSynth;
+    sfz::Synth compressedSynth;
+    compressedSynth.enableCompressedSampleStorage();
+
+    const std::string sfz = R"(
+        <region> key=60 sample=kick.flac transpose=12 loop_mode=loop_continuous loop_start=10000 loop_end=13000
+    )";
+    for (sfz::Synth* synth : { &decodedSynth, &compressedSynth }) {
+        synth->enableFreeWheeling();
+        synth->setSamplesPerBlock(blockSize);
+        synth->setPreloadSize(1024);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/compressed_storage.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+    }
+
+    sfz::AudioBuffer<float> decodedBuffer { 2, blockSize };
+    sfz::AudioBuffer<float> compressedBuffer { 2, blockSize };
+    for (int i = 0; i < 8; ++i) {
+        decodedSynth.renderBlock(decodedBuffer);
+        compressedSynth.renderBlock(compressedBuffer);
+        REQUIRE(decodedSynth.getNumActiveVoices() == compressedSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(0), compressedBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(decodedBuffer.getConstSpan(1), compressedBuffer.getConstSpan(1)));
+    }
+    REQUIRE(compressedSynth.getLatencyMonitor().getNumStreamUnderruns() == 0);
+}
+
+TEST_CASE("[Synth] Samples stored as integers match the floats")
+{
+    sfz::Synth floatSynth;
+    sfz::Synth intSynth;
+    intSynth.setSampleFormat(sfz::Synth::SampleInt24);
+
+    const std::string sfz = R"(
+        <region> key=60 sample=stereo_sample.wav
+        <region> key=62 sample=stereo_sample.wav sample_quality=10
+        <region> key=64 sample=kick.wav sample_quality=2
+    )";
+    for (sfz::Synth* synth : { &floatSynth, &intSynth }) {
+        synth->enableFreeWheeling();
+        synth->setPreloadSize(4096);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/sample_format.sfz", sfz);
+        synth->noteOn(0, 60, 127);
+        synth->noteOn(0, 62, 127);
+        synth->noteOn(0, 64, 127);
+    }
+
+    sfz::AudioBuffer<float> floatBuffer { 2, static_cast<unsigned>(floatSynth.getSamplesPerBlock()) };
+    sfz::AudioBuffer<float> intBuffer { 2, static_cast<unsigned>(intSynth.getSamplesPerBlock()) };
+    const int numBlocks = 20000 / floatSynth.getSamplesPerBlock();
+    for (int i = 0; i < numBlocks; ++i) {
+        floatSynth.renderBlock(floatBuffer);
+        intSynth.renderBlock(intBuffer);
+        REQUIRE(floatSynth.getNumActiveVoices() == intSynth.getNumActiveVoices());
+        REQUIRE(approxEqual<float>(floatBuffer.getConstSpan(0), intBuffer.getConstSpan(0)));
+        REQUIRE(approxEqual<float>(floatBuffer.getConstSpan(1), intBuffer.getConstSpan(1)));
+    }
+}
+
+TEST_CASE("[Synth] Staged instruments are adopted at the end of a block")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+    synth.cc(0, 20, 32);
+    REQUIRE(synth.getNumRegions() == 1);
+
+    REQUIRE(synth.stageSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+        <region> key=62 sample=*sine
+    )"));
+    REQUIRE(synth.hasStagedState());
+    REQUIRE(synth.getNumRegions() == 1);
+
+    // MIDI received after the staging is carried over
+    synth.cc(0, 21, 64);
+    synth.renderBlock(buffer);
+    REQUIRE(!synth.hasStagedState());
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getHdcc(20) == Approx(32_norm));
+    REQUIRE(synth.getHdcc(21) == Approx(64_norm));
+
+    // A failed staging keeps the current instrument
+    REQUIRE(!synth.stageSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", ""));
+    REQUIRE(!synth.hasStagedState());
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumRegions() == 2);
+}
+
+TEST_CASE("[Synth] Staged instruments replace the playing voices after a fade out")
+{
+    constexpr int blockSize = 256;
+    sfz::Synth synth;
+    sfz::Synth reference;
+    for (sfz::Synth* s : { &synth, &reference }) {
+        s->setSamplesPerBlock(blockSize);
+        s->loadSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+            <region> key=60 sample=*sine
+        )");
+        s->noteOn(0, 60, 100);
+    }
+
+    sfz::AudioBuffer<float> buffer { 2, blockSize };
+    sfz::AudioBuffer<float> referenceBuffer { 2, blockSize };
+    synth.renderBlock(buffer);
+    reference.renderBlock(referenceBuffer);
+
+    REQUIRE(synth.stageSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+        <region> key=62 sample=*sine
+    )"));
+
+    // The fade out spans more than a block
+    int numBlocks = 0;
+    while (synth.hasStagedState()) {
+        REQUIRE(numBlocks < 10);
+        synth.renderBlock(buffer);
+        reference.renderBlock(referenceBuffer);
+        ++numBlocks;
+        for (unsigned c = 0; c < 2; ++c) {
+            for (unsigned i = 0; i < blockSize; ++i)
+                REQUIRE(std::abs(buffer.getSample(c, i)) <= std::abs(referenceBuffer.getSample(c, i)));
+        }
+    }
+    REQUIRE(numBlocks > 1);
+    REQUIRE(buffer.getSample(0, blockSize - 1) == 0.0f);
+    REQUIRE(buffer.getSample(1, blockSize - 1) == 0.0f);
+    REQUIRE(referenceBuffer.getSample(0, blockSize - 1) != 0.0f);
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("[Synth] Staged instruments follow the settings changed while pending")
+{
+    sfz::Synth synth;
+    synth.setSamplesPerBlock(256);
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+
+    REQUIRE(synth.stageSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+        <region> key=62 sample=*sine
+    )"));
+    REQUIRE(synth.hasStagedState());
+
+    synth.setSamplesPerBlock(1024);
+    synth.setSampleRate(96000);
+    synth.setNumVoices(32);
+    synth.setVolume(-6.0f);
+
+    sfz::AudioBuffer<float> buffer { 2, 1024 };
+    synth.renderBlock(buffer);
+    REQUIRE(!synth.hasStagedState());
+    REQUIRE(synth.getNumRegions() == 2);
+    REQUIRE(synth.getSamplesPerBlock() == 1024);
+    REQUIRE(synth.getNumVoices() == 32);
+    REQUIRE(synth.getVolume() == -6.0f);
+
+    // The adopted state renders full blocks at the new size
+    synth.noteOn(0, 62, 100);
+    synth.renderBlock(buffer);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("[Synth] Stage instruments while rendering")
+{
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, static_cast<unsigned>(synth.getSamplesPerBlock()) };
+    synth.loadSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+        <region> key=60 sample=*sine
+    )");
+
+    std::atomic<bool> staged { false };
+    std::thread stagingThread([&synth, &staged]() {
+        for (int i = 0; i < 10; ++i) {
+            synth.stageSfzString(fs::current_path() / "tests/TestFiles/staging.sfz", R"(
+                <region> key=60 sample=*sine
+                <region> key=62 sample=*saw
+                <region> key=64 sample=*square
+            )");
+        }
+        staged = true;
+    });
+
+    while (!staged) {
+        synth.noteOn(0, 60, 100);
+        synth.renderBlock(buffer);
+        synth.noteOff(0, 60, 0);
+    }
+    stagingThread.join();
+
+    synth.renderBlock(buffer);
+    REQUIRE(!synth.hasStagedState());
+    REQUIRE(synth.getNumRegions() == 3);
+}
+
+TEST_CASE("[Synth] Sub-block rendering keeps the timing of the events")
+{
+    constexpr int blockSize = 1024;
+    sfz::Synth reference;
+    sfz::Synth quantized;
+    quantized.setRenderQuantum(64);
+    REQUIRE( quantized.getRenderQuantum() == 64 );
+
+    for (sfz::Synth* synth : { &reference, &quantized }) {
+        synth->setSamplesPerBlock(blockSize);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/quantum.sfz", R"(
+            <region> key=60 sample=*sine ampeg_attack=0.005 ampeg_release=0.005
+            <region> key=62 sample=*saw amplitude_oncc20=100 amplitude=0
+        )");
+    }
+
+    sfz::AudioBuffer<float> referenceBuffer { 2, blockSize };
+    sfz::AudioBuffer<float> quantizedBuffer { 2, blockSize };
+    for (int block = 0; block < 4; ++block) {
+        for (sfz::Synth* synth : { &reference, &quantized }) {
+            switch (block) {
+            case 0:
+                synth->noteOn(700, 60, 100);
+                break;
+            case 1:
+                synth->noteOn(100, 62, 100);
+                synth->cc(500, 20, 127);
+                synth->noteOff(900, 60, 0);
+                break;
+            case 2:
+                synth->noteOff(333, 62, 0);
+                break;
+            }
+        }
+        reference.renderBlock(referenceBuffer);
+        quantized.renderBlock(quantizedBuffer);
+        REQUIRE( approxEqual<float>(referenceBuffer.getConstSpan(0), quantizedBuffer.getConstSpan(0), 1e-4f) );
+        REQUIRE( approxEqual<float>(referenceBuffer.getConstSpan(1), quantizedBuffer.getConstSpan(1), 1e-4f) );
+
+        if (block == 0) {
+            REQUIRE( quantizedBuffer.getSample(0, 699) == 0.0f );
+            REQUIRE( quantizedBuffer.getSample(0, 701) != 0.0f );
+        }
+    }
+
+    const sfz::MidiState& midiState = quantized.getResources().getMidiState();
+    REQUIRE( midiState.getCCValue(20) == 1.0_a );
+}
+
+TEST_CASE("[Synth] Parallel effect buses give the same output")
+{
+    constexpr int blockSize = 256;
+    sfz::Synth serial;
+    sfz::Synth parallel;
+    parallel.enableParallelEffects();
+
+    // one voice per output keeps the serial and multithreaded voice mixes
+    // in the same order
+    for (sfz::Synth* synth : { &serial, &parallel }) {
+        synth->setSamplesPerBlock(blockSize);
+        synth->setNumRenderThreads(4);
+        synth->loadSfzString(fs::current_path() / "tests/TestFiles/parallel_effects.sfz", R"(
+            <region> key=60 sample=*saw output=0 effect1=50
+            <region> key=62 sample=*saw output=1 effect1=50 effect2=30
+            <region> key=64 sample=*sine output=2 effect2=60
+            <effect> output=0 bus=fx1 fx1tomain=100 type=fverb reverb_type=large_hall reverb_input=100 reverb_wet=100
+            <effect> output=1 bus=fx1 fx1tomain=100 type=fverb reverb_type=small_room reverb_input=100 reverb_wet=100
+            <effect> output=1 bus=fx2 fx2tomix=50 type=lofi bitred=50 decim=50
+            <effect> output=2 bus=main type=comp comp_threshold=-20 comp_ratio=4
+            <effect> output=2 bus=fx2 fx2tomain=100 type=strings strings_wet=50
+        )");
+        synth->noteOn(0, 60, 100);
+        synth->noteOn(10, 62, 100);
+        synth->noteOn(20, 64, 100);
+    }
+
+    sfz::AudioBuffer<float> serialBuffer { 6, blockSize };
+    sfz::AudioBuffer<float> parallelBuffer { 6, blockSize };
+    for (int block = 0; block < 50; ++block) {
+        serial.renderBlock(serialBuffer);
+        parallel.renderBlock(parallelBuffer);
+        for (unsigned c = 0; c < 6; ++c) {
+            const auto serialSpan = serialBuffer.getConstSpan(c);
+            const auto parallelSpan = parallelBuffer.getConstSpan(c);
+            REQUIRE( std::equal(serialSpan.begin(), serialSpan.end(), parallelSpan.begin()) );
+        }
+    }
+
+    for (unsigned c = 0; c < 6; ++c) {
+        const auto span = serialBuffer.getConstSpan(c);
+        REQUIRE( std::any_of(span.begin(), span.end(), [](float x) { return x != 0.0f; }) );
+    }
+}